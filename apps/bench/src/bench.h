@@ -0,0 +1,57 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_BENCH_
+#define H_BENCH_
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Returns a timestamp in microseconds, based on os_cputime. */
+uint32_t bench_now_us(void);
+
+/**
+ * Prints one result line: average cost of an operation, in nanoseconds.
+ *
+ * @param name          Name of the measured operation.
+ * @param n             Problem size the operation was measured at.
+ * @param elapsed_us    Total time spent, in microseconds.
+ * @param ops           Number of operations performed in that time.
+ */
+void bench_report(const char *name, int n, uint32_t elapsed_us,
+                  uint32_t ops);
+
+/** Returns a pseudo random number; deterministic across runs. */
+uint32_t bench_rand(void);
+
+void bench_callout(void);
+void bench_mbuf(void);
+void bench_crc(void);
+void bench_log(void);
+void bench_cbor(void);
+void bench_nffs(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,183 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include "os/mynewt.h"
+#include "bench.h"
+
+#if MYNEWT_VAL(BENCH_CALLOUT)
+
+#define BENCH_CALLOUT_MAX   1000
+
+/* Expire phase: callouts come due over this many ticks. */
+#define BENCH_CALLOUT_SPREAD    16
+
+static struct os_callout bench_callouts[BENCH_CALLOUT_MAX];
+static uint16_t bench_callout_order[BENCH_CALLOUT_MAX];
+static struct os_eventq bench_callout_evq;
+
+static void
+bench_callout_cb(struct os_event *ev)
+{
+}
+
+/* Random permutation of first n callout indices. */
+static void
+bench_callout_shuffle(int n)
+{
+    uint16_t tmp;
+    int i;
+    int j;
+
+    for (i = 0; i < n; i++) {
+        bench_callout_order[i] = i;
+    }
+    for (i = n - 1; i > 0; i--) {
+        j = bench_rand() % (i + 1);
+        tmp = bench_callout_order[i];
+        bench_callout_order[i] = bench_callout_order[j];
+        bench_callout_order[j] = tmp;
+    }
+}
+
+/*
+ * Expiry times are far enough in the future that nothing expires while the
+ * benchmark runs; they are spread over a range so that both implementations
+ * see a realistic mix of insertion points.
+ */
+static os_time_t
+bench_callout_ticks(void)
+{
+    return OS_TICKS_PER_SEC * 3600 + bench_rand() % (OS_TICKS_PER_SEC * 60);
+}
+
+/*
+ * Advances the OS clock by BENCH_CALLOUT_SPREAD ticks, which runs
+ * os_callout_tick() for the callouts that came due, and returns the time it
+ * took.  Must be called with interrupts disabled, so that the OS tick does not
+ * expire anything first.
+ */
+static uint32_t
+bench_callout_advance(void)
+{
+    struct os_event *ev;
+    uint32_t start;
+    uint32_t us;
+
+    start = bench_now_us();
+    os_time_advance(BENCH_CALLOUT_SPREAD);
+    us = bench_now_us() - start;
+
+    do {
+        ev = os_eventq_get_no_wait(&bench_callout_evq);
+    } while (ev != NULL);
+
+    return us;
+}
+
+static void
+bench_callout_run(int n)
+{
+    uint32_t insert_us;
+    uint32_t cancel_us;
+    uint32_t expire_us;
+    uint32_t idle_us;
+    uint32_t start;
+    uint32_t us;
+    os_sr_t sr;
+    int round;
+    int rc;
+    int i;
+
+    insert_us = 0;
+    cancel_us = 0;
+    expire_us = 0;
+
+    for (round = 0; round < MYNEWT_VAL(BENCH_CALLOUT_ROUNDS); round++) {
+        /*** Insert: arm n callouts in random order. */
+        bench_callout_shuffle(n);
+        start = bench_now_us();
+        for (i = 0; i < n; i++) {
+            rc = os_callout_reset(&bench_callouts[bench_callout_order[i]],
+                                  bench_callout_ticks());
+            assert(rc == 0);
+        }
+        insert_us += bench_now_us() - start;
+
+        /*** Cancel: stop the callouts in a different random order. */
+        bench_callout_shuffle(n);
+        start = bench_now_us();
+        for (i = 0; i < n; i++) {
+            os_callout_stop(&bench_callouts[bench_callout_order[i]]);
+        }
+        cancel_us += bench_now_us() - start;
+
+        /*
+         * Expire: let n callouts come due and time the clock advance that
+         * runs os_callout_tick() on them.  The same advance with nothing due
+         * is subtracted, leaving the cost of os_callout_tick() removing the
+         * callouts from the queue and posting their events.
+         */
+        OS_ENTER_CRITICAL(sr);
+        idle_us = bench_callout_advance();
+        for (i = 0; i < n; i++) {
+            rc = os_callout_reset(&bench_callouts[i],
+                                  1 + bench_rand() % BENCH_CALLOUT_SPREAD);
+            assert(rc == 0);
+        }
+        us = bench_callout_advance();
+        OS_EXIT_CRITICAL(sr);
+
+        /* Timer resolution can make the idle advance look slower. */
+        if (us > idle_us) {
+            expire_us += us - idle_us;
+        }
+
+        for (i = 0; i < n; i++) {
+            assert(!os_callout_queued(&bench_callouts[i]));
+        }
+    }
+
+    bench_report("callout insert", n, insert_us,
+                 n * MYNEWT_VAL(BENCH_CALLOUT_ROUNDS));
+    bench_report("callout cancel", n, cancel_us,
+                 n * MYNEWT_VAL(BENCH_CALLOUT_ROUNDS));
+    bench_report("callout expire", n, expire_us,
+                 n * MYNEWT_VAL(BENCH_CALLOUT_ROUNDS));
+}
+
+void
+bench_callout(void)
+{
+    int i;
+
+    os_eventq_init(&bench_callout_evq);
+    for (i = 0; i < BENCH_CALLOUT_MAX; i++) {
+        os_callout_init(&bench_callouts[i], &bench_callout_evq,
+                        bench_callout_cb, NULL);
+    }
+
+    printf("callout bench (OS_TIMEQ_HEAP=%d)\n", MYNEWT_VAL(OS_TIMEQ_HEAP));
+    bench_callout_run(10);
+    bench_callout_run(100);
+    bench_callout_run(1000);
+}
+
+#endif
@@ -0,0 +1,196 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "tinycbor/cbor.h"
+#include "tinycbor/cbor_buf_reader.h"
+#include "tinycbor/cbor_buf_writer.h"
+#include "tinycbor/cbor_mbuf_reader.h"
+#include "bench.h"
+
+#if MYNEWT_VAL(BENCH_CBOR)
+
+#define BENCH_CBOR_DATA_LEN     128
+#define BENCH_CBOR_BLOCK_LEN    (BENCH_CBOR_DATA_LEN + sizeof(struct os_mbuf))
+#define BENCH_CBOR_MAX_LEN      4200
+#define BENCH_CBOR_COUNT        (BENCH_CBOR_MAX_LEN / BENCH_CBOR_DATA_LEN + 2)
+
+/* Image data carried by one upload request, and ints in the array case. */
+#define BENCH_CBOR_IMG_CHUNK    4000
+#define BENCH_CBOR_INTS         800
+
+static os_membuf_t bench_cbor_mem[OS_MEMPOOL_SIZE(BENCH_CBOR_COUNT,
+                                                  BENCH_CBOR_BLOCK_LEN)];
+static struct os_mempool bench_cbor_mempool;
+static struct os_mbuf_pool bench_cbor_pool;
+static uint8_t bench_cbor_flat[BENCH_CBOR_MAX_LEN];
+static uint8_t bench_cbor_img[BENCH_CBOR_IMG_CHUNK];
+
+/* Builds an image upload request, as sent by mcumgr. */
+static int
+bench_cbor_enc_upload(void)
+{
+    struct cbor_buf_writer writer;
+    CborEncoder enc;
+    CborEncoder map;
+    int rc;
+    int i;
+
+    for (i = 0; i < BENCH_CBOR_IMG_CHUNK; i++) {
+        bench_cbor_img[i] = bench_rand();
+    }
+
+    cbor_buf_writer_init(&writer, bench_cbor_flat, sizeof(bench_cbor_flat));
+    cbor_encoder_init(&enc, &writer.enc, 0);
+    rc = cbor_encoder_create_map(&enc, &map, CborIndefiniteLength);
+    rc |= cbor_encode_text_stringz(&map, "image");
+    rc |= cbor_encode_uint(&map, 0);
+    rc |= cbor_encode_text_stringz(&map, "data");
+    rc |= cbor_encode_byte_string(&map, bench_cbor_img, BENCH_CBOR_IMG_CHUNK);
+    rc |= cbor_encode_text_stringz(&map, "len");
+    rc |= cbor_encode_uint(&map, 123456);
+    rc |= cbor_encode_text_stringz(&map, "off");
+    rc |= cbor_encode_uint(&map, 0);
+    rc |= cbor_encode_text_stringz(&map, "sha");
+    rc |= cbor_encode_byte_string(&map, bench_cbor_img, 32);
+    rc |= cbor_encoder_close_container(&enc, &map);
+    assert(rc == 0);
+
+    return cbor_buf_writer_buffer_size(&writer, bench_cbor_flat);
+}
+
+/* Builds an array of small integers; every item is a separate read. */
+static int
+bench_cbor_enc_ints(void)
+{
+    struct cbor_buf_writer writer;
+    CborEncoder enc;
+    CborEncoder arr;
+    int rc;
+    int i;
+
+    cbor_buf_writer_init(&writer, bench_cbor_flat, sizeof(bench_cbor_flat));
+    cbor_encoder_init(&enc, &writer.enc, 0);
+    rc = cbor_encoder_create_array(&enc, &arr, BENCH_CBOR_INTS);
+    for (i = 0; i < BENCH_CBOR_INTS; i++) {
+        rc |= cbor_encode_uint(&arr, 1000 + (bench_rand() & 0xff));
+    }
+    rc |= cbor_encoder_close_container(&enc, &arr);
+    assert(rc == 0);
+
+    return cbor_buf_writer_buffer_size(&writer, bench_cbor_flat);
+}
+
+/* Walks a decoded value the way a request handler would. */
+static void
+bench_cbor_parse(struct cbor_decoder_reader *reader)
+{
+    static uint8_t data[BENCH_CBOR_IMG_CHUNK];
+    CborParser parser;
+    CborValue value;
+    CborValue elem;
+    char key[8];
+    uint64_t u64;
+    size_t len;
+    int rc;
+
+    rc = cbor_parser_init(reader, 0, &parser, &value);
+    assert(rc == 0);
+    rc = cbor_value_enter_container(&value, &elem);
+    assert(rc == 0);
+
+    while (!cbor_value_at_end(&elem)) {
+        if (cbor_value_is_text_string(&elem)) {
+            /* Map key followed by its value. */
+            len = sizeof(key);
+            rc = cbor_value_copy_text_string(&elem, key, &len, &elem);
+            assert(rc == 0);
+            if (cbor_value_is_byte_string(&elem)) {
+                len = sizeof(data);
+                rc = cbor_value_copy_byte_string(&elem, data, &len, &elem);
+                assert(rc == 0);
+                continue;
+            }
+        }
+        rc = cbor_value_get_uint64(&elem, &u64);
+        assert(rc == 0);
+        rc = cbor_value_advance(&elem);
+        assert(rc == 0);
+    }
+    (void)u64;
+}
+
+static void
+bench_cbor_run(const char *name_flat, const char *name_mbuf, int len)
+{
+    struct cbor_mbuf_reader mbuf_reader;
+    struct cbor_buf_reader buf_reader;
+    struct os_mbuf *om;
+    uint32_t flat_us;
+    uint32_t mbuf_us;
+    uint32_t start;
+    int round;
+    int rc;
+
+    om = os_mbuf_get_pkthdr(&bench_cbor_pool, 0);
+    assert(om != NULL);
+    rc = os_mbuf_append(om, bench_cbor_flat, len);
+    assert(rc == 0);
+
+    flat_us = 0;
+    mbuf_us = 0;
+    for (round = 0; round < MYNEWT_VAL(BENCH_CBOR_ROUNDS); round++) {
+        start = bench_now_us();
+        cbor_buf_reader_init(&buf_reader, bench_cbor_flat, len);
+        bench_cbor_parse(&buf_reader.r);
+        flat_us += bench_now_us() - start;
+
+        start = bench_now_us();
+        cbor_mbuf_reader_init(&mbuf_reader, om, 0);
+        bench_cbor_parse(&mbuf_reader.r);
+        mbuf_us += bench_now_us() - start;
+    }
+
+    bench_report(name_flat, len, flat_us, MYNEWT_VAL(BENCH_CBOR_ROUNDS));
+    bench_report(name_mbuf, len, mbuf_us, MYNEWT_VAL(BENCH_CBOR_ROUNDS));
+
+    os_mbuf_free_chain(om);
+}
+
+void
+bench_cbor(void)
+{
+    int rc;
+
+    rc = os_mempool_init(&bench_cbor_mempool, BENCH_CBOR_COUNT,
+                         BENCH_CBOR_BLOCK_LEN, bench_cbor_mem, "bench_cbor");
+    assert(rc == 0);
+    rc = os_mbuf_pool_init(&bench_cbor_pool, &bench_cbor_mempool,
+                           BENCH_CBOR_BLOCK_LEN, BENCH_CBOR_COUNT);
+    assert(rc == 0);
+
+    printf("cbor bench (%d byte mbufs)\n", BENCH_CBOR_DATA_LEN);
+    bench_cbor_run("upload flat", "upload mbuf", bench_cbor_enc_upload());
+    bench_cbor_run("ints flat", "ints mbuf", bench_cbor_enc_ints());
+}
+
+#endif
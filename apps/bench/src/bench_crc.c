@@ -0,0 +1,83 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+#include "os/mynewt.h"
+#include "crc/crc16.h"
+#include "crc/crc32.h"
+#include "bench.h"
+
+#if MYNEWT_VAL(BENCH_CRC)
+
+#define BENCH_CRC_MAX_LEN   4096
+
+static uint8_t bench_crc_buf[BENCH_CRC_MAX_LEN];
+
+static void
+bench_crc_run(int len)
+{
+    volatile uint32_t sink;
+    uint32_t crc16_us;
+    uint32_t crc32_us;
+    uint32_t crc32c_us;
+    uint32_t start;
+    int round;
+
+    crc16_us = 0;
+    crc32_us = 0;
+    crc32c_us = 0;
+    for (round = 0; round < MYNEWT_VAL(BENCH_CRC_ROUNDS); round++) {
+        start = bench_now_us();
+        sink = crc16_ccitt(CRC16_INITIAL_CRC, bench_crc_buf, len);
+        crc16_us += bench_now_us() - start;
+
+        start = bench_now_us();
+        sink = crc32_ieee(CRC32_INITIAL_CRC, bench_crc_buf, len);
+        crc32_us += bench_now_us() - start;
+
+        start = bench_now_us();
+        sink = crc32c(CRC32_INITIAL_CRC, bench_crc_buf, len);
+        crc32c_us += bench_now_us() - start;
+    }
+    (void)sink;
+
+    bench_report("crc16_ccitt", len, crc16_us,
+                 MYNEWT_VAL(BENCH_CRC_ROUNDS));
+    bench_report("crc32_ieee", len, crc32_us, MYNEWT_VAL(BENCH_CRC_ROUNDS));
+    bench_report("crc32c", len, crc32c_us, MYNEWT_VAL(BENCH_CRC_ROUNDS));
+}
+
+void
+bench_crc(void)
+{
+    int i;
+
+    for (i = 0; i < BENCH_CRC_MAX_LEN; i++) {
+        bench_crc_buf[i] = bench_rand();
+    }
+
+    printf("crc bench (CRC16_SLICE=%d CRC32_SLICE=%d CRC_HAL=%d)\n",
+           MYNEWT_VAL(CRC16_SLICE), MYNEWT_VAL(CRC32_SLICE),
+           MYNEWT_VAL(CRC_HAL));
+    bench_crc_run(64);
+    bench_crc_run(1024);
+    bench_crc_run(BENCH_CRC_MAX_LEN);
+}
+
+#endif
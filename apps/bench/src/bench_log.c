@@ -0,0 +1,198 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "flash_map/flash_map.h"
+#include "log/log.h"
+#include "log/log_fcb.h"
+#include "bench.h"
+
+#if MYNEWT_VAL(BENCH_LOG)
+
+#define BENCH_LOG_MAX_SECTORS   32
+#define BENCH_LOG_BODY_LEN      32
+
+static struct fcb_log bench_fcb_log;
+static struct log bench_flash_log;
+static struct flash_area bench_log_sectors[BENCH_LOG_MAX_SECTORS];
+
+struct bench_log_walk_arg {
+    struct log_entry_hdr hdr;
+    int found;
+};
+
+static int
+bench_log_first_cb(struct log *log, struct log_offset *log_offset,
+                   const void *dptr, uint16_t len)
+{
+    struct bench_log_walk_arg *arg;
+
+    arg = log_offset->lo_arg;
+    if (log_read_hdr(log, dptr, &arg->hdr) != 0) {
+        return 1;
+    }
+
+    /* Like a log reader would, skip entries older than requested. */
+    if (log_offset->lo_ts > 0 && arg->hdr.ue_ts < log_offset->lo_ts) {
+        return 0;
+    }
+
+    arg->found = 1;
+    return 1;
+}
+
+/**
+ * Reads the header of the first entry whose index is >= 'index' and whose
+ * timestamp is >= 'ts'.
+ */
+static int
+bench_log_seek(uint32_t index, int64_t ts, struct log_entry_hdr *hdr)
+{
+    struct bench_log_walk_arg arg;
+    struct log_offset log_offset;
+
+    arg.found = 0;
+    log_offset.lo_arg = &arg;
+    log_offset.lo_ts = ts;
+    log_offset.lo_index = index;
+    log_offset.lo_data_len = 0;
+
+    log_walk(&bench_flash_log, bench_log_first_cb, &log_offset);
+    if (!arg.found) {
+        return SYS_ENOENT;
+    }
+
+    *hdr = arg.hdr;
+    return 0;
+}
+
+static void
+bench_log_init(void)
+{
+    const struct flash_area *fa;
+    int cnt;
+    int rc;
+
+    rc = flash_area_open(MYNEWT_VAL(BENCH_LOG_FLASH_AREA), &fa);
+    assert(rc == 0);
+    rc = flash_area_erase(fa, 0, fa->fa_size);
+    assert(rc == 0);
+    flash_area_close(fa);
+
+    memset(&bench_fcb_log, 0, sizeof(bench_fcb_log));
+    rc = flash_area_to_sectors(MYNEWT_VAL(BENCH_LOG_FLASH_AREA), &cnt, NULL);
+    assert(rc == 0 && cnt <= BENCH_LOG_MAX_SECTORS);
+    flash_area_to_sectors(MYNEWT_VAL(BENCH_LOG_FLASH_AREA), &cnt,
+                          bench_log_sectors);
+
+    bench_fcb_log.fl_fcb.f_magic = 0xbe4c0600;
+    bench_fcb_log.fl_fcb.f_sectors = bench_log_sectors;
+    bench_fcb_log.fl_fcb.f_sector_cnt = cnt;
+    rc = fcb_init(&bench_fcb_log.fl_fcb);
+    assert(rc == 0);
+
+    rc = log_register("bench", &bench_flash_log, &log_fcb_handler,
+                      &bench_fcb_log, LOG_SYSLEVEL);
+    assert(rc == 0);
+}
+
+static void
+bench_log_fill(int count)
+{
+    uint8_t body[BENCH_LOG_BODY_LEN];
+    int rc;
+    int i;
+
+    memset(body, 0xa5, sizeof(body));
+    for (i = 0; i < count; i++) {
+        rc = log_append_body(&bench_flash_log, 0, LOG_LEVEL_INFO,
+                             LOG_ETYPE_BINARY, body, sizeof(body));
+        assert(rc == 0);
+    }
+}
+
+/**
+ * Measures the time it takes to find a random entry, by index and by
+ * timestamp, which is the cost of serving one page of a log read-back.
+ */
+static void
+bench_log_run(int n)
+{
+    struct log_entry_hdr first;
+    struct log_entry_hdr last;
+    struct log_entry_hdr hdr;
+    uint32_t idx_us;
+    uint32_t ts_us;
+    uint32_t start;
+    uint32_t span;
+    int64_t ts_span;
+    int round;
+    int rc;
+
+    rc = bench_log_seek(0, 0, &first);
+    assert(rc == 0);
+    rc = bench_log_seek(0, -1, &last);
+    assert(rc == 0);
+    span = last.ue_index - first.ue_index + 1;
+    ts_span = last.ue_ts - first.ue_ts + 1;
+
+    idx_us = 0;
+    ts_us = 0;
+    for (round = 0; round < MYNEWT_VAL(BENCH_LOG_ROUNDS); round++) {
+        start = bench_now_us();
+        rc = bench_log_seek(first.ue_index + bench_rand() % span, 0, &hdr);
+        idx_us += bench_now_us() - start;
+        assert(rc == 0);
+
+        start = bench_now_us();
+        rc = bench_log_seek(0, first.ue_ts + bench_rand() % ts_span, &hdr);
+        ts_us += bench_now_us() - start;
+        assert(rc == 0);
+    }
+
+    bench_report("log_seek_index", n, idx_us, MYNEWT_VAL(BENCH_LOG_ROUNDS));
+    bench_report("log_seek_ts", n, ts_us, MYNEWT_VAL(BENCH_LOG_ROUNDS));
+}
+
+void
+bench_log(void)
+{
+    int total;
+    int n;
+
+    printf("log bench (LOG_FCB_SECTOR_INDEX=%d)\n",
+           MYNEWT_VAL(LOG_FCB_SECTOR_INDEX));
+
+    bench_log_init();
+
+    /* Grow the log and measure at each size; once the flash area is full the
+     * log keeps its size and older sectors are rotated out.
+     */
+    total = 0;
+    for (n = 128; n <= MYNEWT_VAL(BENCH_LOG_MAX_ENTRIES); n *= 4) {
+        bench_log_fill(n - total);
+        total = n;
+        bench_log_run(n);
+    }
+}
+
+#endif
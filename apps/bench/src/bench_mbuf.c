@@ -0,0 +1,118 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include "os/mynewt.h"
+#include "crc/crc16.h"
+#include "bench.h"
+
+#if MYNEWT_VAL(BENCH_MBUF)
+
+#define BENCH_MBUF_DATA_LEN     128
+#define BENCH_MBUF_BLOCK_LEN    (BENCH_MBUF_DATA_LEN + sizeof(struct os_mbuf))
+#define BENCH_MBUF_MAX_LEN      2048
+#define BENCH_MBUF_COUNT        (BENCH_MBUF_MAX_LEN / BENCH_MBUF_DATA_LEN + 1)
+
+static os_membuf_t bench_mbuf_mem[OS_MEMPOOL_SIZE(BENCH_MBUF_COUNT,
+                                                  BENCH_MBUF_BLOCK_LEN)];
+static struct os_mempool bench_mbuf_mempool;
+static struct os_mbuf_pool bench_mbuf_pool;
+static uint8_t bench_mbuf_flat[BENCH_MBUF_MAX_LEN];
+
+static int
+bench_mbuf_crc_seg(const void *data, uint16_t len, void *arg)
+{
+    uint16_t *crc;
+
+    crc = arg;
+    *crc = crc16_ccitt(*crc, data, len);
+    return 0;
+}
+
+static void
+bench_mbuf_run(int len)
+{
+    struct os_mbuf *om;
+    uint32_t copy_us;
+    uint32_t iter_us;
+    uint32_t start;
+    uint16_t crc1;
+    uint16_t crc2;
+    int round;
+    int rc;
+    int i;
+
+    om = os_mbuf_get_pkthdr(&bench_mbuf_pool, 0);
+    assert(om != NULL);
+    for (i = 0; i < len; i++) {
+        bench_mbuf_flat[i] = bench_rand();
+    }
+    rc = os_mbuf_append(om, bench_mbuf_flat, len);
+    assert(rc == 0);
+
+    copy_us = 0;
+    iter_us = 0;
+    crc1 = 0;
+    crc2 = 0;
+    for (round = 0; round < MYNEWT_VAL(BENCH_MBUF_ROUNDS); round++) {
+        /*** Copy the chain into a flat buffer, then checksum it. */
+        start = bench_now_us();
+        rc = os_mbuf_copydata(om, 0, len, bench_mbuf_flat);
+        assert(rc == 0);
+        crc1 = crc16_ccitt(0, bench_mbuf_flat, len);
+        copy_us += bench_now_us() - start;
+
+        /*** Checksum each segment in place. */
+        start = bench_now_us();
+        crc2 = 0;
+        rc = os_mbuf_foreach_segment(om, 0, len, bench_mbuf_crc_seg, &crc2);
+        assert(rc == 0);
+        iter_us += bench_now_us() - start;
+
+        assert(crc1 == crc2);
+    }
+
+    bench_report("mbuf crc copy", len, copy_us,
+                 MYNEWT_VAL(BENCH_MBUF_ROUNDS));
+    bench_report("mbuf crc foreach", len, iter_us,
+                 MYNEWT_VAL(BENCH_MBUF_ROUNDS));
+
+    os_mbuf_free_chain(om);
+}
+
+void
+bench_mbuf(void)
+{
+    int rc;
+
+    rc = os_mempool_init(&bench_mbuf_mempool, BENCH_MBUF_COUNT,
+                         BENCH_MBUF_BLOCK_LEN, bench_mbuf_mem, "bench_mbuf");
+    assert(rc == 0);
+    rc = os_mbuf_pool_init(&bench_mbuf_pool, &bench_mbuf_mempool,
+                           BENCH_MBUF_BLOCK_LEN, BENCH_MBUF_COUNT);
+    assert(rc == 0);
+
+    printf("mbuf bench (%d byte mbufs)\n", BENCH_MBUF_DATA_LEN);
+    bench_mbuf_run(64);
+    bench_mbuf_run(512);
+    bench_mbuf_run(BENCH_MBUF_MAX_LEN);
+}
+
+#endif
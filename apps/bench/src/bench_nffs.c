@@ -0,0 +1,235 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "fs/fs.h"
+#include "nffs/nffs.h"
+#include "stats/stats.h"
+#include "bench.h"
+
+#if MYNEWT_VAL(BENCH_NFFS)
+
+#define BENCH_NFFS_MAX_AREAS    (MYNEWT_VAL(NFFS_NUM_AREAS) + 1)
+
+/* One write in ten goes to the cold files; the rest to the hot tenth. */
+#define BENCH_NFFS_HOT_PCT      90
+
+#define BENCH_NFFS_STR_(x)      #x
+#define BENCH_NFFS_STR(x)       BENCH_NFFS_STR_(x)
+
+/** nffs statistics sampled around the workload. */
+struct bench_nffs_counters {
+    uint32_t wbytes;
+    uint32_t gccnt;
+    uint32_t gc_copied;
+    uint32_t gc_reclaimed;
+    uint32_t gc_usecs;
+    uint32_t hash_finds;
+    uint32_t hash_probes;
+};
+
+static uint8_t bench_nffs_chunk[MYNEWT_VAL(BENCH_NFFS_CHUNK)];
+
+static int
+bench_nffs_stat_cb(struct stats_hdr *hdr, void *arg, char *name,
+                   uint16_t off)
+{
+    struct bench_nffs_counters *cnt;
+    uint32_t val;
+
+    cnt = arg;
+    val = *(uint32_t *)((uint8_t *)hdr + off);
+
+    if (strcmp(name, "nffs_wbytes") == 0) {
+        cnt->wbytes = val;
+    } else if (strcmp(name, "nffs_gccnt") == 0) {
+        cnt->gccnt = val;
+    } else if (strcmp(name, "nffs_gc_copied") == 0) {
+        cnt->gc_copied = val;
+    } else if (strcmp(name, "nffs_gc_reclaimed") == 0) {
+        cnt->gc_reclaimed = val;
+    } else if (strcmp(name, "nffs_gc_usecs") == 0) {
+        cnt->gc_usecs = val;
+    } else if (strcmp(name, "nffs_hashcnt_find") == 0) {
+        cnt->hash_finds = val;
+    } else if (strcmp(name, "nffs_hashcnt_probe") == 0) {
+        cnt->hash_probes = val;
+    }
+
+    return 0;
+}
+
+static void
+bench_nffs_sample(struct bench_nffs_counters *cnt)
+{
+    struct stats_hdr *hdr;
+    int rc;
+
+    memset(cnt, 0, sizeof(*cnt));
+    hdr = stats_group_find("nffs_stats");
+    assert(hdr != NULL);
+    rc = stats_walk(hdr, bench_nffs_stat_cb, cnt);
+    assert(rc == 0);
+}
+
+static void
+bench_nffs_path(int file, char *buf, int len)
+{
+    snprintf(buf, len, "/bench%d", file);
+}
+
+static void
+bench_nffs_write(int file, uint32_t off)
+{
+    struct fs_file *fp;
+    char path[16];
+    int rc;
+
+    bench_nffs_path(file, path, sizeof(path));
+
+    rc = fs_open(path, FS_ACCESS_WRITE, &fp);
+    assert(rc == 0);
+    rc = fs_seek(fp, off);
+    assert(rc == 0);
+    rc = fs_write(fp, bench_nffs_chunk, sizeof(bench_nffs_chunk));
+    assert(rc == 0);
+    rc = fs_close(fp);
+    assert(rc == 0);
+}
+
+static void
+bench_nffs_init(void)
+{
+    struct nffs_area_desc descs[BENCH_NFFS_MAX_AREAS];
+    uint32_t off;
+    int cnt;
+    int rc;
+    int i;
+
+    cnt = MYNEWT_VAL(NFFS_NUM_AREAS);
+    rc = nffs_misc_desc_from_flash_area(MYNEWT_VAL(NFFS_FLASH_AREA), &cnt,
+                                        descs);
+    assert(rc == 0);
+    rc = nffs_format(descs);
+    assert(rc == 0);
+
+    memset(bench_nffs_chunk, 0xa5, sizeof(bench_nffs_chunk));
+    for (i = 0; i < MYNEWT_VAL(BENCH_NFFS_FILES); i++) {
+        for (off = 0;
+             off < MYNEWT_VAL(BENCH_NFFS_FILE_SIZE);
+             off += sizeof(bench_nffs_chunk)) {
+
+            bench_nffs_write(i, off);
+        }
+    }
+}
+
+/**
+ * Overwrites random chunks of the files; most writes go to a small set of
+ * hot files, the rest of the data is rarely touched.  This is the pattern
+ * under which the choice of garbage collection victim matters most.
+ */
+static void
+bench_nffs_run(void)
+{
+    struct bench_nffs_counters before;
+    struct bench_nffs_counters after;
+    struct nffs_hash_info info;
+    uint32_t user_bytes;
+    uint32_t flash_bytes;
+    uint32_t probes;
+    uint32_t finds;
+    uint32_t chunks;
+    uint32_t elapsed;
+    uint32_t start;
+    int hot;
+    int file;
+    int rc;
+    int i;
+
+    hot = MYNEWT_VAL(BENCH_NFFS_FILES) / 10;
+    if (hot == 0) {
+        hot = 1;
+    }
+    chunks = MYNEWT_VAL(BENCH_NFFS_FILE_SIZE) / sizeof(bench_nffs_chunk);
+
+    bench_nffs_sample(&before);
+
+    start = bench_now_us();
+    for (i = 0; i < MYNEWT_VAL(BENCH_NFFS_ROUNDS); i++) {
+        if (bench_rand() % 100 < BENCH_NFFS_HOT_PCT) {
+            file = bench_rand() % hot;
+        } else {
+            file = hot + bench_rand() % (MYNEWT_VAL(BENCH_NFFS_FILES) - hot);
+        }
+        bench_nffs_write(file,
+                         (bench_rand() % chunks) * sizeof(bench_nffs_chunk));
+    }
+    elapsed = bench_now_us() - start;
+
+    bench_nffs_sample(&after);
+
+    bench_report("nffs_overwrite", MYNEWT_VAL(BENCH_NFFS_FILES), elapsed,
+                 MYNEWT_VAL(BENCH_NFFS_ROUNDS));
+
+    /* Write amplification: bytes written to flash, including inode updates
+     * and garbage collection copies, per byte written by the application.
+     */
+    user_bytes = MYNEWT_VAL(BENCH_NFFS_ROUNDS) * sizeof(bench_nffs_chunk);
+    flash_bytes = after.wbytes - before.wbytes;
+    printf("nffs gc: cycles=%"PRIu32" copied=%"PRIu32" reclaimed=%"PRIu32
+           " time=%"PRIu32" us\n",
+           after.gccnt - before.gccnt,
+           after.gc_copied - before.gc_copied,
+           after.gc_reclaimed - before.gc_reclaimed,
+           after.gc_usecs - before.gc_usecs);
+    printf("nffs write amplification: %"PRIu32".%02"PRIu32"\n",
+           flash_bytes / user_bytes,
+           (flash_bytes % user_bytes) * 100 / user_bytes);
+
+    /* Hash chain entries examined per lookup; compare with the table's
+     * occupancy to choose nffs_config.nc_hash_size.
+     */
+    rc = nffs_get_hash_info(&info);
+    assert(rc == 0);
+    finds = after.hash_finds - before.hash_finds;
+    probes = after.hash_probes - before.hash_probes;
+    if (finds == 0) {
+        finds = 1;
+    }
+    printf("nffs hash: buckets=%"PRIu32" used=%"PRIu32" entries=%"PRIu32
+           " max_chain=%"PRIu32" probes/lookup=%"PRIu32".%02"PRIu32"\n",
+           info.nhi_num_buckets, info.nhi_used_buckets, info.nhi_num_entries,
+           info.nhi_max_chain_len, probes / finds,
+           (probes % finds) * 100 / finds);
+}
+
+void
+bench_nffs(void)
+{
+    printf("nffs bench (%s)\n", BENCH_NFFS_STR(MYNEWT_VAL(NFFS_GC_POLICY)));
+
+    bench_nffs_init();
+    bench_nffs_run();
+}
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+#include "os/mynewt.h"
+#include "bench.h"
+
+static uint32_t bench_seed = 1;
+
+uint32_t
+bench_now_us(void)
+{
+    return os_cputime_ticks_to_usecs(os_cputime_get32());
+}
+
+void
+bench_report(const char *name, int n, uint32_t elapsed_us, uint32_t ops)
+{
+    uint64_t ns;
+
+    ns = (uint64_t)elapsed_us * 1000 / ops;
+    printf("%-16s n=%-5d %8"PRIu32" ns/op\n", name, n, (uint32_t)ns);
+}
+
+uint32_t
+bench_rand(void)
+{
+    bench_seed = bench_seed * 1103515245 + 12345;
+    return bench_seed >> 8;
+}
+
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+#if MYNEWT_VAL(BENCH_CALLOUT)
+    bench_callout();
+#endif
+#if MYNEWT_VAL(BENCH_MBUF)
+    bench_mbuf();
+#endif
+#if MYNEWT_VAL(BENCH_CRC)
+    bench_crc();
+#endif
+#if MYNEWT_VAL(BENCH_LOG)
+    bench_log();
+#endif
+#if MYNEWT_VAL(BENCH_CBOR)
+    bench_cbor();
+#endif
+#if MYNEWT_VAL(BENCH_NFFS)
+    bench_nffs();
+#endif
+
+    printf("bench: done\n");
+
+    while (1) {
+        os_eventq_run(os_eventq_dflt_get());
+    }
+
+    return 0;
+}
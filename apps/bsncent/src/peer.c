@@ -717,7 +717,7 @@ peer_add(uint16_t conn_handle)
 int
 peer_count(void)
 {
-    return peer_pool.mp_num_blocks - peer_pool.mp_num_free;
+    return peer_pool.mp_num_blocks - os_mempool_num_free(&peer_pool);
 }
 
 static void
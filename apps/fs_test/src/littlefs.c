@@ -26,9 +26,7 @@
 #endif
 
 #include "littlefs/lfs.h"
-
-int littlefs_reformat(void);
-int littlefs_init(void);
+#include "littlefs/littlefs.h"
 
 int
 fs_lowlevel_init(void)
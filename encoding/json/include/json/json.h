@@ -223,6 +223,8 @@ int json_read_array(struct json_buffer *, const struct json_array_t *);
 #define JSON_ERR_MISC        20  /* other data conversion error */
 #define JSON_ERR_BADNUM      21  /* error while parsing a numerical argument */
 #define JSON_ERR_NULLPTR     22  /* unexpected null value or attribute pointer */
+#define JSON_ERR_DEPTH       23  /* containers nested too deeply */
+#define JSON_ERR_INCOMPLETE  24  /* input ended in the middle of a value */
 
 /*
  * Use the following macros to declare template initializers for structobject
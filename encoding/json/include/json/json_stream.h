@@ -0,0 +1,144 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _JSON_STREAM_H_
+#define _JSON_STREAM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "syscfg/syscfg.h"
+#include "json/json.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Incremental (push) JSON decoder.
+ *
+ * Unlike json_read_object(), which needs the whole document reachable
+ * through a json_buffer, the stream decoder is fed the input in arbitrary
+ * fragments as they arrive (UART line, BLE write, mbuf chain...) and calls
+ * back for every value it recognizes.  State is kept in a fixed-size
+ * struct json_stream; nothing is allocated.
+ */
+
+typedef enum {
+    JSON_STREAM_OBJ_START,
+    JSON_STREAM_OBJ_END,
+    JSON_STREAM_ARR_START,
+    JSON_STREAM_ARR_END,
+    JSON_STREAM_STRING,
+    JSON_STREAM_INT,
+    JSON_STREAM_UINT,
+    JSON_STREAM_REAL,
+    JSON_STREAM_BOOL,
+    JSON_STREAM_NULL,
+} json_stream_type;
+
+struct json_stream_event {
+    json_stream_type jse_type;
+    /* Member name if the value is inside an object, NULL otherwise. */
+    const char *jse_key;
+    /* Nesting level of the value; the top-level value is at depth 0. */
+    uint8_t jse_depth;
+    /*
+     * Strings longer than JSON_STREAM_BUF_LEN are delivered in chunks;
+     * jse_last is set on the final one.  Strings are not NUL terminated.
+     */
+    bool jse_last;
+    union {
+        struct {
+            const char *str;
+            uint16_t len;
+        } string;
+        long long int integer;
+        long long unsigned int uinteger;
+#ifdef FLOAT_SUPPORT
+        double real;
+#endif
+        bool boolean;
+    } jse_val;
+};
+
+/*
+ * Called for every decoded event.  A non-zero return aborts decoding and
+ * is returned from json_stream_feed().
+ */
+typedef int (*json_stream_cb_t)(const struct json_stream_event *ev,
+                                void *arg);
+
+struct json_stream {
+    json_stream_cb_t js_cb;
+    void *js_arg;
+    int js_err;
+    uint8_t js_state;
+    uint8_t js_depth;
+    /* Bit n set if container at depth n is an object. */
+    uint8_t js_objs[(MYNEWT_VAL(JSON_STREAM_MAX_DEPTH) + 7) / 8];
+    uint8_t js_keylen;
+    bool js_in_key;
+    uint8_t js_ucnt;
+    uint16_t js_uval;
+    /* High surrogate waiting for its low half; 0 if none. */
+    uint16_t js_uhigh;
+    uint16_t js_buflen;
+    char js_key[JSON_ATTR_MAX + 1];
+    char js_buf[MYNEWT_VAL(JSON_STREAM_BUF_LEN)];
+};
+
+/**
+ * Prepares a stream decoder for a new document.
+ *
+ * @param js                    The decoder to initialize.
+ * @param cb                    Callback receiving decoded events.
+ * @param arg                   Argument passed to the callback.
+ */
+void json_stream_init(struct json_stream *js, json_stream_cb_t cb, void *arg);
+
+/**
+ * Feeds the next fragment of the document to the decoder.  Fragments may
+ * split the input anywhere, including in the middle of a token or an
+ * escape sequence.
+ *
+ * @param js                    The decoder.
+ * @param data                  Next input bytes.
+ * @param len                   Number of bytes in data.
+ *
+ * @return                      0 on success; JSON_ERR_* code on malformed
+ *                                  input; callback's return code if it
+ *                                  aborted.  Errors are sticky until the
+ *                                  decoder is re-initialized.
+ */
+int json_stream_feed(struct json_stream *js, const void *data, int len);
+
+/**
+ * Signals the end of input.  Completes a trailing top-level number.
+ *
+ * @return                      0 if a complete document was decoded;
+ *                                  JSON_ERR_INCOMPLETE if input ended
+ *                                  inside a value; earlier error otherwise.
+ */
+int json_stream_finish(struct json_stream *js);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _JSON_STREAM_H_ */
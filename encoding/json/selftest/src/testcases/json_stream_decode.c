@@ -0,0 +1,195 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include "test_json_priv.h"
+#include "json/json_stream.h"
+
+struct test_json_stream_log {
+    char buf[512];
+    int len;
+    bool in_str;
+};
+
+static void
+test_json_stream_put(struct test_json_stream_log *log, const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    log->len += vsnprintf(log->buf + log->len, sizeof(log->buf) - log->len,
+                          fmt, ap);
+    va_end(ap);
+    TEST_ASSERT_FATAL(log->len < sizeof(log->buf));
+}
+
+static int
+test_json_stream_cb(const struct json_stream_event *ev, void *arg)
+{
+    struct test_json_stream_log *log;
+
+    log = arg;
+    if (ev->jse_key && !log->in_str) {
+        test_json_stream_put(log, "%s:", ev->jse_key);
+    }
+    switch (ev->jse_type) {
+    case JSON_STREAM_OBJ_START:
+        test_json_stream_put(log, "{ ");
+        break;
+    case JSON_STREAM_OBJ_END:
+        test_json_stream_put(log, "} ");
+        break;
+    case JSON_STREAM_ARR_START:
+        test_json_stream_put(log, "[ ");
+        break;
+    case JSON_STREAM_ARR_END:
+        test_json_stream_put(log, "] ");
+        break;
+    case JSON_STREAM_STRING:
+        test_json_stream_put(log, "%s%.*s%s", log->in_str ? "" : "\"",
+                             ev->jse_val.string.len, ev->jse_val.string.str,
+                             ev->jse_last ? "\" " : "");
+        log->in_str = !ev->jse_last;
+        break;
+    case JSON_STREAM_INT:
+        test_json_stream_put(log, "%lld ", ev->jse_val.integer);
+        break;
+    case JSON_STREAM_UINT:
+        test_json_stream_put(log, "%llu ", ev->jse_val.uinteger);
+        break;
+    case JSON_STREAM_BOOL:
+        test_json_stream_put(log, "%c ", ev->jse_val.boolean ? 't' : 'f');
+        break;
+    case JSON_STREAM_NULL:
+        test_json_stream_put(log, "n ");
+        break;
+    default:
+        TEST_ASSERT(0);
+        break;
+    }
+    return 0;
+}
+
+/*
+ * Feeds the document in fragments of at most 'step' bytes, starting with
+ * a fragment of 'first' bytes.
+ */
+static int
+test_json_stream_run(const char *doc, int first, int step,
+                     struct test_json_stream_log *log)
+{
+    struct json_stream js;
+    int len;
+    int off;
+    int n;
+    int rc;
+
+    memset(log, 0, sizeof(*log));
+    json_stream_init(&js, test_json_stream_cb, log);
+
+    len = strlen(doc);
+    for (off = 0; off < len; off += n) {
+        n = off ? step : first;
+        if (n > len - off) {
+            n = len - off;
+        }
+        rc = json_stream_feed(&js, doc + off, n);
+        if (rc) {
+            return rc;
+        }
+    }
+    return json_stream_finish(&js);
+}
+
+TEST_CASE_SELF(test_json_stream_decode)
+{
+    struct test_json_stream_log log;
+    char expected[512];
+    const char *doc;
+    int rc;
+    int i;
+
+    doc = "{\"KeyBool\": true, \"KeyInt\":-1234,\"KeyUint\" : 1353214,"
+          "\"KeyString\":\"foo\\\"bar\\u00e9\\n\","
+          "\"Arr\":[1, 2, {\"x\":null}, []],"
+          "\"Long\":\"0123456789012345678901234567890123456789"
+          "0123456789012345678901234567890123456789\"}";
+    strcpy(expected,
+           "{ KeyBool:t KeyInt:-1234 KeyUint:1353214 "
+           "KeyString:\"foo\"bar\xc3\xa9\n\" "
+           "Arr:[ 1 2 { x:n } [ ] ] "
+           "Long:\"0123456789012345678901234567890123456789"
+           "0123456789012345678901234567890123456789\" } ");
+
+    rc = test_json_stream_run(doc, strlen(doc), 0, &log);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!strcmp(log.buf, expected));
+
+    /* Every split point, and one byte at a time. */
+    for (i = 1; i < strlen(doc); i++) {
+        rc = test_json_stream_run(doc, i, strlen(doc), &log);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(!strcmp(log.buf, expected));
+    }
+    rc = test_json_stream_run(doc, 1, 1, &log);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!strcmp(log.buf, expected));
+
+    /* Top-level scalar is completed by json_stream_finish(). */
+    rc = test_json_stream_run("42", 1, 1, &log);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!strcmp(log.buf, "42 "));
+
+    /* Surrogate pairs decode to a single 4-byte sequence. */
+    rc = test_json_stream_run("\"\\ud83d\\ude00\"", 1, 1, &log);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!strcmp(log.buf, "\"\xf0\x9f\x98\x80\" "));
+
+    /* Lone surrogates. */
+    rc = test_json_stream_run("\"\\ud83d\"", 1, 1, &log);
+    TEST_ASSERT(rc == JSON_ERR_BADSTRING);
+    rc = test_json_stream_run("\"\\ud83dx\"", 1, 1, &log);
+    TEST_ASSERT(rc == JSON_ERR_BADSTRING);
+    rc = test_json_stream_run("\"\\ud83d\\n\"", 1, 1, &log);
+    TEST_ASSERT(rc == JSON_ERR_BADSTRING);
+    rc = test_json_stream_run("\"\\ud83d\\u0041\"", 1, 1, &log);
+    TEST_ASSERT(rc == JSON_ERR_BADSTRING);
+    rc = test_json_stream_run("\"\\ude00\"", 1, 1, &log);
+    TEST_ASSERT(rc == JSON_ERR_BADSTRING);
+
+    /* Malformed and truncated input. */
+    rc = test_json_stream_run("{\"a\":1,}", 1, 1, &log);
+    TEST_ASSERT(rc == JSON_ERR_ATTRSTART);
+    rc = test_json_stream_run("[1 2]", 1, 1, &log);
+    TEST_ASSERT(rc == JSON_ERR_BADTRAIL);
+    rc = test_json_stream_run("[1x]", 1, 1, &log);
+    TEST_ASSERT(rc == JSON_ERR_BADNUM);
+    rc = test_json_stream_run("{\"a\":[1,2}", 1, 1, &log);
+    TEST_ASSERT(rc == JSON_ERR_BADTRAIL);
+    rc = test_json_stream_run("{\"a\":\"b", 1, 1, &log);
+    TEST_ASSERT(rc == JSON_ERR_INCOMPLETE);
+    rc = test_json_stream_run("{} {}", 1, 1, &log);
+    TEST_ASSERT(rc == JSON_ERR_BADTRAIL);
+
+    memset(expected, '[', MYNEWT_VAL(JSON_STREAM_MAX_DEPTH) + 1);
+    expected[MYNEWT_VAL(JSON_STREAM_MAX_DEPTH) + 1] = '\0';
+    rc = test_json_stream_run(expected, 1, 1, &log);
+    TEST_ASSERT(rc == JSON_ERR_DEPTH);
+}
@@ -0,0 +1,517 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "json/json.h"
+#include "json/json_stream.h"
+
+/*
+ * Decoder states.  Each input byte is consumed by exactly one state
+ * transition, so the decoder can be suspended between any two bytes.
+ */
+#define JSS_VALUE           0   /* expecting a value */
+#define JSS_VALUE_OR_END    1   /* after '[': value or ']' */
+#define JSS_KEY             2   /* after ',' in object: member name */
+#define JSS_KEY_OR_END      3   /* after '{': member name or '}' */
+#define JSS_COLON           4   /* after member name */
+#define JSS_STRING          5   /* inside quoted key or value */
+#define JSS_ESC             6   /* after '\' */
+#define JSS_UESC            7   /* inside \uXXXX */
+#define JSS_TOKEN           8   /* number or literal */
+#define JSS_AFTER           9   /* after a value: ',' or container end */
+#define JSS_DONE            10  /* top-level value complete */
+#define JSS_ERR             11
+
+static bool
+json_stream_in_obj(const struct json_stream *js)
+{
+    int d;
+
+    if (js->js_depth == 0) {
+        return false;
+    }
+    d = js->js_depth - 1;
+    return (js->js_objs[d / 8] & (1 << (d % 8))) != 0;
+}
+
+static int
+json_stream_emit(struct json_stream *js, struct json_stream_event *ev)
+{
+    if (ev->jse_type != JSON_STREAM_OBJ_END &&
+        ev->jse_type != JSON_STREAM_ARR_END && json_stream_in_obj(js)) {
+        ev->jse_key = js->js_key;
+    }
+    ev->jse_depth = js->js_depth;
+    return js->js_cb(ev, js->js_arg);
+}
+
+static void
+json_stream_value_done(struct json_stream *js)
+{
+    js->js_state = js->js_depth ? JSS_AFTER : JSS_DONE;
+}
+
+static int
+json_stream_push(struct json_stream *js, bool obj)
+{
+    struct json_stream_event ev = { 0 };
+    int d;
+    int rc;
+
+    if (js->js_depth >= MYNEWT_VAL(JSON_STREAM_MAX_DEPTH)) {
+        return JSON_ERR_DEPTH;
+    }
+
+    ev.jse_type = obj ? JSON_STREAM_OBJ_START : JSON_STREAM_ARR_START;
+    rc = json_stream_emit(js, &ev);
+    if (rc) {
+        return rc;
+    }
+
+    d = js->js_depth++;
+    if (obj) {
+        js->js_objs[d / 8] |= 1 << (d % 8);
+        js->js_state = JSS_KEY_OR_END;
+    } else {
+        js->js_objs[d / 8] &= ~(1 << (d % 8));
+        js->js_state = JSS_VALUE_OR_END;
+    }
+    return 0;
+}
+
+static int
+json_stream_pop(struct json_stream *js)
+{
+    struct json_stream_event ev = { 0 };
+    int rc;
+
+    ev.jse_type = json_stream_in_obj(js) ? JSON_STREAM_OBJ_END :
+                                           JSON_STREAM_ARR_END;
+    js->js_depth--;
+    rc = json_stream_emit(js, &ev);
+    if (rc) {
+        return rc;
+    }
+    json_stream_value_done(js);
+    return 0;
+}
+
+static int
+json_stream_str_flush(struct json_stream *js, bool last)
+{
+    struct json_stream_event ev = { 0 };
+
+    ev.jse_type = JSON_STREAM_STRING;
+    ev.jse_last = last;
+    ev.jse_val.string.str = js->js_buf;
+    ev.jse_val.string.len = js->js_buflen;
+    js->js_buflen = 0;
+    return json_stream_emit(js, &ev);
+}
+
+static int
+json_stream_str_put(struct json_stream *js, char c)
+{
+    int rc;
+
+    if (js->js_in_key) {
+        if (js->js_keylen >= JSON_ATTR_MAX) {
+            return JSON_ERR_ATTRLEN;
+        }
+        js->js_key[js->js_keylen++] = c;
+        return 0;
+    }
+
+    if (js->js_buflen >= sizeof(js->js_buf)) {
+        rc = json_stream_str_flush(js, false);
+        if (rc) {
+            return rc;
+        }
+    }
+    js->js_buf[js->js_buflen++] = c;
+    return 0;
+}
+
+/*
+ * Appends the UTF-8 encoding of a code point.
+ */
+static int
+json_stream_str_put_cp(struct json_stream *js, uint32_t cp)
+{
+    int rc;
+
+    if (cp < 0x80) {
+        return json_stream_str_put(js, cp);
+    }
+    if (cp < 0x800) {
+        rc = json_stream_str_put(js, 0xc0 | (cp >> 6));
+    } else {
+        if (cp < 0x10000) {
+            rc = json_stream_str_put(js, 0xe0 | (cp >> 12));
+        } else {
+            rc = json_stream_str_put(js, 0xf0 | (cp >> 18));
+            if (!rc) {
+                rc = json_stream_str_put(js, 0x80 | ((cp >> 12) & 0x3f));
+            }
+        }
+        if (!rc) {
+            rc = json_stream_str_put(js, 0x80 | ((cp >> 6) & 0x3f));
+        }
+    }
+    if (!rc) {
+        rc = json_stream_str_put(js, 0x80 | (cp & 0x3f));
+    }
+    return rc;
+}
+
+/*
+ * Handles a decoded \u escape.  A high surrogate is held until the escape
+ * with its low half follows; the pair is encoded as a single code point.
+ * Surrogates that are not part of a pair are rejected.
+ */
+static int
+json_stream_str_put_u(struct json_stream *js, uint16_t u)
+{
+    uint16_t high;
+
+    high = js->js_uhigh;
+    js->js_uhigh = 0;
+
+    if (u >= 0xd800 && u <= 0xdbff) {
+        if (high) {
+            return JSON_ERR_BADSTRING;
+        }
+        js->js_uhigh = u;
+        return 0;
+    }
+    if (u >= 0xdc00 && u <= 0xdfff) {
+        if (!high) {
+            return JSON_ERR_BADSTRING;
+        }
+        return json_stream_str_put_cp(js, 0x10000 +
+                                      ((uint32_t)(high - 0xd800) << 10) +
+                                      (u - 0xdc00));
+    }
+    if (high) {
+        return JSON_ERR_BADSTRING;
+    }
+    return json_stream_str_put_cp(js, u);
+}
+
+static int
+json_stream_str_end(struct json_stream *js)
+{
+    int rc;
+
+    if (js->js_in_key) {
+        js->js_key[js->js_keylen] = '\0';
+        js->js_state = JSS_COLON;
+        return 0;
+    }
+    rc = json_stream_str_flush(js, true);
+    if (rc) {
+        return rc;
+    }
+    json_stream_value_done(js);
+    return 0;
+}
+
+static bool
+json_stream_is_token(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+           (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.';
+}
+
+static int
+json_stream_token_end(struct json_stream *js)
+{
+    struct json_stream_event ev = { 0 };
+    char *tok;
+    char *end;
+    int rc;
+
+    end = NULL;
+
+    tok = js->js_buf;
+    tok[js->js_buflen] = '\0';
+    js->js_buflen = 0;
+
+    if (!strcmp(tok, "true") || !strcmp(tok, "false")) {
+        ev.jse_type = JSON_STREAM_BOOL;
+        ev.jse_val.boolean = (tok[0] == 't');
+    } else if (!strcmp(tok, "null")) {
+        ev.jse_type = JSON_STREAM_NULL;
+    } else if (tok[0] != '-' && (tok[0] < '0' || tok[0] > '9')) {
+        return JSON_ERR_BADNUM;
+    } else if (strpbrk(tok, ".eE")) {
+#ifdef FLOAT_SUPPORT
+        ev.jse_type = JSON_STREAM_REAL;
+        ev.jse_val.real = strtod(tok, &end);
+#else
+        return JSON_ERR_MISC;
+#endif
+    } else if (tok[0] == '-') {
+        ev.jse_type = JSON_STREAM_INT;
+        ev.jse_val.integer = strtoll(tok, &end, 10);
+    } else {
+        ev.jse_type = JSON_STREAM_UINT;
+        ev.jse_val.uinteger = strtoull(tok, &end, 10);
+    }
+    if (end != NULL && *end != '\0') {
+        return JSON_ERR_BADNUM;
+    }
+
+    rc = json_stream_emit(js, &ev);
+    if (rc) {
+        return rc;
+    }
+    json_stream_value_done(js);
+    return 0;
+}
+
+static int
+json_stream_value_start(struct json_stream *js, char c)
+{
+    if (c == '{') {
+        return json_stream_push(js, true);
+    }
+    if (c == '[') {
+        return json_stream_push(js, false);
+    }
+    if (c == '"') {
+        js->js_in_key = false;
+        js->js_buflen = 0;
+        js->js_state = JSS_STRING;
+        return 0;
+    }
+    if (json_stream_is_token(c)) {
+        js->js_buf[0] = c;
+        js->js_buflen = 1;
+        js->js_state = JSS_TOKEN;
+        return 0;
+    }
+    return JSON_ERR_MISC;
+}
+
+static int
+json_stream_byte(struct json_stream *js, char c)
+{
+    bool ws;
+    int rc;
+
+    ws = (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+
+    switch (js->js_state) {
+    case JSS_VALUE_OR_END:
+        if (c == ']') {
+            return json_stream_pop(js);
+        }
+        /* fallthrough */
+    case JSS_VALUE:
+        if (ws) {
+            return 0;
+        }
+        return json_stream_value_start(js, c);
+
+    case JSS_KEY_OR_END:
+        if (c == '}') {
+            return json_stream_pop(js);
+        }
+        /* fallthrough */
+    case JSS_KEY:
+        if (ws) {
+            return 0;
+        }
+        if (c != '"') {
+            return JSON_ERR_ATTRSTART;
+        }
+        js->js_in_key = true;
+        js->js_keylen = 0;
+        js->js_state = JSS_STRING;
+        return 0;
+
+    case JSS_COLON:
+        if (ws) {
+            return 0;
+        }
+        if (c != ':') {
+            return JSON_ERR_BADTRAIL;
+        }
+        js->js_state = JSS_VALUE;
+        return 0;
+
+    case JSS_STRING:
+        /* Only the escape with the low half may follow a high surrogate. */
+        if (js->js_uhigh && c != '\\') {
+            return JSON_ERR_BADSTRING;
+        }
+        if (c == '"') {
+            return json_stream_str_end(js);
+        }
+        if (c == '\\') {
+            js->js_state = JSS_ESC;
+            return 0;
+        }
+        if ((unsigned char)c < 0x20) {
+            return JSON_ERR_BADSTRING;
+        }
+        return json_stream_str_put(js, c);
+
+    case JSS_ESC:
+        js->js_state = JSS_STRING;
+        if (js->js_uhigh && c != 'u') {
+            return JSON_ERR_BADSTRING;
+        }
+        switch (c) {
+        case 'b':
+            return json_stream_str_put(js, '\b');
+        case 'f':
+            return json_stream_str_put(js, '\f');
+        case 'n':
+            return json_stream_str_put(js, '\n');
+        case 'r':
+            return json_stream_str_put(js, '\r');
+        case 't':
+            return json_stream_str_put(js, '\t');
+        case '"':
+        case '\\':
+        case '/':
+            return json_stream_str_put(js, c);
+        case 'u':
+            js->js_uval = 0;
+            js->js_ucnt = 0;
+            js->js_state = JSS_UESC;
+            return 0;
+        default:
+            return JSON_ERR_BADSTRING;
+        }
+
+    case JSS_UESC:
+        js->js_uval <<= 4;
+        if (c >= '0' && c <= '9') {
+            js->js_uval |= c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            js->js_uval |= c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            js->js_uval |= c - 'A' + 10;
+        } else {
+            return JSON_ERR_BADSTRING;
+        }
+        if (++js->js_ucnt < 4) {
+            return 0;
+        }
+        js->js_state = JSS_STRING;
+        return json_stream_str_put_u(js, js->js_uval);
+
+    case JSS_TOKEN:
+        if (json_stream_is_token(c)) {
+            /* Keep room for the terminating NUL. */
+            if (js->js_buflen >= sizeof(js->js_buf) - 1) {
+                return JSON_ERR_TOKLONG;
+            }
+            js->js_buf[js->js_buflen++] = c;
+            return 0;
+        }
+        rc = json_stream_token_end(js);
+        if (rc) {
+            return rc;
+        }
+        /* The terminating character belongs to the next state. */
+        return json_stream_byte(js, c);
+
+    case JSS_AFTER:
+        if (ws) {
+            return 0;
+        }
+        if (c == ',') {
+            js->js_state = json_stream_in_obj(js) ? JSS_KEY : JSS_VALUE;
+            return 0;
+        }
+        if (c == (json_stream_in_obj(js) ? '}' : ']')) {
+            return json_stream_pop(js);
+        }
+        return JSON_ERR_BADTRAIL;
+
+    case JSS_DONE:
+        if (ws) {
+            return 0;
+        }
+        return JSON_ERR_BADTRAIL;
+
+    default:
+        return js->js_err;
+    }
+}
+
+void
+json_stream_init(struct json_stream *js, json_stream_cb_t cb, void *arg)
+{
+    memset(js, 0, sizeof(*js));
+    js->js_cb = cb;
+    js->js_arg = arg;
+    js->js_state = JSS_VALUE;
+}
+
+int
+json_stream_feed(struct json_stream *js, const void *data, int len)
+{
+    const char *p;
+    int rc;
+    int i;
+
+    if (js->js_state == JSS_ERR) {
+        return js->js_err;
+    }
+
+    p = data;
+    for (i = 0; i < len; i++) {
+        rc = json_stream_byte(js, p[i]);
+        if (rc) {
+            js->js_err = rc;
+            js->js_state = JSS_ERR;
+            return rc;
+        }
+    }
+    return 0;
+}
+
+int
+json_stream_finish(struct json_stream *js)
+{
+    int rc;
+
+    if (js->js_state == JSS_ERR) {
+        return js->js_err;
+    }
+    if (js->js_state == JSS_TOKEN && js->js_depth == 0) {
+        rc = json_stream_token_end(js);
+        if (rc) {
+            js->js_err = rc;
+            js->js_state = JSS_ERR;
+            return rc;
+        }
+    }
+    if (js->js_state != JSS_DONE) {
+        return JSON_ERR_INCOMPLETE;
+    }
+    return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef CBOR_STREAM_H
+#define CBOR_STREAM_H
+
+#include "os/mynewt.h"
+#include <tinycbor/cbor.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Incremental (push) CBOR decoder.
+ *
+ * The tinycbor parser needs random access to the complete message through
+ * a cbor_decoder_reader.  The stream decoder instead consumes the message
+ * in fragments as they are received and reports each data item through a
+ * callback, so a request can be decoded while the rest of it is still in
+ * flight and without reassembling it first.
+ *
+ * Byte and text strings are not copied: each event points into the
+ * fragment passed to cbor_stream_feed() and a string split across
+ * fragments is reported in several pieces.  Map keys must be text strings;
+ * they are collected in the decoder and handed to the value's event.
+ * Tags are skipped, but must be followed by the item they apply to.
+ */
+
+typedef enum {
+    CBOR_STREAM_MAP_START,
+    CBOR_STREAM_MAP_END,
+    CBOR_STREAM_ARR_START,
+    CBOR_STREAM_ARR_END,
+    CBOR_STREAM_UINT,
+    CBOR_STREAM_INT,
+    CBOR_STREAM_BYTES,
+    CBOR_STREAM_TEXT,
+    CBOR_STREAM_BOOL,
+    CBOR_STREAM_NULL,
+    CBOR_STREAM_UNDEFINED,
+    CBOR_STREAM_SIMPLE,
+    CBOR_STREAM_FLOAT,
+} cbor_stream_type;
+
+struct cbor_stream_event {
+    cbor_stream_type cse_type;
+    /* Map key if the item is a map value, NULL otherwise. */
+    const char *cse_key;
+    /* Nesting level of the item; the top-level item is at depth 0. */
+    uint8_t cse_depth;
+    /* Set on the final piece of a byte or text string. */
+    bool cse_last;
+    union {
+        struct {
+            const uint8_t *ptr;
+            size_t len;
+        } string;
+        uint64_t uinteger;
+        int64_t integer;
+        bool boolean;
+        uint8_t simple;
+#if FLOAT_SUPPORT
+        double real;
+#endif
+    } cse_val;
+};
+
+/*
+ * Called for every decoded event.  A non-zero return aborts decoding and
+ * is returned from cbor_stream_feed().
+ */
+typedef int (*cbor_stream_cb_t)(const struct cbor_stream_event *ev,
+                                void *arg);
+
+struct cbor_stream_level {
+    uint32_t csl_remain;                /* items left in definite container */
+    uint8_t csl_flags;
+};
+
+struct cbor_stream {
+    cbor_stream_cb_t cs_cb;
+    void *cs_arg;
+    int cs_err;
+    uint8_t cs_state;
+    uint8_t cs_depth;
+    uint8_t cs_ib;                      /* initial byte of current item */
+    uint8_t cs_cnt;                     /* argument bytes still expected */
+    uint8_t cs_istr;                    /* major type of open indefinite
+                                           string, 0 if none */
+    uint8_t cs_keylen;
+    bool cs_in_key;
+    bool cs_tagged;                     /* tag read, tagged item not
+                                           started yet */
+    uint64_t cs_val;                    /* argument of current item */
+    uint64_t cs_remain;                 /* string bytes still expected */
+    struct cbor_stream_level cs_stack[MYNEWT_VAL(CBOR_STREAM_MAX_DEPTH)];
+    char cs_key[MYNEWT_VAL(CBOR_STREAM_KEY_LEN)];
+};
+
+/**
+ * Prepares a stream decoder for a new message.
+ *
+ * @param cs                    The decoder to initialize.
+ * @param cb                    Callback receiving decoded events.
+ * @param arg                   Argument passed to the callback.
+ */
+void cbor_stream_init(struct cbor_stream *cs, cbor_stream_cb_t cb, void *arg);
+
+/**
+ * Feeds the next fragment of the message to the decoder.  Fragments may
+ * be split at any byte.  String events point into data, which only needs
+ * to stay valid for the duration of the call.
+ *
+ * @param cs                    The decoder.
+ * @param data                  Next input bytes.
+ * @param len                   Number of bytes in data.
+ *
+ * @return                      0 on success; CborError on malformed input;
+ *                                  callback's return code if it aborted.
+ *                                  Errors are sticky until the decoder is
+ *                                  re-initialized.
+ */
+int cbor_stream_feed(struct cbor_stream *cs, const void *data, size_t len);
+
+/**
+ * Signals the end of input.
+ *
+ * @return                      0 if one complete top-level item was
+ *                                  decoded; CborErrorUnexpectedEOF if the
+ *                                  input ended inside an item; earlier
+ *                                  error otherwise.
+ */
+int cbor_stream_finish(struct cbor_stream *cs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CBOR_STREAM_H */
@@ -0,0 +1,155 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "os/mynewt.h"
+#include "cbor_stream_test_priv.h"
+
+static void
+cbor_stream_test_log_add(struct cbor_stream_test_log *log, const char *fmt,
+                         ...)
+{
+    va_list ap;
+    int rc;
+
+    va_start(ap, fmt);
+    rc = vsnprintf(log->cstl_buf + log->cstl_len,
+                   sizeof(log->cstl_buf) - log->cstl_len, fmt, ap);
+    va_end(ap);
+    TEST_ASSERT_FATAL(rc >= 0 &&
+                      rc < sizeof(log->cstl_buf) - log->cstl_len);
+    log->cstl_len += rc;
+}
+
+int
+cbor_stream_test_log_cb(const struct cbor_stream_event *ev, void *arg)
+{
+    struct cbor_stream_test_log *log;
+    size_t i;
+
+    log = arg;
+    if (!log->cstl_in_str) {
+        cbor_stream_test_log_add(log, "%s%d:%s:", log->cstl_len ? " " : "",
+                                 ev->cse_depth,
+                                 ev->cse_key ? ev->cse_key : "");
+    }
+    switch (ev->cse_type) {
+    case CBOR_STREAM_MAP_START:
+        cbor_stream_test_log_add(log, "{");
+        break;
+    case CBOR_STREAM_MAP_END:
+        cbor_stream_test_log_add(log, "}");
+        break;
+    case CBOR_STREAM_ARR_START:
+        cbor_stream_test_log_add(log, "[");
+        break;
+    case CBOR_STREAM_ARR_END:
+        cbor_stream_test_log_add(log, "]");
+        break;
+    case CBOR_STREAM_UINT:
+        cbor_stream_test_log_add(log, "%llu",
+                                 (unsigned long long)ev->cse_val.uinteger);
+        break;
+    case CBOR_STREAM_INT:
+        cbor_stream_test_log_add(log, "%lld",
+                                 (long long)ev->cse_val.integer);
+        break;
+    case CBOR_STREAM_BYTES:
+    case CBOR_STREAM_TEXT:
+        if (!log->cstl_in_str) {
+            cbor_stream_test_log_add(log,
+              ev->cse_type == CBOR_STREAM_TEXT ? "\"" : "h'");
+            log->cstl_in_str = true;
+        }
+        for (i = 0; i < ev->cse_val.string.len; i++) {
+            cbor_stream_test_log_add(log,
+              ev->cse_type == CBOR_STREAM_TEXT ? "%c" : "%02x",
+              ev->cse_val.string.ptr[i]);
+        }
+        if (ev->cse_last) {
+            cbor_stream_test_log_add(log,
+              ev->cse_type == CBOR_STREAM_TEXT ? "\"" : "'");
+            log->cstl_in_str = false;
+        }
+        break;
+    case CBOR_STREAM_BOOL:
+        cbor_stream_test_log_add(log, ev->cse_val.boolean ? "true" : "false");
+        break;
+    case CBOR_STREAM_NULL:
+        cbor_stream_test_log_add(log, "null");
+        break;
+    case CBOR_STREAM_UNDEFINED:
+        cbor_stream_test_log_add(log, "undefined");
+        break;
+    case CBOR_STREAM_SIMPLE:
+        cbor_stream_test_log_add(log, "simple(%d)", ev->cse_val.simple);
+        break;
+    default:
+        cbor_stream_test_log_add(log, "?");
+        break;
+    }
+    return 0;
+}
+
+int
+cbor_stream_test_decode(const uint8_t *data, size_t len, size_t step,
+                        struct cbor_stream_test_log *log)
+{
+    struct cbor_stream cs;
+    size_t off;
+    size_t n;
+    int rc;
+
+    memset(log, 0, sizeof(*log));
+    cbor_stream_init(&cs, cbor_stream_test_log_cb, log);
+    if (step == 0) {
+        step = len;
+    }
+    for (off = 0; off < len; off += n) {
+        n = len - off < step ? len - off : step;
+        rc = cbor_stream_feed(&cs, data + off, n);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    return cbor_stream_finish(&cs);
+}
+
+TEST_SUITE(cbor_stream_test_suite)
+{
+    cbor_stream_test_split();
+    cbor_stream_test_indef();
+    cbor_stream_test_nesting();
+    cbor_stream_test_tags();
+}
+
+TEST_SUITE(cbor_mbuf_reader_test_suite)
+{
+    cbor_mbuf_reader_test_empty();
+}
+
+int
+main(int argc, char **argv)
+{
+    cbor_stream_test_suite();
+    cbor_mbuf_reader_test_suite();
+    return tu_any_failed;
+}
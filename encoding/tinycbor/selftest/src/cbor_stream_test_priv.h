@@ -0,0 +1,61 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_CBOR_STREAM_TEST_PRIV_
+#define H_CBOR_STREAM_TEST_PRIV_
+
+#include "testutil/testutil.h"
+#include "tinycbor/cbor_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Text form of the events reported for a message.  Pieces of a string are
+ * joined, so the log does not depend on how the input was split.
+ */
+struct cbor_stream_test_log {
+    char cstl_buf[512];
+    int cstl_len;
+    bool cstl_in_str;
+};
+
+/* Callback appending each event to the log passed as its argument. */
+int cbor_stream_test_log_cb(const struct cbor_stream_event *ev, void *arg);
+
+/*
+ * Decodes 'len' bytes of 'data' fed in fragments of 'step' bytes, all at
+ * once if 'step' is 0.  Returns the first error from cbor_stream_feed(), or
+ * the result of cbor_stream_finish().
+ */
+int cbor_stream_test_decode(const uint8_t *data, size_t len, size_t step,
+                            struct cbor_stream_test_log *log);
+
+TEST_CASE_DECL(cbor_stream_test_split);
+TEST_CASE_DECL(cbor_stream_test_indef);
+TEST_CASE_DECL(cbor_stream_test_nesting);
+TEST_CASE_DECL(cbor_stream_test_tags);
+TEST_CASE_DECL(cbor_mbuf_reader_test_empty);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "tinycbor/cbor_mbuf_reader.h"
+#include "cbor_stream_test_priv.h"
+
+#define CMR_TEST_DATA_LEN   16
+#define CMR_TEST_BLOCK_LEN  (CMR_TEST_DATA_LEN + sizeof(struct os_mbuf) + \
+                             sizeof(struct os_mbuf_pkthdr))
+#define CMR_TEST_COUNT      4
+
+static os_membuf_t cmr_test_mem[OS_MEMPOOL_SIZE(CMR_TEST_COUNT,
+                                                CMR_TEST_BLOCK_LEN)];
+static struct os_mempool cmr_test_mempool;
+static struct os_mbuf_pool cmr_test_pool;
+
+/* Builds a two-mbuf chain holding 'len' bytes, split at 'split'. */
+static struct os_mbuf *
+cmr_test_chain(const uint8_t *data, int len, int split)
+{
+    struct os_mbuf *m;
+    struct os_mbuf *m2;
+    int rc;
+
+    m = os_mbuf_get_pkthdr(&cmr_test_pool, 0);
+    TEST_ASSERT_FATAL(m != NULL);
+    m2 = os_mbuf_get(&cmr_test_pool, 0);
+    TEST_ASSERT_FATAL(m2 != NULL);
+
+    rc = os_mbuf_append(m, data, split);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_append(m2, data + split, len - split);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_mbuf_concat(m, m2);
+
+    return m;
+}
+
+/*
+ * Decodes a map with one string value that ends the message; the empty
+ * string is copied from the very end of the mbuf chain.
+ */
+static void
+cmr_test_map(const uint8_t *data, int len, const char *val)
+{
+    struct cbor_mbuf_reader reader;
+    struct os_mbuf *m;
+    CborParser parser;
+    CborValue value;
+    CborValue elem;
+    char buf[8];
+    size_t buf_len;
+    int split;
+    int rc;
+
+    for (split = 0; split <= len; split++) {
+        m = cmr_test_chain(data, len, split);
+        cbor_mbuf_reader_init(&reader, m, 0);
+
+        rc = cbor_parser_init(&reader.r, 0, &parser, &value);
+        TEST_ASSERT_FATAL(rc == CborNoError);
+        rc = cbor_value_enter_container(&value, &elem);
+        TEST_ASSERT_FATAL(rc == CborNoError);
+
+        buf_len = sizeof(buf);
+        rc = cbor_value_copy_text_string(&elem, buf, &buf_len, &elem);
+        TEST_ASSERT(rc == CborNoError);
+        TEST_ASSERT(!strcmp(buf, "k"));
+
+        buf_len = sizeof(buf);
+        memset(buf, 0xff, sizeof(buf));
+        if (cbor_value_is_byte_string(&elem)) {
+            rc = cbor_value_copy_byte_string(&elem, (uint8_t *)buf,
+                                             &buf_len, &elem);
+            buf[buf_len] = '\0';
+        } else {
+            rc = cbor_value_copy_text_string(&elem, buf, &buf_len, &elem);
+        }
+        TEST_ASSERT(rc == CborNoError);
+        TEST_ASSERT(buf_len == strlen(val));
+        TEST_ASSERT(!strcmp(buf, val));
+        TEST_ASSERT(cbor_value_at_end(&elem));
+
+        os_mbuf_free_chain(m);
+    }
+}
+
+TEST_CASE_SELF(cbor_mbuf_reader_test_empty)
+{
+    struct cbor_mbuf_reader reader;
+    struct os_mbuf *m;
+    CborParser parser;
+    CborValue value;
+    char buf[4];
+    size_t buf_len;
+    int rc;
+
+    rc = os_mempool_init(&cmr_test_mempool, CMR_TEST_COUNT,
+                         CMR_TEST_BLOCK_LEN, cmr_test_mem, "cmr_test");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&cmr_test_pool, &cmr_test_mempool,
+                           CMR_TEST_BLOCK_LEN, CMR_TEST_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* {"k": ""} and {"k": h''} */
+    cmr_test_map((uint8_t[]){ 0xa1, 0x61, 'k', 0x60 }, 4, "");
+    cmr_test_map((uint8_t[]){ 0xa1, 0x61, 'k', 0x40 }, 4, "");
+
+    /* {"k": "ab"} */
+    cmr_test_map((uint8_t[]){ 0xa1, 0x61, 'k', 0x62, 'a', 'b' }, 6, "ab");
+
+    /* A top-level empty string. */
+    m = cmr_test_chain((uint8_t[]){ 0x60 }, 1, 1);
+    cbor_mbuf_reader_init(&reader, m, 0);
+    rc = cbor_parser_init(&reader.r, 0, &parser, &value);
+    TEST_ASSERT_FATAL(rc == CborNoError);
+    buf_len = sizeof(buf);
+    rc = cbor_value_copy_text_string(&value, buf, &buf_len, &value);
+    TEST_ASSERT(rc == CborNoError);
+    TEST_ASSERT(buf_len == 0 && buf[0] == '\0');
+    os_mbuf_free_chain(m);
+}
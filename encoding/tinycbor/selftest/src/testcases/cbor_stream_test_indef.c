@@ -0,0 +1,89 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "cbor_stream_test_priv.h"
+
+static void
+cst_indef_fail(const uint8_t *data, size_t len, int err)
+{
+    struct cbor_stream_test_log log;
+    size_t step;
+
+    for (step = 0; step < 3; step++) {
+        TEST_ASSERT(cbor_stream_test_decode(data, len, step, &log) == err);
+    }
+}
+
+TEST_CASE_SELF(cbor_stream_test_indef)
+{
+    /* [_ 1, [_ ], {_ "k": (_ h'01', h'0203'), "e": (_ )}, ""] */
+    static const uint8_t msg[] = {
+        0x9f, 0x01, 0x9f, 0xff,
+        0xbf, 0x61, 'k', 0x5f, 0x41, 0x01, 0x42, 0x02, 0x03, 0xff,
+        0x61, 'e', 0x7f, 0xff, 0xff,
+        0x60, 0xff,
+    };
+    static const char msg_log[] =
+        "0::[ 1::1 1::[ 1::] 1::{ 2:k:h'010203' 2:e:\"\" 1::} 1::\"\" 0::]";
+    /* {_ (_ "ab", "c"): 1000} */
+    static const uint8_t key[] = {
+        0xbf, 0x7f, 0x62, 'a', 'b', 0x61, 'c', 0xff, 0x19, 0x03, 0xe8, 0xff,
+    };
+    static const char key_log[] = "0::{ 1:abc:1000 0::}";
+    struct cbor_stream_test_log log;
+    size_t step;
+    int rc;
+
+    for (step = 0; step < 4; step++) {
+        rc = cbor_stream_test_decode(msg, sizeof(msg), step, &log);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(!strcmp(log.cstl_buf, msg_log));
+
+        rc = cbor_stream_test_decode(key, sizeof(key), step, &log);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(!strcmp(log.cstl_buf, key_log));
+    }
+
+    /* Breaks outside of an indefinite-length item. */
+    cst_indef_fail((uint8_t[]){ 0xff }, 1, CborErrorUnexpectedBreak);
+    cst_indef_fail((uint8_t[]){ 0x82, 0x01, 0xff }, 3,
+                   CborErrorUnexpectedBreak);
+    cst_indef_fail((uint8_t[]){ 0x82, 0x9f, 0xff, 0xff }, 4,
+                   CborErrorUnexpectedBreak);
+
+    /* Break where a map value is expected. */
+    cst_indef_fail((uint8_t[]){ 0xbf, 0x61, 'k', 0xff }, 4,
+                   CborErrorUnexpectedBreak);
+
+    /* Chunks must be definite strings of the same type. */
+    cst_indef_fail((uint8_t[]){ 0x5f, 0x61, 'a', 0xff }, 4,
+                   CborErrorIllegalType);
+    cst_indef_fail((uint8_t[]){ 0x7f, 0x7f, 0xff, 0xff }, 4,
+                   CborErrorIllegalType);
+    cst_indef_fail((uint8_t[]){ 0x5f, 0x01, 0xff }, 3,
+                   CborErrorIllegalType);
+
+    /* Unterminated. */
+    cst_indef_fail((uint8_t[]){ 0x9f, 0x01 }, 2, CborErrorUnexpectedEOF);
+    cst_indef_fail((uint8_t[]){ 0xbf, 0x61, 'k', 0x01 }, 4,
+                   CborErrorUnexpectedEOF);
+    cst_indef_fail((uint8_t[]){ 0x5f, 0x41, 0x01 }, 3,
+                   CborErrorUnexpectedEOF);
+}
@@ -0,0 +1,107 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "cbor_stream_test_priv.h"
+
+#define CST_MAX_DEPTH   MYNEWT_VAL(CBOR_STREAM_MAX_DEPTH)
+
+struct cst_nesting_depth {
+    int cnd_max;
+    int cnd_last;
+};
+
+static int
+cst_nesting_depth_cb(const struct cbor_stream_event *ev, void *arg)
+{
+    struct cst_nesting_depth *cnd;
+
+    cnd = arg;
+    if (ev->cse_depth > cnd->cnd_max) {
+        cnd->cnd_max = ev->cse_depth;
+    }
+    cnd->cnd_last = ev->cse_depth;
+    return 0;
+}
+
+static int
+cst_nesting_decode(uint8_t ib, int levels, int step)
+{
+    struct cbor_stream_test_log log;
+    uint8_t msg[(CST_MAX_DEPTH + 1) * 4 + 1];
+    int len;
+    int i;
+
+    len = 0;
+    for (i = 0; i < levels; i++) {
+        msg[len++] = ib;
+        if (ib == 0xa1 || ib == 0xbf) {
+            msg[len++] = 0x61;
+            msg[len++] = 'k';
+        }
+    }
+    msg[len++] = 0x01;
+    if (ib == 0x9f || ib == 0xbf) {
+        for (i = 0; i < levels; i++) {
+            msg[len++] = 0xff;
+        }
+    }
+    return cbor_stream_test_decode(msg, len, step, &log);
+}
+
+TEST_CASE_SELF(cbor_stream_test_nesting)
+{
+    static const uint8_t ibs[] = { 0x81, 0x9f, 0xa1, 0xbf };
+    struct cst_nesting_depth cnd;
+    struct cbor_stream cs;
+    uint8_t msg[CST_MAX_DEPTH + 1];
+    int step;
+    int rc;
+    int i;
+
+    for (i = 0; i < sizeof(ibs); i++) {
+        for (step = 0; step < 2; step++) {
+            rc = cst_nesting_decode(ibs[i], CST_MAX_DEPTH, step);
+            TEST_ASSERT(rc == 0);
+            rc = cst_nesting_decode(ibs[i], CST_MAX_DEPTH + 1, step);
+            TEST_ASSERT(rc == CborErrorNestingTooDeep);
+        }
+    }
+
+    /* Depth is reported per item and drops again as containers close. */
+    memset(msg, 0x81, CST_MAX_DEPTH);
+    msg[CST_MAX_DEPTH] = 0x01;
+    memset(&cnd, 0, sizeof(cnd));
+    cbor_stream_init(&cs, cst_nesting_depth_cb, &cnd);
+    rc = cbor_stream_feed(&cs, msg, sizeof(msg));
+    TEST_ASSERT(rc == 0);
+    rc = cbor_stream_finish(&cs);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cnd.cnd_max == CST_MAX_DEPTH);
+    TEST_ASSERT(cnd.cnd_last == 0);
+
+    /* The error sticks until the decoder is initialized again. */
+    cbor_stream_init(&cs, cst_nesting_depth_cb, &cnd);
+    memset(msg, 0x81, sizeof(msg));
+    rc = cbor_stream_feed(&cs, msg, sizeof(msg));
+    TEST_ASSERT(rc == CborErrorNestingTooDeep);
+    rc = cbor_stream_feed(&cs, (uint8_t[]){ 0x01 }, 1);
+    TEST_ASSERT(rc == CborErrorNestingTooDeep);
+    TEST_ASSERT(cbor_stream_finish(&cs) == CborErrorNestingTooDeep);
+}
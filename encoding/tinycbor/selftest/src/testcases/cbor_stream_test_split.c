@@ -0,0 +1,90 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "cbor_stream_test_priv.h"
+
+/*
+ * {"a": 1, "bc": [1, -500, {"x": "hi"}, h'0102'], "tag": 1(1000000),
+ *  "f": false, "n": null, "s": (_ "ab", "c"), "big": 4294967296}
+ */
+static const uint8_t cst_split_msg[] = {
+    0xa7,
+    0x61, 'a', 0x01,
+    0x62, 'b', 'c', 0x84, 0x01, 0x39, 0x01, 0xf3,
+        0xa1, 0x61, 'x', 0x62, 'h', 'i',
+        0x42, 0x01, 0x02,
+    0x63, 't', 'a', 'g', 0xc1, 0x1a, 0x00, 0x0f, 0x42, 0x40,
+    0x61, 'f', 0xf4,
+    0x61, 'n', 0xf6,
+    0x61, 's', 0x7f, 0x62, 'a', 'b', 0x61, 'c', 0xff,
+    0x63, 'b', 'i', 'g', 0x1b, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const char cst_split_log[] =
+    "0::{ 1:a:1 1:bc:[ 2::1 2::-500 2::{ 3:x:\"hi\" 2::} 2::h'0102' 1::]"
+    " 1:tag:1000000 1:f:false 1:n:null 1:s:\"abc\" 1:big:4294967296 0::}";
+
+TEST_CASE_SELF(cbor_stream_test_split)
+{
+    struct cbor_stream_test_log log;
+    struct cbor_stream cs;
+    size_t len;
+    size_t i;
+    int rc;
+
+    len = sizeof(cst_split_msg);
+
+    rc = cbor_stream_test_decode(cst_split_msg, len, 0, &log);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!strcmp(log.cstl_buf, cst_split_log));
+
+    /* One byte at a time splits the input at every boundary at once. */
+    rc = cbor_stream_test_decode(cst_split_msg, len, 1, &log);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!strcmp(log.cstl_buf, cst_split_log));
+
+    /* Each boundary on its own, with an empty fragment in between. */
+    for (i = 0; i <= len; i++) {
+        memset(&log, 0, sizeof(log));
+        cbor_stream_init(&cs, cbor_stream_test_log_cb, &log);
+        rc = cbor_stream_feed(&cs, cst_split_msg, i);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = cbor_stream_feed(&cs, cst_split_msg + i, 0);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(cbor_stream_finish(&cs) ==
+                    (i == len ? 0 : CborErrorUnexpectedEOF));
+        rc = cbor_stream_feed(&cs, cst_split_msg + i, len - i);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = cbor_stream_finish(&cs);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(!strcmp(log.cstl_buf, cst_split_log));
+    }
+
+    /* Anything after the top-level item is rejected. */
+    for (i = 1; i < 4; i++) {
+        memset(&log, 0, sizeof(log));
+        cbor_stream_init(&cs, cbor_stream_test_log_cb, &log);
+        rc = cbor_stream_feed(&cs, cst_split_msg, len);
+        TEST_ASSERT(rc == 0);
+        rc = cbor_stream_feed(&cs, cst_split_msg, i);
+        TEST_ASSERT(rc == CborErrorGarbageAtEnd);
+        TEST_ASSERT(cbor_stream_finish(&cs) == CborErrorGarbageAtEnd);
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "cbor_stream_test_priv.h"
+
+static void
+cst_tags_pass(const uint8_t *data, size_t len, const char *expected)
+{
+    struct cbor_stream_test_log log;
+    size_t step;
+    int rc;
+
+    for (step = 0; step < 3; step++) {
+        rc = cbor_stream_test_decode(data, len, step, &log);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(!strcmp(log.cstl_buf, expected));
+    }
+}
+
+static void
+cst_tags_fail(const uint8_t *data, size_t len, int err)
+{
+    struct cbor_stream_test_log log;
+    size_t step;
+
+    for (step = 0; step < 3; step++) {
+        TEST_ASSERT(cbor_stream_test_decode(data, len, step, &log) == err);
+    }
+}
+
+TEST_CASE_SELF(cbor_stream_test_tags)
+{
+    /* Tags are skipped, whatever the size of their number. */
+    cst_tags_pass((uint8_t[]){ 0xc1, 0x01 }, 2, "0::1");
+    cst_tags_pass((uint8_t[]){ 0xd8, 0x20, 0x61, 'u' }, 4, "0::\"u\"");
+    cst_tags_pass((uint8_t[]){ 0xc1, 0xd9, 0x01, 0x00, 0x80 }, 5,
+                  "0::[ 0::]");
+    cst_tags_pass((uint8_t[]){ 0x9f, 0xc2, 0x41, 0x07, 0xff }, 5,
+                  "0::[ 1::h'07' 0::]");
+    cst_tags_pass((uint8_t[]){ 0xa1, 0x61, 'k', 0xc1, 0xf5 }, 5,
+                  "0::{ 1:k:true 0::}");
+
+    /* A tag must be followed by the item it applies to. */
+    cst_tags_fail((uint8_t[]){ 0xc1, 0xff }, 2, CborErrorUnexpectedBreak);
+    cst_tags_fail((uint8_t[]){ 0x9f, 0xc1, 0xff }, 3,
+                  CborErrorUnexpectedBreak);
+    cst_tags_fail((uint8_t[]){ 0x9f, 0xc1, 0xc2, 0xff }, 4,
+                  CborErrorUnexpectedBreak);
+    cst_tags_fail((uint8_t[]){ 0xbf, 0x61, 'k', 0xc1, 0xff }, 5,
+                  CborErrorUnexpectedBreak);
+    cst_tags_fail((uint8_t[]){ 0xc1 }, 1, CborErrorUnexpectedEOF);
+    cst_tags_fail((uint8_t[]){ 0x9f, 0xd8 }, 2, CborErrorUnexpectedEOF);
+}
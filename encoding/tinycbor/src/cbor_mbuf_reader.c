@@ -17,47 +17,125 @@
  * under the License.
  */
 
+#include <string.h>
 #include "os/mynewt.h"
 #include <tinycbor/cbor_mbuf_reader.h>
 #include <tinycbor/compilersupport_p.h>
 
+/*
+ * Returns the mbuf holding the given offset into the packet and sets
+ * out_off to the offset within it.  The parser mostly reads forward, so
+ * the search starts at the mbuf of the previous access and only goes back
+ * to the head of the chain when asked for an earlier offset.
+ */
+static struct os_mbuf *
+cbor_mbuf_reader_seek(struct cbor_mbuf_reader *cb, int off, int *out_off)
+{
+    struct os_mbuf *m;
+    int m_off;
+
+    if (off < cb->cur_off) {
+        cb->cur_m = cb->m;
+        cb->cur_off = 0;
+    }
+
+    m = cb->cur_m;
+    m_off = cb->cur_off;
+    while (m != NULL && off >= m_off + m->om_len) {
+        m_off += m->om_len;
+        m = SLIST_NEXT(m, om_next);
+        if (m != NULL) {
+            cb->cur_m = m;
+            cb->cur_off = m_off;
+        }
+    }
+
+    *out_off = off - m_off;
+    return m;
+}
+
+static int
+cbor_mbuf_reader_copy(struct cbor_mbuf_reader *cb, int offset, void *dst,
+                      size_t len)
+{
+    struct os_mbuf *m;
+    uint8_t *udst;
+    size_t chunk;
+    int off;
+
+    /* Empty strings at the end of the message are copied from its end. */
+    if (len == 0) {
+        return 0;
+    }
+
+    m = cbor_mbuf_reader_seek(cb, offset + cb->init_off, &off);
+    if (m == NULL) {
+        return -1;
+    }
+
+    /* Fast path: the data is contiguous. */
+    if (off + len <= m->om_len) {
+        memcpy(dst, m->om_data + off, len);
+        return 0;
+    }
+
+    udst = dst;
+    while (len > 0) {
+        if (m == NULL) {
+            return -1;
+        }
+        chunk = min(len, m->om_len - off);
+        memcpy(udst, m->om_data + off, chunk);
+        udst += chunk;
+        len -= chunk;
+        off = 0;
+        m = SLIST_NEXT(m, om_next);
+    }
+
+    return 0;
+}
+
 static uint8_t
 cbor_mbuf_reader_get8(struct cbor_decoder_reader *d, int offset)
 {
-    uint8_t val;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
+    struct os_mbuf *m;
+    int off;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
-    return val;
+    m = cbor_mbuf_reader_seek(cb, offset + cb->init_off, &off);
+    if (m == NULL) {
+        return 0;
+    }
+    return m->om_data[off];
 }
 
 static uint16_t
 cbor_mbuf_reader_get16(struct cbor_decoder_reader *d, int offset)
 {
-    uint16_t val;
+    uint16_t val = 0;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    cbor_mbuf_reader_copy(cb, offset, &val, sizeof(val));
     return cbor_ntohs(val);
 }
 
 static uint32_t
 cbor_mbuf_reader_get32(struct cbor_decoder_reader *d, int offset)
 {
-    uint32_t val;
+    uint32_t val = 0;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    cbor_mbuf_reader_copy(cb, offset, &val, sizeof(val));
     return cbor_ntohl(val);
 }
 
 static uint64_t
 cbor_mbuf_reader_get64(struct cbor_decoder_reader *d, int offset)
 {
-    uint64_t val;
+    uint64_t val = 0;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    cbor_mbuf_reader_copy(cb, offset, &val, sizeof(val));
     return cbor_ntohll(val);
 }
 
@@ -66,21 +144,35 @@ cbor_mbuf_reader_cmp(struct cbor_decoder_reader *d, char *buf, int offset,
                      size_t len)
 {
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
-    return os_mbuf_cmpf(cb->m, offset + cb->init_off, buf, len) == 0;
+    struct os_mbuf *m;
+    size_t chunk;
+    int off;
+
+    m = cbor_mbuf_reader_seek(cb, offset + cb->init_off, &off);
+    while (len > 0) {
+        if (m == NULL) {
+            return false;
+        }
+        chunk = min(len, m->om_len - off);
+        if (memcmp(buf, m->om_data + off, chunk) != 0) {
+            return false;
+        }
+        buf += chunk;
+        len -= chunk;
+        off = 0;
+        m = SLIST_NEXT(m, om_next);
+    }
+
+    return true;
 }
 
 static uintptr_t
 cbor_mbuf_reader_cpy(struct cbor_decoder_reader *d, char *dst, int offset,
                      size_t len)
 {
-    int rc;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    rc = os_mbuf_copydata(cb->m, offset + cb->init_off, len, dst);
-    if (rc == 0) {
-        return true;
-    }
-    return false;
+    return cbor_mbuf_reader_copy(cb, offset, dst, len) == 0;
 }
 
 void
@@ -100,5 +192,7 @@ cbor_mbuf_reader_init(struct cbor_mbuf_reader *cb, struct os_mbuf *m,
     hdr = OS_MBUF_PKTHDR(m);
     cb->m = m;
     cb->init_off = initial_offset;
+    cb->cur_m = m;
+    cb->cur_off = 0;
     cb->r.message_size = hdr->omp_len - initial_offset;
 }
@@ -0,0 +1,491 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include <tinycbor/cbor.h>
+#include <tinycbor/cbor_stream.h>
+#include "tinycbor/math_support_p.h"
+
+#define CSS_HEAD            0   /* expecting an initial byte */
+#define CSS_ARG             1   /* collecting argument bytes */
+#define CSS_STRING          2   /* inside string payload */
+#define CSS_DONE            3   /* top-level item complete */
+#define CSS_ERR             4
+
+#define CSL_F_MAP           0x01
+#define CSL_F_INDEF         0x02
+#define CSL_F_VAL           0x04    /* next map item is a value */
+
+#define CBOR_MAJOR(ib)      ((ib) >> 5)
+#define CBOR_AI(ib)         ((ib) & 0x1f)
+#define CBOR_AI_INDEF       31
+#define CBOR_BREAK          0xff
+
+static struct cbor_stream_level *
+cbor_stream_top(struct cbor_stream *cs)
+{
+    if (cs->cs_depth == 0) {
+        return NULL;
+    }
+    return &cs->cs_stack[cs->cs_depth - 1];
+}
+
+static bool
+cbor_stream_want_key(struct cbor_stream *cs)
+{
+    struct cbor_stream_level *l;
+
+    l = cbor_stream_top(cs);
+    return l && (l->csl_flags & (CSL_F_MAP | CSL_F_VAL)) == CSL_F_MAP;
+}
+
+static int
+cbor_stream_emit(struct cbor_stream *cs, struct cbor_stream_event *ev)
+{
+    struct cbor_stream_level *l;
+
+    l = cbor_stream_top(cs);
+    if (ev->cse_type != CBOR_STREAM_MAP_END &&
+        ev->cse_type != CBOR_STREAM_ARR_END &&
+        l && (l->csl_flags & CSL_F_MAP)) {
+        ev->cse_key = cs->cs_key;
+    }
+    ev->cse_depth = cs->cs_depth;
+    return cs->cs_cb(ev, cs->cs_arg);
+}
+
+static int
+cbor_stream_pop(struct cbor_stream *cs)
+{
+    struct cbor_stream_event ev = { 0 };
+
+    ev.cse_type = (cbor_stream_top(cs)->csl_flags & CSL_F_MAP) ?
+      CBOR_STREAM_MAP_END : CBOR_STREAM_ARR_END;
+    cs->cs_depth--;
+    return cbor_stream_emit(cs, &ev);
+}
+
+/*
+ * Accounts for a completed data item in the enclosing container, closing
+ * definite-length containers whose last item this was.
+ */
+static int
+cbor_stream_item_done(struct cbor_stream *cs)
+{
+    struct cbor_stream_level *l;
+    int rc;
+
+    while (1) {
+        l = cbor_stream_top(cs);
+        if (l == NULL) {
+            cs->cs_state = CSS_DONE;
+            return 0;
+        }
+        cs->cs_state = CSS_HEAD;
+        if (l->csl_flags & CSL_F_MAP) {
+            l->csl_flags ^= CSL_F_VAL;
+        }
+        if ((l->csl_flags & CSL_F_INDEF) || --l->csl_remain) {
+            return 0;
+        }
+        rc = cbor_stream_pop(cs);
+        if (rc) {
+            return rc;
+        }
+    }
+}
+
+static int
+cbor_stream_push(struct cbor_stream *cs, bool map, bool indef, uint64_t cnt)
+{
+    struct cbor_stream_event ev = { 0 };
+    struct cbor_stream_level *l;
+    int rc;
+
+    if (cs->cs_depth >= MYNEWT_VAL(CBOR_STREAM_MAX_DEPTH)) {
+        return CborErrorNestingTooDeep;
+    }
+    if (map) {
+        if (cnt > UINT32_MAX / 2) {
+            return CborErrorDataTooLarge;
+        }
+        cnt *= 2;
+    } else if (cnt > UINT32_MAX) {
+        return CborErrorDataTooLarge;
+    }
+
+    ev.cse_type = map ? CBOR_STREAM_MAP_START : CBOR_STREAM_ARR_START;
+    rc = cbor_stream_emit(cs, &ev);
+    if (rc) {
+        return rc;
+    }
+
+    l = &cs->cs_stack[cs->cs_depth++];
+    l->csl_flags = (map ? CSL_F_MAP : 0) | (indef ? CSL_F_INDEF : 0);
+    l->csl_remain = cnt;
+    cs->cs_state = CSS_HEAD;
+
+    if (!indef && cnt == 0) {
+        rc = cbor_stream_pop(cs);
+        if (rc) {
+            return rc;
+        }
+        return cbor_stream_item_done(cs);
+    }
+    return 0;
+}
+
+static int
+cbor_stream_string_end(struct cbor_stream *cs)
+{
+    struct cbor_stream_event ev = { 0 };
+    int rc;
+
+    if (cs->cs_in_key) {
+        cs->cs_key[cs->cs_keylen] = '\0';
+    } else {
+        ev.cse_type = CBOR_MAJOR(cs->cs_ib) == 3 ? CBOR_STREAM_TEXT :
+                                                   CBOR_STREAM_BYTES;
+        ev.cse_last = true;
+        rc = cbor_stream_emit(cs, &ev);
+        if (rc) {
+            return rc;
+        }
+    }
+    return cbor_stream_item_done(cs);
+}
+
+static int
+cbor_stream_string_start(struct cbor_stream *cs, bool indef)
+{
+    cs->cs_in_key = cbor_stream_want_key(cs);
+    cs->cs_keylen = 0;
+    if (indef) {
+        cs->cs_istr = cs->cs_ib & 0xe0;
+        cs->cs_state = CSS_HEAD;
+        return 0;
+    }
+    cs->cs_remain = cs->cs_val;
+    if (cs->cs_remain == 0) {
+        return cbor_stream_string_end(cs);
+    }
+    cs->cs_state = CSS_STRING;
+    return 0;
+}
+
+/*
+ * Consumes up to len bytes of string payload; sets *used to the number of
+ * bytes taken.
+ */
+static int
+cbor_stream_string_data(struct cbor_stream *cs, const uint8_t *p, size_t len,
+                        size_t *used)
+{
+    struct cbor_stream_event ev = { 0 };
+    size_t n;
+    int rc;
+
+    n = len;
+    if (n > cs->cs_remain) {
+        n = cs->cs_remain;
+    }
+    *used = n;
+    cs->cs_remain -= n;
+
+    if (cs->cs_in_key) {
+        if (cs->cs_keylen + n >= sizeof(cs->cs_key)) {
+            return CborErrorDataTooLarge;
+        }
+        memcpy(cs->cs_key + cs->cs_keylen, p, n);
+        cs->cs_keylen += n;
+    } else {
+        ev.cse_type = CBOR_MAJOR(cs->cs_ib) == 3 ? CBOR_STREAM_TEXT :
+                                                   CBOR_STREAM_BYTES;
+        ev.cse_last = (cs->cs_remain == 0 && !cs->cs_istr);
+        ev.cse_val.string.ptr = p;
+        ev.cse_val.string.len = n;
+        rc = cbor_stream_emit(cs, &ev);
+        if (rc) {
+            return rc;
+        }
+    }
+
+    if (cs->cs_remain) {
+        return 0;
+    }
+    if (cs->cs_istr) {
+        /* Next chunk or break. */
+        cs->cs_state = CSS_HEAD;
+        return 0;
+    }
+    if (cs->cs_in_key) {
+        cs->cs_key[cs->cs_keylen] = '\0';
+    }
+    return cbor_stream_item_done(cs);
+}
+
+static int
+cbor_stream_simple(struct cbor_stream *cs)
+{
+    struct cbor_stream_event ev = { 0 };
+#if FLOAT_SUPPORT
+    uint32_t f32;
+    float f;
+#endif
+    uint8_t ai;
+    int rc;
+
+    ai = CBOR_AI(cs->cs_ib);
+    if (ai == 24 && cs->cs_val < 32) {
+        return CborErrorIllegalSimpleType;
+    }
+    if (ai <= 24) {
+        switch (cs->cs_val) {
+        case 20:
+        case 21:
+            ev.cse_type = CBOR_STREAM_BOOL;
+            ev.cse_val.boolean = (cs->cs_val == 21);
+            break;
+        case 22:
+            ev.cse_type = CBOR_STREAM_NULL;
+            break;
+        case 23:
+            ev.cse_type = CBOR_STREAM_UNDEFINED;
+            break;
+        default:
+            ev.cse_type = CBOR_STREAM_SIMPLE;
+            ev.cse_val.simple = cs->cs_val;
+            break;
+        }
+    } else {
+#if FLOAT_SUPPORT
+        ev.cse_type = CBOR_STREAM_FLOAT;
+        if (ai == 25) {
+            ev.cse_val.real = decode_half(cs->cs_val);
+        } else if (ai == 26) {
+            f32 = cs->cs_val;
+            memcpy(&f, &f32, sizeof(f));
+            ev.cse_val.real = f;
+        } else {
+            memcpy(&ev.cse_val.real, &cs->cs_val, sizeof(double));
+        }
+#else
+        return CborErrorUnsupportedType;
+#endif
+    }
+
+    rc = cbor_stream_emit(cs, &ev);
+    if (rc) {
+        return rc;
+    }
+    return cbor_stream_item_done(cs);
+}
+
+/*
+ * Handles an item whose initial byte and argument have been read.
+ */
+static int
+cbor_stream_item(struct cbor_stream *cs)
+{
+    struct cbor_stream_event ev = { 0 };
+    uint8_t major;
+    int rc;
+
+    major = CBOR_MAJOR(cs->cs_ib);
+
+    if (cs->cs_istr) {
+        /* Chunk of an indefinite-length string. */
+        cs->cs_remain = cs->cs_val;
+        cs->cs_state = cs->cs_remain ? CSS_STRING : CSS_HEAD;
+        return 0;
+    }
+    if (cbor_stream_want_key(cs) && major != 3 && major != 6) {
+        return CborErrorIllegalType;
+    }
+
+    switch (major) {
+    case 0:
+        ev.cse_type = CBOR_STREAM_UINT;
+        ev.cse_val.uinteger = cs->cs_val;
+        break;
+    case 1:
+        if (cs->cs_val > INT64_MAX) {
+            return CborErrorDataTooLarge;
+        }
+        ev.cse_type = CBOR_STREAM_INT;
+        ev.cse_val.integer = -1 - (int64_t)cs->cs_val;
+        break;
+    case 2:
+    case 3:
+        return cbor_stream_string_start(cs, false);
+    case 4:
+    case 5:
+        return cbor_stream_push(cs, major == 5, false, cs->cs_val);
+    case 6:
+        /* Tag; the tagged item follows. */
+        cs->cs_tagged = true;
+        cs->cs_state = CSS_HEAD;
+        return 0;
+    default:
+        return cbor_stream_simple(cs);
+    }
+
+    rc = cbor_stream_emit(cs, &ev);
+    if (rc) {
+        return rc;
+    }
+    return cbor_stream_item_done(cs);
+}
+
+static int
+cbor_stream_break(struct cbor_stream *cs)
+{
+    struct cbor_stream_level *l;
+    int rc;
+
+    if (cs->cs_istr) {
+        cs->cs_istr = 0;
+        return cbor_stream_string_end(cs);
+    }
+
+    l = cbor_stream_top(cs);
+    if (l == NULL || !(l->csl_flags & CSL_F_INDEF) ||
+        (l->csl_flags & CSL_F_VAL)) {
+        return CborErrorUnexpectedBreak;
+    }
+    rc = cbor_stream_pop(cs);
+    if (rc) {
+        return rc;
+    }
+    return cbor_stream_item_done(cs);
+}
+
+static int
+cbor_stream_head(struct cbor_stream *cs, uint8_t ib)
+{
+    uint8_t major;
+    uint8_t ai;
+
+    if (ib == CBOR_BREAK) {
+        if (cs->cs_tagged) {
+            /* A tag must be followed by the item it applies to. */
+            return CborErrorUnexpectedBreak;
+        }
+        return cbor_stream_break(cs);
+    }
+    cs->cs_tagged = false;
+
+    major = CBOR_MAJOR(ib);
+    ai = CBOR_AI(ib);
+    if (cs->cs_istr && ((ib & 0xe0) != cs->cs_istr || ai == CBOR_AI_INDEF)) {
+        return CborErrorIllegalType;
+    }
+
+    cs->cs_ib = ib;
+    if (ai < 24) {
+        cs->cs_val = ai;
+        return cbor_stream_item(cs);
+    }
+    if (ai <= 27) {
+        cs->cs_val = 0;
+        cs->cs_cnt = 1 << (ai - 24);
+        cs->cs_state = CSS_ARG;
+        return 0;
+    }
+    if (ai != CBOR_AI_INDEF) {
+        return CborErrorIllegalNumber;
+    }
+
+    if (cbor_stream_want_key(cs) && major != 3) {
+        return CborErrorIllegalType;
+    }
+    switch (major) {
+    case 2:
+    case 3:
+        return cbor_stream_string_start(cs, true);
+    case 4:
+    case 5:
+        return cbor_stream_push(cs, major == 5, true, 0);
+    default:
+        return CborErrorIllegalNumber;
+    }
+}
+
+void
+cbor_stream_init(struct cbor_stream *cs, cbor_stream_cb_t cb, void *arg)
+{
+    memset(cs, 0, sizeof(*cs));
+    cs->cs_cb = cb;
+    cs->cs_arg = arg;
+    cs->cs_state = CSS_HEAD;
+}
+
+int
+cbor_stream_feed(struct cbor_stream *cs, const void *data, size_t len)
+{
+    const uint8_t *p;
+    const uint8_t *end;
+    size_t n;
+    int rc;
+
+    p = data;
+    end = p + len;
+    while (p < end) {
+        switch (cs->cs_state) {
+        case CSS_HEAD:
+            rc = cbor_stream_head(cs, *p++);
+            break;
+        case CSS_ARG:
+            cs->cs_val = (cs->cs_val << 8) | *p++;
+            rc = 0;
+            if (--cs->cs_cnt == 0) {
+                rc = cbor_stream_item(cs);
+            }
+            break;
+        case CSS_STRING:
+            rc = cbor_stream_string_data(cs, p, end - p, &n);
+            p += n;
+            break;
+        case CSS_DONE:
+            rc = CborErrorGarbageAtEnd;
+            break;
+        default:
+            return cs->cs_err;
+        }
+        if (rc) {
+            cs->cs_err = rc;
+            cs->cs_state = CSS_ERR;
+            return rc;
+        }
+    }
+    return 0;
+}
+
+int
+cbor_stream_finish(struct cbor_stream *cs)
+{
+    if (cs->cs_state == CSS_ERR) {
+        return cs->cs_err;
+    }
+    if (cs->cs_state != CSS_DONE) {
+        return CborErrorUnexpectedEOF;
+    }
+    return 0;
+}
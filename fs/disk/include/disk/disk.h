@@ -34,15 +34,100 @@ extern "C" {
 #define DISK_ENOENT       3  /* No such file or directory */
 #define DISK_EOS          4  /* OS error */
 #define DISK_EUNINIT      5  /* File system not initialized */
+#define DISK_EBUSY        6  /* Request already queued */
+#define DISK_EINVAL       7  /* Invalid argument */
+
+/* ioctl commands */
+#define DISK_IOCTL_SYNC   1  /* Complete pending writes; arg unused */
+
+/* Asynchronous request operations */
+#define DISK_REQ_READ     0
+#define DISK_REQ_WRITE    1
+#define DISK_REQ_IOCTL    2
+
+struct disk_req;
+struct disk_ops;
+
+typedef void disk_req_done_fn(struct disk_req *req);
+
+/**
+ * An asynchronous disk request.  The caller owns the request and its buffer
+ * until completion is signalled; any number of requests may be outstanding
+ * at once.
+ *
+ * On completion dr_rc holds the result.  If dr_evq is set, dr_ev is posted
+ * to it (the caller sets dr_ev.ev_cb and, usually, ev_arg = the request);
+ * otherwise dr_done is called from the task that serviced the request.
+ */
+struct disk_req {
+    uint8_t dr_op;                  /* DISK_REQ_[...] */
+    uint8_t dr_id;                  /* Disk id passed to the driver */
+    uint32_t dr_addr;               /* Byte address; ioctl command for IOCTL */
+    void *dr_buf;                   /* Data; ioctl argument for IOCTL */
+    uint32_t dr_len;                /* Bytes to transfer */
+    int dr_rc;
+
+    disk_req_done_fn *dr_done;
+    struct os_eventq *dr_evq;
+    struct os_event dr_ev;
+    void *dr_arg;
+
+    /* Internal. */
+    struct disk_ops *dr_dops;
+    struct os_event dr_qev;
+};
 
 struct disk_ops {
     int (*read)(uint8_t, uint32_t, void *, uint32_t);
     int (*write)(uint8_t, uint32_t, const void *, uint32_t);
     int (*ioctl)(uint8_t, uint32_t, void *);
+    /* Optional; requests go to the default disk queue if NULL. */
+    int (*submit)(uint8_t, struct disk_req *);
 
     SLIST_ENTRY(disk_ops) sc_next;
 };
 
+#if MYNEWT_VAL(DISK_ASYNC)
+/**
+ * A task that services disk requests in the order they are submitted,
+ * using the blocking disk_ops of each request.
+ */
+struct disk_queue {
+    struct os_eventq dq_evq;
+    struct os_task dq_task;
+};
+
+/**
+ * Starts a disk queue task.  Drivers that want requests serviced apart from
+ * other disks create their own queue and hand requests to it from
+ * disk_ops.submit.
+ */
+int disk_queue_init(struct disk_queue *dq, const char *name, uint8_t prio,
+                    os_stack_t *stack, uint16_t stack_size);
+
+/**
+ * Queues a request on the given disk queue.  Returns DISK_EBUSY if the
+ * request is still waiting in a queue.
+ */
+int disk_queue_submit(struct disk_queue *dq, struct disk_ops *dops,
+                      struct disk_req *req);
+
+/**
+ * Starts an asynchronous request.  Uses dops->submit if the driver has one,
+ * otherwise the default disk queue.
+ *
+ * @return 0 if the request was queued, DISK_[...] otherwise; the
+ *         request's own result is reported in dr_rc on completion.
+ */
+int disk_submit(struct disk_ops *dops, struct disk_req *req);
+
+/**
+ * Records the result of a request and signals its completion.  For use by
+ * drivers that implement disk_ops.submit.
+ */
+void disk_req_complete(struct disk_req *req, int rc);
+#endif
+
 int disk_register(const char *disk_name, const char *fs_name, struct disk_ops *dops);
 struct disk_ops *disk_ops_for(const char *disk_name);
 char *disk_fs_for(const char *disk_name);
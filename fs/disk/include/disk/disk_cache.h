@@ -0,0 +1,75 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __DISK_CACHE_H__
+#define __DISK_CACHE_H__
+
+#include <inttypes.h>
+#include "os/mynewt.h"
+#include <disk/disk.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(DISK_CACHE)
+
+/**
+ * Puts the block cache in front of a disk.  All cached disks share one LRU
+ * pool of DISK_CACHE_SIZE bytes.  Block aligned transfers of up to one cache
+ * line are served from the cache; longer ones go to the disk as a single
+ * command, and unaligned ones flush the blocks they touch and pass through.
+ *
+ * Written blocks are held until evicted or until DISK_IOCTL_SYNC, which is
+ * passed on to the disk afterwards.  Errors from the disk are returned
+ * unchanged; errors from the cache itself are negated DISK_E* codes.
+ *
+ * @param id                    The id the filesystem passes to the disk ops
+ *                                  (the drive number for FatFS).
+ * @param lower                 The disk ops to cache.
+ *
+ * @return                      Disk ops to register with disk_register();
+ *                              NULL if id is out of range.
+ */
+struct disk_ops *disk_cache_wrap(uint8_t id, struct disk_ops *lower);
+
+/**
+ * Writes all dirty cached blocks of a disk.
+ *
+ * @param id                    The disk id given to disk_cache_wrap().
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int disk_cache_flush(uint8_t id);
+
+/**
+ * Drops all cached blocks of a disk without writing them, e.g. after the
+ * medium was changed.
+ *
+ * @param id                    The disk id given to disk_cache_wrap().
+ */
+void disk_cache_invalidate(uint8_t id);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,132 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "disk_test.h"
+
+uint8_t disk_test_ram[DISK_TEST_BLOCKS * DISK_TEST_BLOCK_SIZE];
+int disk_test_ram_ops_cnt;
+int disk_test_ram_sync_cnt;
+int disk_test_ram_sync_ops_cnt;
+
+static int
+disk_test_ram_read(uint8_t id, uint32_t addr, void *buf, uint32_t len)
+{
+    if (addr + len > sizeof(disk_test_ram)) {
+        return -DISK_EHW;
+    }
+
+    os_time_delay(1);
+    memcpy(buf, disk_test_ram + addr, len);
+    disk_test_ram_ops_cnt++;
+
+    return 0;
+}
+
+static int
+disk_test_ram_write(uint8_t id, uint32_t addr, const void *buf, uint32_t len)
+{
+    if (addr + len > sizeof(disk_test_ram)) {
+        return -DISK_EHW;
+    }
+
+    os_time_delay(1);
+    memcpy(disk_test_ram + addr, buf, len);
+    disk_test_ram_ops_cnt++;
+
+    return 0;
+}
+
+static int
+disk_test_ram_ioctl(uint8_t id, uint32_t cmd, void *arg)
+{
+    if (cmd == DISK_IOCTL_SYNC) {
+        disk_test_ram_sync_cnt++;
+        disk_test_ram_sync_ops_cnt = disk_test_ram_ops_cnt;
+    }
+
+    return 0;
+}
+
+struct disk_ops disk_test_ram_ops = {
+    .read = disk_test_ram_read,
+    .write = disk_test_ram_write,
+    .ioctl = disk_test_ram_ioctl,
+};
+
+void
+disk_test_ram_reset(void)
+{
+    memset(disk_test_ram, 0xff, sizeof(disk_test_ram));
+    disk_test_ram_ops_cnt = 0;
+    disk_test_ram_sync_cnt = 0;
+    disk_test_ram_sync_ops_cnt = 0;
+}
+
+void
+disk_test_ram_fill(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < sizeof(disk_test_ram); i++) {
+        disk_test_ram[i] = disk_test_data(i);
+    }
+}
+
+uint8_t
+disk_test_data(uint32_t addr)
+{
+    return addr ^ (addr >> 8);
+}
+
+int
+disk_test_data_ok(const uint8_t *buf, uint32_t addr, uint32_t len)
+{
+    uint32_t i;
+
+    for (i = 0; i < len; i++) {
+        if (buf[i] != disk_test_data(addr + i)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+TEST_SUITE(disk_test_suite_async)
+{
+    disk_test_async_cb();
+    disk_test_async_evq();
+}
+
+TEST_SUITE(disk_test_suite_cache)
+{
+    disk_test_cache_read();
+    disk_test_cache_write();
+    disk_test_cache_evict();
+    disk_test_cache_invalidate();
+}
+
+int
+main(int argc, char **argv)
+{
+    disk_test_suite_async();
+    disk_test_suite_cache();
+    return tu_any_failed;
+}
@@ -0,0 +1,63 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_DISK_TEST_H
+#define H_DISK_TEST_H
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "disk/disk.h"
+#include "disk/disk_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISK_TEST_BLOCK_SIZE    512
+#define DISK_TEST_BLOCKS        16
+
+/* A RAM disk that takes a tick per transfer, like a slow card would. */
+extern struct disk_ops disk_test_ram_ops;
+extern uint8_t disk_test_ram[DISK_TEST_BLOCKS * DISK_TEST_BLOCK_SIZE];
+extern int disk_test_ram_ops_cnt;
+extern int disk_test_ram_sync_cnt;
+/* disk_test_ram_ops_cnt when the last DISK_IOCTL_SYNC came in. */
+extern int disk_test_ram_sync_ops_cnt;
+
+void disk_test_ram_reset(void);
+/* Fills the RAM disk with disk_test_data(). */
+void disk_test_ram_fill(void);
+uint8_t disk_test_data(uint32_t addr);
+int disk_test_data_ok(const uint8_t *buf, uint32_t addr, uint32_t len);
+
+TEST_SUITE_DECL(disk_test_suite_async);
+TEST_CASE_DECL(disk_test_async_cb);
+TEST_CASE_DECL(disk_test_async_evq);
+
+TEST_SUITE_DECL(disk_test_suite_cache);
+TEST_CASE_DECL(disk_test_cache_read);
+TEST_CASE_DECL(disk_test_cache_write);
+TEST_CASE_DECL(disk_test_cache_evict);
+TEST_CASE_DECL(disk_test_cache_invalidate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
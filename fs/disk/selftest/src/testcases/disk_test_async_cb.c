@@ -0,0 +1,100 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "disk_test.h"
+
+#define DTAC_REQS       4
+#define DTAC_LEN        (2 * DISK_TEST_BLOCK_SIZE)
+
+static struct os_sem dtac_sem;
+static struct disk_req *dtac_done[DTAC_REQS];
+static int dtac_done_cnt;
+
+static void
+dtac_done_cb(struct disk_req *req)
+{
+    dtac_done[dtac_done_cnt++] = req;
+    os_sem_release(&dtac_sem);
+}
+
+static void
+dtac_run(struct disk_req *reqs, uint8_t op, uint8_t bufs[][DTAC_LEN])
+{
+    int rc;
+    int i;
+
+    dtac_done_cnt = 0;
+    for (i = 0; i < DTAC_REQS; i++) {
+        memset(&reqs[i], 0, sizeof(reqs[i]));
+        reqs[i].dr_op = op;
+        reqs[i].dr_addr = i * DTAC_LEN;
+        reqs[i].dr_buf = bufs[i];
+        reqs[i].dr_len = DTAC_LEN;
+        reqs[i].dr_done = dtac_done_cb;
+
+        rc = disk_submit(&disk_test_ram_ops, &reqs[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /* All requests are outstanding at once; they complete in order. */
+    for (i = 0; i < DTAC_REQS; i++) {
+        rc = os_sem_pend(&dtac_sem, OS_TICKS_PER_SEC);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(dtac_done_cnt == DTAC_REQS);
+    for (i = 0; i < DTAC_REQS; i++) {
+        TEST_ASSERT(dtac_done[i] == &reqs[i]);
+        TEST_ASSERT(reqs[i].dr_rc == 0);
+    }
+}
+
+TEST_CASE_TASK(disk_test_async_cb)
+{
+    static uint8_t bufs[DTAC_REQS][DTAC_LEN];
+    struct disk_req reqs[DTAC_REQS];
+    int rc;
+    int i;
+    int j;
+
+    disk_test_ram_reset();
+    rc = os_sem_init(&dtac_sem, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < DTAC_REQS; i++) {
+        for (j = 0; j < DTAC_LEN; j++) {
+            bufs[i][j] = disk_test_data(i * DTAC_LEN + j);
+        }
+    }
+    dtac_run(reqs, DISK_REQ_WRITE, bufs);
+    TEST_ASSERT(disk_test_ram_ops_cnt == DTAC_REQS);
+    for (i = 0; i < DTAC_REQS * DTAC_LEN; i++) {
+        TEST_ASSERT_FATAL(disk_test_ram[i] == disk_test_data(i));
+    }
+
+    memset(bufs, 0, sizeof(bufs));
+    dtac_run(reqs, DISK_REQ_READ, bufs);
+    TEST_ASSERT(disk_test_ram_ops_cnt == 2 * DTAC_REQS);
+    for (i = 0; i < DTAC_REQS; i++) {
+        for (j = 0; j < DTAC_LEN; j++) {
+            TEST_ASSERT_FATAL(bufs[i][j] ==
+                              disk_test_data(i * DTAC_LEN + j));
+        }
+    }
+}
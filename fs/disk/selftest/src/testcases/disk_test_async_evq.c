@@ -0,0 +1,91 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "disk_test.h"
+
+static void
+dtae_noop_cb(struct os_event *ev)
+{
+}
+
+static void
+dtae_req_init(struct disk_req *req, struct os_eventq *evq, uint8_t op,
+              uint32_t addr, void *buf, uint32_t len)
+{
+    memset(req, 0, sizeof(*req));
+    req->dr_op = op;
+    req->dr_addr = addr;
+    req->dr_buf = buf;
+    req->dr_len = len;
+    req->dr_evq = evq;
+    req->dr_ev.ev_cb = dtae_noop_cb;
+    req->dr_ev.ev_arg = req;
+}
+
+TEST_CASE_TASK(disk_test_async_evq)
+{
+    static uint8_t buf[DISK_TEST_BLOCK_SIZE];
+    struct os_eventq evq;
+    struct os_event *ev;
+    struct disk_req reqs[3];
+    int rc;
+    int i;
+
+    disk_test_ram_reset();
+    for (i = 0; i < sizeof(disk_test_ram); i++) {
+        disk_test_ram[i] = disk_test_data(i);
+    }
+    os_eventq_init(&evq);
+
+    /* Past the end of the disk; the driver's error is reported. */
+    dtae_req_init(&reqs[0], &evq, DISK_REQ_READ, sizeof(disk_test_ram),
+                  buf, sizeof(buf));
+    dtae_req_init(&reqs[1], &evq, DISK_REQ_IOCTL, DISK_IOCTL_SYNC, NULL, 0);
+    dtae_req_init(&reqs[2], &evq, DISK_REQ_READ, 3 * DISK_TEST_BLOCK_SIZE,
+                  buf, sizeof(buf));
+
+    for (i = 0; i < 3; i++) {
+        rc = disk_submit(&disk_test_ram_ops, &reqs[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /* The queue task has a lower priority and has not run yet. */
+    rc = disk_submit(&disk_test_ram_ops, &reqs[2]);
+    TEST_ASSERT(rc == DISK_EBUSY);
+
+    for (i = 0; i < 3; i++) {
+        ev = os_eventq_get(&evq);
+        TEST_ASSERT_FATAL(ev->ev_arg == &reqs[i]);
+    }
+
+    TEST_ASSERT(reqs[0].dr_rc == -DISK_EHW);
+    TEST_ASSERT(reqs[1].dr_rc == 0);
+    TEST_ASSERT(disk_test_ram_sync_cnt == 1);
+    TEST_ASSERT(reqs[2].dr_rc == 0);
+    for (i = 0; i < sizeof(buf); i++) {
+        TEST_ASSERT_FATAL(buf[i] ==
+                          disk_test_data(3 * DISK_TEST_BLOCK_SIZE + i));
+    }
+
+    /* Unknown operations are rejected up front. */
+    dtae_req_init(&reqs[0], &evq, DISK_REQ_IOCTL + 1, 0, NULL, 0);
+    rc = disk_submit(&disk_test_ram_ops, &reqs[0]);
+    TEST_ASSERT(rc == DISK_EINVAL);
+}
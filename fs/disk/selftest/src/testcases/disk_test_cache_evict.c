@@ -0,0 +1,89 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "disk_test.h"
+
+#define BS  DISK_TEST_BLOCK_SIZE
+
+static void
+dtce_write(struct disk_ops *ops, int block)
+{
+    uint8_t buf[BS];
+    int rc;
+
+    memset(buf, block, sizeof(buf));
+    rc = ops->write(0, block * BS, buf, BS);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+static void
+dtce_read(struct disk_ops *ops, int block, uint8_t *buf)
+{
+    int rc;
+
+    rc = ops->read(0, block * BS, buf, BS);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+TEST_CASE_TASK(disk_test_cache_evict)
+{
+    static uint8_t buf[BS];
+    struct disk_ops *ops;
+
+    disk_test_ram_reset();
+    disk_test_ram_fill();
+    ops = disk_cache_wrap(0, &disk_test_ram_ops);
+    TEST_ASSERT_FATAL(ops != NULL);
+
+    /* Both lines of the cache get a dirty block. */
+    dtce_write(ops, 0);
+    dtce_write(ops, 2);
+    TEST_ASSERT(disk_test_ram_ops_cnt == 0);
+
+    /*
+     * A third line takes the least recently used one, whose dirty block is
+     * written back first.
+     */
+    dtce_read(ops, 4, buf);
+    TEST_ASSERT(disk_test_data_ok(buf, 4 * BS, BS));
+    TEST_ASSERT(disk_test_ram_ops_cnt == 2);
+    TEST_ASSERT(disk_test_ram[0] == 0);
+    TEST_ASSERT(disk_test_data_ok(disk_test_ram + 2 * BS, 2 * BS, BS));
+
+    /* Using the other line makes the new one least recently used. */
+    dtce_read(ops, 2, buf);
+    TEST_ASSERT(buf[0] == 2);
+    TEST_ASSERT(disk_test_ram_ops_cnt == 2);
+
+    /* Evicting a clean line costs no write. */
+    dtce_read(ops, 6, buf);
+    TEST_ASSERT(disk_test_data_ok(buf, 6 * BS, BS));
+    TEST_ASSERT(disk_test_ram_ops_cnt == 3);
+
+    /* An evicted block is read back from the disk. */
+    dtce_read(ops, 0, buf);
+    TEST_ASSERT(buf[0] == 0 && buf[BS - 1] == 0);
+    TEST_ASSERT(disk_test_ram_ops_cnt == 5);
+    TEST_ASSERT(disk_test_ram[2 * BS] == 2);
+
+    dtce_read(ops, 1, buf);
+    TEST_ASSERT(disk_test_data_ok(buf, BS, BS));
+    TEST_ASSERT(disk_test_ram_ops_cnt == 5);
+}
@@ -0,0 +1,64 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "disk_test.h"
+
+#define BS  DISK_TEST_BLOCK_SIZE
+
+TEST_CASE_TASK(disk_test_cache_invalidate)
+{
+    static uint8_t buf[BS];
+    struct disk_ops *ops;
+    int rc;
+
+    disk_test_ram_reset();
+    disk_test_ram_fill();
+    ops = disk_cache_wrap(0, &disk_test_ram_ops);
+    TEST_ASSERT_FATAL(ops != NULL);
+
+    rc = ops->read(0, 0, buf, BS);
+    TEST_ASSERT(rc == 0);
+    memset(buf, 0x11, sizeof(buf));
+    rc = ops->write(0, 2 * BS, buf, BS);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_ram_ops_cnt == 1);
+
+    /* The medium changes; the cache still has the old contents. */
+    memset(disk_test_ram, 0, BS);
+    rc = ops->read(0, 0, buf, BS);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_data_ok(buf, 0, BS));
+
+    /* After invalidating, blocks come from the disk again. */
+    disk_cache_invalidate(0);
+    rc = ops->read(0, 0, buf, BS);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(buf[0] == 0 && buf[BS - 1] == 0);
+    TEST_ASSERT(disk_test_ram_ops_cnt == 2);
+
+    /* Dirty blocks are dropped, not written. */
+    rc = ops->ioctl(0, DISK_IOCTL_SYNC, NULL);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_ram_ops_cnt == 2);
+    rc = ops->read(0, 2 * BS, buf, BS);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_data_ok(buf, 2 * BS, BS));
+    TEST_ASSERT(disk_test_ram_ops_cnt == 3);
+}
@@ -0,0 +1,67 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "disk_test.h"
+
+#define BS  DISK_TEST_BLOCK_SIZE
+
+TEST_CASE_TASK(disk_test_cache_read)
+{
+    static uint8_t buf[6 * BS];
+    struct disk_ops *ops;
+    int rc;
+
+    disk_test_ram_reset();
+    disk_test_ram_fill();
+    ops = disk_cache_wrap(0, &disk_test_ram_ops);
+    TEST_ASSERT_FATAL(ops != NULL);
+
+    /* A miss reads the whole line with one transfer. */
+    rc = ops->read(0, 0, buf, BS);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_ram_ops_cnt == 1);
+    TEST_ASSERT(disk_test_data_ok(buf, 0, BS));
+
+    /* The block read ahead, and the one read before, are hits. */
+    memset(buf, 0, sizeof(buf));
+    rc = ops->read(0, BS, buf, BS);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_data_ok(buf, BS, BS));
+    rc = ops->read(0, 0, buf, 2 * BS);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_data_ok(buf, 0, 2 * BS));
+    TEST_ASSERT(disk_test_ram_ops_cnt == 1);
+
+    /* Unaligned reads go to the disk. */
+    rc = ops->read(0, 100, buf, 10);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_data_ok(buf, 100, 10));
+    TEST_ASSERT(disk_test_ram_ops_cnt == 2);
+
+    /* So do reads longer than a line, as a single transfer. */
+    rc = ops->read(0, 4 * BS, buf, 6 * BS);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_data_ok(buf, 4 * BS, 6 * BS));
+    TEST_ASSERT(disk_test_ram_ops_cnt == 3);
+
+    /* Errors from the disk come back unchanged. */
+    rc = ops->read(0, DISK_TEST_BLOCKS * BS, buf, BS);
+    TEST_ASSERT(rc == -DISK_EHW);
+}
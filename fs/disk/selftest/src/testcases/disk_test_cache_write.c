@@ -0,0 +1,94 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "disk_test.h"
+
+#define BS  DISK_TEST_BLOCK_SIZE
+
+TEST_CASE_TASK(disk_test_cache_write)
+{
+    static uint8_t buf[6 * BS];
+    struct disk_ops *ops;
+    int rc;
+    int i;
+
+    disk_test_ram_reset();
+    ops = disk_cache_wrap(0, &disk_test_ram_ops);
+    TEST_ASSERT_FATAL(ops != NULL);
+
+    /* Written blocks stay in the cache; the line is not read first. */
+    for (i = 0; i < 2 * BS; i++) {
+        buf[i] = disk_test_data(2 * BS + i);
+    }
+    rc = ops->write(0, 2 * BS, buf, 2 * BS);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_ram_ops_cnt == 0);
+    TEST_ASSERT(disk_test_ram[2 * BS] == 0xff);
+
+    memset(buf, 0, sizeof(buf));
+    rc = ops->read(0, 2 * BS, buf, 2 * BS);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_data_ok(buf, 2 * BS, 2 * BS));
+    TEST_ASSERT(disk_test_ram_ops_cnt == 0);
+
+    /* A read past the cache still sees the blocks not yet written back. */
+    rc = ops->read(0, 0, buf, 6 * BS);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_ram_ops_cnt == 1);
+    TEST_ASSERT(buf[0] == 0xff);
+    TEST_ASSERT(disk_test_data_ok(buf + 2 * BS, 2 * BS, 2 * BS));
+    TEST_ASSERT(buf[4 * BS] == 0xff);
+
+    /* Sync writes them back with one transfer, then syncs the disk. */
+    rc = ops->ioctl(0, DISK_IOCTL_SYNC, NULL);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_ram_sync_cnt == 1);
+    TEST_ASSERT(disk_test_ram_ops_cnt == 2);
+    TEST_ASSERT(disk_test_ram_sync_ops_cnt == 2);
+    TEST_ASSERT(disk_test_data_ok(disk_test_ram + 2 * BS, 2 * BS, 2 * BS));
+
+    /* Nothing is left to write. */
+    rc = disk_cache_flush(0);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_ram_ops_cnt == 2);
+
+    /*
+     * A write past the cache updates the cached copies, which then have
+     * nothing to write back.
+     */
+    rc = ops->write(0, 3 * BS, buf, BS);
+    TEST_ASSERT(rc == 0);
+    for (i = 0; i < 6 * BS; i++) {
+        buf[i] = ~disk_test_data(i);
+    }
+    rc = ops->write(0, 0, buf, 6 * BS);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_ram_ops_cnt == 3);
+    memset(buf, 0, sizeof(buf));
+    rc = ops->read(0, 3 * BS, buf, BS);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_ram_ops_cnt == 3);
+    for (i = 0; i < BS; i++) {
+        TEST_ASSERT_FATAL(buf[i] == (uint8_t)~disk_test_data(3 * BS + i));
+    }
+    rc = disk_cache_flush(0);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(disk_test_ram_ops_cnt == 3);
+}
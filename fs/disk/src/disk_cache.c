@@ -0,0 +1,614 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(DISK_CACHE)
+
+#include <string.h>
+#include <assert.h>
+#include "stats/stats.h"
+#include <disk/disk.h>
+#include <disk/disk_cache.h>
+
+#define DC_BLOCK_SIZE   MYNEWT_VAL(DISK_CACHE_BLOCK_SIZE)
+#define DC_LINE_BLOCKS  MYNEWT_VAL(DISK_CACHE_LINE_BLOCKS)
+#define DC_LINE_SIZE    (DC_BLOCK_SIZE * DC_LINE_BLOCKS)
+#define DC_NUM_LINES    (MYNEWT_VAL(DISK_CACHE_SIZE) / DC_LINE_SIZE)
+
+#if DC_LINE_BLOCKS < 1 || DC_LINE_BLOCKS > 8
+#error "DISK_CACHE_LINE_BLOCKS must be between 1 and 8"
+#endif
+#if DC_NUM_LINES < 1
+#error "DISK_CACHE_SIZE is smaller than one cache line"
+#endif
+
+/*
+ * A line caches DC_LINE_BLOCKS consecutive blocks starting at a multiple of
+ * DC_LINE_BLOCKS.  Each block is tracked separately: a write only makes its
+ * own blocks valid, and a miss reads just the blocks still missing.  A line
+ * with no valid blocks is free.
+ */
+struct disk_cache_line {
+    TAILQ_ENTRY(disk_cache_line) dcl_lru;
+    uint32_t dcl_line;          /* Line number; first block / LINE_BLOCKS. */
+    uint8_t dcl_id;
+    uint8_t dcl_valid;          /* Bit per block. */
+    uint8_t dcl_dirty;          /* Bit per block; subset of dcl_valid. */
+    uint8_t *dcl_data;
+};
+
+STATS_SECT_START(disk_cache_stats)
+    STATS_SECT_ENTRY(hits)
+    STATS_SECT_ENTRY(misses)
+    STATS_SECT_ENTRY(read_ahead)
+    STATS_SECT_ENTRY(disk_reads)
+    STATS_SECT_ENTRY(disk_writes)
+    STATS_SECT_ENTRY(write_backs)
+    STATS_SECT_ENTRY(evictions)
+    STATS_SECT_ENTRY(bypasses)
+STATS_SECT_END
+
+static STATS_SECT_DECL(disk_cache_stats) disk_cache_stats;
+
+STATS_NAME_START(disk_cache_stats)
+    STATS_NAME(disk_cache_stats, hits)
+    STATS_NAME(disk_cache_stats, misses)
+    STATS_NAME(disk_cache_stats, read_ahead)
+    STATS_NAME(disk_cache_stats, disk_reads)
+    STATS_NAME(disk_cache_stats, disk_writes)
+    STATS_NAME(disk_cache_stats, write_backs)
+    STATS_NAME(disk_cache_stats, evictions)
+    STATS_NAME(disk_cache_stats, bypasses)
+STATS_NAME_END(disk_cache_stats)
+
+static uint8_t dc_data[DC_NUM_LINES][DC_LINE_SIZE];
+static struct disk_cache_line dc_lines[DC_NUM_LINES];
+
+/* Most recently used first. */
+static TAILQ_HEAD(disk_cache_line_list, disk_cache_line) dc_lru = TAILQ_HEAD_INITIALIZER(dc_lru);
+static struct disk_ops *dc_lower[MYNEWT_VAL(DISK_CACHE_MAX_DISKS)];
+static struct os_mutex dc_mtx;
+
+static int disk_cache_read(uint8_t id, uint32_t addr, void *buf,
+                           uint32_t len);
+static int disk_cache_write(uint8_t id, uint32_t addr, const void *buf,
+                            uint32_t len);
+static int disk_cache_ioctl(uint8_t id, uint32_t cmd, void *arg);
+
+static struct disk_ops disk_cache_ops = {
+    .read = disk_cache_read,
+    .write = disk_cache_write,
+    .ioctl = disk_cache_ioctl,
+};
+
+static void
+disk_cache_lock(void)
+{
+    int rc;
+
+    rc = os_mutex_pend(&dc_mtx, OS_TIMEOUT_NEVER);
+    assert(rc == 0 || rc == OS_NOT_STARTED);
+}
+
+static void
+disk_cache_unlock(void)
+{
+    int rc;
+
+    rc = os_mutex_release(&dc_mtx);
+    assert(rc == 0 || rc == OS_NOT_STARTED);
+}
+
+static struct disk_cache_line *
+disk_cache_find(uint8_t id, uint32_t line)
+{
+    struct disk_cache_line *dcl;
+
+    TAILQ_FOREACH(dcl, &dc_lru, dcl_lru) {
+        if (dcl->dcl_valid && dcl->dcl_id == id && dcl->dcl_line == line) {
+            return dcl;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+disk_cache_touch(struct disk_cache_line *dcl)
+{
+    TAILQ_REMOVE(&dc_lru, dcl, dcl_lru);
+    TAILQ_INSERT_HEAD(&dc_lru, dcl, dcl_lru);
+}
+
+/**
+ * Calls fn for every run of consecutive set bits in mask, so that each run
+ * becomes a single multi-block transfer.
+ */
+static int
+disk_cache_runs(struct disk_cache_line *dcl, uint8_t mask,
+                int (*fn)(struct disk_cache_line *dcl, int first, int cnt))
+{
+    int first;
+    int i;
+    int rc;
+
+    for (i = 0; i < DC_LINE_BLOCKS; i++) {
+        if (!(mask & (1 << i))) {
+            continue;
+        }
+        first = i;
+        while (i + 1 < DC_LINE_BLOCKS && (mask & (1 << (i + 1)))) {
+            i++;
+        }
+        rc = fn(dcl, first, i - first + 1);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
+static uint32_t
+disk_cache_addr(const struct disk_cache_line *dcl, int block)
+{
+    return (dcl->dcl_line * DC_LINE_BLOCKS + block) * DC_BLOCK_SIZE;
+}
+
+static int
+disk_cache_write_run(struct disk_cache_line *dcl, int first, int cnt)
+{
+    int rc;
+
+    rc = dc_lower[dcl->dcl_id]->write(dcl->dcl_id,
+                                      disk_cache_addr(dcl, first),
+                                      dcl->dcl_data + first * DC_BLOCK_SIZE,
+                                      cnt * DC_BLOCK_SIZE);
+    STATS_INC(disk_cache_stats, disk_writes);
+    if (rc != 0) {
+        return rc;
+    }
+
+    STATS_INCN(disk_cache_stats, write_backs, cnt);
+    dcl->dcl_dirty &= ~(((1 << cnt) - 1) << first);
+
+    return 0;
+}
+
+static int
+disk_cache_read_run(struct disk_cache_line *dcl, int first, int cnt)
+{
+    int rc;
+
+    rc = dc_lower[dcl->dcl_id]->read(dcl->dcl_id,
+                                     disk_cache_addr(dcl, first),
+                                     dcl->dcl_data + first * DC_BLOCK_SIZE,
+                                     cnt * DC_BLOCK_SIZE);
+    STATS_INC(disk_cache_stats, disk_reads);
+    if (rc != 0) {
+        return rc;
+    }
+
+    dcl->dcl_valid |= ((1 << cnt) - 1) << first;
+
+    return 0;
+}
+
+static int
+disk_cache_clean(struct disk_cache_line *dcl)
+{
+    return disk_cache_runs(dcl, dcl->dcl_dirty, disk_cache_write_run);
+}
+
+/**
+ * Takes the least recently used line for the given line number, writing
+ * it back first if needed.
+ */
+static struct disk_cache_line *
+disk_cache_alloc(uint8_t id, uint32_t line, int *out_rc)
+{
+    struct disk_cache_line *dcl;
+    int rc;
+
+    dcl = TAILQ_LAST(&dc_lru, disk_cache_line_list);
+    if (dcl->dcl_valid) {
+        rc = disk_cache_clean(dcl);
+        if (rc != 0) {
+            *out_rc = rc;
+            return NULL;
+        }
+        STATS_INC(disk_cache_stats, evictions);
+    }
+
+    dcl->dcl_id = id;
+    dcl->dcl_line = line;
+    dcl->dcl_valid = 0;
+    dcl->dcl_dirty = 0;
+    disk_cache_touch(dcl);
+
+    return dcl;
+}
+
+/**
+ * Makes the given block of the line valid.  All other missing blocks of the
+ * line are read along with it.
+ */
+static int
+disk_cache_fill(struct disk_cache_line *dcl, int block)
+{
+    uint8_t missing;
+    int rc;
+
+    missing = ~dcl->dcl_valid & ((1 << DC_LINE_BLOCKS) - 1);
+    rc = disk_cache_runs(dcl, missing, disk_cache_read_run);
+    if (rc == 0) {
+        STATS_INCN(disk_cache_stats, read_ahead,
+                   __builtin_popcount(missing) - 1);
+        return 0;
+    }
+
+    /* Possibly past the end of the disk; settle for the one block. */
+    if (!(dcl->dcl_valid & (1 << block))) {
+        rc = disk_cache_read_run(dcl, block, 1);
+    }
+
+    return rc;
+}
+
+/**
+ * Writes back and drops cached blocks in the given range.  Used before
+ * passing an unaligned transfer to the disk.
+ */
+static int
+disk_cache_drop_range(uint8_t id, uint32_t first, uint32_t cnt)
+{
+    struct disk_cache_line *dcl;
+    uint32_t last;
+    int rc;
+
+    last = first + cnt;
+    TAILQ_FOREACH(dcl, &dc_lru, dcl_lru) {
+        if (!dcl->dcl_valid || dcl->dcl_id != id ||
+            (dcl->dcl_line + 1) * DC_LINE_BLOCKS <= first ||
+            dcl->dcl_line * DC_LINE_BLOCKS >= last) {
+            continue;
+        }
+        rc = disk_cache_clean(dcl);
+        if (rc != 0) {
+            return rc;
+        }
+        dcl->dcl_valid = 0;
+    }
+
+    return 0;
+}
+
+static int
+disk_cache_passthrough(uint8_t id, uint32_t addr, void *rbuf,
+                       const void *wbuf, uint32_t len)
+{
+    uint32_t first;
+    int rc;
+
+    first = addr / DC_BLOCK_SIZE;
+    rc = disk_cache_drop_range(id, first,
+                               (addr + len + DC_BLOCK_SIZE - 1) /
+                               DC_BLOCK_SIZE - first);
+    if (rc != 0) {
+        return rc;
+    }
+
+    STATS_INC(disk_cache_stats, bypasses);
+    if (rbuf != NULL) {
+        STATS_INC(disk_cache_stats, disk_reads);
+        return dc_lower[id]->read(id, addr, rbuf, len);
+    } else {
+        STATS_INC(disk_cache_stats, disk_writes);
+        return dc_lower[id]->write(id, addr, wbuf, len);
+    }
+}
+
+/**
+ * Copies between a long transfer that went straight to the disk and the
+ * cached blocks it overlaps.  After a read the caller gets the dirty
+ * blocks; after a write the cached blocks take the new data.
+ */
+static void
+disk_cache_sync_range(uint8_t id, uint32_t first, uint32_t cnt,
+                      uint8_t *rbuf, const uint8_t *wbuf)
+{
+    struct disk_cache_line *dcl;
+    uint32_t block;
+    uint8_t bit;
+    int i;
+
+    TAILQ_FOREACH(dcl, &dc_lru, dcl_lru) {
+        if (!dcl->dcl_valid || dcl->dcl_id != id) {
+            continue;
+        }
+        for (i = 0; i < DC_LINE_BLOCKS; i++) {
+            block = dcl->dcl_line * DC_LINE_BLOCKS + i;
+            bit = 1 << i;
+            if (block < first || block >= first + cnt ||
+                !(dcl->dcl_valid & bit)) {
+                continue;
+            }
+            if (rbuf != NULL) {
+                if (dcl->dcl_dirty & bit) {
+                    memcpy(rbuf + (block - first) * DC_BLOCK_SIZE,
+                           dcl->dcl_data + i * DC_BLOCK_SIZE, DC_BLOCK_SIZE);
+                }
+            } else {
+                memcpy(dcl->dcl_data + i * DC_BLOCK_SIZE,
+                       wbuf + (block - first) * DC_BLOCK_SIZE, DC_BLOCK_SIZE);
+                dcl->dcl_dirty &= ~bit;
+            }
+        }
+    }
+}
+
+static int
+disk_cache_read(uint8_t id, uint32_t addr, void *buf, uint32_t len)
+{
+    struct disk_cache_line *dcl;
+    uint32_t block;
+    uint32_t cnt;
+    uint8_t *dst;
+    int i;
+    int rc;
+
+    if (id >= MYNEWT_VAL(DISK_CACHE_MAX_DISKS) || dc_lower[id] == NULL) {
+        return -DISK_ENOENT;
+    }
+
+    disk_cache_lock();
+
+    if (addr % DC_BLOCK_SIZE != 0 || len % DC_BLOCK_SIZE != 0) {
+        rc = disk_cache_passthrough(id, addr, buf, NULL, len);
+        goto done;
+    }
+
+    block = addr / DC_BLOCK_SIZE;
+    cnt = len / DC_BLOCK_SIZE;
+
+    if (cnt > DC_LINE_BLOCKS) {
+        STATS_INC(disk_cache_stats, bypasses);
+        STATS_INC(disk_cache_stats, disk_reads);
+        rc = dc_lower[id]->read(id, addr, buf, len);
+        if (rc == 0) {
+            disk_cache_sync_range(id, block, cnt, buf, NULL);
+        }
+        goto done;
+    }
+
+    rc = 0;
+    dst = buf;
+    for (; cnt > 0; cnt--, block++, dst += DC_BLOCK_SIZE) {
+        i = block % DC_LINE_BLOCKS;
+        dcl = disk_cache_find(id, block / DC_LINE_BLOCKS);
+        if (dcl == NULL) {
+            dcl = disk_cache_alloc(id, block / DC_LINE_BLOCKS, &rc);
+            if (dcl == NULL) {
+                break;
+            }
+        } else {
+            disk_cache_touch(dcl);
+        }
+
+        if (dcl->dcl_valid & (1 << i)) {
+            STATS_INC(disk_cache_stats, hits);
+        } else {
+            STATS_INC(disk_cache_stats, misses);
+            rc = disk_cache_fill(dcl, i);
+            if (rc != 0) {
+                break;
+            }
+        }
+        memcpy(dst, dcl->dcl_data + i * DC_BLOCK_SIZE, DC_BLOCK_SIZE);
+    }
+
+done:
+    disk_cache_unlock();
+    return rc;
+}
+
+static int
+disk_cache_write(uint8_t id, uint32_t addr, const void *buf, uint32_t len)
+{
+    struct disk_cache_line *dcl;
+    const uint8_t *src;
+    uint32_t block;
+    uint32_t cnt;
+    int i;
+    int rc;
+
+    if (id >= MYNEWT_VAL(DISK_CACHE_MAX_DISKS) || dc_lower[id] == NULL) {
+        return -DISK_ENOENT;
+    }
+
+    disk_cache_lock();
+
+    if (addr % DC_BLOCK_SIZE != 0 || len % DC_BLOCK_SIZE != 0) {
+        rc = disk_cache_passthrough(id, addr, NULL, buf, len);
+        goto done;
+    }
+
+    block = addr / DC_BLOCK_SIZE;
+    cnt = len / DC_BLOCK_SIZE;
+
+    if (cnt > DC_LINE_BLOCKS) {
+        STATS_INC(disk_cache_stats, bypasses);
+        STATS_INC(disk_cache_stats, disk_writes);
+        rc = dc_lower[id]->write(id, addr, buf, len);
+        if (rc == 0) {
+            disk_cache_sync_range(id, block, cnt, NULL, buf);
+        }
+        goto done;
+    }
+
+    rc = 0;
+    src = buf;
+    for (; cnt > 0; cnt--, block++, src += DC_BLOCK_SIZE) {
+        i = block % DC_LINE_BLOCKS;
+        /* No need to read the line; only this block becomes valid. */
+        dcl = disk_cache_find(id, block / DC_LINE_BLOCKS);
+        if (dcl == NULL) {
+            dcl = disk_cache_alloc(id, block / DC_LINE_BLOCKS, &rc);
+            if (dcl == NULL) {
+                break;
+            }
+        } else {
+            disk_cache_touch(dcl);
+        }
+
+        memcpy(dcl->dcl_data + i * DC_BLOCK_SIZE, src, DC_BLOCK_SIZE);
+        dcl->dcl_valid |= 1 << i;
+        dcl->dcl_dirty |= 1 << i;
+    }
+
+#if !MYNEWT_VAL(DISK_CACHE_WRITE_BACK)
+    if (rc == 0) {
+        block = addr / DC_BLOCK_SIZE;
+        for (cnt = 0; cnt < len / DC_BLOCK_SIZE && rc == 0;
+             cnt += DC_LINE_BLOCKS - (block + cnt) % DC_LINE_BLOCKS) {
+            dcl = disk_cache_find(id, (block + cnt) / DC_LINE_BLOCKS);
+            if (dcl != NULL) {
+                rc = disk_cache_clean(dcl);
+            }
+        }
+    }
+#endif
+
+done:
+    disk_cache_unlock();
+    return rc;
+}
+
+static int
+disk_cache_flush_locked(uint8_t id)
+{
+    struct disk_cache_line *dcl;
+    int rc;
+
+    TAILQ_FOREACH(dcl, &dc_lru, dcl_lru) {
+        if (dcl->dcl_valid && dcl->dcl_id == id && dcl->dcl_dirty) {
+            rc = disk_cache_clean(dcl);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int
+disk_cache_ioctl(uint8_t id, uint32_t cmd, void *arg)
+{
+    int rc;
+
+    if (id >= MYNEWT_VAL(DISK_CACHE_MAX_DISKS) || dc_lower[id] == NULL) {
+        return -DISK_ENOENT;
+    }
+
+    if (cmd == DISK_IOCTL_SYNC) {
+        rc = disk_cache_flush(id);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    return dc_lower[id]->ioctl(id, cmd, arg);
+}
+
+int
+disk_cache_flush(uint8_t id)
+{
+    int rc;
+
+    if (id >= MYNEWT_VAL(DISK_CACHE_MAX_DISKS) || dc_lower[id] == NULL) {
+        return -DISK_ENOENT;
+    }
+
+    disk_cache_lock();
+    rc = disk_cache_flush_locked(id);
+    disk_cache_unlock();
+
+    return rc;
+}
+
+void
+disk_cache_invalidate(uint8_t id)
+{
+    struct disk_cache_line *dcl;
+
+    disk_cache_lock();
+    TAILQ_FOREACH(dcl, &dc_lru, dcl_lru) {
+        if (dcl->dcl_id == id) {
+            dcl->dcl_valid = 0;
+            dcl->dcl_dirty = 0;
+        }
+    }
+    disk_cache_unlock();
+}
+
+struct disk_ops *
+disk_cache_wrap(uint8_t id, struct disk_ops *lower)
+{
+    if (id >= MYNEWT_VAL(DISK_CACHE_MAX_DISKS)) {
+        return NULL;
+    }
+
+    disk_cache_invalidate(id);
+    dc_lower[id] = lower;
+
+    return &disk_cache_ops;
+}
+
+void
+disk_cache_init(void)
+{
+    int rc;
+    int i;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    rc = os_mutex_init(&dc_mtx);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    memset(dc_lower, 0, sizeof(dc_lower));
+    TAILQ_INIT(&dc_lru);
+    for (i = 0; i < DC_NUM_LINES; i++) {
+        dc_lines[i].dcl_valid = 0;
+        dc_lines[i].dcl_dirty = 0;
+        dc_lines[i].dcl_data = dc_data[i];
+        TAILQ_INSERT_TAIL(&dc_lru, &dc_lines[i], dcl_lru);
+    }
+
+    rc = stats_init_and_reg(
+        STATS_HDR(disk_cache_stats),
+        STATS_SIZE_INIT_PARMS(disk_cache_stats, STATS_SIZE_32),
+        STATS_NAME_INIT_PARMS(disk_cache_stats),
+        "disk_cache");
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+
+#endif
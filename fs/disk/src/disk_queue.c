@@ -0,0 +1,136 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(DISK_ASYNC)
+
+#include <disk/disk.h>
+
+static struct disk_queue disk_queue_dflt;
+OS_TASK_STACK_DEFINE(disk_queue_dflt_stack, MYNEWT_VAL(DISK_ASYNC_STACK_SIZE));
+
+void
+disk_req_complete(struct disk_req *req, int rc)
+{
+    req->dr_rc = rc;
+
+    if (req->dr_evq != NULL) {
+        os_eventq_put(req->dr_evq, &req->dr_ev);
+    } else if (req->dr_done != NULL) {
+        req->dr_done(req);
+    }
+}
+
+static void
+disk_queue_service(struct os_event *ev)
+{
+    struct disk_req *req;
+    struct disk_ops *dops;
+    int rc;
+
+    req = ev->ev_arg;
+    dops = req->dr_dops;
+
+    switch (req->dr_op) {
+    case DISK_REQ_READ:
+        rc = dops->read(req->dr_id, req->dr_addr, req->dr_buf, req->dr_len);
+        break;
+    case DISK_REQ_WRITE:
+        rc = dops->write(req->dr_id, req->dr_addr, req->dr_buf, req->dr_len);
+        break;
+    case DISK_REQ_IOCTL:
+        rc = dops->ioctl(req->dr_id, req->dr_addr, req->dr_buf);
+        break;
+    default:
+        rc = DISK_EINVAL;
+        break;
+    }
+
+    disk_req_complete(req, rc);
+}
+
+static void
+disk_queue_task_handler(void *arg)
+{
+    struct disk_queue *dq;
+
+    dq = arg;
+    while (1) {
+        os_eventq_run(&dq->dq_evq);
+    }
+}
+
+int
+disk_queue_init(struct disk_queue *dq, const char *name, uint8_t prio,
+                os_stack_t *stack, uint16_t stack_size)
+{
+    os_eventq_init(&dq->dq_evq);
+
+    return os_task_init(&dq->dq_task, name, disk_queue_task_handler, dq,
+                        prio, OS_WAIT_FOREVER, stack, stack_size);
+}
+
+int
+disk_queue_submit(struct disk_queue *dq, struct disk_ops *dops,
+                  struct disk_req *req)
+{
+    if (req->dr_op > DISK_REQ_IOCTL) {
+        return DISK_EINVAL;
+    }
+
+    /* os_eventq_put() would silently drop a request that is still queued. */
+    if (req->dr_qev.ev_queued) {
+        return DISK_EBUSY;
+    }
+
+    req->dr_dops = dops;
+    req->dr_qev.ev_cb = disk_queue_service;
+    req->dr_qev.ev_arg = req;
+    os_eventq_put(&dq->dq_evq, &req->dr_qev);
+
+    return 0;
+}
+
+int
+disk_submit(struct disk_ops *dops, struct disk_req *req)
+{
+    if (dops->submit != NULL) {
+        return dops->submit(req->dr_id, req);
+    }
+
+    return disk_queue_submit(&disk_queue_dflt, dops, req);
+}
+
+void
+disk_queue_dflt_init(void)
+{
+    int rc;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    rc = disk_queue_init(&disk_queue_dflt, "disk_q",
+                         MYNEWT_VAL(DISK_ASYNC_TASK_PRIO),
+                         disk_queue_dflt_stack,
+                         MYNEWT_VAL(DISK_ASYNC_STACK_SIZE));
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+
+#endif
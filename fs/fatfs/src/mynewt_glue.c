@@ -631,6 +631,25 @@ disk_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
 DRESULT
 disk_ioctl(BYTE pdrv, BYTE cmd, void* buff)
 {
+    int rc;
+    struct disk_ops *dops;
+
+    if (cmd != CTRL_SYNC) {
+        return RES_OK;
+    }
+
+    dops = dops_from_handle(pdrv);
+    if (dops == NULL) {
+        return RES_NOTRDY;
+    }
+
+    /* Lets a caching layer below write back before FatFS considers the
+     * volume consistent. */
+    rc = dops->ioctl(pdrv, DISK_IOCTL_SYNC, NULL);
+    if (rc < 0) {
+        return RES_ERROR;
+    }
+
     return RES_OK;
 }
 
@@ -55,6 +55,9 @@ struct fcb {
     uint8_t f_version;  	/* Current version number of the data */
     uint8_t f_sector_cnt;	/* Number of elements in sector array */
     uint8_t f_scratch_cnt;	/* How many sectors should be kept empty */
+#if MYNEWT_VAL(FCB_ERASE_AHEAD)
+    uint8_t f_erase_ahead;	/* How many sectors to keep erased in reserve */
+#endif
     struct flash_area *f_sectors; /* Array of sectors, must be contiguous */
 
     /* Flash circular buffer internal state */
@@ -63,6 +66,14 @@ struct fcb {
     struct fcb_entry f_active;
     uint16_t f_active_id;
     uint8_t f_align;		/* writes to flash have to aligned to this */
+#if MYNEWT_VAL(FCB_ERASE_AHEAD)
+    struct flash_area *f_dirty;	/* First rotated sector not yet erased */
+    uint8_t f_dirty_cnt;	/* Number of rotated sectors not yet erased */
+    uint8_t f_ea_state;		/* Erase task's progress with f_dirty */
+    uint8_t f_ea_waiting;	/* An append waits for the erase task */
+    struct os_sem f_ea_sem;	/* Released when the erase task is done */
+    SLIST_ENTRY(fcb) f_ea_next;
+#endif
 };
 
 /**
@@ -104,9 +115,31 @@ int fcb_getnext(struct fcb *, struct fcb_entry *loc);
 
 /**
  * Erases the data from oldest sector.
+ *
+ * With erase-ahead (f_erase_ahead != 0) the sector is only dropped from the
+ * FCB here and is erased later by a background task.  A sector dropped but
+ * not yet erased when the device resets is found again by fcb_init() as the
+ * oldest sector.
  */
 int fcb_rotate(struct fcb *);
 
+#if MYNEWT_VAL(FCB_ERASE_AHEAD)
+/**
+ * Erases all sectors dropped by fcb_rotate() that the background task has
+ * not erased yet.  Blocks until done.
+ */
+int fcb_erase_ahead_flush(struct fcb *fcb);
+
+/**
+ * Erases what the FCB has dropped and removes it from the set served by
+ * the background task.  Must be called before the memory of an FCB
+ * initialized with erase-ahead is reused.  Sectors dropped after the FCB
+ * was unregistered are erased by calling this again; fcb_init() registers
+ * it again.  If an erase fails, the FCB stays registered.
+ */
+int fcb_erase_ahead_unregister(struct fcb *fcb);
+#endif
+
 /**
  * Start using the scratch block.
  */
@@ -130,7 +163,8 @@ fcb_offset_last_n(struct fcb *fcb, uint8_t entries,
         struct fcb_entry *last_n_entry);
 
 /**
- * Clears FCB passed to it
+ * Clears FCB passed to it.  With erase-ahead, the dropped sectors are
+ * erased before this returns.
  */
 int fcb_clear(struct fcb *fcb);
 
@@ -147,6 +147,10 @@ TEST_CASE_DECL(fcb_test_rotate)
 TEST_CASE_DECL(fcb_test_multiple_scratch)
 TEST_CASE_DECL(fcb_test_last_of_n)
 TEST_CASE_DECL(fcb_test_area_info)
+#if MYNEWT_VAL(FCB_ERASE_AHEAD)
+TEST_CASE_DECL(fcb_test_erase_ahead)
+TEST_CASE_DECL(fcb_test_erase_ahead_bg)
+#endif
 
 TEST_SUITE(fcb_test_all)
 {
@@ -161,6 +165,10 @@ TEST_SUITE(fcb_test_all)
     fcb_test_multiple_scratch();
     fcb_test_last_of_n();
     fcb_test_area_info();
+#if MYNEWT_VAL(FCB_ERASE_AHEAD)
+    fcb_test_erase_ahead();
+    fcb_test_erase_ahead_bg();
+#endif
 }
 
 int
@@ -0,0 +1,265 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+#if MYNEWT_VAL(FCB_ERASE_AHEAD)
+
+static int
+fcb_test_fill_active(struct fcb *fcb, uint8_t *test_data, int len)
+{
+    struct fcb_entry loc;
+    struct flash_area *fa;
+    int rc;
+
+    fa = fcb->f_active.fe_area;
+    while (1) {
+        rc = fcb_append(fcb, len, &loc);
+        if (rc != 0) {
+            return rc;
+        }
+        if (loc.fe_area != fa) {
+            /* Moved on to the next sector. */
+            rc = flash_area_write(loc.fe_area, loc.fe_data_off, test_data,
+                                  len);
+            TEST_ASSERT(rc == 0);
+            return fcb_append_finish(fcb, &loc);
+        }
+
+        rc = flash_area_write(loc.fe_area, loc.fe_data_off, test_data, len);
+        TEST_ASSERT(rc == 0);
+
+        rc = fcb_append_finish(fcb, &loc);
+        TEST_ASSERT(rc == 0);
+    }
+}
+
+TEST_CASE_SELF(fcb_test_erase_ahead)
+{
+    struct flash_area *fa;
+    struct fcb *fcb;
+    uint8_t test_data[128];
+    int cnts[4];
+    struct append_arg aa_arg = {
+        .elem_cnts = cnts
+    };
+    int rc;
+    int i;
+
+    fcb_test_wipe();
+    fcb = &test_fcb;
+    memset(fcb, 0, sizeof(*fcb));
+    fcb->f_sector_cnt = 4;
+    fcb->f_sectors = test_fcb_area;
+    fcb->f_erase_ahead = 1;
+
+    rc = fcb_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = fcb_test_append_data(sizeof(test_data), i);
+    }
+
+    /*
+     * One sector is held in reserve, so only three can be filled before the
+     * FCB asks for a rotation.
+     */
+    for (i = 0; i < 2; i++) {
+        rc = fcb_test_fill_active(fcb, test_data, sizeof(test_data));
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    rc = fcb_test_fill_active(fcb, test_data, sizeof(test_data));
+    TEST_ASSERT(rc == FCB_ERR_NOSPACE);
+    TEST_ASSERT(fcb->f_active.fe_area == &test_fcb_area[2]);
+
+    /* Rotation only drops the sector; the erase is left for later. */
+    fa = fcb->f_oldest;
+    rc = fcb_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_oldest == &test_fcb_area[1]);
+    TEST_ASSERT(fcb_sector_hdr_read(fcb, fa, NULL) == 1);
+
+    memset(cnts, 0, sizeof(cnts));
+    rc = fcb_walk(fcb, NULL, fcb_test_cnt_elems_cb, &aa_arg);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cnts[0] == 0 && cnts[1] > 0);
+
+    rc = fcb_erase_ahead_flush(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb_sector_hdr_read(fcb, fa, NULL) == 0);
+
+    /*
+     * Keep going around the ring without letting the erase task run.
+     * Sectors still waiting are erased when appends get to them.
+     */
+    for (i = 0; i < 8; i++) {
+        rc = fcb_test_fill_active(fcb, test_data, sizeof(test_data));
+        if (rc == FCB_ERR_NOSPACE) {
+            rc = fcb_rotate(fcb);
+            TEST_ASSERT_FATAL(rc == 0);
+            rc = fcb_test_fill_active(fcb, test_data, sizeof(test_data));
+        }
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /* Dropped sectors are not walked. */
+    memset(cnts, 0, sizeof(cnts));
+    rc = fcb_walk(fcb, NULL, fcb_test_cnt_elems_cb, &aa_arg);
+    TEST_ASSERT(rc == 0);
+    for (i = 0; i < fcb->f_dirty_cnt; i++) {
+        fa = &test_fcb_area[(fcb->f_dirty - test_fcb_area + i) % 4];
+        TEST_ASSERT(cnts[fa - test_fcb_area] == 0);
+    }
+
+    /* Dropped sectors are erased before a new fcb_init() scans them. */
+    rc = fcb_init(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_dirty_cnt == 0);
+
+    /*
+     * Registration happens once however many times the FCB is initialized;
+     * a single unregister takes it out, erasing what it had dropped.
+     */
+    rc = fcb_init(fcb);
+    TEST_ASSERT(rc == 0);
+    rc = fcb_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_dirty_cnt == 1);
+    rc = fcb_erase_ahead_unregister(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_dirty_cnt == 0);
+
+    /* Sectors dropped after that are erased by unregistering again. */
+    rc = fcb_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_dirty_cnt == 1);
+    rc = fcb_erase_ahead_unregister(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_dirty_cnt == 0);
+
+    /* A failed erase leaves the sector dropped, and it is tried again. */
+    rc = fcb_init(fcb);
+    TEST_ASSERT(rc == 0);
+    fa = fcb->f_oldest;
+    rc = fcb_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+    fa->fa_device_id = 0xff;
+    rc = fcb_erase_ahead_flush(fcb);
+    TEST_ASSERT(rc == FCB_ERR_FLASH);
+    TEST_ASSERT(fcb->f_dirty_cnt == 1 && fcb->f_dirty == fa);
+    rc = fcb_erase_ahead_unregister(fcb);
+    TEST_ASSERT(rc == FCB_ERR_FLASH);
+    fa->fa_device_id = test_fcb_area[0].fa_device_id;
+    rc = fcb_erase_ahead_flush(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_dirty_cnt == 0);
+
+    /* Clearing erases the data; it does not come back with fcb_init(). */
+    rc = fcb_test_fill_active(fcb, test_data, sizeof(test_data));
+    TEST_ASSERT(rc == 0);
+    rc = fcb_clear(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_dirty_cnt == 0);
+    rc = fcb_init(fcb);
+    TEST_ASSERT(rc == 0);
+    memset(cnts, 0, sizeof(cnts));
+    rc = fcb_walk(fcb, NULL, fcb_test_cnt_elems_cb, &aa_arg);
+    TEST_ASSERT(rc == 0);
+    for (i = 0; i < 4; i++) {
+        TEST_ASSERT(cnts[i] == 0);
+    }
+
+    rc = fcb_erase_ahead_unregister(fcb);
+    TEST_ASSERT(rc == 0);
+}
+
+static struct os_sem fcb_test_ea_busy;
+static struct os_sem fcb_test_ea_gate;
+static int fcb_test_ea_hook_calls;
+
+/* Holds the erase task between taking a sector and erasing it. */
+static void
+fcb_test_ea_hook(struct fcb *fcb)
+{
+    fcb_test_ea_hook_calls++;
+    os_sem_release(&fcb_test_ea_busy);
+    os_sem_pend(&fcb_test_ea_gate, OS_TIMEOUT_NEVER);
+}
+
+TEST_CASE_TASK(fcb_test_erase_ahead_bg)
+{
+    struct fcb *fcb;
+    uint8_t test_data[128];
+    int rc;
+    int i;
+
+    fcb_test_wipe();
+    fcb = &test_fcb;
+    memset(fcb, 0, sizeof(*fcb));
+    fcb->f_sector_cnt = 4;
+    fcb->f_sectors = test_fcb_area;
+    fcb->f_erase_ahead = 1;
+
+    rc = fcb_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = os_sem_init(&fcb_test_ea_busy, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_sem_init(&fcb_test_ea_gate, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = fcb_test_append_data(sizeof(test_data), i);
+    }
+    for (i = 0; i < 2; i++) {
+        rc = fcb_test_fill_active(fcb, test_data, sizeof(test_data));
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    rc = fcb_test_fill_active(fcb, test_data, sizeof(test_data));
+    TEST_ASSERT_FATAL(rc == FCB_ERR_NOSPACE);
+
+    /* Drop sector 0, and let the erase task get as far as erasing it. */
+    fcb_test_ea_hook_calls = 0;
+    fcb_ea_erase_test_hook = fcb_test_ea_hook;
+    rc = fcb_rotate(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_sem_pend(&fcb_test_ea_busy, OS_TIMEOUT_NEVER);
+    TEST_ASSERT(fcb_test_ea_hook_calls == 1);
+
+    /*
+     * Appends moving on to the erased reserve sector go through while the
+     * erase is in progress.
+     */
+    rc = fcb_test_fill_active(fcb, test_data, sizeof(test_data));
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_active.fe_area == &test_fcb_area[3]);
+    TEST_ASSERT(fcb_sector_hdr_read(fcb, &test_fcb_area[0], NULL) == 1);
+
+    /* Needing the sector being erased waits for the erase task. */
+    os_sem_release(&fcb_test_ea_gate);
+    rc = fcb_erase_ahead_flush(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_dirty_cnt == 0);
+    TEST_ASSERT(fcb_sector_hdr_read(fcb, &test_fcb_area[0], NULL) == 0);
+    fcb_ea_erase_test_hook = NULL;
+
+    rc = fcb_erase_ahead_unregister(fcb);
+    TEST_ASSERT(rc == 0);
+}
+
+#endif
@@ -38,6 +38,17 @@ fcb_init(struct fcb *fcb)
     if (!fcb->f_sectors || fcb->f_sector_cnt - fcb->f_scratch_cnt < 1) {
         return FCB_ERR_ARGS;
     }
+#if MYNEWT_VAL(FCB_ERASE_AHEAD)
+    if (fcb->f_erase_ahead) {
+        if (fcb->f_sector_cnt - fcb->f_scratch_cnt - fcb->f_erase_ahead < 1) {
+            return FCB_ERR_ARGS;
+        }
+        rc = fcb_ea_register(fcb);
+        if (rc) {
+            return rc;
+        }
+    }
+#endif
 
     /* Fill last used, first used */
     for (i = 0; i < fcb->f_sector_cnt; i++) {
@@ -263,5 +274,11 @@ fcb_clear(struct fcb *fcb)
             break;
         }
     }
+#if MYNEWT_VAL(FCB_ERASE_AHEAD)
+    /* The data must be gone from flash, not only from the FCB. */
+    if (rc == 0 && fcb->f_erase_ahead) {
+        rc = fcb_erase_ahead_flush(fcb);
+    }
+#endif
     return rc;
 }
@@ -56,6 +56,14 @@ fcb_append_to_scratch(struct fcb *fcb)
     if (!fa) {
         return FCB_ERR_NOSPACE;
     }
+#if MYNEWT_VAL(FCB_ERASE_AHEAD)
+    if (fcb->f_erase_ahead) {
+        rc = fcb_ea_prepare(fcb, fa);
+        if (rc) {
+            return rc;
+        }
+    }
+#endif
     rc = fcb_sector_hdr_init(fcb, fa, fcb->f_active_id + 1);
     if (rc) {
         return rc;
@@ -72,6 +80,7 @@ fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
     struct fcb_entry *active;
     struct flash_area *fa;
     uint8_t tmp_str[2];
+    int reserve;
     int cnt;
     int rc;
 
@@ -88,12 +97,28 @@ fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
     }
     active = &fcb->f_active;
     if (active->fe_elem_off + len + cnt > active->fe_area->fa_size) {
-        fa = fcb_new_area(fcb, fcb->f_scratch_cnt);
+        reserve = fcb->f_scratch_cnt;
+#if MYNEWT_VAL(FCB_ERASE_AHEAD)
+        /*
+         * Have the caller rotate early, so that the sector after the new
+         * active one is erased in the background by the time it is needed.
+         */
+        reserve += fcb->f_erase_ahead;
+#endif
+        fa = fcb_new_area(fcb, reserve);
         if (!fa || (fa->fa_size <
             sizeof(struct fcb_disk_area) + len + cnt)) {
             rc = FCB_ERR_NOSPACE;
             goto err;
         }
+#if MYNEWT_VAL(FCB_ERASE_AHEAD)
+        if (fcb->f_erase_ahead) {
+            rc = fcb_ea_prepare(fcb, fa);
+            if (rc) {
+                goto err;
+            }
+        }
+#endif
         rc = fcb_sector_hdr_init(fcb, fa, fcb->f_active_id + 1);
         if (rc) {
             goto err;
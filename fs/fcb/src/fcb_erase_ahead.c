@@ -0,0 +1,425 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(FCB_ERASE_AHEAD)
+
+#include "fcb/fcb.h"
+#include "fcb_priv.h"
+#include "stats/stats.h"
+
+/*
+ * Sectors dropped by fcb_rotate() form a run that ends just before
+ * f_oldest: f_dirty is the first of them, f_dirty_cnt the run length.
+ * Sectors between the active one and f_dirty are erased.  The run is
+ * extended and shrunk only with f_mtx held.
+ *
+ * The erase task does not hold f_mtx while it erases, so that appends going
+ * to an erased sector are not held up.  It marks the head of the run
+ * FCB_EA_BUSY under f_mtx, erases it, and marks it FCB_EA_DONE in a
+ * critical section.  Whoever holds f_mtx next takes the sector off the run.
+ * An append needing the sector being erased waits on f_ea_sem; it registers
+ * as a waiter in the same critical section where it sees FCB_EA_BUSY.
+ *
+ * fcb_ea_mtx protects the list of registered FCBs; the erase task holds it
+ * while going through the list, so an FCB is not unregistered under it.
+ * Lock order is fcb_ea_mtx, then f_mtx.
+ *
+ * A sector that fails to erase stays at the head of the run.  The task
+ * gives up on that FCB until the next rotation wakes it up; an append
+ * needing the sector retries the erase and gets the error.
+ */
+#define FCB_EA_IDLE     0
+#define FCB_EA_BUSY     1       /* Head of the run is being erased */
+#define FCB_EA_DONE     2       /* Head of the run erased, still in the run */
+
+static SLIST_HEAD(, fcb) fcb_ea_list = SLIST_HEAD_INITIALIZER(fcb_ea_list);
+static struct os_mutex fcb_ea_mtx;
+static struct os_sem fcb_ea_sem;
+static struct os_task fcb_ea_task;
+OS_TASK_STACK_DEFINE(fcb_ea_stack, MYNEWT_VAL(FCB_ERASE_AHEAD_STACK_SIZE));
+
+STATS_SECT_START(fcb_ea_stats)
+    STATS_SECT_ENTRY(erases)
+    STATS_SECT_ENTRY(erase_fails)
+STATS_SECT_END
+static STATS_SECT_DECL(fcb_ea_stats) fcb_ea_stats;
+STATS_NAME_START(fcb_ea_stats)
+    STATS_NAME(fcb_ea_stats, erases)
+    STATS_NAME(fcb_ea_stats, erase_fails)
+STATS_NAME_END(fcb_ea_stats)
+
+#if MYNEWT_VAL(SELFTEST)
+void (*fcb_ea_erase_test_hook)(struct fcb *fcb);
+#endif
+
+static struct flash_area *
+fcb_ea_first_dirty(struct fcb *fcb)
+{
+    return fcb->f_dirty_cnt ? fcb->f_dirty : NULL;
+}
+
+/*
+ * Takes the first dropped sector off the run.  Must be called with f_mtx
+ * held.
+ */
+static void
+fcb_ea_pop(struct fcb *fcb)
+{
+    fcb->f_dirty = fcb_getnext_area(fcb, fcb->f_dirty);
+    fcb->f_dirty_cnt--;
+}
+
+/*
+ * Completes an erase finished by the erase task.  Must be called with f_mtx
+ * held.
+ */
+static void
+fcb_ea_settle(struct fcb *fcb)
+{
+    if (fcb->f_ea_state == FCB_EA_DONE) {
+        fcb->f_ea_state = FCB_EA_IDLE;
+        fcb_ea_pop(fcb);
+    }
+}
+
+static int
+fcb_ea_erase(struct flash_area *fap)
+{
+    int rc;
+
+    rc = flash_area_erase(fap, 0, fap->fa_size);
+    if (rc) {
+        STATS_INC(fcb_ea_stats, erase_fails);
+        return FCB_ERR_FLASH;
+    }
+    STATS_INC(fcb_ea_stats, erases);
+
+    return 0;
+}
+
+/*
+ * Erases the first dropped sector.  Must be called with f_mtx held, and
+ * not while the erase task is at it.
+ */
+static int
+fcb_ea_erase_first(struct fcb *fcb, struct flash_area *fap)
+{
+    int rc;
+
+    rc = fcb_ea_erase(fap);
+    if (rc) {
+        return rc;
+    }
+    fcb_ea_pop(fcb);
+
+    return 0;
+}
+
+/*
+ * Waits for the erase task to finish with the first dropped sector.  Called
+ * with f_mtx held; the task does not need it to finish the erase.
+ */
+static void
+fcb_ea_wait(struct fcb *fcb)
+{
+    os_sr_t sr;
+    int wait;
+
+    OS_ENTER_CRITICAL(sr);
+    wait = fcb->f_ea_state == FCB_EA_BUSY;
+    if (wait) {
+        fcb->f_ea_waiting = 1;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (wait) {
+        os_sem_pend(&fcb->f_ea_sem, OS_TIMEOUT_NEVER);
+    }
+    fcb_ea_settle(fcb);
+}
+
+/*
+ * Erases all dropped sectors.  Must be called with f_mtx held.
+ */
+static int
+fcb_ea_erase_all(struct fcb *fcb)
+{
+    struct flash_area *fap;
+    int rc;
+
+    while ((fap = fcb_ea_first_dirty(fcb)) != NULL) {
+        rc = fcb_ea_prepare(fcb, fap);
+        if (rc) {
+            return rc;
+        }
+    }
+    return 0;
+}
+
+static int
+fcb_ea_lock(struct os_mutex *mtx)
+{
+    int rc;
+
+    rc = os_mutex_pend(mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+    return 0;
+}
+
+static struct fcb *
+fcb_ea_find(struct fcb *fcb)
+{
+    struct fcb *cur;
+
+    SLIST_FOREACH(cur, &fcb_ea_list, f_ea_next) {
+        if (cur == fcb) {
+            break;
+        }
+    }
+    return cur;
+}
+
+/*
+ * Makes sure that the given sector, about to be taken into use, is erased.
+ * Only does work if it is still waiting for the erase task, and only waits
+ * for the task if it is erasing this sector.  Called with f_mtx held.
+ */
+int
+fcb_ea_prepare(struct fcb *fcb, struct flash_area *fap)
+{
+    fcb_ea_settle(fcb);
+    if (fcb_ea_first_dirty(fcb) != fap) {
+        return 0;
+    }
+    if (fcb->f_ea_state == FCB_EA_BUSY) {
+        fcb_ea_wait(fcb);
+        if (fcb_ea_first_dirty(fcb) != fap) {
+            return 0;
+        }
+    }
+    return fcb_ea_erase_first(fcb, fap);
+}
+
+/*
+ * fcb_rotate() with erase-ahead.  Called with f_mtx held.
+ */
+int
+fcb_ea_rotate(struct fcb *fcb)
+{
+    struct flash_area *fap;
+    struct flash_area *next;
+    int rc;
+
+    fap = fcb->f_oldest;
+    next = fcb_getnext_area(fcb, fap);
+    if (fap == fcb->f_active.fe_area) {
+        /*
+         * Need to create a new active area, as we're dropping the current.
+         */
+        rc = fcb_ea_prepare(fcb, next);
+        if (rc) {
+            return rc;
+        }
+        rc = fcb_sector_hdr_init(fcb, next, fcb->f_active_id + 1);
+        if (rc) {
+            return rc;
+        }
+        fcb->f_active.fe_area = next;
+        fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
+        fcb->f_active_id++;
+    }
+
+    if (fcb->f_dirty_cnt++ == 0) {
+        fcb->f_dirty = fap;
+    }
+    fcb->f_oldest = next;
+
+    os_sem_release(&fcb_ea_sem);
+
+    return 0;
+}
+
+int
+fcb_erase_ahead_flush(struct fcb *fcb)
+{
+    int rc;
+
+    rc = fcb_ea_lock(&fcb->f_mtx);
+    if (rc) {
+        return rc;
+    }
+    rc = fcb_ea_erase_all(fcb);
+    os_mutex_release(&fcb->f_mtx);
+
+    return rc;
+}
+
+/*
+ * Adds the FCB to the set served by the erase task, unless it is there
+ * already.  Called by fcb_init() before it scans the sectors, and before
+ * f_mtx is initialized.
+ */
+int
+fcb_ea_register(struct fcb *fcb)
+{
+    int rc;
+
+    rc = fcb_ea_lock(&fcb_ea_mtx);
+    if (rc) {
+        return rc;
+    }
+
+    if (fcb_ea_find(fcb) != NULL) {
+        /*
+         * Initialized again; finish what the previous instance dropped.
+         * The erase task is kept out by fcb_ea_mtx, and nothing else may
+         * use the FCB while it is being initialized.
+         */
+        rc = fcb_ea_erase_all(fcb);
+    } else {
+        fcb->f_dirty_cnt = 0;
+        fcb->f_ea_state = FCB_EA_IDLE;
+        fcb->f_ea_waiting = 0;
+        rc = os_sem_init(&fcb->f_ea_sem, 0);
+        if (rc) {
+            rc = FCB_ERR_ARGS;
+        } else {
+            SLIST_INSERT_HEAD(&fcb_ea_list, fcb, f_ea_next);
+        }
+    }
+
+    os_mutex_release(&fcb_ea_mtx);
+
+    return rc;
+}
+
+int
+fcb_erase_ahead_unregister(struct fcb *fcb)
+{
+    int rc;
+
+    rc = fcb_ea_lock(&fcb_ea_mtx);
+    if (rc) {
+        return rc;
+    }
+
+    rc = fcb_erase_ahead_flush(fcb);
+    if (rc == 0 && fcb_ea_find(fcb) != NULL) {
+        SLIST_REMOVE(&fcb_ea_list, fcb, fcb, f_ea_next);
+    }
+
+    os_mutex_release(&fcb_ea_mtx);
+
+    return rc;
+}
+
+/*
+ * Erases the first dropped sector of the FCB in the background.  Returns
+ * non-zero if there was nothing to do, or the erase failed.
+ */
+static int
+fcb_ea_erase_next(struct fcb *fcb)
+{
+    struct flash_area *fap;
+    os_sr_t sr;
+    int waiting;
+    int rc;
+
+    os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    fcb_ea_settle(fcb);
+    fap = fcb_ea_first_dirty(fcb);
+    if (fap != NULL) {
+        fcb->f_ea_state = FCB_EA_BUSY;
+    }
+    os_mutex_release(&fcb->f_mtx);
+    if (fap == NULL) {
+        return 1;
+    }
+
+#if MYNEWT_VAL(SELFTEST)
+    if (fcb_ea_erase_test_hook != NULL) {
+        fcb_ea_erase_test_hook(fcb);
+    }
+#endif
+    rc = fcb_ea_erase(fap);
+
+    OS_ENTER_CRITICAL(sr);
+    fcb->f_ea_state = rc ? FCB_EA_IDLE : FCB_EA_DONE;
+    waiting = fcb->f_ea_waiting;
+    fcb->f_ea_waiting = 0;
+    OS_EXIT_CRITICAL(sr);
+
+    if (waiting) {
+        os_sem_release(&fcb->f_ea_sem);
+    }
+
+    return rc;
+}
+
+static void
+fcb_ea_task_handler(void *arg)
+{
+    struct fcb *fcb;
+
+    while (1) {
+        os_sem_pend(&fcb_ea_sem, OS_TIMEOUT_NEVER);
+
+        os_mutex_pend(&fcb_ea_mtx, OS_WAIT_FOREVER);
+        SLIST_FOREACH(fcb, &fcb_ea_list, f_ea_next) {
+            /*
+             * One sector at a time; a failing erase is not retried in a
+             * loop.
+             */
+            while (fcb_ea_erase_next(fcb) == 0) {
+            }
+        }
+        os_mutex_release(&fcb_ea_mtx);
+    }
+}
+
+void
+fcb_erase_ahead_init(void)
+{
+    int rc;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    rc = os_mutex_init(&fcb_ea_mtx);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+    rc = os_sem_init(&fcb_ea_sem, 0);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    rc = stats_init_and_reg(STATS_HDR(fcb_ea_stats),
+                            STATS_SIZE_INIT_PARMS(fcb_ea_stats, STATS_SIZE_32),
+                            STATS_NAME_INIT_PARMS(fcb_ea_stats),
+                            "fcb_ea");
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    rc = os_task_init(&fcb_ea_task, "fcb_ea", fcb_ea_task_handler, NULL,
+                      MYNEWT_VAL(FCB_ERASE_AHEAD_TASK_PRIO), OS_WAIT_FOREVER,
+                      fcb_ea_stack, MYNEWT_VAL(FCB_ERASE_AHEAD_STACK_SIZE));
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+
+#endif
@@ -58,6 +58,17 @@ int fcb_sector_hdr_init(struct fcb *, struct flash_area *fap, uint16_t id);
 int fcb_sector_hdr_read(struct fcb *, struct flash_area *fap,
   struct fcb_disk_area *fdap);
 
+#if MYNEWT_VAL(FCB_ERASE_AHEAD)
+int fcb_ea_register(struct fcb *fcb);
+int fcb_ea_prepare(struct fcb *fcb, struct flash_area *fap);
+int fcb_ea_rotate(struct fcb *fcb);
+
+#if MYNEWT_VAL(SELFTEST)
+/* Called by the erase task before each erase, without f_mtx held. */
+extern void (*fcb_ea_erase_test_hook)(struct fcb *fcb);
+#endif
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -31,6 +31,13 @@ fcb_rotate(struct fcb *fcb)
         return FCB_ERR_ARGS;
     }
 
+#if MYNEWT_VAL(FCB_ERASE_AHEAD)
+    if (fcb->f_erase_ahead) {
+        rc = fcb_ea_rotate(fcb);
+        goto out;
+    }
+#endif
+
     rc = flash_area_erase(fcb->f_oldest, 0, fcb->f_oldest->fa_size);
     if (rc) {
         rc = FCB_ERR_FLASH;
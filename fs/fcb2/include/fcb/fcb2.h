@@ -65,6 +65,9 @@ struct fcb2 {
     uint32_t f_magic;       /* As placed on the disk */
     uint8_t f_version;      /* Current version number of the data */
     uint8_t f_scratch_cnt;  /* How many sectors should be kept empty */
+#if MYNEWT_VAL(FCB2_ERASE_AHEAD)
+    uint8_t f_erase_ahead;  /* How many sectors to keep erased in reserve */
+#endif
     uint8_t f_range_cnt;    /* Number of elements in range array */
     uint16_t f_sector_cnt;  /* Number of sectors used by fcb */
     uint16_t f_oldest_sec;  /* Index of oldest sector */
@@ -74,6 +77,14 @@ struct fcb2 {
     struct os_mutex f_mtx;	/* Locking for accessing the FCB data */
     struct fcb2_entry f_active;
     uint16_t f_active_id;
+#if MYNEWT_VAL(FCB2_ERASE_AHEAD)
+    uint16_t f_dirty_sec;   /* First rotated sector not yet erased */
+    uint16_t f_dirty_cnt;   /* Number of rotated sectors not yet erased */
+    uint8_t f_ea_state;     /* Erase task's progress with f_dirty_sec */
+    uint8_t f_ea_waiting;   /* An append waits for the erase task */
+    struct os_sem f_ea_sem; /* Released when the erase task is done */
+    SLIST_ENTRY(fcb2) f_ea_next;
+#endif
 };
 
 /**
@@ -224,12 +235,42 @@ int fcb2_read(struct fcb2_entry *loc, uint16_t off, void *buf, uint16_t len);
 /**
  * Erases the data from oldest sector.
  *
+ * With erase-ahead (f_erase_ahead != 0) the sector is only dropped from the
+ * FCB here and is erased later by a background task.  A sector dropped but
+ * not yet erased when the device resets is found again by fcb2_init() as the
+ * oldest sector.
+ *
  * @param fcb            FCB where to erase the sector
  *
  * @return 0 on success. Otherwise one of FCB2_XXX error codes.
  */
 int fcb2_rotate(struct fcb2 *fcb);
 
+#if MYNEWT_VAL(FCB2_ERASE_AHEAD)
+/**
+ * Erases all sectors dropped by fcb2_rotate() that the background task has
+ * not erased yet.  Blocks until done.
+ *
+ * @param fcb            FCB whose dropped sectors to erase
+ *
+ * @return 0 on success. Otherwise one of FCB2_XXX error codes.
+ */
+int fcb2_erase_ahead_flush(struct fcb2 *fcb);
+
+/**
+ * Erases what the FCB has dropped and removes it from the set served by
+ * the background task.  Must be called before the memory of an FCB
+ * initialized with erase-ahead is reused.  Sectors dropped after the FCB
+ * was unregistered are erased by calling this again; fcb2_init() registers
+ * it again.  If an erase fails, the FCB stays registered.
+ *
+ * @param fcb            FCB to remove
+ *
+ * @return 0 on success. Otherwise one of FCB2_XXX error codes.
+ */
+int fcb2_erase_ahead_unregister(struct fcb2 *fcb);
+#endif
+
 /**
  * Start using the scratch block.
  *
@@ -285,7 +326,8 @@ int fcb2_sector_erase(const struct fcb2 *fcb, int sector);
 int fcb2_get_total_size(const struct fcb2 *fcb);
 
 /**
- * Empty the FCB
+ * Empty the FCB.  With erase-ahead, the dropped sectors are erased before
+ * this returns.
  *
  * @param fcb            FCB to clear
  *
@@ -142,6 +142,10 @@ TEST_CASE_DECL(fcb_test_multiple_scratch)
 TEST_CASE_DECL(fcb_test_last_of_n)
 TEST_CASE_DECL(fcb_test_area_info)
 TEST_CASE_DECL(fcb_test_getprev)
+#if MYNEWT_VAL(FCB2_ERASE_AHEAD)
+TEST_CASE_DECL(fcb_test_erase_ahead)
+TEST_CASE_DECL(fcb_test_erase_ahead_bg)
+#endif
 
 TEST_SUITE(fcb_test_all)
 {
@@ -156,6 +160,10 @@ TEST_SUITE(fcb_test_all)
     fcb_test_last_of_n();
     fcb_test_area_info();
     fcb_test_getprev();
+#if MYNEWT_VAL(FCB2_ERASE_AHEAD)
+    fcb_test_erase_ahead();
+    fcb_test_erase_ahead_bg();
+#endif
 }
 
 int
@@ -0,0 +1,270 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+#if MYNEWT_VAL(FCB2_ERASE_AHEAD)
+
+static int
+fcb_test_fill_active(struct fcb2 *fcb, uint8_t *test_data, int len)
+{
+    struct fcb2_entry loc;
+    int sector;
+    int rc;
+
+    sector = fcb->f_active.fe_sector;
+    while (1) {
+        rc = fcb2_append(fcb, len, &loc);
+        if (rc != 0) {
+            return rc;
+        }
+
+        rc = fcb2_write(&loc, 0, test_data, len);
+        TEST_ASSERT(rc == 0);
+
+        rc = fcb2_append_finish(&loc);
+        TEST_ASSERT(rc == 0);
+
+        if (loc.fe_sector != sector) {
+            /* Moved on to the next sector. */
+            return 0;
+        }
+    }
+}
+
+TEST_CASE_SELF(fcb_test_erase_ahead)
+{
+    struct fcb2 *fcb;
+    uint8_t test_data[128];
+    int cnts[4];
+    struct append_arg aa_arg = {
+        .elem_cnts = cnts
+    };
+    int sector;
+    int rc;
+    int i;
+
+    fcb_test_wipe();
+    fcb = &test_fcb;
+    memset(fcb, 0, sizeof(*fcb));
+    fcb->f_sector_cnt = 4;
+    fcb->f_ranges = test_fcb_ranges;
+    fcb->f_range_cnt = 1;
+    fcb->f_erase_ahead = 1;
+    test_fcb_ranges[0].fsr_sector_count = 4;
+    test_fcb_ranges[0].fsr_flash_area.fa_size =
+        test_fcb_ranges[0].fsr_sector_size * 4;
+
+    rc = fcb2_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = fcb_test_append_data(sizeof(test_data), i);
+    }
+
+    /*
+     * One sector is held in reserve, so only three can be filled before the
+     * FCB asks for a rotation.
+     */
+    for (i = 0; i < 2; i++) {
+        rc = fcb_test_fill_active(fcb, test_data, sizeof(test_data));
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    rc = fcb_test_fill_active(fcb, test_data, sizeof(test_data));
+    TEST_ASSERT(rc == FCB2_ERR_NOSPACE);
+    TEST_ASSERT(fcb->f_active.fe_sector == 2);
+
+    /* Rotation only drops the sector; the erase is left for later. */
+    rc = fcb2_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_oldest_sec == 1);
+    TEST_ASSERT(fcb2_sector_hdr_read(fcb, test_fcb_ranges, 0, NULL) == 1);
+
+    memset(cnts, 0, sizeof(cnts));
+    rc = fcb2_walk(fcb, FCB2_SECTOR_OLDEST, fcb_test_cnt_elems_cb, &aa_arg);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cnts[0] == 0 && cnts[1] > 0);
+
+    rc = fcb2_erase_ahead_flush(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb2_sector_hdr_read(fcb, test_fcb_ranges, 0, NULL) == 0);
+
+    /*
+     * Keep going around the ring without letting the erase task run.
+     * Sectors still waiting are erased when appends get to them.
+     */
+    for (i = 0; i < 8; i++) {
+        rc = fcb_test_fill_active(fcb, test_data, sizeof(test_data));
+        if (rc == FCB2_ERR_NOSPACE) {
+            rc = fcb2_rotate(fcb);
+            TEST_ASSERT_FATAL(rc == 0);
+            rc = fcb_test_fill_active(fcb, test_data, sizeof(test_data));
+        }
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /* Dropped sectors are not walked. */
+    memset(cnts, 0, sizeof(cnts));
+    rc = fcb2_walk(fcb, FCB2_SECTOR_OLDEST, fcb_test_cnt_elems_cb, &aa_arg);
+    TEST_ASSERT(rc == 0);
+    for (i = 0; i < fcb->f_dirty_cnt; i++) {
+        sector = (fcb->f_dirty_sec + i) % 4;
+        TEST_ASSERT(cnts[sector] == 0);
+    }
+
+    /* Dropped sectors are erased before a new fcb2_init() scans them. */
+    rc = fcb2_init(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_dirty_cnt == 0);
+
+    /*
+     * Registration happens once however many times the FCB is initialized;
+     * a single unregister takes it out, erasing what it had dropped.
+     */
+    rc = fcb2_init(fcb);
+    TEST_ASSERT(rc == 0);
+    rc = fcb2_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_dirty_cnt == 1);
+    rc = fcb2_erase_ahead_unregister(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_dirty_cnt == 0);
+
+    /* Sectors dropped after that are erased by unregistering again. */
+    rc = fcb2_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_dirty_cnt == 1);
+    rc = fcb2_erase_ahead_unregister(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_dirty_cnt == 0);
+
+    /* A failed erase leaves the sector dropped, and it is tried again. */
+    rc = fcb2_init(fcb);
+    TEST_ASSERT(rc == 0);
+    sector = fcb->f_oldest_sec;
+    rc = fcb2_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+    test_fcb_ranges[0].fsr_flash_area.fa_device_id = 0xff;
+    rc = fcb2_erase_ahead_flush(fcb);
+    TEST_ASSERT(rc == FCB2_ERR_FLASH);
+    TEST_ASSERT(fcb->f_dirty_cnt == 1 && fcb->f_dirty_sec == sector);
+    rc = fcb2_erase_ahead_unregister(fcb);
+    TEST_ASSERT(rc == FCB2_ERR_FLASH);
+    test_fcb_ranges[0].fsr_flash_area.fa_device_id = 0;
+    rc = fcb2_erase_ahead_flush(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_dirty_cnt == 0);
+
+    /* Clearing erases the data; it does not come back with fcb2_init(). */
+    rc = fcb_test_fill_active(fcb, test_data, sizeof(test_data));
+    TEST_ASSERT(rc == 0);
+    rc = fcb2_clear(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_dirty_cnt == 0);
+    rc = fcb2_init(fcb);
+    TEST_ASSERT(rc == 0);
+    memset(cnts, 0, sizeof(cnts));
+    rc = fcb2_walk(fcb, FCB2_SECTOR_OLDEST, fcb_test_cnt_elems_cb, &aa_arg);
+    TEST_ASSERT(rc == 0);
+    for (i = 0; i < 4; i++) {
+        TEST_ASSERT(cnts[i] == 0);
+    }
+
+    rc = fcb2_erase_ahead_unregister(fcb);
+    TEST_ASSERT(rc == 0);
+}
+
+static struct os_sem fcb_test_ea_busy;
+static struct os_sem fcb_test_ea_gate;
+static int fcb_test_ea_hook_calls;
+
+/* Holds the erase task between taking a sector and erasing it. */
+static void
+fcb_test_ea_hook(struct fcb2 *fcb)
+{
+    fcb_test_ea_hook_calls++;
+    os_sem_release(&fcb_test_ea_busy);
+    os_sem_pend(&fcb_test_ea_gate, OS_TIMEOUT_NEVER);
+}
+
+TEST_CASE_TASK(fcb_test_erase_ahead_bg)
+{
+    struct fcb2 *fcb;
+    uint8_t test_data[128];
+    int rc;
+    int i;
+
+    fcb_test_wipe();
+    fcb = &test_fcb;
+    memset(fcb, 0, sizeof(*fcb));
+    fcb->f_sector_cnt = 4;
+    fcb->f_ranges = test_fcb_ranges;
+    fcb->f_range_cnt = 1;
+    fcb->f_erase_ahead = 1;
+    test_fcb_ranges[0].fsr_sector_count = 4;
+    test_fcb_ranges[0].fsr_flash_area.fa_size =
+        test_fcb_ranges[0].fsr_sector_size * 4;
+
+    rc = fcb2_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = os_sem_init(&fcb_test_ea_busy, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_sem_init(&fcb_test_ea_gate, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = fcb_test_append_data(sizeof(test_data), i);
+    }
+    for (i = 0; i < 2; i++) {
+        rc = fcb_test_fill_active(fcb, test_data, sizeof(test_data));
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    rc = fcb_test_fill_active(fcb, test_data, sizeof(test_data));
+    TEST_ASSERT_FATAL(rc == FCB2_ERR_NOSPACE);
+
+    /* Drop sector 0, and let the erase task get as far as erasing it. */
+    fcb_test_ea_hook_calls = 0;
+    fcb2_ea_erase_test_hook = fcb_test_ea_hook;
+    rc = fcb2_rotate(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_sem_pend(&fcb_test_ea_busy, OS_TIMEOUT_NEVER);
+    TEST_ASSERT(fcb_test_ea_hook_calls == 1);
+
+    /*
+     * Appends moving on to the erased reserve sector go through while the
+     * erase is in progress.
+     */
+    rc = fcb_test_fill_active(fcb, test_data, sizeof(test_data));
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_active.fe_sector == 3);
+    TEST_ASSERT(fcb2_sector_hdr_read(fcb, test_fcb_ranges, 0, NULL) == 1);
+
+    /* Needing the sector being erased waits for the erase task. */
+    os_sem_release(&fcb_test_ea_gate);
+    rc = fcb2_erase_ahead_flush(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_dirty_cnt == 0);
+    TEST_ASSERT(fcb2_sector_hdr_read(fcb, test_fcb_ranges, 0, NULL) == 0);
+    fcb2_ea_erase_test_hook = NULL;
+
+    rc = fcb2_erase_ahead_unregister(fcb);
+    TEST_ASSERT(rc == 0);
+}
+
+#endif
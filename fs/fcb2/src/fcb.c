@@ -37,6 +37,17 @@ fcb2_init(struct fcb2 *fcb)
     if (!fcb->f_ranges || fcb->f_sector_cnt - fcb->f_scratch_cnt < 1) {
         return FCB2_ERR_ARGS;
     }
+#if MYNEWT_VAL(FCB2_ERASE_AHEAD)
+    if (fcb->f_erase_ahead) {
+        if (fcb->f_sector_cnt - fcb->f_scratch_cnt - fcb->f_erase_ahead < 1) {
+            return FCB2_ERR_ARGS;
+        }
+        rc = fcb2_ea_register(fcb);
+        if (rc) {
+            return rc;
+        }
+    }
+#endif
 
     /* Fill last used, first used */
     for (i = 0; i < fcb->f_sector_cnt; i++) {
@@ -257,6 +268,12 @@ fcb2_clear(struct fcb2 *fcb)
             break;
         }
     }
+#if MYNEWT_VAL(FCB2_ERASE_AHEAD)
+    /* The data must be gone from flash, not only from the FCB. */
+    if (rc == 0 && fcb->f_erase_ahead) {
+        rc = fcb2_erase_ahead_flush(fcb);
+    }
+#endif
     return rc;
 }
 
@@ -57,6 +57,14 @@ fcb2_append_to_scratch(struct fcb2 *fcb)
     if (sector < 0) {
         return FCB2_ERR_NOSPACE;
     }
+#if MYNEWT_VAL(FCB2_ERASE_AHEAD)
+    if (fcb->f_erase_ahead) {
+        rc = fcb2_ea_prepare(fcb, sector);
+        if (rc) {
+            return rc;
+        }
+    }
+#endif
     rc = fcb2_sector_hdr_init(fcb, sector, fcb->f_active_id + 1);
     if (rc) {
         return rc;
@@ -165,6 +173,7 @@ fcb2_append(struct fcb2 *fcb, uint16_t len, struct fcb2_entry *append_loc)
     struct fcb2_entry *active;
     struct flash_sector_range *range;
     uint8_t flash_entry[FCB2_ENTRY_SIZE];
+    int reserve;
     int sector;
     int rc;
 
@@ -179,7 +188,15 @@ fcb2_append(struct fcb2 *fcb, uint16_t len, struct fcb2_entry *append_loc)
     active = &fcb->f_active;
     if (fcb2_active_sector_free_space(fcb) < fcb2_element_length_in_flash(active,
                                                                           len)) {
-        sector = fcb2_new_sector(fcb, fcb->f_scratch_cnt);
+        reserve = fcb->f_scratch_cnt;
+#if MYNEWT_VAL(FCB2_ERASE_AHEAD)
+        /*
+         * Have the caller rotate early, so that the sector after the new
+         * active one is erased in the background by the time it is needed.
+         */
+        reserve += fcb->f_erase_ahead;
+#endif
+        sector = fcb2_new_sector(fcb, reserve);
         if (sector >= 0) {
             range = fcb2_get_sector_range(fcb, sector);
         }
@@ -190,6 +207,14 @@ fcb2_append(struct fcb2 *fcb, uint16_t len, struct fcb2_entry *append_loc)
             rc = FCB2_ERR_NOSPACE;
             goto err;
         }
+#if MYNEWT_VAL(FCB2_ERASE_AHEAD)
+        if (fcb->f_erase_ahead) {
+            rc = fcb2_ea_prepare(fcb, sector);
+            if (rc) {
+                goto err;
+            }
+        }
+#endif
         rc = fcb2_sector_hdr_init(fcb, sector, fcb->f_active_id + 1);
         if (rc) {
             goto err;
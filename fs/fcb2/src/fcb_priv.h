@@ -73,6 +73,17 @@ struct flash_sector_range *fcb2_get_sector_range(const struct fcb2 *fcb,
 int fcb2_sector_hdr_read(struct fcb2 *, struct flash_sector_range *srp,
                          uint16_t sec, struct fcb2_disk_area *fdap);
 
+#if MYNEWT_VAL(FCB2_ERASE_AHEAD)
+int fcb2_ea_register(struct fcb2 *fcb);
+int fcb2_ea_prepare(struct fcb2 *fcb, int sector);
+int fcb2_ea_rotate(struct fcb2 *fcb);
+
+#if MYNEWT_VAL(SELFTEST)
+/* Called by the erase task before each erase, without f_mtx held. */
+extern void (*fcb2_ea_erase_test_hook)(struct fcb2 *fcb);
+#endif
+#endif
+
 /**
  * Finds sector range for given fcb sector.
  */
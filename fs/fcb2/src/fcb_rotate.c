@@ -32,6 +32,13 @@ fcb2_rotate(struct fcb2 *fcb)
         return FCB2_ERR_ARGS;
     }
 
+#if MYNEWT_VAL(FCB2_ERASE_AHEAD)
+    if (fcb->f_erase_ahead) {
+        rc = fcb2_ea_rotate(fcb);
+        goto out;
+    }
+#endif
+
     rc = fcb2_sector_erase(fcb, fcb->f_oldest_sec);
     if (rc) {
         rc = FCB2_ERR_FLASH;
@@ -0,0 +1,65 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __LITTLEFS_H__
+#define __LITTLEFS_H__
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Mounts the default littlefs instance on LITTLEFS_FLASH_AREA and
+ * registers littlefs with the fs layer.  Paths without a disk prefix refer
+ * to this instance.
+ *
+ * @return 0 on success, non-zero on failure
+ */
+int littlefs_init(void);
+
+/**
+ * Formats the default littlefs instance.
+ *
+ * @return 0 on success, non-zero on failure
+ */
+int littlefs_reformat(void);
+
+/**
+ * Mounts an additional littlefs instance on a flash area, formatting it
+ * first if it holds no file system and LITTLEFS_DETECT_FAIL_FORMAT is set.
+ * Its files are reached through "<disk_name>:/path", and with
+ * LITTLEFS_STATS its counters are kept in the stats section of the mount
+ * slot it takes.  The instance uses LITTLEFS_BLOCK_SIZE and spans the
+ * whole flash area.
+ *
+ * @param disk_name             Name of the instance; must stay valid while
+ *                                  mounted.
+ * @param flash_area_id         Flash area holding the file system.
+ *
+ * @return 0 on success, FS_[...] on failure
+ */
+int littlefs_mount(const char *disk_name, uint8_t flash_area_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -10,6 +10,20 @@
 #define LFS_BLOCK_NULL ((lfs_block_t)-1)
 #define LFS_BLOCK_INLINE ((lfs_block_t)-2)
 
+// MYNEWT: local patch, recorded in fs/littlefs/patches/lfs-cache-stats.patch.
+// Cache accounting for the glue's per-mount stats: lfs_bd_read() reports
+// each read served from the read or program cache and each read cache
+// refill. No-ops unless LFS_CACHE_STATS is defined.
+#ifdef LFS_CACHE_STATS
+void lfs_cache_stat(const struct lfs_config *cfg, bool hit);
+#define LFS_CACHE_HIT(lfs) lfs_cache_stat((lfs)->cfg, true)
+#define LFS_CACHE_MISS(lfs) lfs_cache_stat((lfs)->cfg, false)
+#else
+#define LFS_CACHE_HIT(lfs)
+#define LFS_CACHE_MISS(lfs)
+#endif
+// MYNEWT: end of local patch
+
 /// Caching block device operations ///
 static inline void lfs_cache_drop(lfs_t *lfs, lfs_cache_t *rcache) {
     // do not zero, cheaper if cache is readonly or only going to be
@@ -43,6 +57,7 @@ static int lfs_bd_read(lfs_t *lfs,
                 // is already in pcache?
                 diff = lfs_min(diff, pcache->size - (off-pcache->off));
                 memcpy(data, &pcache->buffer[off-pcache->off], diff);
+                LFS_CACHE_HIT(lfs); // MYNEWT
 
                 data += diff;
                 off += diff;
@@ -60,6 +75,7 @@ static int lfs_bd_read(lfs_t *lfs,
                 // is already in rcache?
                 diff = lfs_min(diff, rcache->size - (off-rcache->off));
                 memcpy(data, &rcache->buffer[off-rcache->off], diff);
+                LFS_CACHE_HIT(lfs); // MYNEWT
 
                 data += diff;
                 off += diff;
@@ -88,6 +104,7 @@ static int lfs_bd_read(lfs_t *lfs,
 
         // load to cache, first condition can no longer fail
         LFS_ASSERT(block < lfs->cfg->block_count);
+        LFS_CACHE_MISS(lfs); // MYNEWT
         rcache->block = block;
         rcache->off = lfs_aligndown(off, lfs->cfg->read_size);
         rcache->size = lfs_min(
@@ -28,6 +28,10 @@
 
 #include <littlefs/lfs.h>
 #include <littlefs/lfs_util.h>
+#include <littlefs/littlefs.h>
+#if MYNEWT_VAL(LITTLEFS_STATS)
+#include <stats/stats.h>
+#endif
 
 #include <fs/fs.h>
 #include <fs/fs_if.h>
@@ -36,6 +40,76 @@
 #error "Must configure LITTLEFS_BLOCK_SIZE and LITTLEFS_BLOCK_COUNT syscfgs"
 #endif
 
+#if MYNEWT_VAL(LITTLEFS_READ_SIZE) > 0
+#define LITTLEFS_READ_SIZE MYNEWT_VAL(LITTLEFS_READ_SIZE)
+#else
+#define LITTLEFS_READ_SIZE (MYNEWT_VAL(MCU_FLASH_MIN_WRITE_SIZE) * 2)
+#endif
+#if MYNEWT_VAL(LITTLEFS_PROG_SIZE) > 0
+#define LITTLEFS_PROG_SIZE MYNEWT_VAL(LITTLEFS_PROG_SIZE)
+#else
+#define LITTLEFS_PROG_SIZE (MYNEWT_VAL(MCU_FLASH_MIN_WRITE_SIZE) * 2)
+#endif
+#define LITTLEFS_CACHE_SIZE MYNEWT_VAL(LITTLEFS_CACHE_SIZE)
+#define LITTLEFS_LOOKAHEAD_SIZE MYNEWT_VAL(LITTLEFS_LOOKAHEAD_SIZE)
+
+#if (LITTLEFS_CACHE_SIZE % LITTLEFS_READ_SIZE) || \
+    (LITTLEFS_CACHE_SIZE % LITTLEFS_PROG_SIZE)
+#error "LITTLEFS_CACHE_SIZE must be a multiple of the read and prog sizes"
+#endif
+#if (LITTLEFS_LOOKAHEAD_SIZE == 0) || (LITTLEFS_LOOKAHEAD_SIZE % 8)
+#error "LITTLEFS_LOOKAHEAD_SIZE must be a non-zero multiple of 8"
+#endif
+
+#if MYNEWT_VAL(LITTLEFS_STATS)
+STATS_SECT_START(littlefs_stats)
+    STATS_SECT_ENTRY(reads)
+    STATS_SECT_ENTRY(read_bytes)
+    STATS_SECT_ENTRY(progs)
+    STATS_SECT_ENTRY(prog_bytes)
+    STATS_SECT_ENTRY(erases)
+    STATS_SECT_ENTRY(cache_hits)
+    STATS_SECT_ENTRY(cache_misses)
+STATS_SECT_END
+
+STATS_NAME_START(littlefs_stats)
+    STATS_NAME(littlefs_stats, reads)
+    STATS_NAME(littlefs_stats, read_bytes)
+    STATS_NAME(littlefs_stats, progs)
+    STATS_NAME(littlefs_stats, prog_bytes)
+    STATS_NAME(littlefs_stats, erases)
+    STATS_NAME(littlefs_stats, cache_hits)
+    STATS_NAME(littlefs_stats, cache_misses)
+STATS_NAME_END(littlefs_stats)
+
+#define LITTLEFS_STATS_INC(lm, var) STATS_INC((lm)->lm_stats, var)
+#define LITTLEFS_STATS_INCN(lm, var, n) STATS_INCN((lm)->lm_stats, var, n)
+#else
+#define LITTLEFS_STATS_INC(lm, var)
+#define LITTLEFS_STATS_INCN(lm, var, n)
+#endif
+
+/*
+ * A littlefs instance.  The default one, on LITTLEFS_FLASH_AREA, has no
+ * name and is used for paths without a disk prefix; others are reached
+ * through "<name>:/path".
+ */
+struct littlefs_mount {
+    lfs_t lm_lfs;
+    struct lfs_config lm_cfg;
+    const char *lm_name;
+    const struct flash_area *lm_fa;
+    bool lm_mounted;
+#if MYNEWT_VAL(LITTLEFS_STATS)
+    STATS_SECT_DECL(littlefs_stats) lm_stats;
+    char lm_stats_name[sizeof("littlefs") + 3];
+#endif
+    uint8_t lm_read_buf[LITTLEFS_CACHE_SIZE] __attribute__((aligned(4)));
+    uint8_t lm_prog_buf[LITTLEFS_CACHE_SIZE] __attribute__((aligned(4)));
+    uint8_t lm_lookahead_buf[LITTLEFS_LOOKAHEAD_SIZE]
+        __attribute__((aligned(4)));
+};
+
 static int littlefs_open(const char *path, uint8_t access_flags,
                          struct fs_file **out_file);
 static int littlefs_close(struct fs_file *fs_file);
@@ -151,12 +225,14 @@ flash_read(const struct lfs_config *c, lfs_block_t block,
            lfs_off_t off, void *buffer, lfs_size_t size)
 {
     int rc;
-    const struct flash_area *fa;
+    struct littlefs_mount *lm;
     uint32_t offset;
 
-    fa = (const struct flash_area *)(c->context);
+    lm = c->context;
     offset = c->block_size * block + off;
-    rc = flash_area_read(fa, offset, buffer, size);
+    rc = flash_area_read(lm->lm_fa, offset, buffer, size);
+    LITTLEFS_STATS_INC(lm, reads);
+    LITTLEFS_STATS_INCN(lm, read_bytes, size);
     if (rc != 0) {
         return LFS_ERR_IO;
     }
@@ -174,12 +250,14 @@ flash_prog(const struct lfs_config *c, lfs_block_t block,
            lfs_off_t off, const void *buffer, lfs_size_t size)
 {
     int rc;
-    const struct flash_area *fa;
+    struct littlefs_mount *lm;
     uint32_t offset;
 
-    fa = (const struct flash_area *)(c->context);
+    lm = c->context;
     offset = c->block_size * block + off;
-    rc = flash_area_write(fa, offset, buffer, (uint32_t)size);
+    rc = flash_area_write(lm->lm_fa, offset, buffer, (uint32_t)size);
+    LITTLEFS_STATS_INC(lm, progs);
+    LITTLEFS_STATS_INCN(lm, prog_bytes, size);
     if (rc != 0) {
         return LFS_ERR_IO;
     }
@@ -197,10 +275,11 @@ static int
 flash_erase(const struct lfs_config *c, lfs_block_t block)
 {
     int rc;
-    const struct flash_area *fa;
+    struct littlefs_mount *lm;
 
-    fa = (const struct flash_area *)(c->context);
-    rc = flash_area_erase(fa, c->block_size * block, c->block_size);
+    lm = c->context;
+    rc = flash_area_erase(lm->lm_fa, c->block_size * block, c->block_size);
+    LITTLEFS_STATS_INC(lm, erases);
     if (rc != 0) {
         return LFS_ERR_IO;
     }
@@ -219,39 +298,28 @@ flash_sync(const struct lfs_config *c)
     return 0;
 }
 
-static lfs_t *g_lfs = NULL;
-static bool g_lfs_alloc_done = false;
-
-#define READ_SIZE (MYNEWT_VAL(MCU_FLASH_MIN_WRITE_SIZE) * 2)
-static uint8_t read_buffer[READ_SIZE];
-#define WRITE_SIZE (MYNEWT_VAL(MCU_FLASH_MIN_WRITE_SIZE) * 2)
-static uint8_t prog_buffer[WRITE_SIZE];
-#define CACHE_SIZE 8
-static uint8_t __attribute__((aligned(4))) lookahead_buffer[CACHE_SIZE];
-static struct lfs_config g_lfs_cfg = {
-    .context = NULL,
-
-    .read = flash_read,
-    .prog = flash_prog,
-    .erase = flash_erase,
-    .sync = flash_sync,
-
-    /* block device configuration */
-    .read_size = READ_SIZE,
-    .prog_size = WRITE_SIZE,
-    .block_size = MYNEWT_VAL(LITTLEFS_BLOCK_SIZE),
-    .block_count = MYNEWT_VAL(LITTLEFS_BLOCK_COUNT),
-    .block_cycles = 500,
-    .cache_size = 16,
-    .lookahead_size = CACHE_SIZE,
-    .read_buffer = read_buffer,
-    .prog_buffer = prog_buffer,
-    .lookahead_buffer = lookahead_buffer,
-    .name_max = 0,
-    .file_max = 0,
-    .attr_max = 0,
-    .metadata_max = 0,
-};
+#if MYNEWT_VAL(LITTLEFS_STATS)
+/*
+ * Counts reads served by the littlefs caches (hits) and refills of the
+ * read cache (misses).  Called from lfs_bd_read() through the hooks of
+ * patches/lfs-cache-stats.patch.
+ */
+void
+lfs_cache_stat(const struct lfs_config *cfg, bool hit)
+{
+    struct littlefs_mount *lm;
+
+    lm = cfg->context;
+    if (hit) {
+        STATS_INC(lm->lm_stats, cache_hits);
+    } else {
+        STATS_INC(lm->lm_stats, cache_misses);
+    }
+}
+#endif
+
+static struct littlefs_mount littlefs_mounts[MYNEWT_VAL(LITTLEFS_MAX_MOUNTS)];
+static bool littlefs_glue_ready;
 
 static struct os_mutex littlefs_mutex;
 
@@ -273,11 +341,48 @@ littlefs_unlock(void)
     assert(rc == 0 || rc == OS_NOT_STARTED);
 }
 
+/*
+ * Returns the instance a path refers to and sets out_path to the path
+ * within it, or returns NULL if no such instance is mounted.
+ */
+static lfs_t *
+littlefs_lfs_for_path(const char *path, const char **out_path)
+{
+    struct littlefs_mount *lm;
+    const char *colon;
+    size_t len;
+    int i;
+
+    colon = strchr(path, ':');
+    for (i = 0; i < MYNEWT_VAL(LITTLEFS_MAX_MOUNTS); i++) {
+        lm = &littlefs_mounts[i];
+        if (!lm->lm_mounted) {
+            continue;
+        }
+        if (colon == NULL) {
+            if (lm->lm_name == NULL) {
+                *out_path = path;
+                return &lm->lm_lfs;
+            }
+        } else if (lm->lm_name != NULL) {
+            len = colon - path;
+            if (strlen(lm->lm_name) == len &&
+                memcmp(lm->lm_name, path, len) == 0) {
+                *out_path = colon + 1;
+                return &lm->lm_lfs;
+            }
+        }
+    }
+
+    return NULL;
+}
+
 static int
 littlefs_open(const char *path, uint8_t access_flags, struct fs_file **out_fs_file)
 {
     lfs_file_t *out_file = NULL;
     struct littlefs_file *file = NULL;
+    lfs_t *lfs;
     int flags;
     int rc;
 
@@ -285,6 +390,11 @@ littlefs_open(const char *path, uint8_t access_flags, struct fs_file **out_fs_fi
         return FS_EINVAL;
     }
 
+    lfs = littlefs_lfs_for_path(path, &path);
+    if (!lfs) {
+        return FS_EUNINIT;
+    }
+
     out_file = NULL;
 
     file = malloc(sizeof(struct littlefs_file));
@@ -323,7 +433,7 @@ littlefs_open(const char *path, uint8_t access_flags, struct fs_file **out_fs_fi
     }
 
     littlefs_lock();
-    rc = lfs_file_open(g_lfs, out_file, path, flags);
+    rc = lfs_file_open(lfs, out_file, path, flags);
     littlefs_unlock();
     if (rc != LFS_ERR_OK) {
         rc = littlefs_to_vfs_error(rc);
@@ -332,7 +442,7 @@ littlefs_open(const char *path, uint8_t access_flags, struct fs_file **out_fs_fi
 
     file->file = out_file;
     file->fops = &littlefs_ops;
-    file->lfs = g_lfs;
+    file->lfs = lfs;
     *out_fs_file = (struct fs_file *) file;
     rc = FS_EOK;
 
@@ -522,14 +632,20 @@ littlefs_flush(struct fs_file *fs_file)
 static int
 littlefs_unlink(const char *path)
 {
+    lfs_t *lfs;
     int rc;
 
     if (!path) {
         return FS_EINVAL;
     }
 
+    lfs = littlefs_lfs_for_path(path, &path);
+    if (!lfs) {
+        return FS_EUNINIT;
+    }
+
     littlefs_lock();
-    rc = lfs_remove(g_lfs, path);
+    rc = lfs_remove(lfs, path);
     littlefs_unlock();
 
     return littlefs_to_vfs_error(rc);
@@ -538,14 +654,24 @@ littlefs_unlink(const char *path)
 static int
 littlefs_rename(const char *from, const char *to)
 {
+    lfs_t *lfs;
     int rc;
 
     if (!from || !to) {
         return FS_EINVAL;
     }
 
+    lfs = littlefs_lfs_for_path(from, &from);
+    if (!lfs) {
+        return FS_EUNINIT;
+    }
+    /* Renames across instances are not supported. */
+    if (littlefs_lfs_for_path(to, &to) != lfs) {
+        return FS_EINVAL;
+    }
+
     littlefs_lock();
-    rc = lfs_rename(g_lfs, from, to);
+    rc = lfs_rename(lfs, from, to);
     littlefs_unlock();
 
     return littlefs_to_vfs_error(rc);
@@ -554,14 +680,20 @@ littlefs_rename(const char *from, const char *to)
 static int
 littlefs_mkdir(const char *path)
 {
+    lfs_t *lfs;
     int rc;
 
     if (!path) {
         return FS_EINVAL;
     }
 
+    lfs = littlefs_lfs_for_path(path, &path);
+    if (!lfs) {
+        return FS_EUNINIT;
+    }
+
     littlefs_lock();
-    rc = lfs_mkdir(g_lfs, path);
+    rc = lfs_mkdir(lfs, path);
     littlefs_unlock();
 
     return littlefs_to_vfs_error(rc);
@@ -572,12 +704,18 @@ littlefs_opendir(const char *path, struct fs_dir **out_fs_dir)
 {
     lfs_dir_t *out_dir = NULL;
     struct littlefs_dir *dir = NULL;
+    lfs_t *lfs;
     int rc;
 
     if (!path || !out_fs_dir) {
         return FS_EINVAL;
     }
 
+    lfs = littlefs_lfs_for_path(path, &path);
+    if (!lfs) {
+        return FS_EUNINIT;
+    }
+
     out_dir = NULL;
 
     dir = malloc(sizeof(struct littlefs_dir));
@@ -593,7 +731,7 @@ littlefs_opendir(const char *path, struct fs_dir **out_fs_dir)
     }
 
     littlefs_lock();
-    rc = lfs_dir_open(g_lfs, out_dir, path);
+    rc = lfs_dir_open(lfs, out_dir, path);
     littlefs_unlock();
     if (rc < 0) {
         rc = littlefs_to_vfs_error(rc);
@@ -603,7 +741,7 @@ littlefs_opendir(const char *path, struct fs_dir **out_fs_dir)
     dir->dir = out_dir;
     dir->cur_dirent = NULL;
     dir->fops = &littlefs_ops;
-    dir->lfs = g_lfs;
+    dir->lfs = lfs;
     *out_fs_dir = (struct fs_dir *)dir;
     rc = FS_EOK;
 
@@ -723,19 +861,20 @@ littlefs_dirent_is_dir(const struct fs_dirent *fs_dirent)
 }
 
 /*
- * Initializes only Mynewt glue, to fully initialize call
- * LitteFS must call littlefs_format or littlefs_mount.
+ * Sets up the lock and the stats sections of all mount slots.  The stats
+ * registry has no lock of its own, so the sections are registered once,
+ * from sysinit, and only reset when a slot is taken into use.
  */
 static int
-littlefs_alloc(void)
+littlefs_glue_init(void)
 {
-    const struct flash_area *fa;
     int rc;
+#if MYNEWT_VAL(LITTLEFS_STATS)
+    struct littlefs_mount *lm;
+    int i;
+#endif
 
-    /*
-     * Already initialized.
-     */
-    if (g_lfs && g_lfs_alloc_done) {
+    if (littlefs_glue_ready) {
         return FS_EOK;
     }
 
@@ -744,61 +883,152 @@ littlefs_alloc(void)
         return FS_EOS;
     }
 
-    g_lfs = malloc(sizeof(lfs_t));
-    if (!g_lfs) {
+#if MYNEWT_VAL(LITTLEFS_STATS)
+    for (i = 0; i < MYNEWT_VAL(LITTLEFS_MAX_MOUNTS); i++) {
+        lm = &littlefs_mounts[i];
+        if (i == 0) {
+            strcpy(lm->lm_stats_name, "littlefs");
+        } else {
+            snprintf(lm->lm_stats_name, sizeof(lm->lm_stats_name),
+                     "littlefs%d", i);
+        }
+        rc = stats_init_and_reg(
+            STATS_HDR(lm->lm_stats),
+            STATS_SIZE_INIT_PARMS(lm->lm_stats, STATS_SIZE_32),
+            STATS_NAME_INIT_PARMS(littlefs_stats),
+            lm->lm_stats_name);
+        if (rc != 0) {
+            return FS_EOS;
+        }
+    }
+#endif
+
+    littlefs_glue_ready = true;
+
+    return FS_EOK;
+}
+
+/*
+ * Sets up an instance on the given flash area; littlefs_mount_lfs() then
+ * mounts it.
+ */
+static int
+littlefs_alloc(const char *name, uint8_t flash_area_id, uint32_t block_count,
+               struct littlefs_mount **out_lm)
+{
+    const struct flash_area *fa;
+    struct littlefs_mount *lm;
+    int rc;
+    int i;
+
+    rc = littlefs_glue_init();
+    if (rc != FS_EOK) {
+        return rc;
+    }
+
+    rc = flash_area_open(flash_area_id, &fa);
+    if (rc) {
+        return FS_EHW;
+    }
+
+    /* Claim the slot before anyone else can look at it. */
+    littlefs_lock();
+    lm = NULL;
+    for (i = 0; i < MYNEWT_VAL(LITTLEFS_MAX_MOUNTS); i++) {
+        if (littlefs_mounts[i].lm_fa == NULL) {
+            lm = &littlefs_mounts[i];
+            lm->lm_name = name;
+            lm->lm_fa = fa;
+            break;
+        }
+    }
+    littlefs_unlock();
+    if (!lm) {
+        flash_area_close(fa);
         return FS_ENOMEM;
     }
 
+    if (block_count == 0) {
+        block_count = fa->fa_size / MYNEWT_VAL(LITTLEFS_BLOCK_SIZE);
+    }
+
     /*
      * This doesn't seem to be needed because lfs_mount initializes
      * all fields, but just to stay on the safe side...
      */
-    memset(g_lfs, 0, sizeof(lfs_t));
-
-    rc = flash_area_open(MYNEWT_VAL(LITTLEFS_FLASH_AREA), &fa);
-    if (rc) {
-        free(g_lfs);
-        g_lfs = NULL;
-        return FS_EHW;
-    }
+    memset(&lm->lm_lfs, 0, sizeof(lm->lm_lfs));
+
+    lm->lm_cfg = (struct lfs_config) {
+        .context = lm,
+
+        .read = flash_read,
+        .prog = flash_prog,
+        .erase = flash_erase,
+        .sync = flash_sync,
+
+        /* block device configuration */
+        .read_size = LITTLEFS_READ_SIZE,
+        .prog_size = LITTLEFS_PROG_SIZE,
+        .block_size = MYNEWT_VAL(LITTLEFS_BLOCK_SIZE),
+        .block_count = block_count,
+        .block_cycles = MYNEWT_VAL(LITTLEFS_BLOCK_CYCLES),
+        .cache_size = LITTLEFS_CACHE_SIZE,
+        .lookahead_size = LITTLEFS_LOOKAHEAD_SIZE,
+        .read_buffer = lm->lm_read_buf,
+        .prog_buffer = lm->lm_prog_buf,
+        .lookahead_buffer = lm->lm_lookahead_buf,
+    };
+
+#if MYNEWT_VAL(LITTLEFS_STATS)
+    STATS_RESET(lm->lm_stats);
+#endif
 
     /*
      * TODO: could check that fa_size matches the configured block size * count
      */
-    g_lfs_cfg.context = (struct flash_area *)fa;
-    g_lfs_alloc_done = true;
+    *out_lm = lm;
 
     return FS_EOK;
 }
 
-int
-littlefs_reformat(void)
+/*
+ * Undoes littlefs_alloc() for an instance that is not mounted.
+ */
+static void
+littlefs_free(struct littlefs_mount *lm)
 {
-    int rc;
+    flash_area_close(lm->lm_fa);
+    littlefs_lock();
+    lm->lm_name = NULL;
+    lm->lm_fa = NULL;
+    littlefs_unlock();
+}
 
-    if (!g_lfs_alloc_done) {
-        rc = littlefs_alloc();
-        if (rc != FS_EOK) {
-            return -1;
+static struct littlefs_mount *
+littlefs_dflt_mount(void)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(LITTLEFS_MAX_MOUNTS); i++) {
+        if (littlefs_mounts[i].lm_fa != NULL &&
+            littlefs_mounts[i].lm_name == NULL) {
+            return &littlefs_mounts[i];
         }
     }
 
-    return lfs_format(g_lfs, &g_lfs_cfg);
+    return NULL;
 }
 
-int
-littlefs_init(void)
+/*
+ * Mounts an instance, formatting it first if it holds no valid file system
+ * and LITTLEFS_DETECT_FAIL_FORMAT is set.  Returns a littlefs error code.
+ */
+static int
+littlefs_mount_lfs(struct littlefs_mount *lm)
 {
     int rc;
 
-    if (!g_lfs_alloc_done) {
-        rc = littlefs_alloc();
-        if (rc != FS_EOK) {
-            return rc;
-        }
-    }
-
-    rc = lfs_mount(g_lfs, &g_lfs_cfg);
+    rc = lfs_mount(&lm->lm_lfs, &lm->lm_cfg);
     switch (rc) {
     case LFS_ERR_OK:
         break;
@@ -808,30 +1038,107 @@ littlefs_init(void)
          * detection failure policy.
          */
 #if MYNEWT_VAL(LITTLEFS_DETECT_FAIL_FORMAT)
-        rc = lfs_format(g_lfs, &g_lfs_cfg);
+        rc = lfs_format(&lm->lm_lfs, &lm->lm_cfg);
         if (!rc) {
-            rc = lfs_mount(g_lfs, &g_lfs_cfg);
+            rc = lfs_mount(&lm->lm_lfs, &lm->lm_cfg);
         }
 #endif
         break;
     }
 
     if (!rc) {
+        lm->lm_mounted = true;
+        /* Fails with FS_EEXIST for all but the first instance. */
         fs_register(&littlefs_ops);
     }
 
     return rc;
 }
 
+int
+littlefs_reformat(void)
+{
+    struct littlefs_mount *lm;
+    int rc;
+
+    lm = littlefs_dflt_mount();
+    if (!lm) {
+        rc = littlefs_alloc(NULL, MYNEWT_VAL(LITTLEFS_FLASH_AREA),
+                            MYNEWT_VAL(LITTLEFS_BLOCK_COUNT), &lm);
+        if (rc != FS_EOK) {
+            return -1;
+        }
+    }
+
+    return lfs_format(&lm->lm_lfs, &lm->lm_cfg);
+}
+
+int
+littlefs_init(void)
+{
+    struct littlefs_mount *lm;
+    int rc;
+
+    lm = littlefs_dflt_mount();
+    if (!lm) {
+        rc = littlefs_alloc(NULL, MYNEWT_VAL(LITTLEFS_FLASH_AREA),
+                            MYNEWT_VAL(LITTLEFS_BLOCK_COUNT), &lm);
+        if (rc != FS_EOK) {
+            return rc;
+        }
+    }
+
+    return littlefs_mount_lfs(lm);
+}
+
+int
+littlefs_mount(const char *disk_name, uint8_t flash_area_id)
+{
+    struct littlefs_mount *lm;
+    int rc;
+
+    if (!disk_name) {
+        return FS_EINVAL;
+    }
+
+    if (disk_fs_for(disk_name) != NULL) {
+        return FS_EEXIST;
+    }
+
+    rc = littlefs_alloc(disk_name, flash_area_id, 0, &lm);
+    if (rc != FS_EOK) {
+        return rc;
+    }
+
+    rc = littlefs_mount_lfs(lm);
+    if (rc != LFS_ERR_OK) {
+        littlefs_free(lm);
+        return littlefs_to_vfs_error(rc);
+    }
+
+    rc = disk_register(disk_name, "littlefs", NULL);
+    if (rc != 0) {
+        lfs_unmount(&lm->lm_lfs);
+        lm->lm_mounted = false;
+        littlefs_free(lm);
+        return FS_ENOMEM;
+    }
+
+    return FS_EOK;
+}
+
 void
 littlefs_pkg_init(void)
 {
-#if !MYNEWT_VAL(LITTLEFS_DISABLE_SYSINIT)
     int rc;
 
     /* Ensure this function only gets called by sysinit. */
     SYSINIT_ASSERT_ACTIVE();
 
+    rc = littlefs_glue_init();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+#if !MYNEWT_VAL(LITTLEFS_DISABLE_SYSINIT)
     /* Attempt to restore an existing littlefs file system from flash. */
     rc = littlefs_init();
     SYSINIT_PANIC_ASSERT(rc == 0);
@@ -49,10 +49,25 @@ struct nffs_config {
 
     /** Data block cache size; default=64. */
     uint32_t nc_num_cache_blocks;
+
+    /**
+     * Number of inode / block hash buckets, rounded down to a power of two;
+     * default=256.  Lookups walk one bucket, so large volumes want roughly
+     * one bucket per one or two objects.
+     */
+    uint32_t nc_hash_size;
 };
 
 extern struct nffs_config nffs_config;
 
+/** Hash table occupancy, as reported by nffs_get_hash_info(). */
+struct nffs_hash_info {
+    uint32_t nhi_num_buckets;
+    uint32_t nhi_used_buckets;
+    uint32_t nhi_num_entries;
+    uint32_t nhi_max_chain_len;
+};
+
 struct nffs_area_desc {
     uint32_t nad_offset;    /* Flash offset of start of area. */
     uint32_t nad_length;    /* Size of area, in bytes. */
@@ -62,6 +77,9 @@ struct nffs_area_desc {
 int nffs_init(void);
 int nffs_detect(const struct nffs_area_desc *area_descs);
 int nffs_format(const struct nffs_area_desc *area_descs);
+int nffs_set_checkpoint_area(const struct nffs_area_desc *area_desc);
+int nffs_checkpoint(void);
+int nffs_get_hash_info(struct nffs_hash_info *out_info);
 
 int nffs_misc_desc_from_flash_area(int idx, int *cnt, struct nffs_area_desc *nad);
 
@@ -89,6 +89,8 @@ TEST_CASE_DECL(nffs_test_long_filename)
 TEST_CASE_DECL(nffs_test_large_write)
 TEST_CASE_DECL(nffs_test_many_children)
 TEST_CASE_DECL(nffs_test_gc)
+TEST_CASE_DECL(nffs_test_gc_policy)
+TEST_CASE_DECL(nffs_test_gc_garbage)
 TEST_CASE_DECL(nffs_test_wear_level)
 TEST_CASE_DECL(nffs_test_corrupt_scratch)
 TEST_CASE_DECL(nffs_test_incomplete_block)
@@ -100,6 +102,9 @@ TEST_CASE_DECL(nffs_test_readdir)
 TEST_CASE_DECL(nffs_test_split_file)
 TEST_CASE_DECL(nffs_test_gc_on_oom)
 TEST_CASE_DECL(nffs_test_cache_large_file)
+TEST_CASE_DECL(nffs_test_checkpoint)
+TEST_CASE_DECL(nffs_test_checkpoint_reads)
+TEST_CASE_DECL(nffs_test_hash)
 
 static void
 nffs_test_basic_cases(void)
@@ -119,6 +124,8 @@ nffs_test_basic_cases(void)
     nffs_test_large_write();
     nffs_test_many_children();
     nffs_test_gc();
+    nffs_test_gc_policy();
+    nffs_test_gc_garbage();
     nffs_test_wear_level();
     nffs_test_corrupt_scratch();
     nffs_test_incomplete_block();
@@ -129,6 +136,9 @@ nffs_test_basic_cases(void)
     nffs_test_readdir();
     nffs_test_split_file();
     nffs_test_gc_on_oom();
+    nffs_test_checkpoint();
+    nffs_test_checkpoint_reads();
+    nffs_test_hash();
 }
 
 TEST_SUITE(nffs_test_suite_1_1)
@@ -0,0 +1,125 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "nffs_test_utils.h"
+
+#define NFFS_TEST_CKPT_READS_FILE_CNT   32
+
+struct nffs_test_ckpt_reads {
+    uint32_t io;
+    uint32_t block;
+    uint32_t obsolete[4];
+};
+
+static void
+nffs_test_checkpoint_reads_mount(const struct nffs_area_desc *area_descs,
+                                 struct nffs_test_ckpt_reads *out_reads)
+{
+    uint32_t io;
+    uint32_t block;
+    int rc;
+    int i;
+
+    io = STATS_GET(nffs_stats, nffs_iocnt_read);
+    block = STATS_GET(nffs_stats, nffs_readcnt_block);
+
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_detect(area_descs);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    out_reads->io = STATS_GET(nffs_stats, nffs_iocnt_read) - io;
+    out_reads->block = STATS_GET(nffs_stats, nffs_readcnt_block) - block;
+
+    TEST_ASSERT_FATAL(nffs_num_areas == 4);
+    for (i = 0; i < nffs_num_areas; i++) {
+        out_reads->obsolete[i] = nffs_areas[i].na_obsolete;
+    }
+}
+
+TEST_CASE_SELF(nffs_test_checkpoint_reads)
+{
+    struct nffs_test_ckpt_reads ckpt_reads;
+    struct nffs_test_ckpt_reads full_reads;
+    char filename[32];
+    int rc;
+    int i;
+
+    static const struct nffs_area_desc area_descs_ckpt[] = {
+        { 0x00020000, 128 * 1024 },
+        { 0x00040000, 128 * 1024 },
+        { 0x00060000, 128 * 1024 },
+        { 0x00080000, 128 * 1024 },
+        { 0, 0 },
+    };
+    static const struct nffs_area_desc ckpt_desc = {
+        0x000c0000, 128 * 1024
+    };
+
+    /*** Setup. */
+    rc = nffs_set_checkpoint_area(&ckpt_desc);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = nffs_format(area_descs_ckpt);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = fs_mkdir("/many");
+    TEST_ASSERT(rc == 0);
+    for (i = 0; i < NFFS_TEST_CKPT_READS_FILE_CNT; i++) {
+        snprintf(filename, sizeof filename, "/many/f%d", i);
+        nffs_test_util_create_file(filename, "ffff", 4);
+    }
+
+    rc = nffs_checkpoint();
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Replayed; these supersede and delete checkpointed objects. */
+    nffs_test_util_append_file("/many/f0", "1234", 4);
+    nffs_test_util_create_file("/many/f1", "1234", 4);
+    rc = fs_unlink("/many/f2");
+    TEST_ASSERT(rc == 0);
+
+    /*** Mount from the checkpoint, then with a full scan. */
+    nffs_test_checkpoint_reads_mount(area_descs_ckpt, &ckpt_reads);
+    TEST_ASSERT(nffs_ckpt_restored);
+
+    rc = nffs_set_checkpoint_area(NULL);
+    TEST_ASSERT(rc == 0);
+    nffs_test_checkpoint_reads_mount(area_descs_ckpt, &full_reads);
+    TEST_ASSERT(!nffs_ckpt_restored);
+
+    /* Checkpointed objects are neither read back for their size nor for the
+     * block checks of the final sweep.
+     */
+    TEST_ASSERT(ckpt_reads.io < full_reads.io,
+                "ckpt=%u full=%u", (unsigned)ckpt_reads.io,
+                (unsigned)full_reads.io);
+    TEST_ASSERT(ckpt_reads.block * 2 < full_reads.block,
+                "ckpt=%u full=%u", (unsigned)ckpt_reads.block,
+                (unsigned)full_reads.block);
+
+    /* Sizing objects from the checkpoint records gives the same garbage
+     * counts as reading them.
+     */
+    for (i = 0; i < 4; i++) {
+        TEST_ASSERT(ckpt_reads.obsolete[i] == full_reads.obsolete[i],
+                    "area=%d ckpt=%u full=%u", i,
+                    (unsigned)ckpt_reads.obsolete[i],
+                    (unsigned)full_reads.obsolete[i]);
+    }
+}
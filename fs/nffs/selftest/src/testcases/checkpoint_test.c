@@ -0,0 +1,133 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+TEST_CASE_SELF(nffs_test_checkpoint)
+{
+    int rc;
+
+    static const struct nffs_area_desc area_descs_ckpt[] = {
+        { 0x00020000, 128 * 1024 },
+        { 0x00040000, 128 * 1024 },
+        { 0x00060000, 128 * 1024 },
+        { 0x00080000, 128 * 1024 },
+        { 0, 0 },
+    };
+    static const struct nffs_area_desc ckpt_desc = {
+        0x000c0000, 128 * 1024
+    };
+
+    struct nffs_test_file_desc *expected_system =
+        (struct nffs_test_file_desc[]) { {
+            .filename = "",
+            .is_dir = 1,
+            .children = (struct nffs_test_file_desc[]) { {
+                .filename = "mydir",
+                .is_dir = 1,
+                .children = (struct nffs_test_file_desc[]) { {
+                    .filename = "a",
+                    .contents = "aaaa1234",
+                    .contents_len = 8,
+                }, {
+                    .filename = "c",
+                    .contents = "cccc",
+                    .contents_len = 4,
+                }, {
+                    .filename = "e",
+                    .contents = "eeee",
+                    .contents_len = 4,
+                }, {
+                    .filename = NULL,
+                } },
+            }, {
+                .filename = NULL,
+            } },
+    } };
+
+    /*** Setup. */
+    rc = nffs_set_checkpoint_area(&ckpt_desc);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = nffs_format(area_descs_ckpt);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = fs_mkdir("/mydir");
+    TEST_ASSERT(rc == 0);
+    nffs_test_util_create_file("/mydir/a", "aaaa", 4);
+    nffs_test_util_create_file("/mydir/b", "bbbb", 4);
+    nffs_test_util_create_file("/mydir/x", "xxxx", 4);
+    rc = fs_unlink("/mydir/x");
+    TEST_ASSERT(rc == 0);
+
+    rc = nffs_checkpoint();
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* These changes are not in the checkpoint; they must be replayed. */
+    nffs_test_util_append_file("/mydir/a", "1234", 4);
+    nffs_test_util_create_file("/mydir/c", "cccc", 4);
+    rc = fs_unlink("/mydir/b");
+    TEST_ASSERT(rc == 0);
+
+    /*** Mount from the checkpoint. */
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_detect(area_descs_ckpt);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(nffs_ckpt_restored);
+
+    /* New objects must not reuse the IDs of deleted ones. */
+    nffs_test_util_create_file("/mydir/e", "eeee", 4);
+    nffs_test_assert_system_once(expected_system);
+
+    /*** Corrupt the checkpoint; mount falls back to a full scan. */
+    rc = flash_native_memset(ckpt_desc.nad_offset +
+                             sizeof (struct nffs_disk_ckpt) + 1, 0x5a, 1);
+    TEST_ASSERT(rc == 0);
+
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_detect(area_descs_ckpt);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!nffs_ckpt_restored);
+    nffs_test_assert_system_once(expected_system);
+
+    /* The full scan wrote a fresh checkpoint. */
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_detect(area_descs_ckpt);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(nffs_ckpt_restored);
+    nffs_test_assert_system_once(expected_system);
+
+    /*** Garbage collection invalidates the checkpoint. */
+    rc = nffs_gc(NULL);
+    TEST_ASSERT(rc == 0);
+
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_detect(area_descs_ckpt);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!nffs_ckpt_restored);
+
+    nffs_test_assert_system(expected_system, area_descs_ckpt);
+
+    rc = nffs_set_checkpoint_area(NULL);
+    TEST_ASSERT(rc == 0);
+}
@@ -0,0 +1,145 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "nffs_test_utils.h"
+
+static uint32_t
+nffs_test_gc_garbage_total(void)
+{
+    uint32_t total;
+    int i;
+
+    total = 0;
+    for (i = 0; i < nffs_num_areas; i++) {
+        total += nffs_areas[i].na_obsolete;
+    }
+    return total;
+}
+
+/**
+ * Checks that the garbage counts kept up to date as objects are superseded
+ * match the ones recomputed from flash contents when the file system is
+ * restored.
+ */
+static void
+nffs_test_gc_garbage_assert_restored(const struct nffs_area_desc *area_descs)
+{
+    uint32_t obsolete[4];
+    int rc;
+    int i;
+
+    for (i = 0; i < nffs_num_areas; i++) {
+        obsolete[i] = nffs_areas[i].na_obsolete;
+    }
+
+    rc = nffs_detect(area_descs);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < nffs_num_areas; i++) {
+        TEST_ASSERT(nffs_areas[i].na_obsolete == obsolete[i]);
+    }
+}
+
+TEST_CASE_SELF(nffs_test_gc_garbage)
+{
+    static const struct nffs_area_desc area_descs_four[] = {
+        { 0x00000000, 16 * 1024 },
+        { 0x00004000, 16 * 1024 },
+        { 0x00008000, 16 * 1024 },
+        { 0x0000c000, 16 * 1024 },
+        { 0, 0 },
+    };
+    struct fs_file *file;
+    uint32_t total;
+    uint8_t area_idx;
+    int rc;
+    int i;
+
+    rc = nffs_format(area_descs_four);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(nffs_num_areas == 4);
+    TEST_ASSERT(nffs_test_gc_garbage_total() == 0);
+
+    nffs_test_util_create_file("/f", "abcdefgh", 8);
+    total = nffs_test_gc_garbage_total();
+    nffs_test_gc_garbage_assert_restored(area_descs_four);
+
+    /* Overwriting a block turns the old one into garbage. */
+    rc = fs_open("/f", FS_ACCESS_WRITE, &file);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = fs_write(file, "ABCDEFGH", 8);
+    TEST_ASSERT(rc == 0);
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+    nffs_test_util_assert_contents("/f", "ABCDEFGH", 8);
+
+    TEST_ASSERT(nffs_test_gc_garbage_total() >=
+                total + sizeof (struct nffs_disk_block) + 8);
+    total = nffs_test_gc_garbage_total();
+    nffs_test_gc_garbage_assert_restored(area_descs_four);
+
+    /* So does renaming the inode. */
+    rc = fs_rename("/f", "/g");
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(nffs_test_gc_garbage_total() >=
+                total + sizeof (struct nffs_disk_inode) + 1);
+    total = nffs_test_gc_garbage_total();
+    nffs_test_gc_garbage_assert_restored(area_descs_four);
+
+    /* Unlinking leaves nothing but garbage: the inode, its block and the
+     * deletion record.
+     */
+    rc = fs_unlink("/g");
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(nffs_test_gc_garbage_total() >=
+                total + 2 * sizeof (struct nffs_disk_inode) + 1 +
+                sizeof (struct nffs_disk_block) + 8);
+    nffs_test_gc_garbage_assert_restored(area_descs_four);
+
+    /* Garbage collection leaves none in the source or destination area,
+     * other than the deletion record.  A restore cannot tell which areas
+     * have been rebuilt since the deletion, so the record is kept.
+     */
+    nffs_test_util_create_file("/h", "12345678", 8);
+    nffs_test_util_append_file("/h", "9", 1);
+    for (i = 0; i < nffs_num_areas; i++) {
+        rc = nffs_gc(&area_idx);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(nffs_areas[area_idx].na_obsolete ==
+                    nffs_areas[area_idx].na_deletes *
+                    sizeof (struct nffs_disk_inode));
+        TEST_ASSERT(nffs_areas[nffs_scratch_area_idx].na_obsolete == 0);
+        nffs_test_gc_garbage_assert_restored(area_descs_four);
+    }
+    TEST_ASSERT(nffs_test_gc_garbage_total() ==
+                sizeof (struct nffs_disk_inode));
+    nffs_test_util_assert_contents("/h", "123456789", 9);
+
+    /* Once every other area has been rebuilt, the record goes too, and the
+     * file stays deleted.
+     */
+    for (i = 0; i < 2 * nffs_num_areas; i++) {
+        rc = nffs_gc(NULL);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(nffs_test_gc_garbage_total() == 0);
+    nffs_test_gc_garbage_assert_restored(area_descs_four);
+    rc = fs_open("/g", FS_ACCESS_READ, &file);
+    TEST_ASSERT(rc == FS_ENOENT);
+    nffs_test_util_assert_contents("/h", "123456789", 9);
+}
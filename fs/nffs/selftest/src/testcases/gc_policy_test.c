@@ -0,0 +1,160 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "nffs_test_utils.h"
+
+#define NFFS_TEST_GC_AREA_LEN   (16 * 1024)
+
+/**
+ * Sets an area's fill level, garbage and collection count.  Only the RAM
+ * state used for victim selection is touched.
+ */
+static void
+nffs_test_gc_policy_set(int idx, uint32_t used, uint32_t obsolete,
+                        uint8_t gc_seq)
+{
+    struct nffs_area *area;
+
+    area = nffs_areas + idx;
+    area->na_cur = sizeof (struct nffs_disk_area) + used;
+    area->na_obsolete = obsolete;
+    area->na_gc_seq = gc_seq;
+    area->na_deletes = 0;
+    area->na_clean_gc = 0;
+    area->na_delete_gc = 0;
+}
+
+TEST_CASE_SELF(nffs_test_gc_policy)
+{
+    static const struct nffs_area_desc area_descs_four[] = {
+        { 0x00000000, NFFS_TEST_GC_AREA_LEN },
+        { 0x00004000, NFFS_TEST_GC_AREA_LEN },
+        { 0x00008000, NFFS_TEST_GC_AREA_LEN },
+        { 0x0000c000, NFFS_TEST_GC_AREA_LEN },
+        { 0, 0 },
+    };
+    uint8_t full;
+    uint8_t clean;
+    uint8_t stale;
+    int rc;
+    int i;
+
+    rc = nffs_format(area_descs_four);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(nffs_num_areas == 4);
+
+    /* Name the three areas that are not scratch. */
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (i != nffs_scratch_area_idx) {
+            break;
+        }
+    }
+    full = i++;
+    if (i == nffs_scratch_area_idx) {
+        i++;
+    }
+    clean = i++;
+    if (i == nffs_scratch_area_idx) {
+        i++;
+    }
+    stale = i;
+
+    /*
+     * full:  completely written, half of it garbage.
+     * clean: 40% written, all of it garbage.
+     * stale: empty, but collected least often.
+     *
+     * GREEDY goes for the most garbage, COST_BENEFIT for the garbage that
+     * is cheapest to reclaim, ROTATE for the least collected area.
+     */
+    nffs_test_gc_policy_set(nffs_scratch_area_idx, 0, 0, 5);
+    nffs_test_gc_policy_set(full, NFFS_TEST_GC_AREA_LEN -
+                            sizeof (struct nffs_disk_area),
+                            NFFS_TEST_GC_AREA_LEN / 2, 5);
+    nffs_test_gc_policy_set(clean, NFFS_TEST_GC_AREA_LEN * 2 / 5,
+                            NFFS_TEST_GC_AREA_LEN * 2 / 5, 5);
+    nffs_test_gc_policy_set(stale, 0, 0, 4);
+
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_ROTATE) == stale);
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_GREEDY) == full);
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_COST_BENEFIT) == clean);
+
+    /* Age makes up for less garbage under COST_BENEFIT only. */
+    nffs_test_gc_policy_set(stale, NFFS_TEST_GC_AREA_LEN / 4,
+                            NFFS_TEST_GC_AREA_LEN / 4, 3);
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_GREEDY) == full);
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_COST_BENEFIT) == stale);
+    nffs_test_gc_policy_set(stale, 0, 0, 4);
+
+    /* Deletion records that still have to be copied count as live data;
+     * the rest of the area's garbage still does.
+     */
+    nffs_areas[clean].na_deletes = 1;
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_GREEDY) == full);
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_COST_BENEFIT) == clean);
+    nffs_areas[clean].na_deletes = NFFS_TEST_GC_AREA_LEN * 2 / 5 /
+                                   sizeof (struct nffs_disk_inode);
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_COST_BENEFIT) == full);
+
+    /* They are garbage again once every other area has been rebuilt. */
+    nffs_areas[full].na_clean_gc = 1;
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_COST_BENEFIT) == full);
+    nffs_areas[stale].na_clean_gc = 1;
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_COST_BENEFIT) == clean);
+    nffs_areas[clean].na_deletes = 0;
+    nffs_areas[full].na_clean_gc = 0;
+    nffs_areas[stale].na_clean_gc = 0;
+
+    /* Equal scores go to the least collected area. */
+    nffs_test_gc_policy_set(full, NFFS_TEST_GC_AREA_LEN * 2 / 5,
+                            NFFS_TEST_GC_AREA_LEN * 2 / 5, 5);
+    nffs_test_gc_policy_set(clean, NFFS_TEST_GC_AREA_LEN * 2 / 5,
+                            NFFS_TEST_GC_AREA_LEN * 2 / 5, 4);
+    nffs_test_gc_policy_set(stale, 0, 0, 5);
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_GREEDY) == clean);
+    nffs_test_gc_policy_set(clean, NFFS_TEST_GC_AREA_LEN * 2 / 5,
+                            NFFS_TEST_GC_AREA_LEN * 2 / 5, 5);
+    nffs_test_gc_policy_set(full, NFFS_TEST_GC_AREA_LEN * 2 / 5,
+                            NFFS_TEST_GC_AREA_LEN * 2 / 5, 4);
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_GREEDY) == full);
+
+#if MYNEWT_VAL(NFFS_GC_MAX_AGE) != 0
+    /* An overdue area is collected whatever it holds, across sequence
+     * number wrap.
+     */
+    nffs_test_gc_policy_set(nffs_scratch_area_idx, 0, 0, 2);
+    nffs_test_gc_policy_set(full, NFFS_TEST_GC_AREA_LEN / 2,
+                            NFFS_TEST_GC_AREA_LEN / 2, 2);
+    nffs_test_gc_policy_set(clean, NFFS_TEST_GC_AREA_LEN / 2,
+                            NFFS_TEST_GC_AREA_LEN / 2, 1);
+    nffs_test_gc_policy_set(stale, 0, 0,
+                            (uint8_t)(2 - MYNEWT_VAL(NFFS_GC_MAX_AGE) + 1));
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_GREEDY) == clean);
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_COST_BENEFIT) == clean);
+
+    nffs_areas[stale].na_gc_seq--;
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_GREEDY) == stale);
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_COST_BENEFIT) == stale);
+    nffs_areas[stale].na_deletes = 1;
+    TEST_ASSERT(nffs_gc_select_area(NFFS_GC_POLICY_COST_BENEFIT) == stale);
+#endif
+
+    /* Leave a consistent file system behind. */
+    rc = nffs_format(area_descs_four);
+    TEST_ASSERT(rc == 0);
+}
@@ -0,0 +1,73 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+#include "nffs_test_utils.h"
+
+TEST_CASE_SELF(nffs_test_hash)
+{
+    struct nffs_hash_info info;
+    uint32_t save_hash_size;
+    char filename[32];
+    int rc;
+    int i;
+
+    /*** Setup; a size that is not a power of two gets rounded down. */
+    save_hash_size = nffs_config.nc_hash_size;
+    nffs_config.nc_hash_size = 100;
+
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = nffs_get_hash_info(&info);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(info.nhi_num_buckets == 64);
+
+    /* Root directory and lost+found. */
+    TEST_ASSERT(info.nhi_num_entries == 2);
+
+    /*** Create files with one data block each. */
+    rc = fs_mkdir("/mydir");
+    TEST_ASSERT(rc == 0);
+    for (i = 0; i < 40; i++) {
+        snprintf(filename, sizeof filename, "/mydir/%d", i);
+        nffs_test_util_create_file(filename, "abc", 3);
+    }
+
+    rc = nffs_get_hash_info(&info);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(info.nhi_num_entries == 3 + 2 * 40);
+
+    /* Entries are spread over the table without long chains. */
+    TEST_ASSERT(info.nhi_used_buckets >= 40);
+    TEST_ASSERT(info.nhi_max_chain_len <= 3);
+
+    /*** Entries survive a remount into the resized table. */
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_detect(nffs_current_area_descs);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = nffs_get_hash_info(&info);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(info.nhi_num_buckets == 64);
+    TEST_ASSERT(info.nhi_num_entries == 3 + 2 * 40);
+
+    nffs_config.nc_hash_size = save_hash_size;
+}
@@ -106,6 +106,8 @@ STATS_SECT_DECL(nffs_stats) nffs_stats;
 STATS_NAME_START(nffs_stats)
     STATS_NAME(nffs_stats, nffs_hashcnt_ins)
     STATS_NAME(nffs_stats, nffs_hashcnt_rm)
+    STATS_NAME(nffs_stats, nffs_hashcnt_find)
+    STATS_NAME(nffs_stats, nffs_hashcnt_probe)
     STATS_NAME(nffs_stats, nffs_object_count)
     STATS_NAME(nffs_stats, nffs_iocnt_read)
     STATS_NAME(nffs_stats, nffs_iocnt_write)
@@ -123,6 +125,10 @@ STATS_NAME_START(nffs_stats)
     STATS_NAME(nffs_stats, nffs_readcnt_filename)
     STATS_NAME(nffs_stats, nffs_readcnt_object)
     STATS_NAME(nffs_stats, nffs_readcnt_detect)
+    STATS_NAME(nffs_stats, nffs_wbytes)
+    STATS_NAME(nffs_stats, nffs_gc_copied)
+    STATS_NAME(nffs_stats, nffs_gc_reclaimed)
+    STATS_NAME(nffs_stats, nffs_gc_usecs)
 STATS_NAME_END(nffs_stats)
 
 static void
@@ -687,6 +693,100 @@ nffs_detect(const struct nffs_area_desc *area_descs)
     return rc;
 }
 
+/**
+ * Configures the flash region used to checkpoint the nffs RAM index.  With a
+ * checkpoint in place, nffs_detect() loads the index from the checkpoint and
+ * only reads objects written after it was taken, instead of scanning every
+ * area.  The region must not overlap any nffs area.
+ *
+ * @param area_desc         The checkpoint region; NULL disables
+ *                              checkpoints.
+ *
+ * @return                  0 on success;
+ *                          FS_EINVAL if the region is too small.
+ */
+int
+nffs_set_checkpoint_area(const struct nffs_area_desc *area_desc)
+{
+    int rc;
+
+    nffs_lock();
+
+    if (area_desc == NULL) {
+        memset(&nffs_ckpt_area_desc, 0, sizeof nffs_ckpt_area_desc);
+        rc = 0;
+    } else if (area_desc->nad_length < sizeof (struct nffs_disk_ckpt)) {
+        rc = FS_EINVAL;
+    } else {
+        nffs_ckpt_area_desc = *area_desc;
+        rc = 0;
+    }
+
+    nffs_unlock();
+
+    return rc;
+}
+
+/**
+ * Writes a checkpoint of the current RAM index, so that the next
+ * nffs_detect() does not need to replay objects written up to now.  A
+ * checkpoint is written automatically whenever nffs_detect() has to fall back
+ * to a full scan; garbage collection invalidates it.
+ *
+ * @return                  0 on success;
+ *                          FS_EINVAL if no checkpoint area is configured;
+ *                          FS_EFULL if the checkpoint area is too small;
+ *                          other nonzero on error.
+ */
+int
+nffs_checkpoint(void)
+{
+    int rc;
+
+    nffs_lock();
+
+    if (!nffs_misc_ready()) {
+        rc = FS_EUNINIT;
+    } else {
+        rc = nffs_ckpt_write();
+    }
+
+    nffs_unlock();
+
+    return rc;
+}
+
+/**
+ * Reports the occupancy of the inode / block hash table.  Together with the
+ * nffs_hashcnt_find and nffs_hashcnt_probe statistics (average chain length
+ * walked per lookup), this indicates whether nffs_config.nc_hash_size suits
+ * the volume.
+ *
+ * @param out_info          On success, the hash table occupancy gets
+ *                              written here.
+ *
+ * @return                  0 on success;
+ *                          FS_EUNINIT if nffs is not initialized.
+ */
+int
+nffs_get_hash_info(struct nffs_hash_info *out_info)
+{
+    int rc;
+
+    nffs_lock();
+
+    if (nffs_hash == NULL) {
+        rc = FS_EUNINIT;
+    } else {
+        nffs_hash_get_info(out_info);
+        rc = 0;
+    }
+
+    nffs_unlock();
+
+    return rc;
+}
+
 /**
  * Initializes internal nffs memory and data structures.  This must be called
  * before any nffs operations are attempted.
@@ -772,6 +872,10 @@ void
 nffs_pkg_init(void)
 {
     struct nffs_area_desc descs[MYNEWT_VAL(NFFS_NUM_AREAS) + 1];
+#if MYNEWT_VAL(NFFS_CKPT)
+    struct nffs_area_desc ckpt_desc;
+    const struct flash_area *fa;
+#endif
     int cnt;
     int rc;
 
@@ -790,6 +894,17 @@ nffs_pkg_init(void)
         MYNEWT_VAL(NFFS_FLASH_AREA), &cnt, descs);
     SYSINIT_PANIC_ASSERT(rc == 0);
 
+#if MYNEWT_VAL(NFFS_CKPT)
+    rc = flash_area_open(MYNEWT_VAL(NFFS_CKPT_FLASH_AREA), &fa);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    ckpt_desc.nad_offset = fa->fa_off;
+    ckpt_desc.nad_length = fa->fa_size;
+    ckpt_desc.nad_flash_id = fa->fa_device_id;
+    rc = nffs_set_checkpoint_area(&ckpt_desc);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+
     /* Attempt to restore an existing nffs file system from flash. */
     rc = nffs_detect(descs);
     switch (rc) {
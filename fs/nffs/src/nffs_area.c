@@ -71,6 +71,179 @@ nffs_area_free_space(const struct nffs_area *area)
     return area->na_length - area->na_cur;
 }
 
+/**
+ * Calculates the number of bytes written to an area after its header.
+ */
+static uint32_t
+nffs_area_used_bytes(const struct nffs_area *area)
+{
+    if (area->na_cur <= sizeof (struct nffs_disk_area)) {
+        return 0;
+    }
+    return area->na_cur - sizeof (struct nffs_disk_area);
+}
+
+/**
+ * Calculates the number of bytes in an area that are occupied by current
+ * disk objects, i.e., the amount of data garbage collection would have to
+ * copy out of the area.
+ */
+uint32_t
+nffs_area_live_bytes(const struct nffs_area *area)
+{
+    uint32_t used;
+
+    used = nffs_area_used_bytes(area);
+    if (area->na_obsolete >= used) {
+        return 0;
+    }
+    return used - area->na_obsolete;
+}
+
+/**
+ * Records that a disk object has been superseded or deleted.  Its space is
+ * garbage from now on, and is reclaimed when the area is next collected.
+ *
+ * @param flash_loc             The location of the obsolete object.
+ * @param len                   The size of the object, including header.
+ */
+void
+nffs_area_add_garbage(uint32_t flash_loc, uint32_t len)
+{
+    uint32_t area_offset;
+    uint8_t area_idx;
+
+    if (flash_loc == NFFS_FLASH_LOC_NONE) {
+        return;
+    }
+
+    nffs_flash_loc_expand(flash_loc, &area_idx, &area_offset);
+    if (area_idx < nffs_num_areas) {
+        nffs_areas[area_idx].na_obsolete += len;
+    }
+}
+
+/**
+ * Reads the size of the disk object that the specified hash entry refers to.
+ */
+static int
+nffs_area_object_size(const struct nffs_hash_entry *entry, uint32_t *out_len)
+{
+    struct nffs_disk_inode disk_inode;
+    struct nffs_disk_block disk_block;
+    uint32_t area_offset;
+    uint8_t area_idx;
+    int rc;
+
+    nffs_flash_loc_expand(entry->nhe_flash_loc, &area_idx, &area_offset);
+    if (nffs_hash_id_is_inode(entry->nhe_id)) {
+        rc = nffs_inode_read_disk(area_idx, area_offset, &disk_inode);
+        *out_len = sizeof disk_inode + disk_inode.ndi_filename_len;
+    } else {
+        rc = nffs_block_read_disk(area_idx, area_offset, &disk_block);
+        *out_len = sizeof disk_block + disk_block.ndb_data_len;
+    }
+
+    return rc;
+}
+
+/**
+ * Records that the disk object referred to by the specified hash entry is
+ * about to be superseded or deleted.  The object's size is read from flash;
+ * if that fails the object is not counted.  The counts only steer garbage
+ * collection, so this is not treated as an error.
+ *
+ * @param entry                 The inode or block entry whose current disk
+ *                                  object becomes obsolete.
+ */
+void
+nffs_area_add_garbage_entry(const struct nffs_hash_entry *entry)
+{
+    uint32_t len;
+
+    if (entry->nhe_flash_loc == NFFS_FLASH_LOC_NONE) {
+        return;
+    }
+
+    if (nffs_area_object_size(entry, &len) == 0) {
+        nffs_area_add_garbage(entry->nhe_flash_loc, len);
+    }
+}
+
+/**
+ * Removes an object that is still in use from its area's garbage count.  Only
+ * used while the counts are rebuilt after a restore.
+ *
+ * @param flash_loc             The location of the live object.
+ * @param len                   The size of the object, including header.
+ */
+void
+nffs_area_add_live(uint32_t flash_loc, uint32_t len)
+{
+    struct nffs_area *area;
+    uint32_t area_offset;
+    uint8_t area_idx;
+
+    nffs_flash_loc_expand(flash_loc, &area_idx, &area_offset);
+    if (area_idx >= nffs_num_areas) {
+        return;
+    }
+
+    area = nffs_areas + area_idx;
+    if (area->na_obsolete >= len) {
+        area->na_obsolete -= len;
+    } else {
+        area->na_obsolete = 0;
+    }
+}
+
+/**
+ * Recalculates the amount of garbage in each area from the contents of the
+ * hash table.  Everything written to an area that is not referenced by a
+ * hash entry is garbage.  This is done once after the file system is
+ * restored; from then on, the counts are maintained as objects are
+ * superseded and deleted.
+ *
+ * Objects loaded from a checkpoint are sized from its records, so only the
+ * objects written after the checkpoint are read from flash.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_area_count_garbage(void)
+{
+    struct nffs_hash_entry *entry;
+    struct nffs_hash_entry *next;
+    struct nffs_area *area;
+    uint32_t len;
+    int rc;
+    int i;
+
+    /* Start with everything written counted as garbage, then subtract the
+     * objects that are still in use.
+     */
+    for (i = 0; i < nffs_num_areas; i++) {
+        area = nffs_areas + i;
+        area->na_obsolete = nffs_area_used_bytes(area);
+    }
+
+    NFFS_HASH_FOREACH(entry, i, next) {
+        if (entry->nhe_flash_loc == NFFS_FLASH_LOC_NONE ||
+            nffs_ckpt_entry_is_restored(entry)) {
+            continue;
+        }
+
+        rc = nffs_area_object_size(entry, &len);
+        if (rc != 0) {
+            return rc;
+        }
+
+        nffs_area_add_live(entry->nhe_flash_loc, len);
+    }
+
+    return nffs_ckpt_count_live();
+}
+
 /**
  * Finds a corrupt scratch area.  An area is indentified as a corrupt scratch
  * area if it and another area share the same ID.  Among two areas with the
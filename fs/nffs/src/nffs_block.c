@@ -261,6 +261,10 @@ nffs_block_delete_from_ram(struct nffs_hash_entry *block_entry)
          * found in the hash table - this can occur during the sweep where
          * the inodes were deleted ahead of the blocks.
          */
+        nffs_area_add_garbage(block_entry->nhe_flash_loc,
+                              sizeof (struct nffs_disk_block) +
+                              block.nb_data_len);
+
         inode_entry = block.nb_inode_entry;
         if (inode_entry != NULL &&
             inode_entry->nie_last_block_entry == block_entry) {
@@ -0,0 +1,726 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include "hal/hal_flash.h"
+#include "nffs/nffs.h"
+#include "nffs_priv.h"
+
+/**
+ * Flash region holding the checkpoint of the RAM index.  A length of 0
+ * disables checkpoints.
+ */
+struct nffs_area_desc nffs_ckpt_area_desc;
+
+/** Set if the most recent restore was satisfied from the checkpoint. */
+uint8_t nffs_ckpt_restored;
+
+int
+nffs_ckpt_is_enabled(void)
+{
+    return nffs_ckpt_area_desc.nad_length != 0;
+}
+
+static int
+nffs_ckpt_flash_read(uint32_t offset, void *data, uint32_t len)
+{
+    int rc;
+
+    if (offset + len > nffs_ckpt_area_desc.nad_length) {
+        return FS_EOFFSET;
+    }
+
+    rc = hal_flash_read(nffs_ckpt_area_desc.nad_flash_id,
+                        nffs_ckpt_area_desc.nad_offset + offset, data, len);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    return 0;
+}
+
+static int
+nffs_ckpt_flash_write(uint32_t offset, const void *data, uint32_t len)
+{
+    int rc;
+
+    if (offset + len > nffs_ckpt_area_desc.nad_length) {
+        return FS_EFULL;
+    }
+
+    STATS_INCN(nffs_stats, nffs_wbytes, len);
+    rc = hal_flash_write(nffs_ckpt_area_desc.nad_flash_id,
+                         nffs_ckpt_area_desc.nad_offset + offset, data, len);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    return 0;
+}
+
+/**
+ * Appends a record to the checkpoint body and folds it into the running CRC.
+ */
+static int
+nffs_ckpt_append(uint32_t *offset, const void *data, uint32_t len,
+                 uint16_t *crc)
+{
+    int rc;
+
+    rc = nffs_ckpt_flash_write(*offset, data, len);
+    if (rc != 0) {
+        return rc;
+    }
+
+    *crc = crc16_ccitt(*crc, data, len);
+    *offset += len;
+
+    return 0;
+}
+
+/**
+ * Calculates the CRC of a range of the checkpoint region.
+ */
+static int
+nffs_ckpt_crc(uint16_t initial_crc, uint32_t offset, uint32_t len,
+              uint16_t *out_crc)
+{
+    uint32_t chunk_len;
+    uint16_t crc;
+    int rc;
+
+    crc = initial_crc;
+
+    while (len > 0) {
+        if (len > sizeof nffs_flash_buf) {
+            chunk_len = sizeof nffs_flash_buf;
+        } else {
+            chunk_len = len;
+        }
+
+        rc = nffs_ckpt_flash_read(offset, nffs_flash_buf, chunk_len);
+        if (rc != 0) {
+            return rc;
+        }
+
+        crc = crc16_ccitt(crc, nffs_flash_buf, chunk_len);
+
+        offset += chunk_len;
+        len -= chunk_len;
+    }
+
+    *out_crc = crc;
+    return 0;
+}
+
+/**
+ * Reads the checkpoint header.
+ *
+ * @return                      0 if the header describes a checkpoint that
+ *                                  has not been invalidated;
+ *                              FS_ENOENT if there is no such checkpoint;
+ *                              other nonzero on error.
+ */
+static int
+nffs_ckpt_read_header(struct nffs_disk_ckpt *out_disk_ckpt)
+{
+    uint8_t erased_val;
+    const uint8_t *u8p;
+    int rc;
+    int i;
+
+    rc = nffs_ckpt_flash_read(0, out_disk_ckpt, sizeof *out_disk_ckpt);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (out_disk_ckpt->ndc_magic != NFFS_CKPT_MAGIC) {
+        return FS_ENOENT;
+    }
+
+    erased_val = hal_flash_erased_val(nffs_ckpt_area_desc.nad_flash_id);
+    u8p = (const uint8_t *)&out_disk_ckpt->ndc_invalid;
+    for (i = 0; i < sizeof out_disk_ckpt->ndc_invalid; i++) {
+        if (u8p[i] != erased_val) {
+            return FS_ENOENT;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Calculates the CRC of the bytes immediately preceding the specified write
+ * position in an area.  This catches an area that has been erased and
+ * rewritten since the checkpoint was taken.
+ */
+static int
+nffs_ckpt_area_tail_crc(uint8_t area_idx, uint32_t cur, uint16_t *out_crc)
+{
+    uint32_t len;
+
+    len = cur;
+    if (len > NFFS_CKPT_TAIL_LEN) {
+        len = NFFS_CKPT_TAIL_LEN;
+    }
+
+    return nffs_crc_flash(0, area_idx, cur - len, len, out_crc);
+}
+
+static int
+nffs_ckpt_area_to_disk(uint8_t area_idx,
+                       struct nffs_disk_ckpt_area *out_disk_area)
+{
+    const struct nffs_area *area;
+
+    area = nffs_areas + area_idx;
+
+    memset(out_disk_area, 0, sizeof *out_disk_area);
+    out_disk_area->ndca_offset = area->na_offset;
+    out_disk_area->ndca_cur = area->na_cur;
+    out_disk_area->ndca_id = area->na_id;
+    out_disk_area->ndca_deletes = area->na_deletes;
+    out_disk_area->ndca_flash_id = area->na_flash_id;
+    out_disk_area->ndca_gc_seq = area->na_gc_seq;
+
+    /* The scratch area's contents are not part of the file system. */
+    if (area_idx == nffs_scratch_area_idx) {
+        return 0;
+    }
+
+    return nffs_ckpt_area_tail_crc(area_idx, area->na_cur,
+                                   &out_disk_area->ndca_tail_crc16);
+}
+
+/**
+ * Checks that an area looks the same as when the checkpoint was taken, and
+ * rewinds its write position to the checkpoint's.
+ */
+static int
+nffs_ckpt_area_from_disk(uint8_t area_idx,
+                         const struct nffs_disk_ckpt_area *disk_area)
+{
+    struct nffs_area *area;
+    uint16_t crc;
+    int rc;
+
+    area = nffs_areas + area_idx;
+
+    if (disk_area->ndca_offset != area->na_offset ||
+        disk_area->ndca_flash_id != area->na_flash_id ||
+        disk_area->ndca_id != area->na_id ||
+        disk_area->ndca_gc_seq != area->na_gc_seq) {
+
+        return FS_ECORRUPT;
+    }
+
+    if (area_idx == nffs_scratch_area_idx) {
+        return 0;
+    }
+
+    if (disk_area->ndca_cur < sizeof (struct nffs_disk_area) ||
+        disk_area->ndca_cur > area->na_length) {
+
+        return FS_ECORRUPT;
+    }
+
+    rc = nffs_ckpt_area_tail_crc(area_idx, disk_area->ndca_cur, &crc);
+    if (rc != 0) {
+        return rc;
+    }
+    if (crc != disk_area->ndca_tail_crc16) {
+        return FS_ECORRUPT;
+    }
+
+    area->na_cur = disk_area->ndca_cur;
+    area->na_ckpt_cur = disk_area->ndca_cur;
+    area->na_deletes = disk_area->ndca_deletes;
+
+    return 0;
+}
+
+/**
+ * Builds the checkpoint record for the specified hash entry.
+ *
+ * @return                      0 on success;
+ *                              FS_ENOENT if the entry does not need to be
+ *                                  recorded;
+ *                              other nonzero on error.
+ */
+static int
+nffs_ckpt_object_to_disk(struct nffs_hash_entry *entry,
+                         struct nffs_disk_ckpt_object *out_disk_object)
+{
+    struct nffs_inode_entry *inode_entry;
+    uint32_t area_offset;
+    uint8_t area_idx;
+    int rc;
+
+    if (nffs_hash_entry_is_dummy(entry)) {
+        return FS_ENOENT;
+    }
+
+    memset(out_disk_object, 0, sizeof *out_disk_object);
+    out_disk_object->ndco_flash_loc = entry->nhe_flash_loc;
+    nffs_flash_loc_expand(entry->nhe_flash_loc, &area_idx, &area_offset);
+
+    if (nffs_hash_id_is_inode(entry->nhe_id)) {
+        /* A deleted inode's records are superseded by its delete record,
+         * which predates the checkpoint; leaving the inode out is the same
+         * as sweeping it at restore time.
+         */
+        inode_entry = (struct nffs_inode_entry *)entry;
+        if (nffs_inode_is_deleted(inode_entry)) {
+            return FS_ENOENT;
+        }
+
+        return nffs_inode_read_disk(area_idx, area_offset,
+                                    &out_disk_object->ndco_disk_inode);
+    }
+
+    rc = nffs_block_read_disk(area_idx, area_offset,
+                              &out_disk_object->ndco_disk_block);
+    if (rc != 0) {
+        return rc;
+    }
+
+    inode_entry =
+        nffs_hash_find_inode(out_disk_object->ndco_disk_block.ndb_inode_id);
+    if (inode_entry == NULL || nffs_inode_is_deleted(inode_entry)) {
+        return FS_ENOENT;
+    }
+
+    return 0;
+}
+
+static int
+nffs_ckpt_object_from_disk(const struct nffs_disk_ckpt_object *disk_object,
+                           struct nffs_disk_object *out_disk_object,
+                           uint32_t *out_len)
+{
+    const struct nffs_area *area;
+    uint32_t len;
+
+    memset(out_disk_object, 0, sizeof *out_disk_object);
+    nffs_flash_loc_expand(disk_object->ndco_flash_loc,
+                          &out_disk_object->ndo_area_idx,
+                          &out_disk_object->ndo_offset);
+
+    if (out_disk_object->ndo_area_idx >= nffs_num_areas ||
+        out_disk_object->ndo_area_idx == nffs_scratch_area_idx) {
+
+        return FS_ECORRUPT;
+    }
+
+    if (nffs_hash_id_is_inode(disk_object->ndco_disk_inode.ndi_id)) {
+        out_disk_object->ndo_type = NFFS_OBJECT_TYPE_INODE;
+        out_disk_object->ndo_disk_inode = disk_object->ndco_disk_inode;
+        len = sizeof (struct nffs_disk_inode) +
+              disk_object->ndco_disk_inode.ndi_filename_len;
+    } else if (nffs_hash_id_is_block(disk_object->ndco_disk_block.ndb_id)) {
+        out_disk_object->ndo_type = NFFS_OBJECT_TYPE_BLOCK;
+        out_disk_object->ndo_disk_block = disk_object->ndco_disk_block;
+        len = sizeof (struct nffs_disk_block) +
+              disk_object->ndco_disk_block.ndb_data_len;
+    } else {
+        return FS_ECORRUPT;
+    }
+
+    /* The object must lie entirely before the checkpointed write position. */
+    area = nffs_areas + out_disk_object->ndo_area_idx;
+    if (out_disk_object->ndo_offset < sizeof (struct nffs_disk_area) ||
+        out_disk_object->ndo_offset + len > area->na_cur) {
+
+        return FS_ECORRUPT;
+    }
+
+    *out_len = len;
+    return 0;
+}
+
+/**
+ * Erases the checkpoint region.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_ckpt_erase(void)
+{
+    int rc;
+
+    if (!nffs_ckpt_is_enabled()) {
+        return 0;
+    }
+
+    rc = hal_flash_erase(nffs_ckpt_area_desc.nad_flash_id,
+                         nffs_ckpt_area_desc.nad_offset,
+                         nffs_ckpt_area_desc.nad_length);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    return 0;
+}
+
+/**
+ * Marks the checkpoint as stale.  This must be done before any area is
+ * erased, since the checkpoint describes the areas' contents.  A single word
+ * is written, so this is much cheaper than erasing the checkpoint region.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_ckpt_invalidate(void)
+{
+    struct nffs_disk_ckpt disk_ckpt;
+    uint8_t erased_val;
+    int rc;
+    int i;
+
+    if (!nffs_ckpt_is_enabled()) {
+        return 0;
+    }
+
+    /* The areas are about to change; nothing in them can be sized from the
+     * checkpoint any more.
+     */
+    for (i = 0; i < nffs_num_areas; i++) {
+        nffs_areas[i].na_ckpt_cur = 0;
+    }
+
+    rc = nffs_ckpt_read_header(&disk_ckpt);
+    if (rc == FS_ENOENT) {
+        return 0;
+    }
+    if (rc != 0) {
+        return rc;
+    }
+
+    erased_val = hal_flash_erased_val(nffs_ckpt_area_desc.nad_flash_id);
+    memset(&disk_ckpt.ndc_invalid, (uint8_t)~erased_val,
+           sizeof disk_ckpt.ndc_invalid);
+
+    return nffs_ckpt_flash_write(offsetof(struct nffs_disk_ckpt, ndc_invalid),
+                                 &disk_ckpt.ndc_invalid,
+                                 sizeof disk_ckpt.ndc_invalid);
+}
+
+/**
+ * Writes a checkpoint of the RAM index to the checkpoint region, replacing
+ * the previous one.
+ *
+ * @return                      0 on success;
+ *                              FS_EFULL if the checkpoint region is too
+ *                                  small;
+ *                              other nonzero on error.
+ */
+int
+nffs_ckpt_write(void)
+{
+    struct nffs_disk_ckpt_object disk_object;
+    struct nffs_disk_ckpt_area disk_area;
+    struct nffs_disk_ckpt disk_ckpt;
+    struct nffs_hash_entry *entry;
+    struct nffs_hash_entry *next;
+    uint32_t offset;
+    uint16_t crc;
+    int pass;
+    int rc;
+    int i;
+
+    if (!nffs_ckpt_is_enabled()) {
+        return FS_EINVAL;
+    }
+
+    rc = nffs_ckpt_erase();
+    if (rc != 0) {
+        return rc;
+    }
+
+    memset(&disk_ckpt, 0, sizeof disk_ckpt);
+    offset = sizeof disk_ckpt;
+    crc = 0;
+
+    for (i = 0; i < nffs_num_areas; i++) {
+        rc = nffs_ckpt_area_to_disk(i, &disk_area);
+        if (rc != 0) {
+            return rc;
+        }
+
+        rc = nffs_ckpt_append(&offset, &disk_area, sizeof disk_area, &crc);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    /* Record data blocks before inodes, as they are laid out by normal
+     * writes: restoring an inode then finds its last block already in the
+     * index rather than allocating a placeholder for it.
+     */
+    for (pass = 0; pass < 2; pass++) {
+        NFFS_HASH_FOREACH(entry, i, next) {
+            if (nffs_hash_id_is_block(entry->nhe_id) != (pass == 0)) {
+                continue;
+            }
+
+            rc = nffs_ckpt_object_to_disk(entry, &disk_object);
+            if (rc == FS_ENOENT) {
+                continue;
+            }
+            if (rc != 0) {
+                return rc;
+            }
+
+            rc = nffs_ckpt_append(&offset, &disk_object, sizeof disk_object,
+                                  &crc);
+            if (rc != 0) {
+                return rc;
+            }
+            disk_ckpt.ndc_num_objects++;
+        }
+    }
+
+    disk_ckpt.ndc_magic = NFFS_CKPT_MAGIC;
+    disk_ckpt.ndc_next_file_id = nffs_hash_next_file_id;
+    disk_ckpt.ndc_next_dir_id = nffs_hash_next_dir_id;
+    disk_ckpt.ndc_next_block_id = nffs_hash_next_block_id;
+    disk_ckpt.ndc_num_areas = nffs_num_areas;
+    disk_ckpt.ndc_crc16 = crc16_ccitt(crc, &disk_ckpt,
+                                      offsetof(struct nffs_disk_ckpt,
+                                               ndc_crc16));
+
+    /* The header goes last; a checkpoint interrupted before this point has
+     * no magic number and is ignored.  The invalid word stays erased.
+     */
+    return nffs_ckpt_flash_write(0, &disk_ckpt,
+                                 offsetof(struct nffs_disk_ckpt, ndc_invalid));
+}
+
+/**
+ * Loads the RAM index from the checkpoint.  The areas must already have been
+ * detected.  On success, each area's write position is set to where the
+ * checkpoint was taken, so that only objects written afterwards need to be
+ * read from flash.
+ *
+ * On failure the RAM representation is left partially populated; the caller
+ * is expected to reset it and fall back to a full scan.
+ *
+ * @return                      0 on success;
+ *                              FS_ENOENT if there is no usable checkpoint;
+ *                              FS_ECORRUPT if the checkpoint does not match
+ *                                  the areas;
+ *                              other nonzero on error.
+ */
+int
+nffs_ckpt_restore(void)
+{
+    struct nffs_disk_ckpt_object disk_ckpt_object;
+    struct nffs_disk_ckpt_area disk_area;
+    struct nffs_disk_object disk_object;
+    struct nffs_disk_ckpt disk_ckpt;
+    uint32_t max_objects;
+    uint32_t offset;
+    uint32_t len;
+    uint16_t crc;
+    uint32_t i;
+    int rc;
+
+    rc = nffs_ckpt_read_header(&disk_ckpt);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (disk_ckpt.ndc_num_areas != nffs_num_areas) {
+        return FS_ECORRUPT;
+    }
+
+    len = sizeof disk_ckpt + nffs_num_areas * sizeof disk_area;
+    if (len > nffs_ckpt_area_desc.nad_length) {
+        return FS_ECORRUPT;
+    }
+    max_objects = (nffs_ckpt_area_desc.nad_length - len) /
+                  sizeof disk_ckpt_object;
+    if (disk_ckpt.ndc_num_objects > max_objects) {
+        return FS_ECORRUPT;
+    }
+    len += disk_ckpt.ndc_num_objects * sizeof disk_ckpt_object;
+
+    rc = nffs_ckpt_crc(0, sizeof disk_ckpt, len - sizeof disk_ckpt, &crc);
+    if (rc != 0) {
+        return rc;
+    }
+    crc = crc16_ccitt(crc, &disk_ckpt,
+                      offsetof(struct nffs_disk_ckpt, ndc_crc16));
+    if (crc != disk_ckpt.ndc_crc16) {
+        return FS_ECORRUPT;
+    }
+
+    offset = sizeof disk_ckpt;
+    for (i = 0; i < nffs_num_areas; i++) {
+        rc = nffs_ckpt_flash_read(offset, &disk_area, sizeof disk_area);
+        if (rc != 0) {
+            return rc;
+        }
+        offset += sizeof disk_area;
+
+        rc = nffs_ckpt_area_from_disk(i, &disk_area);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    for (i = 0; i < disk_ckpt.ndc_num_objects; i++) {
+        rc = nffs_ckpt_flash_read(offset, &disk_ckpt_object,
+                                  sizeof disk_ckpt_object);
+        if (rc != 0) {
+            return rc;
+        }
+        offset += sizeof disk_ckpt_object;
+
+        rc = nffs_ckpt_object_from_disk(&disk_ckpt_object, &disk_object,
+                                        &len);
+        if (rc != 0) {
+            return rc;
+        }
+
+        rc = nffs_restore_object(&disk_object, 0);
+        if (rc != 0) {
+            return rc;
+        }
+        STATS_INC(nffs_stats, nffs_object_count);
+    }
+
+    /* Deleted objects are not recorded, but their IDs must not be reused. */
+    if (disk_ckpt.ndc_next_file_id > nffs_hash_next_file_id) {
+        nffs_hash_next_file_id = disk_ckpt.ndc_next_file_id;
+    }
+    if (disk_ckpt.ndc_next_dir_id > nffs_hash_next_dir_id) {
+        nffs_hash_next_dir_id = disk_ckpt.ndc_next_dir_id;
+    }
+    if (disk_ckpt.ndc_next_block_id > nffs_hash_next_block_id) {
+        nffs_hash_next_block_id = disk_ckpt.ndc_next_block_id;
+    }
+
+    return 0;
+}
+
+/**
+ * Indicates whether the disk object that the specified hash entry refers to
+ * was loaded from the checkpoint during the current restore, as opposed to
+ * read from an area.
+ */
+int
+nffs_ckpt_entry_is_restored(const struct nffs_hash_entry *entry)
+{
+    uint32_t area_offset;
+    uint8_t area_idx;
+
+    if (entry->nhe_flash_loc == NFFS_FLASH_LOC_NONE) {
+        return 0;
+    }
+
+    nffs_flash_loc_expand(entry->nhe_flash_loc, &area_idx, &area_offset);
+    return area_idx < nffs_num_areas &&
+           area_offset < nffs_areas[area_idx].na_ckpt_cur;
+}
+
+/**
+ * Removes the objects loaded from the checkpoint that are still in use from
+ * their areas' garbage counts.  Their sizes are taken from the checkpoint
+ * records, so the areas are not read.  Does nothing if the file system was
+ * not restored from a checkpoint.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_ckpt_count_live(void)
+{
+    struct nffs_disk_ckpt_object disk_ckpt_object;
+    struct nffs_disk_object disk_object;
+    struct nffs_disk_ckpt disk_ckpt;
+    struct nffs_hash_entry *entry;
+    uint32_t chunk_cnt;
+    uint32_t offset;
+    uint32_t len;
+    uint32_t id;
+    uint32_t i;
+    uint32_t j;
+    int rc;
+
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (nffs_areas[i].na_ckpt_cur != 0) {
+            break;
+        }
+    }
+    if (i == nffs_num_areas) {
+        return 0;
+    }
+
+    rc = nffs_ckpt_read_header(&disk_ckpt);
+    if (rc != 0) {
+        return rc;
+    }
+
+    offset = sizeof disk_ckpt +
+             nffs_num_areas * sizeof (struct nffs_disk_ckpt_area);
+
+    for (i = 0; i < disk_ckpt.ndc_num_objects; i += chunk_cnt) {
+        chunk_cnt = sizeof nffs_flash_buf / sizeof disk_ckpt_object;
+        if (chunk_cnt > disk_ckpt.ndc_num_objects - i) {
+            chunk_cnt = disk_ckpt.ndc_num_objects - i;
+        }
+
+        rc = nffs_ckpt_flash_read(offset, nffs_flash_buf,
+                                  chunk_cnt * sizeof disk_ckpt_object);
+        if (rc != 0) {
+            return rc;
+        }
+        offset += chunk_cnt * sizeof disk_ckpt_object;
+
+        for (j = 0; j < chunk_cnt; j++) {
+            memcpy(&disk_ckpt_object,
+                   nffs_flash_buf + j * sizeof disk_ckpt_object,
+                   sizeof disk_ckpt_object);
+
+            rc = nffs_ckpt_object_from_disk(&disk_ckpt_object, &disk_object,
+                                            &len);
+            if (rc != 0) {
+                return rc;
+            }
+
+            if (disk_object.ndo_type == NFFS_OBJECT_TYPE_INODE) {
+                id = disk_object.ndo_disk_inode.ndi_id;
+            } else {
+                id = disk_object.ndo_disk_block.ndb_id;
+            }
+
+            /* Superseded or deleted since the checkpoint otherwise. */
+            entry = nffs_hash_find(id);
+            if (entry != NULL &&
+                entry->nhe_flash_loc == disk_ckpt_object.ndco_flash_loc) {
+
+                nffs_area_add_live(entry->nhe_flash_loc, len);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -28,6 +28,7 @@ const struct nffs_config nffs_config_dflt = {
     .nc_num_cache_inodes = 4,
     .nc_num_cache_blocks = 64,
     .nc_num_dirs = 4,
+    .nc_hash_size = 256,
 };
 
 void
@@ -51,4 +52,7 @@ nffs_config_init(void)
     if (nffs_config.nc_num_dirs == 0) {
         nffs_config.nc_num_dirs = nffs_config_dflt.nc_num_dirs;
     }
+    if (nffs_config.nc_hash_size == 0) {
+        nffs_config.nc_hash_size = nffs_config_dflt.nc_hash_size;
+    }
 }
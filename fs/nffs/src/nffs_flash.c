@@ -97,6 +97,7 @@ nffs_flash_write(uint8_t area_idx, uint32_t area_offset, const void *data,
     }
 
     STATS_INC(nffs_stats, nffs_iocnt_write);
+    STATS_INCN(nffs_stats, nffs_wbytes, len);
     rc = hal_flash_write(area->na_flash_id, area->na_offset + area_offset,
                          data, len);
     if (rc != 0) {
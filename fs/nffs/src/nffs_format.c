@@ -77,6 +77,11 @@ nffs_format_area(uint8_t area_idx, int is_scratch)
         return FS_EHW;
     }
     area->na_cur = 0;
+    area->na_obsolete = 0;
+    area->na_deletes = 0;
+    area->na_clean_gc = nffs_gc_count;
+    area->na_delete_gc = nffs_gc_count;
+    area->na_ckpt_cur = 0;
 
     nffs_area_to_disk(area, &disk_area);
 
@@ -113,6 +118,11 @@ nffs_format_full(const struct nffs_area_desc *area_descs)
     /* Start from a clean state. */
     nffs_misc_reset();
 
+    rc = nffs_ckpt_erase();
+    if (rc != 0) {
+        goto err;
+    }
+
     /* Select largest area to be the initial scratch area. */
     nffs_scratch_area_idx = 0;
     for (i = 1; area_descs[i].nad_length != 0; i++) {
@@ -78,12 +78,13 @@ nffs_gc_copy_inode(struct nffs_inode_entry *inode_entry, uint8_t to_area_idx)
 }
 
 /**
- * Selects the most appropriate area for garbage collection.
+ * Selects the area to garbage collect under NFFS_GC_POLICY_ROTATE.  Areas
+ * are collected in turn, regardless of their contents.
  *
  * @return                  The ID of the area to garbage collect.
  */
 static uint16_t
-nffs_gc_select_area(void)
+nffs_gc_select_area_rotate(void)
 {
     const struct nffs_area *area;
     uint8_t best_area_idx;
@@ -115,6 +116,203 @@ nffs_gc_select_area(void)
     return best_area_idx;
 }
 
+/**
+ * Calculates an area's age: how many fewer times it has been garbage
+ * collected than the most collected area, plus one.  An area's garbage
+ * collection sequence number counts the times it has been collected; these
+ * wrap, so they are compared as signed 8-bit differences.
+ */
+static uint32_t
+nffs_gc_area_age(const struct nffs_area *area, uint8_t newest_seq)
+{
+    return (uint8_t)(newest_seq - area->na_gc_seq) + 1;
+}
+
+/**
+ * Determines whether an area's deletion records can be discarded.  A
+ * deletion record has to outlive every older version of its inode.  Those
+ * can only be in areas that have not been rebuilt by a garbage collection
+ * since the deletion, so the records are kept until every other area has
+ * been.
+ *
+ * @param area_idx          The index of the area to check.
+ *
+ * @return                  1 if the deletion records can be discarded;
+ *                          0 if garbage collection must copy them.
+ */
+static int
+nffs_gc_deletes_expired(uint8_t area_idx)
+{
+    const struct nffs_area *area;
+    int i;
+
+    area = nffs_areas + area_idx;
+    if (area->na_deletes == 0) {
+        return 1;
+    }
+
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (i == area_idx || i == nffs_scratch_area_idx) {
+            continue;
+        }
+
+        if ((int)(nffs_areas[i].na_clean_gc - area->na_delete_gc) <= 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Calculates the number of bytes a collection of the specified area would
+ * reclaim.  Deletion records that are still needed get copied, so they
+ * count as live data rather than garbage.
+ */
+static uint32_t
+nffs_gc_area_garbage(uint8_t area_idx)
+{
+    const struct nffs_area *area;
+    uint32_t kept;
+
+    area = nffs_areas + area_idx;
+    if (nffs_gc_deletes_expired(area_idx)) {
+        return area->na_obsolete;
+    }
+
+    kept = area->na_deletes * sizeof (struct nffs_disk_inode);
+    if (kept >= area->na_obsolete) {
+        return 0;
+    }
+    return area->na_obsolete - kept;
+}
+
+/**
+ * Rates an area as a garbage collection victim; higher is better.
+ *
+ * The greedy policy picks the area containing the most garbage.  The
+ * cost-benefit policy weighs the space gained (the area's garbage; unwritten
+ * space is free without a collection) against the cost of reading and
+ * copying the live data out, scaled by the area's age:
+ *
+ *     score = g * age / (1 + u),  g = garbage bytes / area length,
+ *                                 u = live bytes / area length
+ *
+ * Old areas with little live data are preferred, and areas holding
+ * long-lived data are eventually recycled as well.
+ */
+static uint64_t
+nffs_gc_area_score(uint8_t area_idx, uint32_t age, int policy)
+{
+    const struct nffs_area *area;
+    uint32_t garbage;
+    uint32_t live;
+
+    area = nffs_areas + area_idx;
+    garbage = nffs_gc_area_garbage(area_idx);
+    if (policy == NFFS_GC_POLICY_GREEDY) {
+        return garbage;
+    }
+
+    live = nffs_area_live_bytes(area) + (area->na_obsolete - garbage);
+    return ((uint64_t)garbage * age << 16) / (area->na_length + live);
+}
+
+/**
+ * Selects the most appropriate area for garbage collection.  With
+ * NFFS_GC_POLICY_ROTATE areas are collected in turn; the other policies
+ * choose based on how much of each area is garbage.  Garbage collection
+ * uses the configured NFFS_GC_POLICY; the policy is an argument so that all
+ * of them can be tested.
+ *
+ * Only areas as large as the largest area are considered.  This keeps the
+ * scratch area large enough to take the contents of any victim.  An area
+ * that has not been collected for NFFS_GC_MAX_AGE cycles is selected
+ * regardless of its score, so that areas holding static data still take
+ * their share of erase cycles.
+ *
+ * Deletion records that may still shadow an older version of their inode
+ * are copied by the collection, so they are scored as live data.  Ties go to
+ * the least collected area.
+ *
+ * @param policy            The NFFS_GC_POLICY_[...] to apply.
+ *
+ * @return                  The ID of the area to garbage collect.
+ */
+uint16_t
+nffs_gc_select_area(int policy)
+{
+    const struct nffs_area *area;
+    uint64_t best_score;
+    uint64_t score;
+    uint32_t max_length;
+    uint32_t best_age;
+    uint32_t age;
+    uint8_t best_area_idx;
+    uint8_t newest_seq;
+    int8_t diff;
+    int first;
+    int i;
+
+    if (policy == NFFS_GC_POLICY_ROTATE) {
+        return nffs_gc_select_area_rotate();
+    }
+
+    /* Find the largest area size and the most collected area. */
+    first = 1;
+    max_length = 0;
+    newest_seq = 0;
+    for (i = 0; i < nffs_num_areas; i++) {
+        area = nffs_areas + i;
+        if (i != nffs_scratch_area_idx && area->na_length > max_length) {
+            max_length = area->na_length;
+        }
+
+        diff = area->na_gc_seq - newest_seq;
+        if (first || diff > 0) {
+            newest_seq = area->na_gc_seq;
+            first = 0;
+        }
+    }
+
+    best_area_idx = nffs_scratch_area_idx;
+    best_score = 0;
+    best_age = 0;
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (i == nffs_scratch_area_idx) {
+            continue;
+        }
+
+        area = nffs_areas + i;
+        if (area->na_length != max_length) {
+            continue;
+        }
+
+        age = nffs_gc_area_age(area, newest_seq);
+        if (MYNEWT_VAL(NFFS_GC_MAX_AGE) != 0 &&
+            age > MYNEWT_VAL(NFFS_GC_MAX_AGE)) {
+
+            /* Overdue for wear leveling; outranks any score. */
+            score = UINT64_MAX;
+        } else {
+            score = nffs_gc_area_score(i, age, policy);
+        }
+
+        if (best_area_idx == nffs_scratch_area_idx ||
+            score > best_score ||
+            (score == best_score && age > best_age)) {
+
+            best_area_idx = i;
+            best_score = score;
+            best_age = age;
+        }
+    }
+
+    assert(best_area_idx != nffs_scratch_area_idx);
+
+    return best_area_idx;
+}
+
 static int
 nffs_gc_block_chain_copy(struct nffs_hash_entry *last_entry, uint32_t data_len,
                          uint8_t to_area_idx)
@@ -395,12 +593,81 @@ nffs_gc_inode_blocks(struct nffs_inode_entry *inode_entry,
     return 0;
 }
 
+/**
+ * Copies the deletion records in the source area to the destination area.
+ * The source area is read sequentially, since deletion records are not
+ * referenced from RAM.
+ *
+ * @param from_area_idx         The index of the area to copy from.
+ * @param to_area_idx           The index of the area to copy to.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+static int
+nffs_gc_copy_deletes(uint8_t from_area_idx, uint8_t to_area_idx)
+{
+    struct nffs_disk_object disk_object;
+    struct nffs_area *from_area;
+    struct nffs_area *to_area;
+    uint32_t from_offset;
+    uint32_t to_offset;
+    uint16_t copy_len;
+    int rc;
+
+    from_area = nffs_areas + from_area_idx;
+    to_area = nffs_areas + to_area_idx;
+
+    from_offset = sizeof (struct nffs_disk_area);
+    while (from_offset < from_area->na_cur) {
+        rc = nffs_flash_read(from_area_idx, from_offset,
+                             &disk_object.ndo_un_obj,
+                             sizeof disk_object.ndo_un_obj);
+        if (rc != 0) {
+            return rc;
+        }
+        STATS_INC(nffs_stats, nffs_readcnt_object);
+
+        if (nffs_hash_id_is_block(disk_object.ndo_disk_block.ndb_id)) {
+            from_offset += sizeof disk_object.ndo_disk_block +
+                           disk_object.ndo_disk_block.ndb_data_len;
+        } else if (!nffs_hash_id_is_inode(disk_object.ndo_disk_inode.ndi_id)) {
+            /* Not an object header; skip ahead as restore does. */
+            from_offset++;
+        } else if (nffs_crc_disk_inode_validate(&disk_object.ndo_disk_inode,
+                                                from_area_idx,
+                                                from_offset) != 0) {
+            from_offset++;
+        } else {
+            copy_len = sizeof disk_object.ndo_disk_inode +
+                       disk_object.ndo_disk_inode.ndi_filename_len;
+            if (disk_object.ndo_disk_inode.ndi_flags &
+                NFFS_INODE_FLAG_DELETED) {
+
+                to_offset = to_area->na_cur;
+                rc = nffs_flash_copy(from_area_idx, from_offset, to_area_idx,
+                                     to_offset, copy_len);
+                if (rc != 0) {
+                    return rc;
+                }
+
+                nffs_area_add_garbage(nffs_flash_loc(to_area_idx, to_offset),
+                                      copy_len);
+                to_area->na_deletes++;
+            }
+            from_offset += copy_len;
+        }
+    }
+
+    to_area->na_delete_gc = from_area->na_delete_gc;
+
+    return 0;
+}
+
 /**
  * Triggers a garbage collection cycle.  This is implemented as follows:
  *
- *  (1) The non-scratch area with the lowest garbage collection sequence
- *      number is selected as the "source area."  If there are other areas
- *      with the same sequence number, the first one encountered is selected.
+ *  (1) A non-scratch area is selected as the "source area" according to
+ *      NFFS_GC_POLICY (see nffs_gc_select_area()).
  *
  *  (2) The source area's ID is written to the scratch area's header,
  *      transforming it into a non-scratch ID.  The former scratch area is now
@@ -420,6 +687,9 @@ nffs_gc_inode_blocks(struct nffs_inode_entry *inode_entry,
  *              are consolidated and copied to the destination area as a single
  *              new block.
  *
+ *      Deletion records in the source area are copied as well, until every
+ *      other area has been rebuilt since they were written.
+ *
  *  (4) The source area is reformatted as a scratch sector (i.e., its header
  *      indicates an ID of 0xffff).  The area's garbage collection sequence
  *      number is incremented prior to rewriting the header.  This area is now
@@ -452,22 +722,45 @@ nffs_gc(uint8_t *out_area_idx)
     struct nffs_area *to_area;
     struct nffs_inode_entry *inode_entry;
     uint32_t area_offset;
+    uint32_t to_area_start;
+    int64_t start_usecs;
     uint8_t from_area_idx;
     uint8_t area_idx;
     int rc;
     int i;
 
-    from_area_idx = nffs_gc_select_area();
+    start_usecs = os_get_uptime_usec();
+
+    from_area_idx = nffs_gc_select_area(MYNEWT_VAL(NFFS_GC_POLICY));
     from_area = nffs_areas + from_area_idx;
     to_area = nffs_areas + nffs_scratch_area_idx;
 
+    /* The checkpoint no longer describes the areas once one is erased. */
+    rc = nffs_ckpt_invalidate();
+    if (rc != 0) {
+        return rc;
+    }
+
     rc = nffs_format_from_scratch_area(nffs_scratch_area_idx,
                                        from_area->na_id);
     if (rc != 0) {
         return rc;
     }
+    to_area->na_obsolete = 0;
+    to_area->na_deletes = 0;
+    to_area_start = to_area->na_cur;
+
+    if (!nffs_gc_deletes_expired(from_area_idx)) {
+        rc = nffs_gc_copy_deletes(from_area_idx, nffs_scratch_area_idx);
+        if (rc != 0) {
+            return rc;
+        }
+    }
 
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    /* Nothing older than this collection remains in the destination area. */
+    to_area->na_clean_gc = nffs_gc_count + 1;
+
+    for (i = 0; i < nffs_hash_size; i++) {
         entry = SLIST_FIRST(nffs_hash + i);
         while (entry != NULL) {
             next = SLIST_NEXT(entry, nhe_next);
@@ -506,6 +799,10 @@ nffs_gc(uint8_t *out_area_idx)
      */
     assert(to_area->na_cur <= from_area->na_cur);
 
+    STATS_INCN(nffs_stats, nffs_gc_copied, to_area->na_cur - to_area_start);
+    STATS_INCN(nffs_stats, nffs_gc_reclaimed,
+               from_area->na_cur - to_area->na_cur);
+
     /* Turn the source area into the new scratch area. */
     from_area->na_gc_seq++;
     rc = nffs_format_area(from_area_idx, 1);
@@ -534,6 +831,8 @@ nffs_gc(uint8_t *out_area_idx)
      */
     nffs_gc_count++;
     STATS_INC(nffs_stats, nffs_gccnt);
+    STATS_INCN(nffs_stats, nffs_gc_usecs,
+               (uint32_t)(os_get_uptime_usec() - start_usecs));
 
     return 0;
 }
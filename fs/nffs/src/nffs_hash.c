@@ -25,6 +25,12 @@
 
 struct nffs_hash_list *nffs_hash;
 
+/** Number of buckets in nffs_hash; always a power of two. */
+uint32_t nffs_hash_size;
+
+/** log2(nffs_hash_size). */
+static uint8_t nffs_hash_bits;
+
 uint32_t nffs_hash_next_dir_id;
 uint32_t nffs_hash_next_file_id;
 uint32_t nffs_hash_next_block_id;
@@ -53,38 +59,16 @@ nffs_hash_id_is_block(uint32_t id)
     return id >= NFFS_ID_BLOCK_MIN && id < NFFS_ID_BLOCK_MAX;
 }
 
-static int
+/**
+ * Maps an object ID to a bucket index.  IDs are handed out sequentially from
+ * a few widely separated ranges, so the ID is multiplied by 2^32 / phi and the
+ * top bits of the product are kept; this spreads every range evenly over the
+ * table whatever its size.
+ */
+int
 nffs_hash_fn(uint32_t id)
 {
-    return id % NFFS_HASH_SIZE;
-}
-
-static struct nffs_hash_entry *
-nffs_hash_find_reorder(uint32_t id)
-{
-    struct nffs_hash_entry *entry;
-    struct nffs_hash_entry *prev;
-    struct nffs_hash_list *list;
-    int idx;
-
-    idx = nffs_hash_fn(id);
-    list = nffs_hash + idx;
-
-    prev = NULL;
-    SLIST_FOREACH(entry, list, nhe_next) {
-        if (entry->nhe_id == id) {
-            /* Put entry at the front of the list. */
-            if (prev != NULL) {
-                SLIST_NEXT(prev, nhe_next) = SLIST_NEXT(entry, nhe_next);
-                SLIST_INSERT_HEAD(list, entry, nhe_next);
-            }
-            return entry;
-        }
-
-        prev = entry;
-    }
-
-    return NULL;
+    return (uint32_t)(id * 0x9e3779b1) >> (32 - nffs_hash_bits);
 }
 
 struct nffs_hash_entry *
@@ -97,7 +81,9 @@ nffs_hash_find(uint32_t id)
     idx = nffs_hash_fn(id);
     list = nffs_hash + idx;
 
+    STATS_INC(nffs_stats, nffs_hashcnt_find);
     SLIST_FOREACH(entry, list, nhe_next) {
+        STATS_INC(nffs_stats, nffs_hashcnt_probe);
         if (entry->nhe_id == id) {
             return entry;
         }
@@ -113,7 +99,7 @@ nffs_hash_find_inode(uint32_t id)
 
     assert(nffs_hash_id_is_inode(id));
 
-    entry = nffs_hash_find_reorder(id);
+    entry = nffs_hash_find(id);
     return (struct nffs_inode_entry *)entry;
 }
 
@@ -124,7 +110,7 @@ nffs_hash_find_block(uint32_t id)
 
     assert(nffs_hash_id_is_block(id));
 
-    entry = nffs_hash_find_reorder(id);
+    entry = nffs_hash_find(id);
     return entry;
 }
 
@@ -194,19 +180,57 @@ nffs_hash_remove(struct nffs_hash_entry *entry)
     assert(nffs_hash_find(entry->nhe_id) == NULL);
 }
 
+/**
+ * Reports how evenly the hash table is populated.
+ */
+void
+nffs_hash_get_info(struct nffs_hash_info *out_info)
+{
+    struct nffs_hash_entry *entry;
+    uint32_t chain_len;
+    uint32_t i;
+
+    memset(out_info, 0, sizeof *out_info);
+    out_info->nhi_num_buckets = nffs_hash_size;
+
+    for (i = 0; i < nffs_hash_size; i++) {
+        chain_len = 0;
+        SLIST_FOREACH(entry, nffs_hash + i, nhe_next) {
+            chain_len++;
+        }
+
+        if (chain_len != 0) {
+            out_info->nhi_used_buckets++;
+        }
+        if (chain_len > out_info->nhi_max_chain_len) {
+            out_info->nhi_max_chain_len = chain_len;
+        }
+        out_info->nhi_num_entries += chain_len;
+    }
+}
+
 int
 nffs_hash_init(void)
 {
-    int i;
+    uint32_t i;
 
     free(nffs_hash);
 
-    nffs_hash = malloc(NFFS_HASH_SIZE * sizeof *nffs_hash);
+    /* Use the largest power of two not exceeding the configured size. */
+    nffs_hash_bits = NFFS_HASH_MIN_BITS;
+    while (nffs_hash_bits < NFFS_HASH_MAX_BITS &&
+           (uint32_t)2 << nffs_hash_bits <= nffs_config.nc_hash_size) {
+
+        nffs_hash_bits++;
+    }
+    nffs_hash_size = (uint32_t)1 << nffs_hash_bits;
+
+    nffs_hash = malloc(nffs_hash_size * sizeof *nffs_hash);
     if (nffs_hash == NULL) {
         return FS_ENOMEM;
     }
 
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         SLIST_INIT(nffs_hash + i);
     }
 
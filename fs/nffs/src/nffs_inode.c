@@ -315,6 +315,7 @@ nffs_inode_delete_from_ram(struct nffs_inode_entry *inode_entry,
     }
 
     nffs_cache_inode_delete(inode_entry);
+    nffs_area_add_garbage_entry(&inode_entry->nie_hash_entry);
     /*
      * XXX Not deleting empty inode delete records from hash could prevent
      * a case where we could lose delete records in a gc operation
@@ -442,6 +443,7 @@ nffs_inode_process_unlink_list(struct nffs_hash_entry **inout_next,
         /* The directory is already removed from the hash table; just free its
          * memory.
          */
+        nffs_area_add_garbage_entry(&inode_entry->nie_hash_entry);
         nffs_inode_entry_free(inode_entry);
     }
 
@@ -501,6 +503,14 @@ nffs_inode_delete_from_disk(struct nffs_inode *inode)
         return rc;
     }
 
+    /* The deletion record is not referenced from RAM.  Garbage collection
+     * keeps it until every other area has been rebuilt, since older versions
+     * of the inode may still be on disk until then.
+     */
+    nffs_area_add_garbage(nffs_flash_loc(area_idx, offset), sizeof disk_inode);
+    nffs_areas[area_idx].na_deletes++;
+    nffs_areas[area_idx].na_delete_gc = nffs_gc_count;
+
     return 0;
 }
 
@@ -630,6 +640,8 @@ nffs_inode_rename(struct nffs_inode_entry *inode_entry,
         return rc;
     }
 
+    nffs_area_add_garbage(inode_entry->nie_hash_entry.nhe_flash_loc,
+                          sizeof disk_inode + inode.ni_filename_len);
     inode_entry->nie_hash_entry.nhe_flash_loc =
         nffs_flash_loc(area_idx, area_offset);
 
@@ -701,6 +713,8 @@ nffs_inode_update(struct nffs_inode_entry *inode_entry)
         return rc;
     }
 
+    nffs_area_add_garbage(inode_entry->nie_hash_entry.nhe_flash_loc,
+                          sizeof disk_inode + filename_len);
     inode_entry->nie_hash_entry.nhe_flash_loc =
         nffs_flash_loc(area_idx, area_offset);
     return 0;
@@ -32,7 +32,8 @@
 extern "C" {
 #endif
 
-#define NFFS_HASH_SIZE               256
+#define NFFS_HASH_MIN_BITS           4
+#define NFFS_HASH_MAX_BITS           16
 
 #define NFFS_ID_DIR_MIN              0
 #define NFFS_ID_DIR_MAX              0x10000000
@@ -65,6 +66,10 @@ extern "C" {
 #define NFFS_DETECT_FAIL_IGNORE     1
 #define NFFS_DETECT_FAIL_FORMAT     2
 
+#define NFFS_GC_POLICY_ROTATE       0
+#define NFFS_GC_POLICY_GREEDY       1
+#define NFFS_GC_POLICY_COST_BENEFIT 2
+
 /** On-disk representation of an area header. */
 struct nffs_disk_area {
     uint32_t nda_magic[4];  /* NFFS_AREA_MAGIC{0,1,2,3} */
@@ -182,7 +187,13 @@ struct nffs_area {
     uint16_t na_id;
     uint8_t na_gc_seq;
     uint8_t na_flash_id;
-    uint32_t na_obsolete;   /* deleted bytecount */
+    uint32_t na_obsolete;   /* bytes of superseded / deleted objects */
+    uint16_t na_deletes;    /* deletion records in this area */
+    unsigned int na_clean_gc;   /* nffs_gc_count when the area last held
+                                   only live objects */
+    unsigned int na_delete_gc;  /* nffs_gc_count at the newest deletion */
+    uint32_t na_ckpt_cur;   /* write position when checkpointed; 0 if the
+                               area was not restored from a checkpoint */
 };
 
 struct nffs_disk_object {
@@ -198,6 +209,48 @@ struct nffs_disk_object {
 #define ndo_disk_inode    ndo_un_obj.ndo_disk_inode
 #define ndo_disk_block    ndo_un_obj.ndo_disk_block
 
+#define NFFS_CKPT_MAGIC             0x504b434e  /* "NCKP" */
+
+/** Number of bytes preceding an area's write position covered by a CRC. */
+#define NFFS_CKPT_TAIL_LEN          32
+
+/**
+ * On-disk representation of a checkpoint header.  The header is followed by
+ * one nffs_disk_ckpt_area per area and then by one nffs_disk_ckpt_object per
+ * object in the RAM index.
+ */
+struct nffs_disk_ckpt {
+    uint32_t ndc_magic;         /* NFFS_CKPT_MAGIC */
+    uint32_t ndc_num_objects;
+    uint32_t ndc_next_file_id;
+    uint32_t ndc_next_dir_id;
+    uint32_t ndc_next_block_id;
+    uint8_t ndc_num_areas;
+    uint8_t reserved8;
+    uint16_t ndc_crc16;         /* Covers records, then preceding fields. */
+    uint32_t ndc_invalid;       /* Left erased until checkpoint is stale. */
+};
+
+/** On-disk state of one area at the time a checkpoint was taken. */
+struct nffs_disk_ckpt_area {
+    uint32_t ndca_offset;       /* Flash offset of start of area. */
+    uint32_t ndca_cur;          /* Write position; replay starts here. */
+    uint16_t ndca_id;
+    uint16_t ndca_deletes;
+    uint16_t ndca_tail_crc16;   /* Covers bytes just before ndca_cur. */
+    uint8_t ndca_flash_id;
+    uint8_t ndca_gc_seq;
+};
+
+/** On-disk checkpoint record of one object in the RAM index. */
+struct nffs_disk_ckpt_object {
+    uint32_t ndco_flash_loc;
+    union {
+        struct nffs_disk_inode ndco_disk_inode;
+        struct nffs_disk_block ndco_disk_block;
+    };
+};
+
 struct nffs_seek_info {
     struct nffs_block nsi_last_block;
     uint32_t nsi_block_file_off;
@@ -250,6 +303,8 @@ struct nffs_dir {
 STATS_SECT_START(nffs_stats)
     STATS_SECT_ENTRY(nffs_hashcnt_ins)
     STATS_SECT_ENTRY(nffs_hashcnt_rm)
+    STATS_SECT_ENTRY(nffs_hashcnt_find)
+    STATS_SECT_ENTRY(nffs_hashcnt_probe)
     STATS_SECT_ENTRY(nffs_object_count)
     STATS_SECT_ENTRY(nffs_iocnt_read)
     STATS_SECT_ENTRY(nffs_iocnt_write)
@@ -267,6 +322,10 @@ STATS_SECT_START(nffs_stats)
     STATS_SECT_ENTRY(nffs_readcnt_filename)
     STATS_SECT_ENTRY(nffs_readcnt_object)
     STATS_SECT_ENTRY(nffs_readcnt_detect)
+    STATS_SECT_ENTRY(nffs_wbytes)
+    STATS_SECT_ENTRY(nffs_gc_copied)
+    STATS_SECT_ENTRY(nffs_gc_reclaimed)
+    STATS_SECT_ENTRY(nffs_gc_usecs)
 STATS_SECT_END
 extern STATS_SECT_DECL(nffs_stats) nffs_stats;
 
@@ -296,6 +355,7 @@ extern struct nffs_area_desc *nffs_current_area_descs;
 extern uint8_t nffs_flash_buf[NFFS_FLASH_BUF_SZ];
 
 extern struct nffs_hash_list *nffs_hash;
+extern uint32_t nffs_hash_size;
 extern struct nffs_inode_entry *nffs_root_dir;
 extern struct nffs_inode_entry *nffs_lost_found_dir;
 
@@ -306,6 +366,11 @@ int nffs_area_is_current_version(const struct nffs_disk_area *disk_area);
 void nffs_area_to_disk(const struct nffs_area *area,
                        struct nffs_disk_area *out_disk_area);
 uint32_t nffs_area_free_space(const struct nffs_area *area);
+uint32_t nffs_area_live_bytes(const struct nffs_area *area);
+void nffs_area_add_garbage(uint32_t flash_loc, uint32_t len);
+void nffs_area_add_garbage_entry(const struct nffs_hash_entry *entry);
+void nffs_area_add_live(uint32_t flash_loc, uint32_t len);
+int nffs_area_count_garbage(void);
 int nffs_area_find_corrupt_scratch(uint16_t *out_good_idx,
                                    uint16_t *out_bad_idx);
 
@@ -359,6 +424,17 @@ int nffs_crc_disk_inode_validate(const struct nffs_disk_inode *disk_inode,
 void nffs_crc_disk_inode_fill(struct nffs_disk_inode *disk_inode,
                               const char *filename);
 
+/* @ckpt */
+extern struct nffs_area_desc nffs_ckpt_area_desc;
+extern uint8_t nffs_ckpt_restored;
+int nffs_ckpt_is_enabled(void);
+int nffs_ckpt_write(void);
+int nffs_ckpt_restore(void);
+int nffs_ckpt_invalidate(void);
+int nffs_ckpt_erase(void);
+int nffs_ckpt_entry_is_restored(const struct nffs_hash_entry *entry);
+int nffs_ckpt_count_live(void);
+
 /* @config */
 void nffs_config_init(void);
 
@@ -386,6 +462,7 @@ int nffs_format_full(const struct nffs_area_desc *area_descs);
 /* @gc */
 int nffs_gc(uint8_t *out_area_idx);
 int nffs_gc_until(uint32_t space, uint8_t *out_area_idx);
+uint16_t nffs_gc_select_area(int policy);
 
 /* @flash */
 struct nffs_area *nffs_flash_find_area(uint16_t logical_id);
@@ -411,6 +488,8 @@ struct nffs_hash_entry *nffs_hash_find_block(uint32_t id);
 void nffs_hash_insert(struct nffs_hash_entry *entry);
 void nffs_hash_remove(struct nffs_hash_entry *entry);
 int nffs_hash_init(void);
+int nffs_hash_fn(uint32_t id);
+void nffs_hash_get_info(struct nffs_hash_info *out_info);
 int nffs_hash_entry_is_dummy(struct nffs_hash_entry *he);
 int nffs_hash_id_is_dummy(uint32_t id);
 
@@ -497,13 +576,15 @@ int nffs_path_new_dir(const char *path,
 
 /* @restore */
 int nffs_restore_full(const struct nffs_area_desc *area_descs);
+int nffs_restore_object(const struct nffs_disk_object *disk_object,
+                        int validate);
 
 /* @write */
 int nffs_write_to_file(struct nffs_file *file, const void *data, int len);
 
 
 #define NFFS_HASH_FOREACH(entry, i, next)                               \
-    for ((i) = 0; (i) < NFFS_HASH_SIZE; (i)++)                          \
+    for ((i) = 0; (i) < nffs_hash_size; (i)++)                          \
         for ((entry) = SLIST_FIRST(nffs_hash + (i));                    \
              (entry) && (((next)) = SLIST_NEXT((entry), nhe_next), 1);  \
              (entry) = ((next)))
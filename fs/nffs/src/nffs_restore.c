@@ -236,9 +236,15 @@ nffs_restore_should_sweep_inode_entry(struct nffs_inode_entry *inode_entry,
     }
 
     /* If this is a file inode, verify that all of its constituent blocks are
-     * present.
+     * present.  A file whose inode and last block both come from the
+     * checkpoint had a complete chain when it was taken; blocks rewritten
+     * since keep their IDs.
      */
-    if (nffs_hash_id_is_file(inode_entry->nie_hash_entry.nhe_id)) {
+    if (nffs_hash_id_is_file(inode_entry->nie_hash_entry.nhe_id) &&
+        !(nffs_ckpt_entry_is_restored(&inode_entry->nie_hash_entry) &&
+          inode_entry->nie_last_block_entry != NULL &&
+          nffs_ckpt_entry_is_restored(inode_entry->nie_last_block_entry))) {
+
         rc = nffs_restore_validate_block_chain(
                 inode_entry->nie_last_block_entry);
         if (rc == FS_ECORRUPT) {
@@ -281,74 +287,86 @@ nffs_restore_sweep(void)
     struct nffs_inode inode;
     struct nffs_block block;
     int del = 0;
+    int pass;
     int rc;
     int i;
 
     /* Iterate through every object in the hash table, deleting all inodes that
-     * should be removed.
+     * should be removed.  Inodes are swept before blocks: deleting an inode
+     * deletes its blocks, including a dummy last block that the inode still
+     * references, so the block pass only sees blocks no inode owns.
      */
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
-        list = nffs_hash + i;
-
-        entry = SLIST_FIRST(list);
-        while (entry != NULL) {
-            next = SLIST_NEXT(entry, nhe_next);
-            if (nffs_hash_id_is_inode(entry->nhe_id)) {
-                inode_entry = (struct nffs_inode_entry *)entry;
-
-                /*
-                 * If this is a dummy inode directory, the file system
-                 * is corrupt.  Move the directory's children inodes to
-                 * the lost+found directory.
-                 */
-                rc = nffs_restore_migrate_orphan_children(inode_entry);
-                if (rc != 0) {
-                    return rc;
-                }
-
-                /* Determine if this inode needs to be deleted. */
-                rc = nffs_restore_should_sweep_inode_entry(inode_entry, &del);
-                if (rc != 0) {
-                    return rc;
-                }
-
-                rc = nffs_inode_from_entry(&inode, inode_entry);
-                if (rc != 0 && rc != FS_ENOENT) {
-                    return rc;
-                }
-
-                if (del) {
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < nffs_hash_size; i++) {
+            list = nffs_hash + i;
+
+            entry = SLIST_FIRST(list);
+            while (entry != NULL) {
+                next = SLIST_NEXT(entry, nhe_next);
+                if (pass == 0 && nffs_hash_id_is_inode(entry->nhe_id)) {
+                    inode_entry = (struct nffs_inode_entry *)entry;
 
-                    /* Remove the inode and all its children from RAM.  We
-                     * expect some file system corruption; the children are
-                     * subject to garbage collection and may not exist in the
-                     * hash.  Remove what is actually present and ignore
-                     * corruption errors.
+                    /*
+                     * If this is a dummy inode directory, the file system
+                     * is corrupt.  Move the directory's children inodes to
+                     * the lost+found directory.
                      */
-                    rc = nffs_inode_unlink_from_ram_corrupt_ok(&inode, &next);
+                    rc = nffs_restore_migrate_orphan_children(inode_entry);
                     if (rc != 0) {
                         return rc;
                     }
-                    next = SLIST_FIRST(list);
-                }
-            } else if (nffs_hash_id_is_block(entry->nhe_id)) {
-                if (nffs_hash_id_is_dummy(entry->nhe_id)) {
-                    del = 1;
-                    nffs_block_delete_from_ram(entry);
-                } else {
-                    rc = nffs_block_from_hash_entry(&block, entry);
+
+                    /* Determine if this inode needs to be deleted. */
+                    rc = nffs_restore_should_sweep_inode_entry(inode_entry,
+                                                               &del);
+                    if (rc != 0) {
+                        return rc;
+                    }
+
+                    rc = nffs_inode_from_entry(&inode, inode_entry);
                     if (rc != 0 && rc != FS_ENOENT) {
+                        return rc;
+                    }
+
+                    if (del) {
+
+                        /* Remove the inode and all its children from RAM.
+                         * We expect some file system corruption; the
+                         * children are subject to garbage collection and may
+                         * not exist in the hash.  Remove what is actually
+                         * present and ignore corruption errors.
+                         */
+                        rc = nffs_inode_unlink_from_ram_corrupt_ok(&inode,
+                                                                   &next);
+                        if (rc != 0) {
+                            return rc;
+                        }
+                        next = SLIST_FIRST(list);
+                    }
+                } else if (pass == 1 &&
+                           nffs_hash_id_is_block(entry->nhe_id)) {
+                    if (nffs_hash_id_is_dummy(entry->nhe_id)) {
                         del = 1;
                         nffs_block_delete_from_ram(entry);
+                    } else if (!nffs_ckpt_entry_is_restored(entry)) {
+                        /* Blocks from the checkpoint belonged to a file then;
+                         * if it was deleted since, the inode pass removed
+                         * them along with it.
+                         */
+                        rc = nffs_block_from_hash_entry(&block, entry);
+                        if (rc != 0 && rc != FS_ENOENT) {
+                            del = 1;
+                            nffs_block_delete_from_ram(entry);
+                        }
+                    }
+                    if (del) {
+                        del = 0;
+                        next = SLIST_FIRST(list);
                     }
                 }
-                if (del) {
-                    del = 0;
-                    next = SLIST_FIRST(list);
-                }
-            }
 
-            entry = next;
+                entry = next;
+            }
         }
     }
 
@@ -461,12 +479,13 @@ nffs_restore_inode_gets_replaced(struct nffs_inode_entry *old_inode_entry,
  * @param disk_inode            The inode just read from flash.
  * @param area_idx              The index of the area containing the inode.
  * @param area_offset           The offset within the area of the inode.
+ * @param validate              Whether to check the inode's CRC.
  *
  * @return                      0 on success; nonzero on failure.
  */
 static int
 nffs_restore_inode(const struct nffs_disk_inode *disk_inode, uint8_t area_idx,
-                   uint32_t area_offset)
+                   uint32_t area_offset, int validate)
 {
     struct nffs_inode_entry *inode_entry;
     struct nffs_inode_entry *parent;
@@ -479,9 +498,15 @@ nffs_restore_inode(const struct nffs_disk_inode *disk_inode, uint8_t area_idx,
     new_inode = 0;
 
     /* Check the inode's CRC.  If the inode is corrupt, discard it. */
-    rc = nffs_crc_disk_inode_validate(disk_inode, area_idx, area_offset);
-    if (rc != 0) {
-        goto err;
+    if (validate) {
+        rc = nffs_crc_disk_inode_validate(disk_inode, area_idx, area_offset);
+        if (rc != 0) {
+            goto err;
+        }
+    }
+
+    if (disk_inode->ndi_flags & NFFS_INODE_FLAG_DELETED) {
+        nffs_areas[area_idx].na_deletes++;
     }
 
     inode_entry = nffs_hash_find_inode(disk_inode->ndi_id);
@@ -781,12 +806,13 @@ nffs_restore_block_gets_replaced(const struct nffs_block *old_block,
  * @param disk_block            The source disk block to insert.
  * @param area_idx              The ID of the area containing the block.
  * @param area_offset           The area_offset within the area of the block.
+ * @param validate              Whether to check the block's CRC.
  *
  * @return                      0 on success; nonzero on failure.
  */
 static int
 nffs_restore_block(const struct nffs_disk_block *disk_block, uint8_t area_idx,
-                   uint32_t area_offset)
+                   uint32_t area_offset, int validate)
 {
     struct nffs_inode_entry *inode_entry;
     struct nffs_hash_entry *entry;
@@ -800,9 +826,11 @@ nffs_restore_block(const struct nffs_disk_block *disk_block, uint8_t area_idx,
     /* Check the block's CRC.  If the block is corrupt, discard it.  If this
      * block would have superseded another, the old block becomes current.
      */
-    rc = nffs_crc_disk_block_validate(disk_block, area_idx, area_offset);
-    if (rc != 0) {
-        goto err;
+    if (validate) {
+        rc = nffs_crc_disk_block_validate(disk_block, area_idx, area_offset);
+        if (rc != 0) {
+            goto err;
+        }
     }
 
     entry = nffs_hash_find_block(disk_block->ndb_id);
@@ -931,11 +959,14 @@ err:
  * disk object.
  *
  * @param disk_object           The source disk object to convert.
+ * @param validate              Whether to check the object's CRC.  Objects
+ *                                  loaded from a checkpoint were validated
+ *                                  when the checkpoint was taken.
  *
  * @return                      0 on success; nonzero on failure.
  */
-static int
-nffs_restore_object(const struct nffs_disk_object *disk_object)
+int
+nffs_restore_object(const struct nffs_disk_object *disk_object, int validate)
 {
     int rc;
 
@@ -943,13 +974,13 @@ nffs_restore_object(const struct nffs_disk_object *disk_object)
     case NFFS_OBJECT_TYPE_INODE:
         rc = nffs_restore_inode(&disk_object->ndo_disk_inode,
                                 disk_object->ndo_area_idx,
-                                disk_object->ndo_offset);
+                                disk_object->ndo_offset, validate);
         break;
 
     case NFFS_OBJECT_TYPE_BLOCK:
         rc = nffs_restore_block(&disk_object->ndo_disk_block,
                                 disk_object->ndo_area_idx,
-                                disk_object->ndo_offset);
+                                disk_object->ndo_offset, validate);
         break;
 
     default:
@@ -1030,7 +1061,7 @@ nffs_restore_disk_object_size(const struct nffs_disk_object *disk_object)
 
 /**
  * Reads the specified area from disk and loads its contents into the RAM
- * representation.
+ * representation.  Reading starts at the area's current write position.
  *
  * @param area_idx              The index of the area to read.
  *
@@ -1045,14 +1076,13 @@ nffs_restore_area_contents(int area_idx)
 
     area = nffs_areas + area_idx;
 
-    area->na_cur = sizeof (struct nffs_disk_area);
     while (1) {
         rc = nffs_restore_disk_object(area_idx, area->na_cur,  &disk_object);
         switch (rc) {
         case 0:
 
             /* Valid object; restore it into the RAM representation. */
-            rc = nffs_restore_object(&disk_object);
+            rc = nffs_restore_object(&disk_object, 1);
 
             /*
              * If the restore fails the CRC check, the object length field
@@ -1159,7 +1189,7 @@ nffs_restore_corrupt_scratch(void)
     }
 
     /* Invalidate all objects resident in the bad area. */
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         entry = SLIST_FIRST(&nffs_hash[i]);
         while (entry != NULL) {
             next = SLIST_NEXT(entry, nhe_next);
@@ -1185,6 +1215,7 @@ nffs_restore_corrupt_scratch(void)
     /* Now that the objects in the scratch area have been invalidated, reload
      * everything from the good area.
      */
+    nffs_areas[good_idx].na_cur = sizeof (struct nffs_disk_area);
     rc = nffs_restore_area_contents(good_idx);
     if (rc != 0) {
         return rc;
@@ -1274,20 +1305,21 @@ nffs_log_contents(void)
 }
 
 /**
- * Searches for a valid nffs file system among the specified areas.  This
- * function succeeds if a file system is detected among any subset of the
- * supplied areas.  If the area set does not contain a valid file system,
- * a new one can be created via a call to nffs_format().
+ * Rebuilds the RAM representation of the file system from the specified
+ * areas.
  *
  * @param area_descs        The area set to search.  This array must be
  *                              terminated with a 0-length area.
+ * @param use_ckpt          If set, the RAM index is loaded from the
+ *                              checkpoint and only objects written after it
+ *                              are read from the areas.
  *
  * @return                  0 on success;
  *                          FS_ECORRUPT if no valid file system was detected;
  *                          other nonzero on error.
  */
-int
-nffs_restore_full(const struct nffs_area_desc *area_descs)
+static int
+nffs_restore_areas(const struct nffs_area_desc *area_descs, int use_ckpt)
 {
     struct nffs_disk_area disk_area;
     int cur_area_idx;
@@ -1350,6 +1382,11 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
             nffs_areas[cur_area_idx].na_flash_id = area_descs[i].nad_flash_id;
             nffs_areas[cur_area_idx].na_gc_seq = disk_area.nda_gc_seq;
             nffs_areas[cur_area_idx].na_id = disk_area.nda_id;
+            nffs_areas[cur_area_idx].na_obsolete = 0;
+            nffs_areas[cur_area_idx].na_deletes = 0;
+            nffs_areas[cur_area_idx].na_clean_gc = nffs_gc_count;
+            nffs_areas[cur_area_idx].na_delete_gc = nffs_gc_count;
+            nffs_areas[cur_area_idx].na_ckpt_cur = 0;
 
             if (disk_area.nda_id == NFFS_AREA_ID_NONE) {
                 nffs_areas[cur_area_idx].na_cur = NFFS_AREA_OFFSET_ID;
@@ -1357,11 +1394,27 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
             } else {
                 nffs_areas[cur_area_idx].na_cur =
                     sizeof (struct nffs_disk_area);
-                nffs_restore_area_contents(cur_area_idx);
             }
         }
     }
 
+    if (use_ckpt) {
+        /* Load the index and each area's write position from the
+         * checkpoint.
+         */
+        rc = nffs_ckpt_restore();
+        if (rc != 0) {
+            goto err;
+        }
+    }
+
+    /* Read each area's objects, starting at its write position. */
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (i != nffs_scratch_area_idx) {
+            nffs_restore_area_contents(i);
+        }
+    }
+
     /* All areas have been restored from flash. */
 
     if (nffs_scratch_area_idx == NFFS_AREA_ID_NONE) {
@@ -1400,6 +1453,12 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
      */
     nffs_restore_sweep();
 
+    /* Determine how much of each area is occupied by obsolete objects. */
+    rc = nffs_area_count_garbage();
+    if (rc != 0) {
+        goto err;
+    }
+
     /* Set the maximum data block size according to the size of the smallest
      * area.
      */
@@ -1417,3 +1476,53 @@ err:
     nffs_misc_reset();
     return rc;
 }
+
+/**
+ * Searches for a valid nffs file system among the specified areas.  This
+ * function succeeds if a file system is detected among any subset of the
+ * supplied areas.  If the area set does not contain a valid file system,
+ * a new one can be created via a call to nffs_format().
+ *
+ * If a checkpoint area is configured, the checkpoint is tried first; if it
+ * does not describe the areas as they are on flash, every area is scanned
+ * and a fresh checkpoint is written.
+ *
+ * @param area_descs        The area set to search.  This array must be
+ *                              terminated with a 0-length area.
+ *
+ * @return                  0 on success;
+ *                          FS_ECORRUPT if no valid file system was detected;
+ *                          other nonzero on error.
+ */
+int
+nffs_restore_full(const struct nffs_area_desc *area_descs)
+{
+    int rc;
+
+    nffs_ckpt_restored = 0;
+
+    if (nffs_ckpt_is_enabled()) {
+        rc = nffs_restore_areas(area_descs, 1);
+        if (rc == 0) {
+            nffs_ckpt_restored = 1;
+            return 0;
+        }
+        NFFS_LOG_DEBUG("checkpoint unusable (rc=%d); scanning all areas\n",
+                       rc);
+    }
+
+    rc = nffs_restore_areas(area_descs, 0);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (nffs_ckpt_is_enabled()) {
+        /* A failure here only costs the next mount a full scan. */
+        rc = nffs_ckpt_write();
+        if (rc != 0) {
+            NFFS_LOG_DEBUG("failed to write checkpoint; rc=%d\n", rc);
+        }
+    }
+
+    return 0;
+}
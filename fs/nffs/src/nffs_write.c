@@ -100,6 +100,7 @@ nffs_write_over_block(struct nffs_hash_entry *entry, uint16_t left_copy_len,
     uint32_t src_area_offset;
     uint32_t dst_area_offset;
     uint16_t right_copy_len;
+    uint16_t old_data_len;
     uint16_t block_off;
     uint8_t src_area_idx;
     uint8_t dst_area_idx;
@@ -122,6 +123,7 @@ nffs_write_over_block(struct nffs_hash_entry *entry, uint16_t left_copy_len,
         right_copy_len = block.nb_data_len - left_copy_len - new_data_len;
     }
 
+    old_data_len = block.nb_data_len;
     block.nb_seq++;
     block.nb_data_len = left_copy_len + new_data_len + right_copy_len;
     nffs_block_to_disk(&block, &disk_block);
@@ -191,6 +193,8 @@ nffs_write_over_block(struct nffs_hash_entry *entry, uint16_t left_copy_len,
 
     assert(block_off == sizeof disk_block + block.nb_data_len);
 
+    nffs_area_add_garbage(entry->nhe_flash_loc,
+                          sizeof disk_block + old_data_len);
     entry->nhe_flash_loc = nffs_flash_loc(dst_area_idx, dst_area_offset);
 
     ASSERT_IF_TEST(nffs_crc_disk_block_validate(&disk_block, dst_area_idx,
@@ -90,6 +90,11 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len);
 int
 mmc_ioctl(uint8_t mmc_id, uint32_t cmd, void *arg);
 
+#if MYNEWT_VAL(MMC_ASYNC)
+int
+mmc_submit(uint8_t mmc_id, struct disk_req *req);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,6 +22,7 @@
 #include <disk/disk.h>
 #include <mmc/mmc.h>
 #include <stdio.h>
+#include <assert.h>
 
 #define MIN(n, m) (((n) < (m)) ? (n) : (m))
 
@@ -65,6 +66,14 @@
 
 static uint8_t g_block_buf[BLOCK_LEN];
 
+#if MYNEWT_VAL(MMC_ASYNC)
+static struct disk_queue mmc_queue;
+OS_TASK_STACK_DEFINE(mmc_queue_stack, MYNEWT_VAL(MMC_ASYNC_STACK_SIZE));
+
+/* Owned for each transfer; the MMC task and direct callers share the bus. */
+static struct os_mutex mmc_mtx;
+#endif
+
 static struct hal_spi_settings mmc_settings = {
     .data_order = HAL_SPI_MSB_FIRST,
     .data_mode  = HAL_SPI_MODE0,
@@ -111,6 +120,28 @@ error_by_response(uint8_t status)
     return (rc);
 }
 
+static void
+mmc_lock(void)
+{
+#if MYNEWT_VAL(MMC_ASYNC)
+    int rc;
+
+    rc = os_mutex_pend(&mmc_mtx, OS_TIMEOUT_NEVER);
+    assert(rc == 0 || rc == OS_NOT_STARTED);
+#endif
+}
+
+static void
+mmc_unlock(void)
+{
+#if MYNEWT_VAL(MMC_ASYNC)
+    int rc;
+
+    rc = os_mutex_release(&mmc_mtx);
+    assert(rc == 0 || rc == OS_NOT_STARTED);
+#endif
+}
+
 static struct mmc_cfg *
 mmc_cfg_dev(uint8_t id)
 {
@@ -188,6 +219,8 @@ mmc_init(int spi_num, void *spi_cfg, int ss_pin)
     os_time_t timeout;
     struct mmc_cfg *mmc;
 
+    mmc_lock();
+
     /* TODO: create new struct for every new spi mmc, add to SLIST */
     mmc = &g_mmc_cfg;
     mmc->spi_num = spi_num;
@@ -199,18 +232,18 @@ mmc_init(int spi_num, void *spi_cfg, int ss_pin)
 
     rc = hal_spi_init(mmc->spi_num, mmc->spi_cfg, HAL_SPI_TYPE_MASTER);
     if (rc) {
-        return (rc);
+        goto out;
     }
 
     rc = hal_spi_config(mmc->spi_num, mmc->settings);
     if (rc) {
-        return (rc);
+        goto out;
     }
 
     hal_spi_set_txrx_cb(mmc->spi_num, NULL, NULL);
     rc = hal_spi_enable(mmc->spi_num);
     if (rc) {
-        return (rc);
+        goto out;
     }
 
     /**
@@ -336,6 +369,7 @@ mmc_init(int spi_num, void *spi_cfg, int ss_pin)
 
 out:
     hal_gpio_write(mmc->ss_pin, 1);
+    mmc_unlock();
     return rc;
 }
 
@@ -391,6 +425,7 @@ mmc_read(uint8_t mmc_id, uint32_t addr, void *buf, uint32_t len)
     block_addr = addr / BLOCK_LEN;
     offset = addr - (block_addr * BLOCK_LEN);
 
+    mmc_lock();
     hal_gpio_write(mmc->ss_pin, 0);
 
     cmd = (block_count == 1) ? CMD17 : CMD18;
@@ -400,27 +435,28 @@ mmc_read(uint8_t mmc_id, uint32_t addr, void *buf, uint32_t len)
         goto out;
     }
 
-    /**
-     * 7.3.3 Control tokens
-     *   Wait up to 200ms for control token.
-     */
-    timeout = os_time_get() + OS_TICKS_PER_SEC / 5;
-    do {
-        res = hal_spi_tx_val(mmc->spi_num, 0xff);
-        if (res != 0xFF) break;
-        os_time_delay(OS_TICKS_PER_SEC / 20);
-    } while (os_time_get() < timeout);
-
-    /**
-     * 7.3.3.2 Start Block Tokens and Stop Tran Token
-     */
-    if (res != START_BLOCK) {
-        rc = MMC_TIMEOUT;
-        goto out;
-    }
-
     index = 0;
     while (block_count--) {
+        /**
+         * 7.3.3 Control tokens
+         *   Wait up to 200ms for control token.  With CMD18 every block
+         *   comes with its own start token.
+         */
+        timeout = os_time_get() + OS_TICKS_PER_SEC / 5;
+        do {
+            res = hal_spi_tx_val(mmc->spi_num, 0xff);
+            if (res != 0xFF) break;
+            os_time_delay(OS_TICKS_PER_SEC / 20);
+        } while (os_time_get() < timeout);
+
+        /**
+         * 7.3.3.2 Start Block Tokens and Stop Tran Token
+         */
+        if (res != START_BLOCK) {
+            rc = MMC_TIMEOUT;
+            break;
+        }
+
         for (n = 0; n < BLOCK_LEN; n++) {
             g_block_buf[n] = hal_spi_tx_val(mmc->spi_num, 0xff);
         }
@@ -445,6 +481,7 @@ mmc_read(uint8_t mmc_id, uint32_t addr, void *buf, uint32_t len)
 
 out:
     hal_gpio_write(mmc->ss_pin, 1);
+    mmc_unlock();
     return (rc);
 }
 
@@ -477,6 +514,7 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len)
     block_addr = addr / BLOCK_LEN;
     offset = addr - (block_addr * BLOCK_LEN);
 
+    mmc_lock();
     hal_gpio_write(mmc->ss_pin, 0);
 
     /**
@@ -584,6 +622,7 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len)
 
 out:
     hal_gpio_write(mmc->ss_pin, 1);
+    mmc_unlock();
     return (rc);
 }
 
@@ -596,6 +635,40 @@ mmc_ioctl(uint8_t mmc_id, uint32_t cmd, void *arg)
     return 0;
 }
 
+#if MYNEWT_VAL(MMC_ASYNC)
+/**
+ * Queues a request for the MMC task, which owns the SPI bus for the
+ * duration of each transfer.
+ *
+ * @return 0 if the request was queued, non-zero on failure
+ */
+int
+mmc_submit(uint8_t mmc_id, struct disk_req *req)
+{
+    if (mmc_cfg_dev(mmc_id) == NULL) {
+        return MMC_PARAM_ERROR;
+    }
+
+    return disk_queue_submit(&mmc_queue, &mmc_ops, req);
+}
+
+void
+mmc_async_init(void)
+{
+    int rc;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    rc = os_mutex_init(&mmc_mtx);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    rc = disk_queue_init(&mmc_queue, "mmc", MYNEWT_VAL(MMC_ASYNC_TASK_PRIO),
+                         mmc_queue_stack, MYNEWT_VAL(MMC_ASYNC_STACK_SIZE));
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+#endif
+
 /*
  *
  */
@@ -603,4 +676,7 @@ struct disk_ops mmc_ops = {
     .read  = &mmc_read,
     .write = &mmc_write,
     .ioctl = &mmc_ioctl,
+#if MYNEWT_VAL(MMC_ASYNC)
+    .submit = &mmc_submit,
+#endif
 };
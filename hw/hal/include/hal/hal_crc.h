@@ -0,0 +1,73 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @addtogroup HAL
+ * @{
+ *   @defgroup HALCrc HAL CRC
+ *   @{
+ */
+
+#ifndef __HAL_CRC_H_
+#define __HAL_CRC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <inttypes.h>
+
+/** CRC16-CCITT; polynomial 0x1021, MSB first, no final XOR. */
+#define HAL_CRC_ALG_CRC16_CCITT     0
+/** CRC-32 (IEEE 802.3); reflected polynomial 0xedb88320. */
+#define HAL_CRC_ALG_CRC32           1
+/** CRC-32C (Castagnoli); reflected polynomial 0x82f63b78. */
+#define HAL_CRC_ALG_CRC32C          2
+
+/**
+ * Computes a CRC using the MCU's CRC peripheral.  Implemented by MCU
+ * packages which have one; used by util/crc when CRC_HAL is enabled.
+ *
+ * The CRC is continued from `crc`, with the same conventions as the
+ * matching util/crc function, so hardware and software results can be
+ * mixed.
+ *
+ * @param alg           One of the HAL_CRC_ALG_* values.
+ * @param crc           CRC to continue from.
+ * @param buf           Data to checksum.
+ * @param len           Number of bytes in buf.
+ * @param out_crc       On success, the resulting CRC is written here.
+ *
+ * @return 0 on success; nonzero if the algorithm is not supported or the
+ *         peripheral is busy.  The caller then computes the CRC in
+ *         software.
+ */
+int hal_crc_calc(int alg, uint32_t crc, const void *buf, int len,
+                 uint32_t *out_crc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/**
+ *   @} HALCrc
+ * @} HAL
+ */
@@ -32,6 +32,7 @@ extern "C" {
 #endif
 
 #include "os/os_eventq.h"
+#include "os/os_timeq.h"
 #include <stddef.h>
 
 /**
@@ -46,8 +47,11 @@ struct os_callout {
     /** Number of ticks in the future to expire the callout */
     os_time_t c_ticks;
 
-
+#if MYNEWT_VAL(OS_TIMEQ_HEAP)
+    struct os_timeq_node c_node;
+#else
     TAILQ_ENTRY(os_callout) c_next;
+#endif
 };
 
 /**
@@ -119,7 +123,11 @@ os_time_t os_callout_remaining_ticks(struct os_callout *, os_time_t);
 static inline int
 os_callout_queued(struct os_callout *c)
 {
+#if MYNEWT_VAL(OS_TIMEQ_HEAP)
+    return os_timeq_queued(&c->c_node);
+#else
     return c->c_next.tqe_prev != NULL;
+#endif
 }
 
 /**
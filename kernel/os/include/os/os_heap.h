@@ -30,6 +30,7 @@
 #define H_OS_HEAP_
 
 #include <stddef.h>
+#include <inttypes.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -70,6 +71,42 @@ void os_free(void *mem);
  */
 void *os_realloc(void *ptr, size_t size);
 
+/**
+ * Heap usage information, as returned by os_malloc_info_get().  Usage of the
+ * OS_MALLOC_SLAB size class pools is reported per pool by
+ * os_mempool_info_get_next(); the pools are named "malloc_<n>".
+ */
+struct os_malloc_info {
+    /** Number of blocks currently allocated from the heap */
+    uint32_t omi_heap_allocs;
+    /** Highest number of blocks allocated from the heap at the same time */
+    uint32_t omi_heap_allocs_max;
+    /**
+     * Number of allocations that found their size class exhausted.  With
+     * OS_MALLOC_SLAB_FALLBACK they used a larger class or the heap,
+     * otherwise they failed.
+     */
+    uint32_t omi_slab_fallbacks;
+    /** Free heap bytes; 0 if not known for this libc */
+    uint32_t omi_heap_free;
+    /** Largest free heap block; 0 if not known for this libc */
+    uint32_t omi_heap_largest;
+    /**
+     * Heap fragmentation in percent: the share of free heap that is not part
+     * of the largest free block.
+     */
+    uint8_t omi_heap_frag_pct;
+};
+
+/**
+ * Reads heap usage and fragmentation information.
+ *
+ * @param omi The structure to fill in.
+ *
+ * @return 0 on success.
+ */
+int os_malloc_info_get(struct os_malloc_info *omi);
+
 #ifdef __cplusplus
 }
 #endif
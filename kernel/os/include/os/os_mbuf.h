@@ -74,6 +74,33 @@ struct os_mbuf_pkthdr {
     STAILQ_ENTRY(os_mbuf_pkthdr) omp_next;
 };
 
+#if MYNEWT_VAL(OS_MBUF_EXT)
+struct os_mbuf_ext;
+
+/**
+ * Callback executed when the last mbuf referencing an external buffer is
+ * freed.
+ *
+ * @param ext                   The external buffer descriptor.
+ * @param arg                   The argument configured in the descriptor.
+ */
+typedef void os_mbuf_ext_free_fn(struct os_mbuf_ext *ext, void *arg);
+
+/**
+ * Descriptor for a buffer outside any mbuf pool (e.g., a flash-resident
+ * image) that mbufs may reference with os_mbuf_get_ext().  Initialize with
+ * os_mbuf_ext_init(); the descriptor must stay valid until its free callback
+ * runs.
+ */
+struct os_mbuf_ext {
+    /** Number of mbufs referencing the buffer. */
+    uint16_t ome_refcnt;
+    /** Called when the count drops to zero; may be NULL. */
+    os_mbuf_ext_free_fn *ome_free_cb;
+    void *ome_free_arg;
+};
+#endif
+
 /**
  * Chained memory buffer.
  */
@@ -102,12 +129,51 @@ struct os_mbuf {
 
     SLIST_ENTRY(os_mbuf) om_next;
 
+#if MYNEWT_VAL(OS_MBUF_EXT)
+    /**
+     * Number of holders of this mbuf's memory block: the mbuf itself, plus
+     * every other mbuf whose data points into this block's databuf.
+     */
+    uint16_t om_refcnt;
+
+    /**
+     * Mbuf block whose databuf holds this mbuf's data, if not this one.
+     */
+    struct os_mbuf *om_owner;
+
+    /**
+     * External buffer holding this mbuf's data, if any.
+     */
+    struct os_mbuf_ext *om_ext;
+#endif
+
     /**
      * Pointer to the beginning of the data, after this buffer
      */
     uint8_t om_databuf[0];
 };
 
+/**
+ * Iterator over the contiguous data segments of a region of an mbuf chain.
+ * Initialize with os_mbuf_iter_init(); fields are private.
+ */
+struct os_mbuf_iter {
+    const struct os_mbuf *omi_cur;
+    uint16_t omi_off;
+    int omi_remaining;
+};
+
+/**
+ * Callback applied to each segment by os_mbuf_foreach_segment().
+ *
+ * @param data                  Start of the segment, inside the mbuf.
+ * @param len                   Length of the segment, in bytes.
+ * @param arg                   Argument passed to os_mbuf_foreach_segment().
+ *
+ * @return                      0 to continue; nonzero to stop iterating.
+ */
+typedef int os_mbuf_segment_fn(const void *data, uint16_t len, void *arg);
+
 /**
  * Structure representing a queue of mbufs.
  */
@@ -173,6 +239,19 @@ struct os_mqueue {
     ((om)->om_pkthdr_len - sizeof (struct os_mbuf_pkthdr))
 
 
+#if MYNEWT_VAL(OS_MBUF_EXT)
+/**
+ * Indicates whether an mbuf's data lives in its own databuf and is not
+ * referenced by any other mbuf.  Only such mbufs can grow in place; all
+ * others report zero leading and trailing space.
+ *
+ * @param __om  The mbuf to check
+ */
+#define OS_MBUF_IS_EXCLUSIVE(__om)                                  \
+    ((__om)->om_owner == NULL && (__om)->om_ext == NULL &&          \
+     (__om)->om_refcnt == 1)
+#endif
+
 /** @cond INTERNAL_HIDDEN */
 
 /*
@@ -184,6 +263,12 @@ _os_mbuf_leadingspace(struct os_mbuf *om)
     uint16_t startoff;
     uint16_t leadingspace;
 
+#if MYNEWT_VAL(OS_MBUF_EXT)
+    if (!OS_MBUF_IS_EXCLUSIVE(om)) {
+        return 0;
+    }
+#endif
+
     startoff = 0;
     if (OS_MBUF_IS_PKTHDR(om)) {
         startoff = om->om_pkthdr_len;
@@ -218,6 +303,12 @@ _os_mbuf_trailingspace(struct os_mbuf *om)
 {
     struct os_mbuf_pool *omp;
 
+#if MYNEWT_VAL(OS_MBUF_EXT)
+    if (!OS_MBUF_IS_EXCLUSIVE(om)) {
+        return 0;
+    }
+#endif
+
     omp = om->om_omp;
 
     return (&om->om_databuf[0] + omp->omp_databuf_len) -
@@ -383,6 +474,71 @@ struct os_mbuf *os_mbuf_get_pkthdr(struct os_mbuf_pool *omp,
  */
 struct os_mbuf *os_mbuf_dup(struct os_mbuf *m);
 
+#if MYNEWT_VAL(OS_MBUF_EXT)
+/**
+ * Initializes an external buffer descriptor.
+ *
+ * @param ext                   The descriptor to initialize.
+ * @param free_cb               Called when the last referencing mbuf is
+ *                                  freed; may be NULL.
+ * @param free_arg              Argument passed to the callback.
+ */
+void os_mbuf_ext_init(struct os_mbuf_ext *ext, os_mbuf_ext_free_fn *free_cb,
+                      void *free_arg);
+
+/**
+ * Allocates an mbuf whose data is a region of an external buffer.  The data
+ * is not copied and is treated as read-only.  The mbuf does not have a
+ * packet header; concatenate it onto one if required.
+ *
+ * @param omp                   The mbuf pool to allocate the mbuf header
+ *                                  from.
+ * @param ext                   Descriptor of the external buffer.
+ * @param data                  Start of the data, inside the external buffer.
+ * @param len                   Length of the data.
+ *
+ * @return                      The mbuf on success; NULL on failure.
+ */
+struct os_mbuf *os_mbuf_get_ext(struct os_mbuf_pool *omp,
+                                struct os_mbuf_ext *ext, const void *data,
+                                uint16_t len);
+
+/**
+ * Creates a chain of mbufs that share the data of an existing chain.  This
+ * is the opt-in alternative to os_mbuf_dup(), which always copies.  No
+ * data is copied: each new mbuf references the data of its counterpart, and
+ * the underlying blocks are only returned to their pools once every mbuf
+ * referencing them has been freed.  Any packet header is copied.
+ *
+ * Shared data is read-only.  The mbuf functions in this file respect that
+ * (e.g., os_mbuf_append() starts a new mbuf rather than writing into shared
+ * trailing space); code that writes through om_data directly must call
+ * os_mbuf_unshare() first.
+ *
+ * @param omp                   The pool to allocate the new mbuf headers
+ *                                  from.  Its blocks need only be large
+ *                                  enough for the packet header; memory is
+ *                                  only saved if it is smaller than the
+ *                                  source chain's pool.
+ * @param om                    The chain to clone.
+ *
+ * @return                      The new chain on success; NULL on failure.
+ */
+struct os_mbuf *os_mbuf_clone(struct os_mbuf_pool *omp, struct os_mbuf *om);
+
+/**
+ * Ensures that every mbuf in a chain can be modified in place without
+ * affecting other mbufs.  Mbufs whose data is shared get a private copy.
+ *
+ * @param om                    The chain to make writable.
+ *
+ * @return                      0 on success;
+ *                              OS_ENOMEM if a private copy could not be
+ *                                  made.
+ */
+int os_mbuf_unshare(struct os_mbuf *om);
+#endif
+
 /**
  * Locates the specified absolute offset within an mbuf chain.  The offset
  * can be one past than the total length of the chain, but no greater.
@@ -414,6 +570,57 @@ struct os_mbuf *os_mbuf_off(const struct os_mbuf *om, int off,
  */
 int os_mbuf_copydata(const struct os_mbuf *m, int off, int len, void *dst);
 
+/**
+ * Prepares an iterator over the data segments of an mbuf chain region.  Each
+ * call to os_mbuf_iter_next() then yields a pointer into one mbuf's data, so
+ * the region can be read without copying it into a flat buffer.
+ *
+ * @param it                    The iterator to initialize.
+ * @param om                    The mbuf chain to iterate.
+ * @param off                   Offset within the chain of the first byte.
+ * @param len                   Number of bytes to iterate over.
+ *
+ * @return                      0 on success;
+ *                              OS_EINVAL if the chain is shorter than
+ *                                  off + len.
+ */
+int os_mbuf_iter_init(struct os_mbuf_iter *it, const struct os_mbuf *om,
+                      int off, int len);
+
+/**
+ * Retrieves the next data segment from an mbuf iterator.  Empty mbufs are
+ * skipped.
+ *
+ * @param it                    The iterator.
+ * @param out_data              On success, points to the segment's data.
+ * @param out_len               On success, the segment's length.
+ *
+ * @return                      1 if a segment was retrieved;
+ *                              0 if the end of the region was reached.
+ */
+int os_mbuf_iter_next(struct os_mbuf_iter *it, const uint8_t **out_data,
+                      uint16_t *out_len);
+
+/**
+ * Calls a function for each contiguous data segment in a region of an mbuf
+ * chain, in order.  This lets checksums, ciphers and parsers process mbuf
+ * data in place.
+ *
+ * @param om                    The mbuf chain to iterate.
+ * @param off                   Offset within the chain of the first byte.
+ * @param len                   Number of bytes to process.
+ * @param cb                    The function to call for each segment.
+ * @param arg                   Argument passed to the callback.
+ *
+ * @return                      0 on success;
+ *                              OS_EINVAL if the chain is shorter than
+ *                                  off + len;
+ *                              The callback's return code if it stopped the
+ *                                  iteration.
+ */
+int os_mbuf_foreach_segment(const struct os_mbuf *om, int off, int len,
+                            os_mbuf_segment_fn *cb, void *arg);
+
 /**
  * @brief Calculates the length of an mbuf chain.
  *
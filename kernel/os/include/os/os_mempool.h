@@ -46,6 +46,24 @@ struct os_memblock {
     SLIST_ENTRY(os_memblock) mb_next;
 };
 
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+struct os_task;
+
+/**
+ * Per-task block cache ("magazine") placed in front of a mempool.  A
+ * magazine is only ever accessed by the task that owns it, so blocks can be
+ * pushed and popped without entering a critical section.
+ */
+struct os_mempool_mag {
+    /** Task that claimed this magazine; NULL if unclaimed. */
+    struct os_task *omm_owner;
+    /** Number of blocks currently cached. */
+    uint16_t omm_cnt;
+    /** Cached free blocks. */
+    void *omm_blocks[MYNEWT_VAL(OS_MEMPOOL_MAG_SIZE)];
+};
+#endif
+
 /* XXX: Change this structure so that we keep the first address in the pool? */
 /* XXX: add memory debug structure and associated code */
 /* XXX: Change how I coded the SLIST_HEAD here. It should be named:
@@ -71,6 +89,16 @@ struct os_mempool {
     SLIST_HEAD(,os_memblock);
     /** Name for memory block */
     char *name;
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+    /** Per-task magazines; NULL if none are attached. */
+    struct os_mempool_mag *mp_mags;
+    /** Number of entries in mp_mags. */
+    uint8_t mp_num_mags;
+#endif
+#if MYNEWT_VAL(OS_MEMPOOL_FREE_MAP)
+    /** One bit per block, set while the block is free; NULL if none. */
+    uint32_t *mp_free_map;
+#endif
 };
 
 /**
@@ -121,9 +149,12 @@ struct os_mempool_info {
     int omi_block_size;
     /** Number of memory blocks in the pool */
     int omi_num_blocks;
-    /** Number of free memory blocks */
+    /** Number of free memory blocks, including blocks cached in magazines */
     int omi_num_free;
-    /** Minimum number of free memory blocks ever */
+    /**
+     * Minimum number of free memory blocks ever.  When magazines are in use
+     * this is a lower bound: blocks cached in magazines are not counted.
+     */
     int omi_min_free;
     /** Name of the memory pool */
     char omi_name[OS_MEMPOOL_INFO_NAME_LEN];
@@ -170,6 +201,9 @@ typedef __uint128_t os_membuf_t;
 #define OS_MEMPOOL_BYTES(n,blksize)     \
     (sizeof (os_membuf_t) * OS_MEMPOOL_SIZE((n), (blksize)))
 
+/** Number of uint32_t words in the free bitmap of an n-block pool. */
+#define OS_MEMPOOL_FREE_MAP_SIZE(n)     (((n) + 31) / 32)
+
 /**
  * Initialize a memory pool.
  *
@@ -232,6 +266,83 @@ os_error_t os_mempool_clear(struct os_mempool *mp);
  */
 bool os_mempool_is_sane(const struct os_mempool *mp);
 
+/**
+ * Returns the number of free blocks in the specified mempool.  This includes
+ * blocks held in per-task magazines.
+ *
+ * @param mp                    The mempool to query.
+ *
+ * @return                      The number of free blocks.
+ */
+int os_mempool_num_free(const struct os_mempool *mp);
+
+/**
+ * Returns the number of blocks the caller can allocate from the specified
+ * mempool right now: the shared free list plus the calling task's own
+ * magazine.  Blocks cached in other tasks' magazines are not counted.
+ * Without magazines this is the same as os_mempool_num_free().
+ *
+ * @param mp                    The mempool to query.
+ *
+ * @return                      The number of blocks available to the caller.
+ */
+int os_mempool_num_avail(const struct os_mempool *mp);
+
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+/**
+ * Attaches an array of per-task magazines to a mempool.  Each task that
+ * allocates from or frees to the pool claims one unused magazine the first
+ * time it does so; once all are claimed, remaining tasks fall back to the
+ * shared free list.  Interrupt handlers always use the shared free list.
+ *
+ * Blocks cached in a task's magazine are not available to other tasks until
+ * the magazine overflows or is flushed with os_mempool_mag_flush().  Size
+ * pools with this in mind: up to (OS_MEMPOOL_MAG_SIZE * num_mags) blocks may
+ * be held in magazines at once.
+ *
+ * This function must be called before the pool is used.
+ *
+ * @param mp                    The mempool to attach magazines to.
+ * @param mags                  Array of magazines.
+ * @param num_mags              Number of entries in the array.
+ *
+ * @return                      0 on success;
+ *                              OS_INVALID_PARM on bad arguments.
+ */
+os_error_t os_mempool_mag_init(struct os_mempool *mp,
+                               struct os_mempool_mag *mags, uint8_t num_mags);
+
+/**
+ * Returns all blocks cached in the calling task's magazine to the shared free
+ * list and releases the magazine so that another task may claim it.  A task
+ * that is about to exit or stop using a pool should call this.
+ *
+ * @param mp                    The mempool whose magazine should be flushed.
+ */
+void os_mempool_mag_flush(struct os_mempool *mp);
+#endif
+
+#if MYNEWT_VAL(OS_MEMPOOL_FREE_MAP)
+/**
+ * Attaches a free bitmap to a mempool.  The bitmap is filled in from the
+ * pool's current free blocks.  Afterwards, os_memblock_put() validates each
+ * freed block in constant time and rejects blocks that do not belong to the
+ * pool or are already free.  For an extended pool, a put callback that
+ * returns 0 is taken to have freed the block.
+ *
+ * This function must not be called while the pool is in use by other tasks.
+ *
+ * @param mp                    The mempool to attach the bitmap to.
+ * @param map                   Storage for the bitmap; must hold
+ *                                  OS_MEMPOOL_FREE_MAP_SIZE(mp_num_blocks)
+ *                                  words.
+ *
+ * @return                      0 on success;
+ *                              OS_INVALID_PARM on bad arguments.
+ */
+os_error_t os_mempool_free_map_init(struct os_mempool *mp, uint32_t *map);
+#endif
+
 /**
  * Checks if a memory block was allocated from the specified mempool.
  *
@@ -270,7 +381,8 @@ os_error_t os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr);
  * @param mp Pointer to memory pool
  * @param block_addr Pointer to memory block
  *
- * @return os_error_t
+ * @return os_error_t; OS_INVALID_PARM if the pool has a free bitmap and
+ *         the block is not an allocated block of this pool.
  */
 os_error_t os_memblock_put(struct os_mempool *mp, void *block_addr);
 
@@ -31,6 +31,7 @@
 #include "os/os.h"
 #include "os/os_sanity.h"
 #include "os/os_arch.h"
+#include "os/os_timeq.h"
 #include "os/queue.h"
 
 #ifdef __cplusplus
@@ -128,6 +129,14 @@ struct os_task {
      * execution.
      */
     uint32_t t_ctx_sw_cnt;
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+    /** Priority the task was queued with in the run list */
+    uint8_t t_runq_prio;
+#endif
+#if MYNEWT_VAL(OS_TIMEQ_HEAP)
+    /** Entry in the timeout queue while sleeping with a timeout */
+    struct os_timeq_node t_sleep_node;
+#endif
 
     STAILQ_ENTRY(os_task) t_os_task_list;
     TAILQ_ENTRY(os_task) t_os_list;
@@ -0,0 +1,88 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _OS_TIMEQ_H
+#define _OS_TIMEQ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @cond INTERNAL_HIDDEN */
+
+/*
+ * Timeout queue, used for pending callouts and sleeping tasks when
+ * OS_TIMEQ_HEAP is enabled.  It is an intrusive pairing heap ordered by an
+ * os_time_t expiry time stored in the containing structure; insertion is
+ * constant time, removal is amortized logarithmic and the earliest expiry
+ * is always at the root.  Nodes with the same expiry time are ordered by
+ * insertion sequence, so they come out first-in first-out like they do
+ * from the sorted lists.
+ */
+struct os_timeq_node {
+    /** First child */
+    struct os_timeq_node *tqn_child;
+    /** Next sibling */
+    struct os_timeq_node *tqn_next;
+    /**
+     * Parent if this is the first child, previous sibling otherwise.  Points
+     * to the node itself for the root and is NULL when not queued.
+     */
+    struct os_timeq_node *tqn_prev;
+    /** Insertion sequence number; breaks ties between equal expiry times */
+    uint32_t tqn_seq;
+};
+
+struct os_timeq {
+    struct os_timeq_node *tq_root;
+    /** Offset from a node to the os_time_t expiry time it is ordered by */
+    int tq_key_off;
+    /** Sequence number given to the next inserted node */
+    uint32_t tq_seq;
+};
+
+#define OS_TIMEQ_INITIALIZER(type, node_field, key_field)                   \
+    { NULL, (int)offsetof(type, key_field) - (int)offsetof(type, node_field), \
+      0 }
+
+void os_timeq_insert(struct os_timeq *tq, struct os_timeq_node *node);
+void os_timeq_remove(struct os_timeq *tq, struct os_timeq_node *node);
+
+static inline struct os_timeq_node *
+os_timeq_first(const struct os_timeq *tq)
+{
+    return tq->tq_root;
+}
+
+static inline int
+os_timeq_queued(const struct os_timeq_node *node)
+{
+    return node->tqn_prev != NULL;
+}
+
+/** @endcond */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _OS_TIMEQ_H */
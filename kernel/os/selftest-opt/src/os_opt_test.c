@@ -0,0 +1,155 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Runs the scheduler, timer and memory allocator tests with every optional
+ * mode enabled (see syscfg.yml).  The default configuration is covered by
+ * kernel/os/selftest.
+ */
+
+#include <string.h>
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "os_opt_test_priv.h"
+
+static os_membuf_t os_mbuf_membuf[OS_MEMPOOL_SIZE(MBUF_TEST_POOL_BUF_SIZE,
+        MBUF_TEST_POOL_BUF_COUNT)];
+
+struct os_mbuf_pool os_mbuf_pool;
+struct os_mempool os_mbuf_mempool;
+uint8_t os_mbuf_test_data[MBUF_TEST_DATA_LEN];
+
+void
+os_mbuf_test_setup(void)
+{
+    int rc;
+    int i;
+
+    rc = os_mempool_init(&os_mbuf_mempool, MBUF_TEST_POOL_BUF_COUNT,
+            MBUF_TEST_POOL_BUF_SIZE, &os_mbuf_membuf[0], "mbuf_pool");
+    TEST_ASSERT_FATAL(rc == 0, "Error creating memory pool %d", rc);
+
+    rc = os_mbuf_pool_init(&os_mbuf_pool, &os_mbuf_mempool,
+            MBUF_TEST_POOL_BUF_SIZE, MBUF_TEST_POOL_BUF_COUNT);
+    TEST_ASSERT_FATAL(rc == 0, "Error creating mbuf pool %d", rc);
+
+    for (i = 0; i < sizeof os_mbuf_test_data; i++) {
+        os_mbuf_test_data[i] = i;
+    }
+}
+
+/*
+ * Like the kernel/os/selftest helper, but also accepts mbufs whose data
+ * lives in another mbuf or in an external buffer.
+ */
+void
+os_mbuf_test_misc_assert_sane(struct os_mbuf *om, void *data,
+                              int buflen, int pktlen, int pkthdr_len)
+{
+    uint8_t *data_min;
+    uint8_t *data_max;
+    int totlen;
+    int i;
+
+    TEST_ASSERT_FATAL(om != NULL);
+
+    if (OS_MBUF_IS_PKTHDR(om)) {
+        TEST_ASSERT(OS_MBUF_PKTLEN(om) == pktlen);
+    }
+
+    totlen = 0;
+    for (i = 0; om != NULL; i++) {
+        if (i == 0) {
+            TEST_ASSERT(om->om_len == buflen);
+            TEST_ASSERT(om->om_pkthdr_len == pkthdr_len);
+        }
+
+        if (om->om_owner != NULL) {
+            data_min = om->om_owner->om_databuf;
+            data_max = om->om_owner->om_databuf +
+                       om->om_owner->om_omp->omp_databuf_len - om->om_len;
+            TEST_ASSERT(om->om_data >= data_min && om->om_data <= data_max);
+        } else if (om->om_ext == NULL) {
+            data_min = om->om_databuf + om->om_pkthdr_len;
+            data_max = om->om_databuf + om->om_omp->omp_databuf_len -
+                       om->om_len;
+            TEST_ASSERT(om->om_data >= data_min && om->om_data <= data_max);
+        }
+
+        if (data != NULL) {
+            TEST_ASSERT(memcmp(om->om_data, data + totlen, om->om_len) == 0);
+        }
+
+        totlen += om->om_len;
+        om = SLIST_NEXT(om, om_next);
+    }
+
+    TEST_ASSERT(totlen == pktlen);
+}
+
+TEST_CASE_DECL(os_sched_test_runq)
+TEST_CASE_DECL(os_sched_test_sleepq)
+TEST_CASE_DECL(callout_test_order)
+TEST_CASE_DECL(os_malloc_test_slab)
+TEST_CASE_DECL(os_mempool_test_mag)
+TEST_CASE_DECL(os_mempool_test_free_map)
+TEST_CASE_DECL(os_msys_test_fallback)
+TEST_CASE_DECL(os_mbuf_test_ext)
+
+TEST_SUITE(os_opt_sched_test_suite)
+{
+    os_sched_test_runq();
+    os_sched_test_sleepq();
+}
+
+TEST_SUITE(os_opt_callout_test_suite)
+{
+    callout_test_order();
+}
+
+TEST_SUITE(os_opt_mempool_test_suite)
+{
+    os_malloc_test_slab();
+    os_mempool_test_mag();
+    os_mempool_test_free_map();
+}
+
+TEST_SUITE(os_opt_mbuf_test_suite)
+{
+    os_msys_test_fallback();
+    os_mbuf_test_ext();
+}
+
+int
+os_opt_test_all(void)
+{
+    os_opt_sched_test_suite();
+    os_opt_callout_test_suite();
+    os_opt_mempool_test_suite();
+    os_opt_mbuf_test_suite();
+
+    return tu_case_failed;
+}
+
+int
+main(int argc, char **argv)
+{
+    os_opt_test_all();
+    return tu_any_failed;
+}
@@ -0,0 +1,54 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_OS_OPT_TEST_PRIV_
+#define H_OS_OPT_TEST_PRIV_
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEM_BLOCK_SIZE              (80)
+
+#define MBUF_TEST_POOL_BUF_SIZE     (256)
+#define MBUF_TEST_POOL_BUF_COUNT    (10)
+
+#define MBUF_TEST_DATA_LEN          (1024)
+
+extern struct os_mbuf_pool os_mbuf_pool;
+extern struct os_mempool os_mbuf_mempool;
+extern uint8_t os_mbuf_test_data[MBUF_TEST_DATA_LEN];
+
+void os_mbuf_test_setup(void);
+void os_mbuf_test_misc_assert_sane(struct os_mbuf *om, void *data, int buflen,
+                                   int pktlen, int pkthdr_len);
+
+TEST_SUITE_DECL(os_opt_sched_test_suite);
+TEST_SUITE_DECL(os_opt_callout_test_suite);
+TEST_SUITE_DECL(os_opt_mempool_test_suite);
+TEST_SUITE_DECL(os_opt_mbuf_test_suite);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
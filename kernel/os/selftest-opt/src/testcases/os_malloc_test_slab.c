@@ -0,0 +1,102 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "os_opt_test_priv.h"
+
+#define OMTS_NUM_PTRS   64
+
+static void *omts_ptrs[OMTS_NUM_PTRS];
+
+TEST_CASE_SELF(os_malloc_test_slab)
+{
+    struct os_malloc_info omi1;
+    struct os_malloc_info omi2;
+    uint8_t *p;
+    int rc;
+    int i;
+
+    rc = os_malloc_info_get(&omi1);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /*** Small allocations do not touch the heap. */
+    for (i = 0; i < MYNEWT_VAL(OS_MALLOC_SLAB_1_BLOCK_COUNT); i++) {
+        omts_ptrs[i] = os_malloc(MYNEWT_VAL(OS_MALLOC_SLAB_1_BLOCK_SIZE));
+        TEST_ASSERT_FATAL(omts_ptrs[i] != NULL);
+        TEST_ASSERT(((uintptr_t)omts_ptrs[i] & 7) == 0);
+        memset(omts_ptrs[i], i, MYNEWT_VAL(OS_MALLOC_SLAB_1_BLOCK_SIZE));
+    }
+
+    rc = os_malloc_info_get(&omi2);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(omi2.omi_heap_allocs == omi1.omi_heap_allocs);
+    TEST_ASSERT(omi2.omi_slab_fallbacks == omi1.omi_slab_fallbacks);
+
+    /*** Smallest class is exhausted. */
+    p = os_malloc(1);
+#if MYNEWT_VAL(OS_MALLOC_SLAB_FALLBACK)
+    /* Next class spills over. */
+    TEST_ASSERT_FATAL(p != NULL);
+#else
+    /* Never falls back to another class or the heap. */
+    TEST_ASSERT(p == NULL);
+#endif
+
+    rc = os_malloc_info_get(&omi2);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(omi2.omi_heap_allocs == omi1.omi_heap_allocs);
+    TEST_ASSERT(omi2.omi_slab_fallbacks == omi1.omi_slab_fallbacks + 1);
+    os_free(p);
+
+    /*** Growing a small block preserves its contents. */
+    p = os_realloc(omts_ptrs[0], MYNEWT_VAL(OS_MALLOC_SLAB_4_BLOCK_SIZE) + 1);
+    TEST_ASSERT_FATAL(p != NULL);
+    for (i = 0; i < MYNEWT_VAL(OS_MALLOC_SLAB_1_BLOCK_SIZE); i++) {
+        TEST_ASSERT(p[i] == 0);
+    }
+    omts_ptrs[0] = p;
+
+    rc = os_malloc_info_get(&omi2);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(omi2.omi_heap_allocs == omi1.omi_heap_allocs + 1);
+
+    /*** Everything goes back where it came from. */
+    for (i = 0; i < MYNEWT_VAL(OS_MALLOC_SLAB_1_BLOCK_COUNT); i++) {
+        os_free(omts_ptrs[i]);
+    }
+
+    rc = os_malloc_info_get(&omi2);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(omi2.omi_heap_allocs == omi1.omi_heap_allocs);
+    TEST_ASSERT(omi2.omi_heap_allocs_max >= omi1.omi_heap_allocs + 1);
+
+    /* Freed small blocks are reused. */
+    for (i = 0; i < MYNEWT_VAL(OS_MALLOC_SLAB_1_BLOCK_COUNT); i++) {
+        omts_ptrs[i] = os_malloc(1);
+        TEST_ASSERT_FATAL(omts_ptrs[i] != NULL);
+    }
+    rc = os_malloc_info_get(&omi2);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(omi2.omi_heap_allocs == omi1.omi_heap_allocs);
+    TEST_ASSERT(omi2.omi_slab_fallbacks == omi1.omi_slab_fallbacks + 1);
+
+    for (i = 0; i < MYNEWT_VAL(OS_MALLOC_SLAB_1_BLOCK_COUNT); i++) {
+        os_free(omts_ptrs[i]);
+    }
+}
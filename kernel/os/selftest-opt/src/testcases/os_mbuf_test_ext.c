@@ -0,0 +1,195 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os_opt_test_priv.h"
+
+#if MYNEWT_VAL(OS_MBUF_EXT)
+#define OMTE_PKTHDR_LEN     ((int)sizeof (struct os_mbuf_pkthdr))
+
+static int omte_num_frees;
+
+static void
+omte_free_cb(struct os_mbuf_ext *ext, void *arg)
+{
+    TEST_ASSERT(arg == &omte_num_frees);
+    omte_num_frees++;
+}
+#endif
+
+TEST_CASE_SELF(os_mbuf_test_ext)
+{
+#if MYNEWT_VAL(OS_MBUF_EXT)
+    static const uint8_t ext_data[600] = { 1, 2, 3 };
+    struct os_mbuf_ext ext;
+    struct os_mbuf *om;
+    struct os_mbuf *clone;
+    struct os_mbuf *clone2;
+    uint8_t buf[8];
+    uint8_t val;
+    int nfree;
+    int rc;
+
+    os_mbuf_test_setup();
+    nfree = os_mbuf_mempool.mp_num_free;
+
+    /*** Clone shares the data; only a header block is consumed. */
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, os_mbuf_test_data, 100);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    clone = os_mbuf_clone(&os_mbuf_pool, om);
+    TEST_ASSERT_FATAL(clone != NULL);
+    TEST_ASSERT(clone->om_data == om->om_data);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == nfree - 2);
+    TEST_ASSERT(!OS_MBUF_IS_EXCLUSIVE(om));
+    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(om) == 0);
+    os_mbuf_test_misc_assert_sane(clone, os_mbuf_test_data, 100, 100,
+                                  OMTE_PKTHDR_LEN);
+
+    /*** Freeing the original keeps its block alive for the clone. */
+    rc = os_mbuf_free_chain(om);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == nfree - 2);
+    os_mbuf_test_misc_assert_sane(clone, os_mbuf_test_data, 100, 100,
+                                  OMTE_PKTHDR_LEN);
+
+    rc = os_mbuf_free_chain(clone);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == nfree);
+
+    /*** Dup makes a private copy that may be written directly. */
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, os_mbuf_test_data, 100);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    clone = os_mbuf_dup(om);
+    TEST_ASSERT_FATAL(clone != NULL);
+    TEST_ASSERT(clone->om_data != om->om_data);
+    TEST_ASSERT(OS_MBUF_IS_EXCLUSIVE(om));
+    TEST_ASSERT(OS_MBUF_IS_EXCLUSIVE(clone));
+    clone->om_data[0] = 0xff;
+    os_mbuf_test_misc_assert_sane(om, os_mbuf_test_data, 100, 100,
+                                  OMTE_PKTHDR_LEN);
+
+    os_mbuf_free_chain(om);
+    os_mbuf_free_chain(clone);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == nfree);
+
+    /*** Writes through one clone are not visible in the other. */
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, os_mbuf_test_data, 100);
+    TEST_ASSERT_FATAL(rc == 0);
+    clone = os_mbuf_clone(&os_mbuf_pool, om);
+    TEST_ASSERT_FATAL(clone != NULL);
+
+    val = 0xff;
+    rc = os_mbuf_copyinto(clone, 10, &val, 1);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(clone->om_data != om->om_data);
+    os_mbuf_test_misc_assert_sane(om, os_mbuf_test_data, 100, 100,
+                                  OMTE_PKTHDR_LEN);
+    rc = os_mbuf_copydata(clone, 9, 3, buf);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(buf[0] == 9 && buf[1] == 0xff && buf[2] == 11);
+
+    rc = os_mbuf_copyinto(om, 20, &val, 1);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(OS_MBUF_IS_EXCLUSIVE(om));
+
+    /*** Appending to a clone goes to a new mbuf. */
+    clone2 = os_mbuf_clone(&os_mbuf_pool, om);
+    TEST_ASSERT_FATAL(clone2 != NULL);
+    rc = os_mbuf_append(clone2, os_mbuf_test_data + 100, 10);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(SLIST_NEXT(clone2, om_next) != NULL);
+    TEST_ASSERT(OS_MBUF_PKTLEN(clone2) == 110);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 100);
+
+    /*** Unshare gives each mbuf a private copy. */
+    rc = os_mbuf_unshare(clone2);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(OS_MBUF_IS_EXCLUSIVE(clone2));
+    TEST_ASSERT(OS_MBUF_IS_EXCLUSIVE(om));
+    rc = os_mbuf_cmpm(om, 0, clone2, 0, 100);
+    TEST_ASSERT(rc == 0);
+
+    os_mbuf_free_chain(om);
+    os_mbuf_free_chain(clone);
+    os_mbuf_free_chain(clone2);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == nfree);
+
+    /*** External buffer: read-only, callback fires on last free. */
+    omte_num_frees = 0;
+    os_mbuf_ext_init(&ext, omte_free_cb, &omte_num_frees);
+
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    clone = os_mbuf_get_ext(&os_mbuf_pool, &ext, ext_data, sizeof ext_data);
+    TEST_ASSERT_FATAL(clone != NULL);
+    os_mbuf_concat(om, clone);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == sizeof ext_data);
+    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(clone) == 0);
+
+    clone2 = os_mbuf_clone(&os_mbuf_pool, om);
+    TEST_ASSERT_FATAL(clone2 != NULL);
+    TEST_ASSERT(ext.ome_refcnt == 2);
+
+    /* Too large to copy into the mbuf's own databuf. */
+    rc = os_mbuf_copyinto(clone2, 0, &val, 1);
+    TEST_ASSERT(rc == OS_ENOMEM);
+
+    os_mbuf_free_chain(om);
+    TEST_ASSERT(omte_num_frees == 0);
+    rc = os_mbuf_copydata(clone2, 0, 3, buf);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(buf[0] == 1 && buf[1] == 2 && buf[2] == 3);
+
+    os_mbuf_free_chain(clone2);
+    TEST_ASSERT(omte_num_frees == 1);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == nfree);
+
+    /*** Dup copies, even data that does not fit in one block. */
+    omte_num_frees = 0;
+    os_mbuf_ext_init(&ext, omte_free_cb, &omte_num_frees);
+
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    clone = os_mbuf_get_ext(&os_mbuf_pool, &ext, ext_data, sizeof ext_data);
+    TEST_ASSERT_FATAL(clone != NULL);
+    os_mbuf_concat(om, clone);
+
+    clone2 = os_mbuf_dup(om);
+    TEST_ASSERT_FATAL(clone2 != NULL);
+    TEST_ASSERT(ext.ome_refcnt == 1);
+    TEST_ASSERT(OS_MBUF_PKTLEN(clone2) == sizeof ext_data);
+    for (clone = clone2; clone != NULL; clone = SLIST_NEXT(clone, om_next)) {
+        TEST_ASSERT(OS_MBUF_IS_EXCLUSIVE(clone));
+    }
+    rc = os_mbuf_cmpf(clone2, 0, ext_data, sizeof ext_data);
+    TEST_ASSERT(rc == 0);
+
+    os_mbuf_free_chain(om);
+    TEST_ASSERT(omte_num_frees == 1);
+    os_mbuf_free_chain(clone2);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == nfree);
+#endif
+}
@@ -0,0 +1,93 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os_opt_test_priv.h"
+
+#define OMTF_NUM_BLOCKS     40
+
+static os_membuf_t omtf_buf[OS_MEMPOOL_SIZE(OMTF_NUM_BLOCKS, MEM_BLOCK_SIZE)];
+static uint32_t omtf_map[OS_MEMPOOL_FREE_MAP_SIZE(OMTF_NUM_BLOCKS)];
+static struct os_mempool omtf_pool;
+static void *omtf_blocks[OMTF_NUM_BLOCKS];
+
+TEST_CASE_SELF(os_mempool_test_free_map)
+{
+    uint8_t *foreign;
+    int rc;
+    int i;
+
+    rc = os_mempool_init(&omtf_pool, OMTF_NUM_BLOCKS, MEM_BLOCK_SIZE,
+                         omtf_buf, "omtf");
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Blocks allocated before the map is attached are tracked correctly. */
+    omtf_blocks[0] = os_memblock_get(&omtf_pool);
+    TEST_ASSERT_FATAL(omtf_blocks[0] != NULL);
+
+    rc = os_mempool_free_map_init(&omtf_pool, omtf_map);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mempool_is_sane(&omtf_pool));
+
+    for (i = 1; i < OMTF_NUM_BLOCKS; i++) {
+        omtf_blocks[i] = os_memblock_get(&omtf_pool);
+        TEST_ASSERT_FATAL(omtf_blocks[i] != NULL);
+    }
+    TEST_ASSERT(os_memblock_get(&omtf_pool) == NULL);
+
+    for (i = 0; i < OMTF_NUM_BLOCKS; i++) {
+        rc = os_memblock_put(&omtf_pool, omtf_blocks[i]);
+        TEST_ASSERT(rc == 0);
+    }
+    TEST_ASSERT(omtf_pool.mp_num_free == OMTF_NUM_BLOCKS);
+    TEST_ASSERT(os_mempool_is_sane(&omtf_pool));
+
+#if !MYNEWT_VAL(OS_MEMPOOL_CHECK)
+    /*** Double free is rejected. */
+    rc = os_memblock_put(&omtf_pool, omtf_blocks[3]);
+    TEST_ASSERT(rc == OS_INVALID_PARM);
+    TEST_ASSERT(omtf_pool.mp_num_free == OMTF_NUM_BLOCKS);
+
+    /*** Misaligned and out-of-range blocks are rejected. */
+    omtf_blocks[0] = os_memblock_get(&omtf_pool);
+    TEST_ASSERT_FATAL(omtf_blocks[0] != NULL);
+
+    foreign = (uint8_t *)omtf_blocks[0] + 1;
+    rc = os_memblock_put(&omtf_pool, foreign);
+    TEST_ASSERT(rc == OS_INVALID_PARM);
+
+    foreign = (uint8_t *)omtf_buf + sizeof omtf_buf;
+    rc = os_memblock_put(&omtf_pool, foreign);
+    TEST_ASSERT(rc == OS_INVALID_PARM);
+
+    rc = os_memblock_put(&omtf_pool, omtf_blocks[0]);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(omtf_pool.mp_num_free == OMTF_NUM_BLOCKS);
+#endif
+
+    /*** Clearing the pool marks every block free. */
+    omtf_blocks[0] = os_memblock_get(&omtf_pool);
+    TEST_ASSERT_FATAL(omtf_blocks[0] != NULL);
+    rc = os_mempool_clear(&omtf_pool);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mempool_is_sane(&omtf_pool));
+    omtf_blocks[0] = os_memblock_get(&omtf_pool);
+    TEST_ASSERT_FATAL(omtf_blocks[0] != NULL);
+    rc = os_memblock_put(&omtf_pool, omtf_blocks[0]);
+    TEST_ASSERT(rc == 0);
+}
@@ -0,0 +1,114 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os_opt_test_priv.h"
+
+#define OMTM_NUM_BLOCKS     10
+#define OMTM_NUM_MAGS       2
+
+static os_membuf_t omtm_buf[OS_MEMPOOL_SIZE(OMTM_NUM_BLOCKS, MEM_BLOCK_SIZE)];
+static struct os_mempool omtm_pool;
+static struct os_mempool_mag omtm_mags[OMTM_NUM_MAGS];
+static void *omtm_blocks[OMTM_NUM_BLOCKS];
+static struct os_task omtm_other_task;
+
+static int
+omtm_info_num_free(const struct os_mempool *mp)
+{
+    struct os_mempool_info omi;
+    struct os_mempool *cur;
+
+    cur = NULL;
+    while (1) {
+        cur = os_mempool_info_get_next(cur, &omi);
+        TEST_ASSERT_FATAL(cur != NULL);
+        if (cur == mp) {
+            return omi.omi_num_free;
+        }
+    }
+}
+
+TEST_CASE_TASK(os_mempool_test_mag)
+{
+    void *block;
+    int rc;
+    int i;
+    int j;
+
+    rc = os_mempool_init(&omtm_pool, OMTM_NUM_BLOCKS, MEM_BLOCK_SIZE,
+                         omtm_buf, "omtm");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mempool_mag_init(&omtm_pool, omtm_mags, OMTM_NUM_MAGS);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /*** First allocation claims a magazine and caches a batch of blocks. */
+    block = os_memblock_get(&omtm_pool);
+    TEST_ASSERT_FATAL(block != NULL);
+    TEST_ASSERT(omtm_mags[0].omm_owner == os_sched_get_current_task());
+    TEST_ASSERT(omtm_mags[0].omm_cnt > 0);
+    TEST_ASSERT(omtm_pool.mp_num_free < OMTM_NUM_BLOCKS - 1);
+
+    /* Cached blocks are still reported as free. */
+    TEST_ASSERT(os_mempool_num_free(&omtm_pool) == OMTM_NUM_BLOCKS - 1);
+    TEST_ASSERT(omtm_info_num_free(&omtm_pool) == OMTM_NUM_BLOCKS - 1);
+
+    /* The owner can get its cached blocks; other tasks cannot. */
+    TEST_ASSERT(os_mempool_num_avail(&omtm_pool) == OMTM_NUM_BLOCKS - 1);
+    omtm_mags[0].omm_owner = &omtm_other_task;
+    TEST_ASSERT(os_mempool_num_avail(&omtm_pool) == omtm_pool.mp_num_free);
+    TEST_ASSERT(os_mempool_num_free(&omtm_pool) == OMTM_NUM_BLOCKS - 1);
+    omtm_mags[0].omm_owner = os_sched_get_current_task();
+
+    rc = os_memblock_put(&omtm_pool, block);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mempool_num_free(&omtm_pool) == OMTM_NUM_BLOCKS);
+
+    /*** Every block can still be allocated exactly once. */
+    for (i = 0; i < OMTM_NUM_BLOCKS; i++) {
+        omtm_blocks[i] = os_memblock_get(&omtm_pool);
+        TEST_ASSERT_FATAL(omtm_blocks[i] != NULL);
+        TEST_ASSERT(os_memblock_from(&omtm_pool, omtm_blocks[i]));
+        for (j = 0; j < i; j++) {
+            TEST_ASSERT(omtm_blocks[i] != omtm_blocks[j]);
+        }
+    }
+    TEST_ASSERT(os_memblock_get(&omtm_pool) == NULL);
+    TEST_ASSERT(os_mempool_num_free(&omtm_pool) == 0);
+    TEST_ASSERT(omtm_pool.mp_min_free == 0);
+
+    /*** Frees overflow from the magazine back to the shared list. */
+    for (i = 0; i < OMTM_NUM_BLOCKS; i++) {
+        rc = os_memblock_put(&omtm_pool, omtm_blocks[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(os_mempool_num_free(&omtm_pool) == i + 1);
+    }
+    TEST_ASSERT(omtm_mags[0].omm_cnt <= MYNEWT_VAL(OS_MEMPOOL_MAG_SIZE));
+    TEST_ASSERT(omtm_info_num_free(&omtm_pool) == OMTM_NUM_BLOCKS);
+    TEST_ASSERT(os_mempool_is_sane(&omtm_pool));
+
+    /*** Flushing returns everything and releases the magazine. */
+    os_mempool_mag_flush(&omtm_pool);
+    TEST_ASSERT(omtm_pool.mp_num_free == OMTM_NUM_BLOCKS);
+    TEST_ASSERT(omtm_mags[0].omm_owner == NULL);
+    TEST_ASSERT(omtm_mags[0].omm_cnt == 0);
+    TEST_ASSERT(os_mempool_is_sane(&omtm_pool));
+
+    rc = os_mempool_unregister(&omtm_pool);
+    TEST_ASSERT(rc == 0);
+}
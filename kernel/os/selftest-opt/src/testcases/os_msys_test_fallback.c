@@ -0,0 +1,92 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os_opt_test_priv.h"
+
+#define OMTF_SMALL_DATA     64
+#define OMTF_LARGE_DATA     256
+#define OMTF_COUNT          4
+
+#define OMTF_SMALL_BLOCK    (OMTF_SMALL_DATA + sizeof(struct os_mbuf))
+#define OMTF_LARGE_BLOCK    (OMTF_LARGE_DATA + sizeof(struct os_mbuf))
+
+static os_membuf_t omtf_small_buf[OS_MEMPOOL_SIZE(OMTF_COUNT,
+                                                  OMTF_SMALL_BLOCK)];
+static os_membuf_t omtf_large_buf[OS_MEMPOOL_SIZE(OMTF_COUNT,
+                                                  OMTF_LARGE_BLOCK)];
+static struct os_mempool omtf_small_mempool;
+static struct os_mempool omtf_large_mempool;
+static struct os_mbuf_pool omtf_small_pool;
+static struct os_mbuf_pool omtf_large_pool;
+static struct os_mbuf *omtf_mbufs[OMTF_COUNT * 2];
+
+static void
+omtf_pool_init(struct os_mbuf_pool *omp, struct os_mempool *mp,
+               os_membuf_t *buf, int block_size, char *name)
+{
+    int rc;
+
+    rc = os_mempool_init(mp, OMTF_COUNT, block_size, buf, name);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(omp, mp, block_size, OMTF_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_msys_register(omp);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+TEST_CASE_SELF(os_msys_test_fallback)
+{
+    int i;
+
+    os_msys_reset();
+    omtf_pool_init(&omtf_small_pool, &omtf_small_mempool, omtf_small_buf,
+                   OMTF_SMALL_BLOCK, "omtf_small");
+    omtf_pool_init(&omtf_large_pool, &omtf_large_mempool, omtf_large_buf,
+                   OMTF_LARGE_BLOCK, "omtf_large");
+
+    /*** Small requests use the small pool while it has blocks. */
+    for (i = 0; i < OMTF_COUNT; i++) {
+        omtf_mbufs[i] = os_msys_get(OMTF_SMALL_DATA / 2, 0);
+        TEST_ASSERT_FATAL(omtf_mbufs[i] != NULL);
+        TEST_ASSERT(omtf_mbufs[i]->om_omp == &omtf_small_pool);
+    }
+
+    /*** Then they fall back to the larger pool. */
+    for (; i < OMTF_COUNT * 2; i++) {
+        omtf_mbufs[i] = os_msys_get(OMTF_SMALL_DATA / 2, 0);
+        TEST_ASSERT_FATAL(omtf_mbufs[i] != NULL);
+        TEST_ASSERT(omtf_mbufs[i]->om_omp == &omtf_large_pool);
+    }
+
+    /*** Everything exhausted. */
+    TEST_ASSERT(os_msys_get(OMTF_SMALL_DATA / 2, 0) == NULL);
+    TEST_ASSERT(os_msys_get_pkthdr(OMTF_SMALL_DATA / 2, 0) == NULL);
+    TEST_ASSERT(os_msys_num_free() == 0);
+
+    /*** A freed small block is preferred again. */
+    os_mbuf_free(omtf_mbufs[0]);
+    omtf_mbufs[0] = os_msys_get_pkthdr(OMTF_SMALL_DATA / 2, 0);
+    TEST_ASSERT_FATAL(omtf_mbufs[0] != NULL);
+    TEST_ASSERT(omtf_mbufs[0]->om_omp == &omtf_small_pool);
+
+    for (i = 0; i < OMTF_COUNT * 2; i++) {
+        os_mbuf_free(omtf_mbufs[i]);
+    }
+    TEST_ASSERT(os_msys_num_free() == OMTF_COUNT * 2);
+}
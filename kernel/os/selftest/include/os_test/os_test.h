@@ -33,6 +33,7 @@ TEST_SUITE_DECL(os_time_test_suite);
 TEST_SUITE_DECL(os_mbuf_test_suite);
 TEST_SUITE_DECL(os_eventq_test_suite);
 TEST_SUITE_DECL(os_callout_test_suite);
+TEST_SUITE_DECL(os_sched_test_suite);
 
 TEST_CASE_DECL(os_time_test_change);
 
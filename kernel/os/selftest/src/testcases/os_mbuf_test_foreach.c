@@ -0,0 +1,127 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os_test_priv.h"
+
+struct omtf_arg {
+    uint8_t buf[MBUF_TEST_DATA_LEN];
+    int len;
+    int segs;
+    int stop_after;
+};
+
+static int
+omtf_cb(const void *data, uint16_t len, void *arg)
+{
+    struct omtf_arg *a;
+
+    a = arg;
+    TEST_ASSERT_FATAL(len > 0);
+    TEST_ASSERT_FATAL(a->len + len <= sizeof a->buf);
+
+    memcpy(a->buf + a->len, data, len);
+    a->len += len;
+    a->segs++;
+
+    if (a->segs == a->stop_after) {
+        return 99;
+    }
+    return 0;
+}
+
+static void
+omtf_check(const struct os_mbuf *om, int off, int len)
+{
+    struct omtf_arg a;
+    int rc;
+
+    memset(&a, 0, sizeof a);
+    rc = os_mbuf_foreach_segment(om, off, len, omtf_cb, &a);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(a.len == len);
+    TEST_ASSERT(memcmp(a.buf, os_mbuf_test_data + off, len) == 0);
+}
+
+TEST_CASE_SELF(os_mbuf_test_foreach)
+{
+    struct os_mbuf_iter it;
+    struct os_mbuf *om;
+    struct os_mbuf *om2;
+    struct omtf_arg a;
+    const uint8_t *data;
+    uint16_t seg_len;
+    int total;
+    int rc;
+
+    os_mbuf_test_setup();
+
+    /* Three full mbufs, an empty one, and a partial one. */
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, os_mbuf_test_data, 600);
+    TEST_ASSERT_FATAL(rc == 0);
+    om2 = os_mbuf_get(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om2 != NULL);
+    os_mbuf_concat(om, om2);
+    om2 = os_mbuf_get(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om2 != NULL);
+    rc = os_mbuf_append(om2, os_mbuf_test_data + 600, 100);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_mbuf_concat(om, om2);
+    total = OS_MBUF_PKTLEN(om);
+    TEST_ASSERT_FATAL(total == 700);
+
+    /*** Whole chain and assorted sub-ranges. */
+    omtf_check(om, 0, total);
+    omtf_check(om, 1, total - 1);
+    omtf_check(om, 250, 10);
+    omtf_check(om, 590, 20);
+    omtf_check(om, total - 1, 1);
+    omtf_check(om, total, 0);
+
+    /*** Out of range. */
+    rc = os_mbuf_foreach_segment(om, 0, total + 1, omtf_cb, &a);
+    TEST_ASSERT(rc == OS_EINVAL);
+    rc = os_mbuf_foreach_segment(om, total + 1, 0, omtf_cb, &a);
+    TEST_ASSERT(rc == OS_EINVAL);
+
+    /*** Callback can stop the walk. */
+    memset(&a, 0, sizeof a);
+    a.stop_after = 2;
+    rc = os_mbuf_foreach_segment(om, 0, total, omtf_cb, &a);
+    TEST_ASSERT(rc == 99);
+    TEST_ASSERT(a.segs == 2);
+
+    /*** Iterator yields the same segments without a callback. */
+    rc = os_mbuf_iter_init(&it, om, 10, total - 10);
+    TEST_ASSERT_FATAL(rc == 0);
+    memset(&a, 0, sizeof a);
+    while (os_mbuf_iter_next(&it, &data, &seg_len)) {
+        TEST_ASSERT_FATAL(seg_len > 0);
+        /* Segments point into the pool; nothing was copied. */
+        TEST_ASSERT(data >= (uint8_t *)os_mbuf_membuf &&
+                    data < (uint8_t *)os_mbuf_membuf + sizeof os_mbuf_membuf);
+        memcpy(a.buf + a.len, data, seg_len);
+        a.len += seg_len;
+    }
+    TEST_ASSERT(a.len == total - 10);
+    TEST_ASSERT(memcmp(a.buf, os_mbuf_test_data + 10, a.len) == 0);
+
+    os_mbuf_free_chain(om);
+}
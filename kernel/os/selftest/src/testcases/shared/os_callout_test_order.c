@@ -0,0 +1,216 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+
+#define CALLOUT_ORDER_NUM   32
+
+static struct os_callout callout_order[CALLOUT_ORDER_NUM];
+static struct os_eventq callout_order_evq;
+
+/* Expiry time and arming sequence of each callout in the firing phase. */
+static os_time_t callout_order_exp[CALLOUT_ORDER_NUM];
+static int callout_order_seq[CALLOUT_ORDER_NUM];
+static uint8_t callout_order_fired[CALLOUT_ORDER_NUM];
+
+static void
+callout_order_cb(struct os_event *ev)
+{
+}
+
+/* Verifies that the earliest pending callout is reported to tickless idle. */
+static void
+callout_order_verify(os_time_t now)
+{
+    os_time_t expected;
+    os_time_t rem;
+    os_time_t tm;
+    os_sr_t sr;
+    int i;
+
+    expected = OS_TIMEOUT_NEVER;
+    for (i = 0; i < CALLOUT_ORDER_NUM; i++) {
+        if (os_callout_queued(&callout_order[i])) {
+            rem = os_callout_remaining_ticks(&callout_order[i], now);
+            if (rem < expected) {
+                expected = rem;
+            }
+        }
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    tm = os_callout_wakeup_ticks(now);
+    OS_EXIT_CRITICAL(sr);
+
+    TEST_ASSERT(tm == expected);
+}
+
+static void
+callout_order_arm(int idx, os_time_t ticks, int seq)
+{
+    int rc;
+
+    rc = os_callout_reset(&callout_order[idx], ticks);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    callout_order_exp[idx] = os_time_get() + ticks;
+    callout_order_seq[idx] = seq;
+}
+
+/*
+ * Returns the callout that should fire next: earliest expiry time first,
+ * the one armed first among those that expire together.
+ */
+static int
+callout_order_next(void)
+{
+    int best;
+    int i;
+
+    best = -1;
+    for (i = 0; i < CALLOUT_ORDER_NUM; i++) {
+        if (callout_order_fired[i] || !os_callout_queued(&callout_order[i])) {
+            continue;
+        }
+        if (best == -1 ||
+            OS_TIME_TICK_LT(callout_order_exp[i], callout_order_exp[best]) ||
+            (callout_order_exp[i] == callout_order_exp[best] &&
+             callout_order_seq[i] < callout_order_seq[best])) {
+
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+/*
+ * Advances time by the given number of ticks, runs the callout tick and
+ * verifies that exactly the callouts which have expired were posted, in
+ * order.
+ */
+static void
+callout_order_advance(int ticks)
+{
+    struct os_event *ev;
+    os_time_t now;
+    int expected[CALLOUT_ORDER_NUM];
+    int num_expected;
+    int idx;
+    int i;
+
+    os_time_advance(ticks);
+    now = os_time_get();
+
+    num_expected = 0;
+    while ((idx = callout_order_next()) != -1 &&
+           OS_TIME_TICK_GEQ(now, callout_order_exp[idx])) {
+
+        expected[num_expected++] = idx;
+        callout_order_fired[idx] = 1;
+    }
+
+    os_callout_tick();
+
+    for (i = 0; i < num_expected; i++) {
+        ev = os_eventq_get_no_wait(&callout_order_evq);
+        TEST_ASSERT_FATAL(ev != NULL);
+        TEST_ASSERT(ev == &callout_order[expected[i]].c_ev,
+                    "now=%u expected=%d", (unsigned)now, expected[i]);
+        TEST_ASSERT(!os_callout_queued(&callout_order[expected[i]]));
+    }
+    TEST_ASSERT(os_eventq_get_no_wait(&callout_order_evq) == NULL);
+
+    callout_order_verify(now);
+}
+
+/* Test case to verify callouts armed in random order expire in order */
+TEST_CASE_SELF(callout_test_order)
+{
+    os_time_t now;
+    int idx;
+    int rc;
+    int i;
+
+    os_eventq_init(&callout_order_evq);
+    for (i = 0; i < CALLOUT_ORDER_NUM; i++) {
+        os_callout_init(&callout_order[i], &callout_order_evq,
+                        callout_order_cb, NULL);
+    }
+
+    now = os_time_get();
+    callout_order_verify(now);
+
+    /* Arm in scrambled order, with some duplicate expiry times. */
+    for (i = 0; i < CALLOUT_ORDER_NUM; i++) {
+        rc = os_callout_reset(&callout_order[i],
+                              100 + (i * 7) % 16 * 10);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(os_callout_queued(&callout_order[i]));
+        callout_order_verify(now);
+    }
+
+    /* Re-arming moves a callout. */
+    rc = os_callout_reset(&callout_order[5], 50);
+    TEST_ASSERT_FATAL(rc == 0);
+    callout_order_verify(now);
+
+    rc = os_callout_reset(&callout_order[5], 10000);
+    TEST_ASSERT_FATAL(rc == 0);
+    callout_order_verify(now);
+
+    /* Stop callouts from the middle and from the head. */
+    for (i = 0; i < CALLOUT_ORDER_NUM; i += 3) {
+        os_callout_stop(&callout_order[i]);
+        TEST_ASSERT(!os_callout_queued(&callout_order[i]));
+        callout_order_verify(now);
+    }
+    for (i = 0; i < CALLOUT_ORDER_NUM; i++) {
+        os_callout_stop(&callout_order[i]);
+        callout_order_verify(now);
+    }
+
+    /*** Firing order: four callouts share each of eight expiry times. */
+    for (i = 0; i < CALLOUT_ORDER_NUM; i++) {
+        idx = (i * 13) % CALLOUT_ORDER_NUM;
+        callout_order_arm(idx, 10 + (idx * 5) % 8 * 10, i);
+    }
+
+    /* Re-arming puts a callout behind the others with the same expiry. */
+    idx = callout_order_next();
+    callout_order_arm(idx, callout_order_exp[idx] - os_time_get(),
+                      CALLOUT_ORDER_NUM);
+
+    /* A stopped callout does not fire. */
+    os_callout_stop(&callout_order[3]);
+
+    /* Tick by tick through the first expiry times... */
+    for (i = 0; i < 40; i++) {
+        callout_order_advance(1);
+    }
+
+    /* ...then expire several expiry times' worth in one tick. */
+    callout_order_advance(25);
+    callout_order_advance(100);
+
+    for (i = 0; i < CALLOUT_ORDER_NUM; i++) {
+        TEST_ASSERT(!os_callout_queued(&callout_order[i]));
+        TEST_ASSERT(callout_order_fired[i] == (i != 3));
+    }
+}
@@ -0,0 +1,183 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+
+#define OSTR_NUM_TASKS  6
+
+/*
+ * Tasks that are never started; they are only moved between the run and
+ * sleep lists to exercise run list ordering.
+ */
+static struct os_task ostr_tasks[OSTR_NUM_TASKS];
+
+static void
+ostr_task_init(struct os_task *t, uint8_t prio)
+{
+    memset(t, 0, sizeof *t);
+    t->t_prio = prio;
+    t->t_state = OS_TASK_READY;
+}
+
+static int
+ostr_is_test_task(const struct os_task *t)
+{
+    return t >= ostr_tasks && t < ostr_tasks + OSTR_NUM_TASKS;
+}
+
+/**
+ * Verifies that the run list is sorted by priority and that the test tasks in
+ * it appear in the specified order.
+ */
+static void
+ostr_verify(struct os_task **expected, int num)
+{
+    struct os_task *prev;
+    struct os_task *t;
+    int i;
+
+    prev = NULL;
+    i = 0;
+    TAILQ_FOREACH(t, &g_os_run_list, t_os_list) {
+        if (prev != NULL) {
+            TEST_ASSERT(prev->t_prio <= t->t_prio);
+        }
+        prev = t;
+
+        if (ostr_is_test_task(t)) {
+            TEST_ASSERT_FATAL(i < num);
+            TEST_ASSERT(t == expected[i]);
+            i++;
+        }
+    }
+    TEST_ASSERT(i == num);
+
+    if (num > 0) {
+        TEST_ASSERT(os_sched_next_task() == expected[0]);
+    }
+}
+
+#define OSTR_VERIFY(...) do                                         \
+{                                                                   \
+    struct os_task *ostr_exp[] = { __VA_ARGS__ };                   \
+    ostr_verify(ostr_exp, sizeof ostr_exp / sizeof ostr_exp[0]);    \
+} while (0)
+
+/* Takes a test task out of the scheduler altogether. */
+static void
+ostr_task_remove(struct os_task *t)
+{
+    if (t->t_state == OS_TASK_READY) {
+        os_sched_sleep(t, OS_TIMEOUT_NEVER);
+    }
+    TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
+}
+
+TEST_CASE_SELF(os_sched_test_runq)
+{
+    struct os_task *a;
+    struct os_task *b;
+    struct os_task *c;
+    struct os_task *d;
+    struct os_task *e;
+    struct os_task *f;
+    os_sr_t sr;
+    int rc;
+    int i;
+
+    a = &ostr_tasks[0];
+    b = &ostr_tasks[1];
+    c = &ostr_tasks[2];
+    d = &ostr_tasks[3];
+    e = &ostr_tasks[4];
+    f = &ostr_tasks[5];
+
+    ostr_task_init(a, 40);
+    ostr_task_init(b, 20);
+    ostr_task_init(c, 30);
+    ostr_task_init(d, 20);
+    ostr_task_init(e, 10);
+    ostr_task_init(f, 20);
+
+    OS_ENTER_CRITICAL(sr);
+
+    /*** Insert; equal priority tasks are queued in FIFO order. */
+    for (i = 0; i < 5; i++) {
+        rc = os_sched_insert(&ostr_tasks[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    OSTR_VERIFY(e, b, d, c, a);
+
+    /*** Only ready tasks can be inserted. */
+    f->t_state = OS_TASK_SLEEP;
+    rc = os_sched_insert(f);
+    TEST_ASSERT(rc == OS_EINVAL);
+    f->t_state = OS_TASK_READY;
+
+    /*** Sleep highest priority task; next one takes over. */
+    os_sched_sleep(e, OS_TIMEOUT_NEVER);
+    OSTR_VERIFY(b, d, c, a);
+
+    /*** Priority change while queued (mutex priority inheritance). */
+    a->t_prio = 20;
+    os_sched_resort(a);
+    OSTR_VERIFY(b, d, a, c);
+
+    d->t_prio = 50;
+    os_sched_resort(d);
+    OSTR_VERIFY(b, a, c, d);
+
+    /*** Wakeup moves task back to the head of the run list. */
+    os_sched_wakeup(e);
+    OSTR_VERIFY(e, b, a, c, d);
+
+    /*** Removing the last task of a priority level. */
+    os_sched_sleep(a, OS_TIMEOUT_NEVER);
+    OSTR_VERIFY(e, b, c, d);
+
+    rc = os_sched_insert(f);
+    TEST_ASSERT_FATAL(rc == 0);
+    OSTR_VERIFY(e, b, f, c, d);
+
+    /*** Removing the first task of a priority level. */
+    os_sched_sleep(b, OS_TIMEOUT_NEVER);
+    OSTR_VERIFY(e, f, c, d);
+
+    os_sched_wakeup(b);
+    OSTR_VERIFY(e, f, b, c, d);
+
+    /*** Priorities at both ends of the range. */
+    a->t_prio = OS_TASK_PRI_HIGHEST;
+    os_sched_wakeup(a);
+    OSTR_VERIFY(a, e, f, b, c, d);
+
+    os_sched_sleep(a, OS_TIMEOUT_NEVER);
+    a->t_prio = OS_TASK_PRI_LOWEST;
+    os_sched_wakeup(a);
+    OSTR_VERIFY(e, f, b, c, d, a);
+
+    for (i = 0; i < OSTR_NUM_TASKS; i++) {
+        ostr_task_remove(&ostr_tasks[i]);
+    }
+    ostr_verify(NULL, 0);
+
+    OS_EXIT_CRITICAL(sr);
+}
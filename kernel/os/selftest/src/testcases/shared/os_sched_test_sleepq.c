@@ -0,0 +1,216 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+
+#define OSTS_NUM_TASKS  12
+#define OSTS_PRIO       20
+
+/*
+ * Tasks that are never started; they are put to sleep with a timeout and
+ * woken by os_sched_os_timer_exp() as time is advanced by hand.
+ */
+static struct os_task osts_tasks[OSTS_NUM_TASKS];
+static os_time_t osts_wakeup[OSTS_NUM_TASKS];
+static int osts_seq[OSTS_NUM_TASKS];
+static uint8_t osts_expired[OSTS_NUM_TASKS];
+
+/* Tasks in the order they are expected to have been woken. */
+static struct os_task *osts_woken[OSTS_NUM_TASKS];
+static int osts_num_woken;
+
+static int
+osts_is_test_task(const struct os_task *t)
+{
+    return t >= osts_tasks && t < osts_tasks + OSTS_NUM_TASKS;
+}
+
+static void
+osts_sleep(int idx, os_time_t ticks, int seq)
+{
+    struct os_task *t;
+
+    t = &osts_tasks[idx];
+    if (t->t_state == OS_TASK_SLEEP) {
+        os_sched_wakeup(t);
+    }
+    os_sched_sleep(t, ticks);
+
+    osts_wakeup[idx] = os_time_get() + ticks;
+    osts_seq[idx] = seq;
+}
+
+/*
+ * Returns the task that should wake next: earliest wakeup time first, the
+ * one put to sleep first among those that wake together.
+ */
+static int
+osts_next(void)
+{
+    const struct os_task *t;
+    int best;
+    int i;
+
+    best = -1;
+    for (i = 0; i < OSTS_NUM_TASKS; i++) {
+        t = &osts_tasks[i];
+        if (osts_expired[i] || t->t_state != OS_TASK_SLEEP ||
+            (t->t_flags & OS_TASK_FLAG_NO_TIMEOUT)) {
+            continue;
+        }
+        if (best == -1 ||
+            OS_TIME_TICK_LT(osts_wakeup[i], osts_wakeup[best]) ||
+            (osts_wakeup[i] == osts_wakeup[best] &&
+             osts_seq[i] < osts_seq[best])) {
+
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+/*
+ * Verifies that the run list holds the woken test tasks in wakeup order
+ * (they all have the same priority, so they are queued FIFO), and that the
+ * earliest remaining wakeup is reported to tickless idle.
+ */
+static void
+osts_verify(os_time_t now)
+{
+    struct os_task *t;
+    os_time_t expected;
+    os_time_t tm;
+    int idx;
+    int i;
+
+    i = 0;
+    TAILQ_FOREACH(t, &g_os_run_list, t_os_list) {
+        if (osts_is_test_task(t)) {
+            TEST_ASSERT_FATAL(i < osts_num_woken);
+            TEST_ASSERT(t == osts_woken[i], "now=%u pos=%d",
+                        (unsigned)now, i);
+            i++;
+        }
+    }
+    TEST_ASSERT(i == osts_num_woken);
+
+    idx = osts_next();
+    if (idx == -1) {
+        expected = OS_TIMEOUT_NEVER;
+    } else {
+        expected = osts_wakeup[idx] - now;
+    }
+    tm = os_sched_wakeup_ticks(now);
+    TEST_ASSERT(tm == expected);
+}
+
+/* Advances time and wakes the tasks whose sleep timer has expired. */
+static void
+osts_advance(int ticks)
+{
+    os_time_t now;
+    os_sr_t sr;
+    int idx;
+
+    os_time_advance(ticks);
+    now = os_time_get();
+
+    OS_ENTER_CRITICAL(sr);
+
+    while ((idx = osts_next()) != -1 &&
+           OS_TIME_TICK_GEQ(now, osts_wakeup[idx])) {
+
+        osts_woken[osts_num_woken++] = &osts_tasks[idx];
+        osts_expired[idx] = 1;
+    }
+
+    os_sched_os_timer_exp();
+    osts_verify(now);
+
+    OS_EXIT_CRITICAL(sr);
+}
+
+TEST_CASE_SELF(os_sched_test_sleepq)
+{
+    struct os_task *t;
+    os_sr_t sr;
+    int idx;
+    int rc;
+    int i;
+
+    osts_num_woken = 0;
+    memset(osts_expired, 0, sizeof osts_expired);
+    for (i = 0; i < OSTS_NUM_TASKS; i++) {
+        t = &osts_tasks[i];
+        memset(t, 0, sizeof *t);
+        t->t_prio = OSTS_PRIO;
+        t->t_state = OS_TASK_READY;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+
+    for (i = 0; i < OSTS_NUM_TASKS; i++) {
+        rc = os_sched_insert(&osts_tasks[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /*** Sleep in scrambled order; up to three tasks share each wakeup time. */
+    for (i = 0; i < OSTS_NUM_TASKS - 1; i++) {
+        idx = (i * 5) % OSTS_NUM_TASKS;
+        osts_sleep(idx, 10 + idx % 4 * 10, i);
+    }
+    osts_sleep((OSTS_NUM_TASKS - 1) * 5 % OSTS_NUM_TASKS, OS_TIMEOUT_NEVER,
+               OSTS_NUM_TASKS - 1);
+    osts_verify(os_time_get());
+
+    /*** Sleeping again puts a task behind others with the same wakeup. */
+    idx = osts_next();
+    osts_sleep(idx, osts_wakeup[idx] - os_time_get(), OSTS_NUM_TASKS);
+    osts_verify(os_time_get());
+
+    OS_EXIT_CRITICAL(sr);
+
+    /*** Tick by tick through the first wakeup times... */
+    for (i = 0; i < 25; i++) {
+        osts_advance(1);
+    }
+
+    /*** ...then several wakeup times' worth in one tick. */
+    osts_advance(100);
+    TEST_ASSERT(osts_num_woken == OSTS_NUM_TASKS - 1);
+
+    /*** A task waiting forever is still asleep. */
+    OS_ENTER_CRITICAL(sr);
+
+    for (i = 0; i < OSTS_NUM_TASKS; i++) {
+        t = &osts_tasks[i];
+        if (t->t_state == OS_TASK_SLEEP) {
+            TEST_ASSERT(t->t_flags & OS_TASK_FLAG_NO_TIMEOUT);
+        } else {
+            os_sched_sleep(t, OS_TIMEOUT_NEVER);
+        }
+        TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
+    }
+    TEST_ASSERT(os_sched_wakeup_ticks(os_time_get()) == OS_TIMEOUT_NEVER);
+
+    OS_EXIT_CRITICAL(sr);
+}
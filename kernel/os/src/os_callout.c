@@ -26,7 +26,72 @@
 #include "os/mynewt.h"
 #include "os_priv.h"
 
+#if MYNEWT_VAL(OS_TIMEQ_HEAP)
+static struct os_timeq g_callout_timeq =
+    OS_TIMEQ_INITIALIZER(struct os_callout, c_node, c_ticks);
+#else
 struct os_callout_list g_callout_list;
+#endif
+
+void
+os_callout_module_init(void)
+{
+#if MYNEWT_VAL(OS_TIMEQ_HEAP)
+    g_callout_timeq.tq_root = NULL;
+#else
+    TAILQ_INIT(&g_callout_list);
+#endif
+}
+
+/* Returns the pending callout with the earliest expiry time. */
+static struct os_callout *
+os_callout_first(void)
+{
+#if MYNEWT_VAL(OS_TIMEQ_HEAP)
+    struct os_timeq_node *node;
+
+    node = os_timeq_first(&g_callout_timeq);
+    if (node == NULL) {
+        return NULL;
+    }
+    return CONTAINER_OF(node, struct os_callout, c_node);
+#else
+    return TAILQ_FIRST(&g_callout_list);
+#endif
+}
+
+static void
+os_callout_dequeue(struct os_callout *c)
+{
+#if MYNEWT_VAL(OS_TIMEQ_HEAP)
+    os_timeq_remove(&g_callout_timeq, &c->c_node);
+#else
+    TAILQ_REMOVE(&g_callout_list, c, c_next);
+    c->c_next.tqe_prev = NULL;
+#endif
+}
+
+static void
+os_callout_enqueue(struct os_callout *c)
+{
+#if MYNEWT_VAL(OS_TIMEQ_HEAP)
+    os_timeq_insert(&g_callout_timeq, &c->c_node);
+#else
+    struct os_callout *entry;
+
+    TAILQ_FOREACH(entry, &g_callout_list, c_next) {
+        if (OS_TIME_TICK_LT(c->c_ticks, entry->c_ticks)) {
+            break;
+        }
+    }
+
+    if (entry) {
+        TAILQ_INSERT_BEFORE(entry, c, c_next);
+    } else {
+        TAILQ_INSERT_TAIL(&g_callout_list, c, c_next);
+    }
+#endif
+}
 
 void os_callout_init(struct os_callout *c, struct os_eventq *evq,
                      os_event_fn *ev_cb, void *ev_arg)
@@ -51,8 +116,7 @@ os_callout_stop(struct os_callout *c)
     OS_ENTER_CRITICAL(sr);
 
     if (os_callout_queued(c)) {
-        TAILQ_REMOVE(&g_callout_list, c, c_next);
-        c->c_next.tqe_prev = NULL;
+        os_callout_dequeue(c);
     }
 
     if (c->c_evq) {
@@ -67,7 +131,6 @@ os_callout_stop(struct os_callout *c)
 int
 os_callout_reset(struct os_callout *c, os_time_t ticks)
 {
-    struct os_callout *entry;
     os_sr_t sr;
     int ret;
 
@@ -90,19 +153,7 @@ os_callout_reset(struct os_callout *c, os_time_t ticks)
     }
 
     c->c_ticks = os_time_get() + ticks;
-
-    entry = NULL;
-    TAILQ_FOREACH(entry, &g_callout_list, c_next) {
-        if (OS_TIME_TICK_LT(c->c_ticks, entry->c_ticks)) {
-            break;
-        }
-    }
-
-    if (entry) {
-        TAILQ_INSERT_BEFORE(entry, c, c_next);
-    } else {
-        TAILQ_INSERT_TAIL(&g_callout_list, c, c_next);
-    }
+    os_callout_enqueue(c);
 
     OS_EXIT_CRITICAL(sr);
 
@@ -133,11 +184,10 @@ os_callout_tick(void)
 
     while (1) {
         OS_ENTER_CRITICAL(sr);
-        c = TAILQ_FIRST(&g_callout_list);
+        c = os_callout_first();
         if (c) {
             if (OS_TIME_TICK_GEQ(now, c->c_ticks)) {
-                TAILQ_REMOVE(&g_callout_list, c, c_next);
-                c->c_next.tqe_prev = NULL;
+                os_callout_dequeue(c);
             } else {
                 c = NULL;
             }
@@ -174,7 +224,7 @@ os_callout_wakeup_ticks(os_time_t now)
 
     OS_ASSERT_CRITICAL();
 
-    c = TAILQ_FIRST(&g_callout_list);
+    c = os_callout_first();
     if (c != NULL) {
         if (OS_TIME_TICK_GEQ(c->c_ticks, now)) {
             rt = c->c_ticks - now;
@@ -18,12 +18,18 @@
  */
 
 #include <assert.h>
+#include <string.h>
 #include "os/mynewt.h"
+#include "os_priv.h"
 
 #if MYNEWT_VAL(OS_SCHEDULING)
 static struct os_mutex os_malloc_mutex;
 #endif
 
+/* Number of heap allocations currently outstanding, and the peak. */
+static uint32_t os_malloc_heap_allocs;
+static uint32_t os_malloc_heap_allocs_max;
+
 static void
 os_malloc_lock(void)
 {
@@ -50,30 +56,257 @@ os_malloc_unlock(void)
 #endif
 }
 
-void *
-os_malloc(size_t size)
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+
+/*
+ * Size class front-end.  Small requests are served from a handful of
+ * mempools, one per size class, and never take the heap mutex nor walk the
+ * heap free list while their class has blocks left.  If the request's class
+ * is exhausted the allocation fails, unless OS_MALLOC_SLAB_FALLBACK is
+ * enabled; then it spills over to the next larger class and only then to the
+ * heap.
+ *
+ * Blocks are aligned like malloc() memory, not just to OS_ALIGNMENT, so
+ * callers can store 64-bit types in them.  What has to be a multiple of the
+ * alignment is the distance between blocks, which includes the guard word
+ * with OS_MEMPOOL_GUARD; the usable block size is whatever that leaves.
+ */
+#define OS_MALLOC_SLAB_ALIGN    8
+
+#define OS_MALLOC_SLAB_ROUND(sz)                                            \
+    (((sz) + OS_MALLOC_SLAB_ALIGN - 1) & ~(OS_MALLOC_SLAB_ALIGN - 1))
+
+#define OS_MALLOC_SLAB_BLOCK_SIZE(n)                                        \
+    (OS_MALLOC_SLAB_ROUND(OS_MEMPOOL_BLOCK_SZ(                              \
+        MYNEWT_VAL(OS_MALLOC_SLAB_##n##_BLOCK_SIZE))) -                     \
+     OS_MEMPOOL_BLOCK_SZ(0))
+
+#define OS_MALLOC_SLAB_DEFINE(n)                                            \
+    static os_membuf_t os_malloc_slab_##n##_data[                           \
+        OS_MEMPOOL_SIZE(MYNEWT_VAL(OS_MALLOC_SLAB_##n##_BLOCK_COUNT),       \
+                        OS_MEMPOOL_BLOCK_SZ(OS_MALLOC_SLAB_BLOCK_SIZE(n)))] \
+        __attribute__((aligned(OS_MALLOC_SLAB_ALIGN)))
+
+#if MYNEWT_VAL(OS_MALLOC_SLAB_1_BLOCK_COUNT) > 0
+OS_MALLOC_SLAB_DEFINE(1);
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_2_BLOCK_COUNT) > 0
+OS_MALLOC_SLAB_DEFINE(2);
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_3_BLOCK_COUNT) > 0
+OS_MALLOC_SLAB_DEFINE(3);
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_4_BLOCK_COUNT) > 0
+OS_MALLOC_SLAB_DEFINE(4);
+#endif
+
+#if MYNEWT_VAL(OS_MALLOC_SLAB_1_BLOCK_SIZE) >=   \
+        MYNEWT_VAL(OS_MALLOC_SLAB_2_BLOCK_SIZE) ||  \
+    MYNEWT_VAL(OS_MALLOC_SLAB_2_BLOCK_SIZE) >=   \
+        MYNEWT_VAL(OS_MALLOC_SLAB_3_BLOCK_SIZE) ||  \
+    MYNEWT_VAL(OS_MALLOC_SLAB_3_BLOCK_SIZE) >=   \
+        MYNEWT_VAL(OS_MALLOC_SLAB_4_BLOCK_SIZE)
+#error "OS_MALLOC_SLAB_n_BLOCK_SIZE must be in ascending order"
+#endif
+
+#define OS_MALLOC_SLAB_CNT  4
+
+static struct os_mempool os_malloc_slabs[OS_MALLOC_SLAB_CNT];
+static uint32_t os_malloc_slab_fallbacks;
+
+static void
+os_malloc_slab_init(int idx, void *data, uint16_t blocks,
+                    uint32_t block_size, char *name)
+{
+    int rc;
+
+    rc = os_mempool_init(&os_malloc_slabs[idx], blocks, block_size, data,
+                         name);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+
+/*
+ * Returns the size class that owns the given block, or NULL if the block
+ * came from the heap.  Pools that were not initialized yet have no blocks
+ * and never claim a block.
+ */
+static struct os_mempool *
+os_malloc_slab_find(const void *mem)
+{
+    int i;
+
+    for (i = 0; i < OS_MALLOC_SLAB_CNT; i++) {
+        if (os_malloc_slabs[i].mp_num_blocks > 0 &&
+            os_memblock_from(&os_malloc_slabs[i], mem)) {
+            return &os_malloc_slabs[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Returns the smallest size class that can hold the given number of bytes,
+ * or -1 if the request is too big for any class.
+ */
+static int
+os_malloc_slab_class(size_t size)
+{
+    int i;
+
+    for (i = 0; i < OS_MALLOC_SLAB_CNT; i++) {
+        if (size <= os_malloc_slabs[i].mp_block_size &&
+            os_malloc_slabs[i].mp_num_blocks > 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void *
+os_malloc_slab_get(int idx)
+{
+    void *mem;
+
+    mem = os_memblock_get(&os_malloc_slabs[idx]);
+    if (mem != NULL) {
+        return mem;
+    }
+
+    /* Exhaustion is the slow path; count it under the heap mutex. */
+    os_malloc_lock();
+    os_malloc_slab_fallbacks++;
+    os_malloc_unlock();
+
+#if MYNEWT_VAL(OS_MALLOC_SLAB_FALLBACK)
+    for (idx++; idx < OS_MALLOC_SLAB_CNT; idx++) {
+        if (os_malloc_slabs[idx].mp_num_blocks > 0) {
+            mem = os_memblock_get(&os_malloc_slabs[idx]);
+            if (mem != NULL) {
+                return mem;
+            }
+        }
+    }
+#endif
+
+    return NULL;
+}
+
+#endif
+
+static void *
+os_malloc_heap(size_t size)
 {
     void *ptr;
 
     os_malloc_lock();
     ptr = malloc(size);
+    if (ptr != NULL) {
+        os_malloc_heap_allocs++;
+        if (os_malloc_heap_allocs > os_malloc_heap_allocs_max) {
+            os_malloc_heap_allocs_max = os_malloc_heap_allocs;
+        }
+    }
     os_malloc_unlock();
 
     return ptr;
 }
 
-void
-os_free(void *mem)
+/* Must only be given blocks counted by os_malloc_heap(). */
+static void
+os_free_heap(void *mem)
 {
     os_malloc_lock();
     free(mem);
+    os_malloc_heap_allocs--;
     os_malloc_unlock();
 }
 
+void *
+os_malloc(size_t size)
+{
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    void *ptr;
+    int idx;
+
+    if (size > 0) {
+        idx = os_malloc_slab_class(size);
+        if (idx >= 0) {
+            ptr = os_malloc_slab_get(idx);
+            if (ptr != NULL || !MYNEWT_VAL(OS_MALLOC_SLAB_FALLBACK)) {
+                return ptr;
+            }
+        }
+    }
+#endif
+
+    return os_malloc_heap(size);
+}
+
+void
+os_free(void *mem)
+{
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    struct os_mempool *mp;
+    int rc;
+#endif
+
+    if (mem == NULL) {
+        return;
+    }
+
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    mp = os_malloc_slab_find(mem);
+    if (mp != NULL) {
+        rc = os_memblock_put(mp, mem);
+        assert(rc == 0);
+        return;
+    }
+#endif
+
+    os_free_heap(mem);
+}
+
 void *
 os_realloc(void *ptr, size_t size)
 {
     void *new_ptr;
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    struct os_mempool *mp;
+
+    if (ptr != NULL) {
+        mp = os_malloc_slab_find(ptr);
+        if (mp != NULL) {
+            if (size == 0) {
+                os_free(ptr);
+                return NULL;
+            }
+            if (size <= mp->mp_block_size) {
+                return ptr;
+            }
+
+            new_ptr = os_malloc(size);
+            if (new_ptr != NULL) {
+                memcpy(new_ptr, ptr, mp->mp_block_size);
+                os_free(ptr);
+            }
+            return new_ptr;
+        }
+    }
+#endif
+
+    if (ptr == NULL) {
+        return os_malloc(size);
+    }
+
+    /* Whether realloc(ptr, 0) frees the block is up to the libc; free it
+     * here so that the count stays right.
+     */
+    if (size == 0) {
+        os_free_heap(ptr);
+        return NULL;
+    }
 
     os_malloc_lock();
     new_ptr = realloc(ptr, size);
@@ -82,3 +315,62 @@ os_realloc(void *ptr, size_t size)
     return new_ptr;
 }
 
+int
+os_malloc_info_get(struct os_malloc_info *omi)
+{
+#if MYNEWT_VAL(BASELIBC_PRESENT)
+    size_t free_bytes;
+    size_t largest;
+#endif
+
+    memset(omi, 0, sizeof(*omi));
+
+    os_malloc_lock();
+
+    omi->omi_heap_allocs = os_malloc_heap_allocs;
+    omi->omi_heap_allocs_max = os_malloc_heap_allocs_max;
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    omi->omi_slab_fallbacks = os_malloc_slab_fallbacks;
+#endif
+
+#if MYNEWT_VAL(BASELIBC_PRESENT)
+    get_malloc_memory_status(&free_bytes, &largest);
+    omi->omi_heap_free = free_bytes;
+    omi->omi_heap_largest = largest;
+    if (free_bytes > 0) {
+        omi->omi_heap_frag_pct = 100 - (uint64_t)largest * 100 / free_bytes;
+    }
+#endif
+
+    os_malloc_unlock();
+
+    return 0;
+}
+
+void
+os_malloc_init(void)
+{
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+#if MYNEWT_VAL(OS_MALLOC_SLAB_1_BLOCK_COUNT) > 0
+    os_malloc_slab_init(0, os_malloc_slab_1_data,
+                        MYNEWT_VAL(OS_MALLOC_SLAB_1_BLOCK_COUNT),
+                        OS_MALLOC_SLAB_BLOCK_SIZE(1), "malloc_1");
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_2_BLOCK_COUNT) > 0
+    os_malloc_slab_init(1, os_malloc_slab_2_data,
+                        MYNEWT_VAL(OS_MALLOC_SLAB_2_BLOCK_COUNT),
+                        OS_MALLOC_SLAB_BLOCK_SIZE(2), "malloc_2");
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_3_BLOCK_COUNT) > 0
+    os_malloc_slab_init(2, os_malloc_slab_3_data,
+                        MYNEWT_VAL(OS_MALLOC_SLAB_3_BLOCK_COUNT),
+                        OS_MALLOC_SLAB_BLOCK_SIZE(3), "malloc_3");
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_4_BLOCK_COUNT) > 0
+    os_malloc_slab_init(3, os_malloc_slab_4_data,
+                        MYNEWT_VAL(OS_MALLOC_SLAB_4_BLOCK_COUNT),
+                        OS_MALLOC_SLAB_BLOCK_SIZE(4), "malloc_4");
+#endif
+#endif
+}
+
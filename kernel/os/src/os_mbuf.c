@@ -143,6 +143,11 @@ os_mbuf_get(struct os_mbuf_pool *omp, uint16_t leadingspace)
     om->om_len = 0;
     om->om_data = (&om->om_databuf[0] + leadingspace);
     om->om_omp = omp;
+#if MYNEWT_VAL(OS_MBUF_EXT)
+    om->om_refcnt = 1;
+    om->om_owner = NULL;
+    om->om_ext = NULL;
+#endif
 
 done:
     os_trace_api_ret_u32(OS_TRACE_ID_MBUF_GET, (uint32_t)om);
@@ -182,6 +187,204 @@ done:
     return om;
 }
 
+#if MYNEWT_VAL(OS_MBUF_EXT)
+/**
+ * Drops one reference to an mbuf's memory block.  The block goes back to its
+ * pool when the last reference is gone.
+ */
+static int
+os_mbuf_block_release(struct os_mbuf *om)
+{
+    uint16_t refcnt;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    assert(om->om_refcnt > 0);
+    refcnt = --om->om_refcnt;
+    OS_EXIT_CRITICAL(sr);
+
+    if (refcnt > 0 || om->om_omp == NULL) {
+        return 0;
+    }
+
+    return os_memblock_put(om->om_omp->omp_pool, om);
+}
+
+/**
+ * Releases the data an mbuf references, if it is not in the mbuf's own
+ * databuf.
+ */
+static void
+os_mbuf_data_release(struct os_mbuf *om)
+{
+    struct os_mbuf_ext *ext;
+    uint16_t refcnt;
+    os_sr_t sr;
+
+    ext = om->om_ext;
+    if (ext != NULL) {
+        om->om_ext = NULL;
+
+        OS_ENTER_CRITICAL(sr);
+        assert(ext->ome_refcnt > 0);
+        refcnt = --ext->ome_refcnt;
+        OS_EXIT_CRITICAL(sr);
+
+        if (refcnt == 0 && ext->ome_free_cb != NULL) {
+            ext->ome_free_cb(ext, ext->ome_free_arg);
+        }
+    } else if (om->om_owner != NULL) {
+        os_mbuf_block_release(om->om_owner);
+        om->om_owner = NULL;
+    }
+}
+
+/**
+ * Makes the clone's data reference the same memory as the source mbuf.
+ */
+static void
+os_mbuf_data_share(struct os_mbuf *clone, struct os_mbuf *om)
+{
+    struct os_mbuf *owner;
+    os_sr_t sr;
+
+    clone->om_data = om->om_data;
+    clone->om_len = om->om_len;
+
+    OS_ENTER_CRITICAL(sr);
+    if (om->om_ext != NULL) {
+        clone->om_ext = om->om_ext;
+        clone->om_ext->ome_refcnt++;
+    } else {
+        owner = om->om_owner != NULL ? om->om_owner : om;
+        clone->om_owner = owner;
+        owner->om_refcnt++;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Indicates whether an mbuf's current data can be overwritten without
+ * affecting any other mbuf.
+ */
+static bool
+os_mbuf_data_writable(const struct os_mbuf *om)
+{
+    if (om->om_ext != NULL) {
+        return false;
+    }
+    if (om->om_owner != NULL) {
+        return om->om_owner->om_refcnt == 1;
+    }
+    return om->om_refcnt == 1;
+}
+
+/**
+ * Gives an mbuf a private copy of its data if the data is shared.
+ */
+static int
+os_mbuf_data_unshare(struct os_mbuf *om)
+{
+    struct os_mbuf_pool *omp;
+    struct os_mbuf *blk;
+    uint8_t *dst;
+
+    if (os_mbuf_data_writable(om)) {
+        return 0;
+    }
+
+    if (om->om_owner == NULL && om->om_ext == NULL) {
+        /* Other mbufs view this mbuf's databuf; move this mbuf's data to a
+         * fresh block that it owns alone.
+         */
+        omp = om->om_omp;
+    } else if (om->om_len <= om->om_omp->omp_databuf_len -
+                             om->om_pkthdr_len) {
+        /* This mbuf's own databuf is unused; copy the data there. */
+        dst = om->om_databuf + om->om_pkthdr_len;
+        memcpy(dst, om->om_data, om->om_len);
+        os_mbuf_data_release(om);
+        om->om_data = dst;
+        return 0;
+    } else if (om->om_owner != NULL) {
+        /* Too big for this mbuf (e.g., a clone from a small pool); take a
+         * block from the pool the data came from.
+         */
+        omp = om->om_owner->om_omp;
+    } else {
+        return OS_ENOMEM;
+    }
+
+    if (omp == NULL || om->om_len > omp->omp_databuf_len) {
+        return OS_ENOMEM;
+    }
+
+    blk = os_memblock_get(omp->omp_pool);
+    if (blk == NULL) {
+        return OS_ENOMEM;
+    }
+    blk->om_omp = omp;
+    blk->om_refcnt = 1;
+    blk->om_owner = NULL;
+    blk->om_ext = NULL;
+
+    memcpy(blk->om_databuf, om->om_data, om->om_len);
+    os_mbuf_data_release(om);
+    om->om_data = blk->om_databuf;
+    om->om_owner = blk;
+
+    return 0;
+}
+
+void
+os_mbuf_ext_init(struct os_mbuf_ext *ext, os_mbuf_ext_free_fn *free_cb,
+                 void *free_arg)
+{
+    ext->ome_refcnt = 0;
+    ext->ome_free_cb = free_cb;
+    ext->ome_free_arg = free_arg;
+}
+
+struct os_mbuf *
+os_mbuf_get_ext(struct os_mbuf_pool *omp, struct os_mbuf_ext *ext,
+                const void *data, uint16_t len)
+{
+    struct os_mbuf *om;
+    os_sr_t sr;
+
+    om = os_mbuf_get(omp, 0);
+    if (om == NULL) {
+        return NULL;
+    }
+
+    /* Cast away const; OS_MBUF_IS_EXCLUSIVE() keeps writers away. */
+    om->om_data = (uint8_t *)data;
+    om->om_len = len;
+    om->om_ext = ext;
+
+    OS_ENTER_CRITICAL(sr);
+    ext->ome_refcnt++;
+    OS_EXIT_CRITICAL(sr);
+
+    return om;
+}
+
+int
+os_mbuf_unshare(struct os_mbuf *om)
+{
+    int rc;
+
+    for (; om != NULL; om = SLIST_NEXT(om, om_next)) {
+        rc = os_mbuf_data_unshare(om);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    return 0;
+}
+#endif
+
 int
 os_mbuf_free(struct os_mbuf *om)
 {
@@ -190,7 +393,12 @@ os_mbuf_free(struct os_mbuf *om)
     os_trace_api_u32(OS_TRACE_ID_MBUF_FREE, (uint32_t)om);
 
     if (om->om_omp != NULL) {
+#if MYNEWT_VAL(OS_MBUF_EXT)
+        os_mbuf_data_release(om);
+        rc = os_mbuf_block_release(om);
+#else
         rc = os_memblock_put(om->om_omp->omp_pool, om);
+#endif
         if (rc != 0) {
             goto done;
         }
@@ -364,6 +572,88 @@ os_mbuf_appendfrom(struct os_mbuf *dst, const struct os_mbuf *src,
     return 0;
 }
 
+#if MYNEWT_VAL(OS_MBUF_EXT)
+struct os_mbuf *
+os_mbuf_clone(struct os_mbuf_pool *omp, struct os_mbuf *om)
+{
+    struct os_mbuf *head;
+    struct os_mbuf *prev;
+    struct os_mbuf *copy;
+
+    head = NULL;
+    prev = NULL;
+
+    for (; om != NULL; om = SLIST_NEXT(om, om_next)) {
+        copy = os_mbuf_get(omp, 0);
+        if (copy == NULL) {
+            goto err;
+        }
+
+        if (prev == NULL) {
+            head = copy;
+            if (OS_MBUF_IS_PKTHDR(om)) {
+                if (om->om_pkthdr_len > omp->omp_databuf_len) {
+                    goto err;
+                }
+                _os_mbuf_copypkthdr(copy, om);
+            }
+        } else {
+            SLIST_NEXT(prev, om_next) = copy;
+        }
+        prev = copy;
+
+        copy->om_flags = om->om_flags;
+        os_mbuf_data_share(copy, om);
+    }
+
+    return head;
+
+err:
+    os_mbuf_free_chain(head);
+    return NULL;
+}
+#endif
+
+#if MYNEWT_VAL(OS_MBUF_EXT)
+/*
+ * Copies one mbuf's data into a fresh mbuf, continuing into additional
+ * mbufs if it does not fit.  That happens for data that lives outside the
+ * source mbuf's own block: external buffers, or the owner's block for an
+ * mbuf cloned from a small header pool.  Returns the last mbuf written, or
+ * NULL if more mbufs were needed and none could be allocated.
+ */
+static struct os_mbuf *
+os_mbuf_dup_data(struct os_mbuf *copy, const struct os_mbuf *om)
+{
+    struct os_mbuf *next;
+    uint16_t off;
+    uint16_t len;
+
+    off = 0;
+    while (1) {
+        len = min(om->om_len - off, OS_MBUF_TRAILINGSPACE(copy));
+        memcpy(OS_MBUF_DATA(copy, uint8_t *), om->om_data + off, len);
+        copy->om_len = len;
+        off += len;
+        if (off == om->om_len) {
+            return copy;
+        }
+
+        next = os_mbuf_get(copy->om_omp, 0);
+        if (next == NULL) {
+            return NULL;
+        }
+        if (OS_MBUF_TRAILINGSPACE(next) == 0) {
+            os_mbuf_free(next);
+            return NULL;
+        }
+        next->om_flags = om->om_flags;
+        SLIST_NEXT(copy, om_next) = next;
+        copy = next;
+    }
+}
+#endif
+
 struct os_mbuf *
 os_mbuf_dup(struct os_mbuf *om)
 {
@@ -398,9 +688,17 @@ os_mbuf_dup(struct os_mbuf *om)
             copy = head;
         }
         copy->om_flags = om->om_flags;
+#if MYNEWT_VAL(OS_MBUF_EXT)
+        copy = os_mbuf_dup_data(copy, om);
+        if (copy == NULL) {
+            os_mbuf_free_chain(head);
+            goto err;
+        }
+#else
         copy->om_len = om->om_len;
         memcpy(OS_MBUF_DATA(copy, uint8_t *), OS_MBUF_DATA(om, uint8_t *),
                 om->om_len);
+#endif
     }
 
     return (head);
@@ -470,6 +768,86 @@ os_mbuf_copydata(const struct os_mbuf *m, int off, int len, void *dst)
     return (len > 0 ? -1 : 0);
 }
 
+int
+os_mbuf_iter_init(struct os_mbuf_iter *it, const struct os_mbuf *om,
+                  int off, int len)
+{
+    const struct os_mbuf *cur;
+    int avail;
+
+    if (off < 0 || len < 0) {
+        return OS_EINVAL;
+    }
+
+    it->omi_remaining = len;
+    it->omi_cur = os_mbuf_off(om, off, &it->omi_off);
+    if (it->omi_cur == NULL) {
+        return OS_EINVAL;
+    }
+
+    /* Verify up front that the chain holds the whole region. */
+    avail = it->omi_cur->om_len - it->omi_off;
+    for (cur = SLIST_NEXT(it->omi_cur, om_next);
+         avail < len && cur != NULL;
+         cur = SLIST_NEXT(cur, om_next)) {
+
+        avail += cur->om_len;
+    }
+    if (avail < len) {
+        it->omi_cur = NULL;
+        return OS_EINVAL;
+    }
+
+    return 0;
+}
+
+int
+os_mbuf_iter_next(struct os_mbuf_iter *it, const uint8_t **out_data,
+                  uint16_t *out_len)
+{
+    uint16_t chunk;
+
+    while (it->omi_remaining > 0 && it->omi_cur != NULL) {
+        chunk = min(it->omi_cur->om_len - it->omi_off, it->omi_remaining);
+        *out_data = it->omi_cur->om_data + it->omi_off;
+
+        it->omi_cur = SLIST_NEXT(it->omi_cur, om_next);
+        it->omi_off = 0;
+
+        if (chunk > 0) {
+            it->omi_remaining -= chunk;
+            *out_len = chunk;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int
+os_mbuf_foreach_segment(const struct os_mbuf *om, int off, int len,
+                        os_mbuf_segment_fn *cb, void *arg)
+{
+    struct os_mbuf_iter it;
+    const uint8_t *data;
+    uint16_t seg_len;
+    int rc;
+
+    rc = os_mbuf_iter_init(&it, om, off, len);
+    if (rc != 0) {
+        return rc;
+    }
+
+    while (os_mbuf_iter_next(&it, &data, &seg_len)) {
+        rc = cb(data, seg_len, arg);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
 void
 os_mbuf_adj(struct os_mbuf *mp, int req_len)
 {
@@ -730,6 +1108,12 @@ os_mbuf_copyinto(struct os_mbuf *om, int off, const void *src, int len)
     while (1) {
         copylen = min(cur->om_len - cur_off, len);
         if (copylen > 0) {
+#if MYNEWT_VAL(OS_MBUF_EXT)
+            rc = os_mbuf_data_unshare(cur);
+            if (rc != 0) {
+                return rc;
+            }
+#endif
             memcpy(cur->om_data + cur_off, sptr, copylen);
             sptr += copylen;
             len -= copylen;
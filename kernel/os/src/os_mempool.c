@@ -114,6 +114,260 @@ os_mempool_guard_check(const struct os_mempool *mp, void *start)
 #define os_mempool_guard_check(mp, start)
 #endif
 
+#if MYNEWT_VAL(OS_MEMPOOL_FREE_MAP)
+#define OS_MEMPOOL_HAS_FREE_MAP(mp)     ((mp)->mp_free_map != NULL)
+
+static int
+os_mempool_block_idx(const struct os_mempool *mp, const void *block)
+{
+    return ((uint32_t)block - mp->mp_membuf_addr) /
+           OS_MEMPOOL_TRUE_BLOCK_SIZE(mp);
+}
+
+static bool
+os_mempool_free_map_test(const struct os_mempool *mp, const void *block)
+{
+    int idx;
+
+    idx = os_mempool_block_idx(mp, block);
+    return (mp->mp_free_map[idx / 32] & (1UL << (idx % 32))) != 0;
+}
+
+/**
+ * Marks a block as free or allocated.  The caller must prevent concurrent
+ * updates of the same pool's bitmap.
+ */
+static void
+os_mempool_free_map_set(struct os_mempool *mp, const void *block, bool free)
+{
+    int idx;
+
+    if (mp->mp_free_map == NULL) {
+        return;
+    }
+
+    idx = os_mempool_block_idx(mp, block);
+    if (free) {
+        mp->mp_free_map[idx / 32] |= 1UL << (idx % 32);
+    } else {
+        mp->mp_free_map[idx / 32] &= ~(1UL << (idx % 32));
+    }
+}
+
+/**
+ * Marks an allocated block as free.  Testing and setting the bit in one
+ * critical section means that only one of several concurrent frees of the
+ * same block succeeds.
+ *
+ * @return                      true if the block was allocated;
+ *                              false if it was already free.
+ */
+static bool
+os_mempool_free_map_claim(struct os_mempool *mp, const void *block)
+{
+    os_sr_t sr;
+    bool was_free;
+
+    OS_ENTER_CRITICAL(sr);
+    was_free = os_mempool_free_map_test(mp, block);
+    if (!was_free) {
+        os_mempool_free_map_set(mp, block, true);
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return !was_free;
+}
+
+static void
+os_mempool_free_map_fill(struct os_mempool *mp)
+{
+    if (mp->mp_free_map != NULL) {
+        memset(mp->mp_free_map, 0xff,
+               OS_MEMPOOL_FREE_MAP_SIZE(mp->mp_num_blocks) * sizeof(uint32_t));
+    }
+}
+#else
+#define OS_MEMPOOL_HAS_FREE_MAP(mp)     0
+#define os_mempool_free_map_set(mp, block, free)
+#define os_mempool_free_map_fill(mp)
+#endif
+
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+/* Number of blocks moved between a magazine and the shared free list. */
+#define OS_MEMPOOL_MAG_BATCH    ((MYNEWT_VAL(OS_MEMPOOL_MAG_SIZE) + 1) / 2)
+
+/**
+ * Returns the calling task's magazine for the specified pool, claiming an
+ * unused one if necessary.  Returns NULL if the caller must use the shared
+ * free list: the pool has no magazines, the scheduler is not running, the
+ * caller is an interrupt handler, or all magazines are taken.
+ */
+static struct os_mempool_mag *
+os_mempool_mag_find(struct os_mempool *mp)
+{
+    struct os_mempool_mag *mag;
+    struct os_task *t;
+    os_sr_t sr;
+    int i;
+
+    if (mp->mp_num_mags == 0 || !os_started() || os_arch_in_isr()) {
+        return NULL;
+    }
+
+    t = os_sched_get_current_task();
+    for (i = 0; i < mp->mp_num_mags; i++) {
+        if (mp->mp_mags[i].omm_owner == t) {
+            return &mp->mp_mags[i];
+        }
+    }
+
+    mag = NULL;
+    OS_ENTER_CRITICAL(sr);
+    for (i = 0; i < mp->mp_num_mags; i++) {
+        if (mp->mp_mags[i].omm_owner == NULL) {
+            mag = &mp->mp_mags[i];
+            mag->omm_cnt = 0;
+            mag->omm_owner = t;
+            break;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return mag;
+}
+
+/**
+ * Moves a batch of blocks from the shared free list into an empty magazine.
+ * At most half of the shared free blocks are taken so that tasks without a
+ * magazine are not starved.
+ */
+static void
+os_mempool_mag_refill(struct os_mempool *mp, struct os_mempool_mag *mag)
+{
+    struct os_memblock *block;
+    os_sr_t sr;
+    int n;
+
+    OS_ENTER_CRITICAL(sr);
+    n = mp->mp_num_free / 2;
+    if (n == 0) {
+        n = mp->mp_num_free;
+    } else if (n > OS_MEMPOOL_MAG_BATCH) {
+        n = OS_MEMPOOL_MAG_BATCH;
+    }
+
+    while (n-- > 0) {
+        block = SLIST_FIRST(mp);
+        SLIST_FIRST(mp) = SLIST_NEXT(block, mb_next);
+        mag->omm_blocks[mag->omm_cnt++] = block;
+        mp->mp_num_free--;
+    }
+    if (mp->mp_min_free > mp->mp_num_free) {
+        mp->mp_min_free = mp->mp_num_free;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Returns the top n blocks of a magazine to the shared free list.
+ */
+static void
+os_mempool_mag_drain(struct os_mempool *mp, struct os_mempool_mag *mag, int n)
+{
+    struct os_memblock *block;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    while (n-- > 0) {
+        block = mag->omm_blocks[--mag->omm_cnt];
+        SLIST_NEXT(block, mb_next) = SLIST_FIRST(mp);
+        SLIST_FIRST(mp) = block;
+        mp->mp_num_free++;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+os_error_t
+os_mempool_mag_init(struct os_mempool *mp, struct os_mempool_mag *mags,
+                    uint8_t num_mags)
+{
+    int i;
+
+    if (mp == NULL || (mags == NULL && num_mags != 0)) {
+        return OS_INVALID_PARM;
+    }
+
+    for (i = 0; i < num_mags; i++) {
+        mags[i].omm_owner = NULL;
+        mags[i].omm_cnt = 0;
+    }
+    mp->mp_mags = mags;
+    mp->mp_num_mags = num_mags;
+
+    return OS_OK;
+}
+
+void
+os_mempool_mag_flush(struct os_mempool *mp)
+{
+    struct os_mempool_mag *mag;
+    struct os_task *t;
+    int i;
+
+    if (mp == NULL || !os_started() || os_arch_in_isr()) {
+        return;
+    }
+
+    t = os_sched_get_current_task();
+    for (i = 0; i < mp->mp_num_mags; i++) {
+        mag = &mp->mp_mags[i];
+        if (mag->omm_owner == t) {
+            os_mempool_mag_drain(mp, mag, mag->omm_cnt);
+            mag->omm_owner = NULL;
+            break;
+        }
+    }
+}
+#endif
+
+#if MYNEWT_VAL(OS_MEMPOOL_FREE_MAP)
+os_error_t
+os_mempool_free_map_init(struct os_mempool *mp, uint32_t *map)
+{
+    struct os_memblock *block;
+    os_sr_t sr;
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+    int i;
+    int j;
+#endif
+
+    if (mp == NULL || map == NULL) {
+        return OS_INVALID_PARM;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+
+    memset(map, 0, OS_MEMPOOL_FREE_MAP_SIZE(mp->mp_num_blocks) *
+                   sizeof(uint32_t));
+    mp->mp_free_map = map;
+
+    SLIST_FOREACH(block, mp, mb_next) {
+        os_mempool_free_map_set(mp, block, true);
+    }
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+    for (i = 0; i < mp->mp_num_mags; i++) {
+        for (j = 0; j < mp->mp_mags[i].omm_cnt; j++) {
+            os_mempool_free_map_set(mp, mp->mp_mags[i].omm_blocks[j], true);
+        }
+    }
+#endif
+
+    OS_EXIT_CRITICAL(sr);
+
+    return OS_OK;
+}
+#endif
+
 static os_error_t
 os_mempool_init_internal(struct os_mempool *mp, uint16_t blocks,
                          uint32_t block_size, void *membuf, char *name,
@@ -144,6 +398,13 @@ os_mempool_init_internal(struct os_mempool *mp, uint16_t blocks,
 
     /* Initialize the memory pool structure */
     mp->mp_block_size = block_size;
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+    mp->mp_mags = NULL;
+    mp->mp_num_mags = 0;
+#endif
+#if MYNEWT_VAL(OS_MEMPOOL_FREE_MAP)
+    mp->mp_free_map = NULL;
+#endif
     mp->mp_num_free = blocks;
     mp->mp_min_free = blocks;
     mp->mp_flags = flags;
@@ -247,6 +508,9 @@ os_mempool_clear(struct os_mempool *mp)
     int true_block_size;
     uint8_t *block_addr;
     uint16_t blocks;
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+    int i;
+#endif
 
     if (!mp) {
         return OS_INVALID_PARM;
@@ -254,7 +518,16 @@ os_mempool_clear(struct os_mempool *mp)
 
     true_block_size = OS_MEMPOOL_TRUE_BLOCK_SIZE(mp);
 
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+    /* Every block goes back on the shared list; release all magazines. */
+    for (i = 0; i < mp->mp_num_mags; i++) {
+        mp->mp_mags[i].omm_owner = NULL;
+        mp->mp_mags[i].omm_cnt = 0;
+    }
+#endif
+
     /* cleanup the memory pool structure */
+    os_mempool_free_map_fill(mp);
     mp->mp_num_free = mp->mp_num_blocks;
     mp->mp_min_free = mp->mp_num_blocks;
     os_mempool_poison(mp, (void *)mp->mp_membuf_addr);
@@ -285,19 +558,92 @@ bool
 os_mempool_is_sane(const struct os_mempool *mp)
 {
     struct os_memblock *block;
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+    const struct os_mempool_mag *mag;
+    int i;
+    int j;
+#endif
 
     /* Verify that each block in the free list belongs to the mempool. */
     SLIST_FOREACH(block, mp, mb_next) {
         if (!os_memblock_from(mp, block)) {
             return false;
         }
+#if MYNEWT_VAL(OS_MEMPOOL_FREE_MAP)
+        if (OS_MEMPOOL_HAS_FREE_MAP(mp) &&
+            !os_mempool_free_map_test(mp, block)) {
+            return false;
+        }
+#endif
         os_mempool_poison_check(mp, block);
         os_mempool_guard_check(mp, block);
     }
 
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+    /* Magazines belong to other tasks and may change under us; only check
+     * ownership, not contents.
+     */
+    for (i = 0; i < mp->mp_num_mags; i++) {
+        mag = &mp->mp_mags[i];
+        if (mag->omm_cnt > MYNEWT_VAL(OS_MEMPOOL_MAG_SIZE)) {
+            return false;
+        }
+        for (j = 0; j < mag->omm_cnt; j++) {
+            if (!os_memblock_from(mp, mag->omm_blocks[j])) {
+                return false;
+            }
+        }
+    }
+#endif
+
     return true;
 }
 
+int
+os_mempool_num_free(const struct os_mempool *mp)
+{
+    int num_free;
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+    int i;
+#endif
+
+    num_free = mp->mp_num_free;
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+    for (i = 0; i < mp->mp_num_mags; i++) {
+        num_free += mp->mp_mags[i].omm_cnt;
+    }
+#endif
+
+    return num_free;
+}
+
+int
+os_mempool_num_avail(const struct os_mempool *mp)
+{
+    int num_avail;
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+    struct os_task *t;
+    int i;
+#endif
+
+    num_avail = mp->mp_num_free;
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+    if (mp->mp_num_mags == 0 || !os_started() || os_arch_in_isr()) {
+        return num_avail;
+    }
+
+    t = os_sched_get_current_task();
+    for (i = 0; i < mp->mp_num_mags; i++) {
+        if (mp->mp_mags[i].omm_owner == t) {
+            num_avail += mp->mp_mags[i].omm_cnt;
+            break;
+        }
+    }
+#endif
+
+    return num_avail;
+}
+
 int
 os_memblock_from(const struct os_mempool *mp, const void *block_addr)
 {
@@ -330,12 +676,34 @@ os_memblock_get(struct os_mempool *mp)
 {
     os_sr_t sr;
     struct os_memblock *block;
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+    struct os_mempool_mag *mag;
+#endif
 
     os_trace_api_u32(OS_TRACE_ID_MEMBLOCK_GET, (uint32_t)mp);
 
     /* Check to make sure they passed in a memory pool (or something) */
     block = NULL;
     if (mp) {
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+        mag = os_mempool_mag_find(mp);
+        if (mag != NULL) {
+            /* Only this task touches its magazine; no need to lock. */
+            if (mag->omm_cnt == 0) {
+                os_mempool_mag_refill(mp, mag);
+            }
+            if (mag->omm_cnt > 0) {
+                block = mag->omm_blocks[--mag->omm_cnt];
+                if (OS_MEMPOOL_HAS_FREE_MAP(mp)) {
+                    OS_ENTER_CRITICAL(sr);
+                    os_mempool_free_map_set(mp, block, false);
+                    OS_EXIT_CRITICAL(sr);
+                }
+            }
+            goto done;
+        }
+#endif
+
         OS_ENTER_CRITICAL(sr);
         /* Check for any free */
         if (mp->mp_num_free) {
@@ -345,6 +713,8 @@ os_memblock_get(struct os_mempool *mp)
             /* Set new free list head */
             SLIST_FIRST(mp) = SLIST_NEXT(block, mb_next);
 
+            os_mempool_free_map_set(mp, block, false);
+
             /* Decrement number free by 1 */
             mp->mp_num_free--;
             if (mp->mp_min_free > mp->mp_num_free) {
@@ -353,6 +723,9 @@ os_memblock_get(struct os_mempool *mp)
         }
         OS_EXIT_CRITICAL(sr);
 
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+done:
+#endif
         if (block) {
             os_mempool_poison_check(mp, block);
             os_mempool_guard_check(mp, block);
@@ -369,6 +742,9 @@ os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr)
 {
     os_sr_t sr;
     struct os_memblock *block;
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+    struct os_mempool_mag *mag;
+#endif
 
     os_trace_api_u32x2(OS_TRACE_ID_MEMBLOCK_PUT_FROM_CB, (uint32_t)mp,
                        (uint32_t)block_addr);
@@ -376,6 +752,22 @@ os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr)
     os_mempool_guard_check(mp, block_addr);
     os_mempool_poison(mp, block_addr);
 
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+    mag = os_mempool_mag_find(mp);
+    if (mag != NULL) {
+        if (mag->omm_cnt == MYNEWT_VAL(OS_MEMPOOL_MAG_SIZE)) {
+            os_mempool_mag_drain(mp, mag, OS_MEMPOOL_MAG_BATCH);
+        }
+        if (OS_MEMPOOL_HAS_FREE_MAP(mp)) {
+            OS_ENTER_CRITICAL(sr);
+            os_mempool_free_map_set(mp, block_addr, true);
+            OS_EXIT_CRITICAL(sr);
+        }
+        mag->omm_blocks[mag->omm_cnt++] = block_addr;
+        goto done;
+    }
+#endif
+
     block = (struct os_memblock *)block_addr;
     OS_ENTER_CRITICAL(sr);
 
@@ -383,12 +775,17 @@ os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr)
     SLIST_NEXT(block, mb_next) = SLIST_FIRST(mp);
     SLIST_FIRST(mp) = block;
 
+    os_mempool_free_map_set(mp, block, true);
+
     /* XXX: Should we check that the number free <= number blocks? */
     /* Increment number free */
     mp->mp_num_free++;
 
     OS_EXIT_CRITICAL(sr);
 
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+done:
+#endif
     os_trace_api_ret_u32(OS_TRACE_ID_MEMBLOCK_PUT_FROM_CB, (uint32_t)OS_OK);
 
     return OS_OK;
@@ -399,8 +796,16 @@ os_memblock_put(struct os_mempool *mp, void *block_addr)
 {
     struct os_mempool_ext *mpe;
     os_error_t ret;
+#if MYNEWT_VAL(OS_MEMPOOL_CHECK) && MYNEWT_VAL(OS_MEMPOOL_MAG) || \
+    MYNEWT_VAL(OS_MEMPOOL_FREE_MAP)
+    os_sr_t sr;
+#endif
 #if MYNEWT_VAL(OS_MEMPOOL_CHECK)
     struct os_memblock *block;
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+    int i;
+    int j;
+#endif
 #endif
 
     os_trace_api_u32x2(OS_TRACE_ID_MEMBLOCK_PUT, (uint32_t)mp,
@@ -412,15 +817,44 @@ os_memblock_put(struct os_mempool *mp, void *block_addr)
         goto done;
     }
 
+#if MYNEWT_VAL(OS_MEMPOOL_FREE_MAP)
+    /*
+     * Constant-time ownership and duplicate free check.  The block is marked
+     * free right away so that a concurrent free of the same block fails.
+     */
+    if (OS_MEMPOOL_HAS_FREE_MAP(mp)) {
+        if (!os_memblock_from(mp, block_addr) ||
+            !os_mempool_free_map_claim(mp, block_addr)) {
+
+            assert(!MYNEWT_VAL(OS_MEMPOOL_CHECK));
+            ret = OS_INVALID_PARM;
+            goto done;
+        }
+    }
+#endif
+
 #if MYNEWT_VAL(OS_MEMPOOL_CHECK)
     /* Check that the block we are freeing is a valid block! */
     assert(os_memblock_from(mp, block_addr));
 
     /*
-     * Check for duplicate free.
+     * Check for duplicate free.  Pools with a free bitmap were checked
+     * above.
      */
-    SLIST_FOREACH(block, mp, mb_next) {
-        assert(block != (struct os_memblock *)block_addr);
+    if (!OS_MEMPOOL_HAS_FREE_MAP(mp)) {
+        SLIST_FOREACH(block, mp, mb_next) {
+            assert(block != (struct os_memblock *)block_addr);
+        }
+#if MYNEWT_VAL(OS_MEMPOOL_MAG)
+        /* Other tasks' magazines can change under us. */
+        OS_ENTER_CRITICAL(sr);
+        for (i = 0; i < mp->mp_num_mags; i++) {
+            for (j = 0; j < mp->mp_mags[i].omm_cnt; j++) {
+                assert(mp->mp_mags[i].omm_blocks[j] != block_addr);
+            }
+        }
+        OS_EXIT_CRITICAL(sr);
+#endif
     }
 #endif
     /* If this is an extended mempool with a put callback, call the callback
@@ -430,6 +864,14 @@ os_memblock_put(struct os_mempool *mp, void *block_addr)
         mpe = (struct os_mempool_ext *)mp;
         if (mpe->mpe_put_cb != NULL) {
             ret = mpe->mpe_put_cb(mpe, block_addr, mpe->mpe_put_arg);
+#if MYNEWT_VAL(OS_MEMPOOL_FREE_MAP)
+            if (ret != 0 && OS_MEMPOOL_HAS_FREE_MAP(mp)) {
+                /* The callback kept the block; it is still allocated. */
+                OS_ENTER_CRITICAL(sr);
+                os_mempool_free_map_set(mp, block_addr, false);
+                OS_EXIT_CRITICAL(sr);
+            }
+#endif
             goto done;
         }
     }
@@ -459,7 +901,7 @@ os_mempool_info_get_next(struct os_mempool *mp, struct os_mempool_info *omi)
 
     omi->omi_block_size = cur->mp_block_size;
     omi->omi_num_blocks = cur->mp_num_blocks;
-    omi->omi_num_free = cur->mp_num_free;
+    omi->omi_num_free = os_mempool_num_free(cur);
     omi->omi_min_free = cur->mp_min_free;
     omi->omi_name[0] = '\0';
     strncat(omi->omi_name, cur->name, sizeof(omi->omi_name) - 1);
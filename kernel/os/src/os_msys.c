@@ -21,10 +21,16 @@
 #include "os/mynewt.h"
 #include "mem/mem.h"
 #include "os_priv.h"
+#if MYNEWT_VAL(OS_MSYS_STATS)
+#include "stats/stats.h"
+#endif
 
 static STAILQ_HEAD(, os_mbuf_pool) g_msys_pool_list =
     STAILQ_HEAD_INITIALIZER(g_msys_pool_list);
 
+#define OS_MSYS_MAG_ENABLED                     \
+    (MYNEWT_VAL(OS_MEMPOOL_MAG) && MYNEWT_VAL(MSYS_MAG_COUNT) > 0)
+
 #if MYNEWT_VAL(MSYS_1_BLOCK_COUNT) > 0
 #define SYSINIT_MSYS_1_MEMBLOCK_SIZE                \
     OS_ALIGN(MYNEWT_VAL(MSYS_1_BLOCK_SIZE), 4)
@@ -34,6 +40,13 @@ static STAILQ_HEAD(, os_mbuf_pool) g_msys_pool_list =
 static os_membuf_t os_msys_1_data[SYSINIT_MSYS_1_MEMPOOL_SIZE];
 static struct os_mbuf_pool os_msys_1_mbuf_pool;
 static struct os_mempool os_msys_1_mempool;
+#if OS_MSYS_MAG_ENABLED
+static struct os_mempool_mag os_msys_1_mags[MYNEWT_VAL(MSYS_MAG_COUNT)];
+#endif
+#if MYNEWT_VAL(OS_MEMPOOL_FREE_MAP)
+static uint32_t
+os_msys_1_free_map[OS_MEMPOOL_FREE_MAP_SIZE(MYNEWT_VAL(MSYS_1_BLOCK_COUNT))];
+#endif
 #endif
 
 #if MYNEWT_VAL(MSYS_2_BLOCK_COUNT) > 0
@@ -45,6 +58,13 @@ static struct os_mempool os_msys_1_mempool;
 static os_membuf_t os_msys_2_data[SYSINIT_MSYS_2_MEMPOOL_SIZE];
 static struct os_mbuf_pool os_msys_2_mbuf_pool;
 static struct os_mempool os_msys_2_mempool;
+#if OS_MSYS_MAG_ENABLED
+static struct os_mempool_mag os_msys_2_mags[MYNEWT_VAL(MSYS_MAG_COUNT)];
+#endif
+#if MYNEWT_VAL(OS_MEMPOOL_FREE_MAP)
+static uint32_t
+os_msys_2_free_map[OS_MEMPOOL_FREE_MAP_SIZE(MYNEWT_VAL(MSYS_2_BLOCK_COUNT))];
+#endif
 #endif
 
 #define OS_MSYS_SANITY_ENABLED                  \
@@ -55,6 +75,124 @@ static struct os_mempool os_msys_2_mempool;
 static struct os_sanity_check os_msys_sc;
 #endif
 
+#if MYNEWT_VAL(OS_MSYS_STATS)
+STATS_SECT_START(os_msys_stats)
+    STATS_SECT_ENTRY(miss)
+    STATS_SECT_ENTRY(fallback)
+    STATS_SECT_ENTRY(high_water)
+STATS_SECT_END
+
+STATS_NAME_START(os_msys_stats)
+    STATS_NAME(os_msys_stats, miss)
+    STATS_NAME(os_msys_stats, fallback)
+    STATS_NAME(os_msys_stats, high_water)
+STATS_NAME_END(os_msys_stats)
+
+struct os_msys_pool_stats {
+    const struct os_mbuf_pool *omps_pool;
+    /* Shadow of the high_water stat; stats may be stubbed out. */
+    uint16_t omps_high_water;
+    STATS_SECT_DECL(os_msys_stats) omps_stats;
+};
+
+static struct os_msys_pool_stats os_msys_pool_stats[] = {
+#if MYNEWT_VAL(MSYS_1_BLOCK_COUNT) > 0
+    { .omps_pool = &os_msys_1_mbuf_pool },
+#endif
+#if MYNEWT_VAL(MSYS_2_BLOCK_COUNT) > 0
+    { .omps_pool = &os_msys_2_mbuf_pool },
+#endif
+    { .omps_pool = NULL },
+};
+
+static struct os_msys_pool_stats *
+os_msys_stats_find(const struct os_mbuf_pool *omp)
+{
+    struct os_msys_pool_stats *omps;
+
+    for (omps = os_msys_pool_stats; omps->omps_pool != NULL; omps++) {
+        if (omps->omps_pool == omp) {
+            return omps;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Records the outcome of pool selection: a miss against the best-fitting
+ * pool if it was empty, and a fallback against the pool actually chosen.
+ */
+static void
+os_msys_stats_select(const struct os_mbuf_pool *first,
+                     const struct os_mbuf_pool *chosen)
+{
+    struct os_msys_pool_stats *omps;
+
+    if (os_mempool_num_avail(first->omp_pool) == 0) {
+        omps = os_msys_stats_find(first);
+        if (omps != NULL) {
+            STATS_INC(omps->omps_stats, miss);
+        }
+    }
+
+    if (chosen != first) {
+        omps = os_msys_stats_find(chosen);
+        if (omps != NULL) {
+            STATS_INC(omps->omps_stats, fallback);
+        }
+    }
+}
+
+static void
+os_msys_stats_alloc(const struct os_mbuf_pool *omp)
+{
+    struct os_msys_pool_stats *omps;
+    int in_use;
+    os_sr_t sr;
+
+    omps = os_msys_stats_find(omp);
+    if (omps == NULL) {
+        return;
+    }
+
+    in_use = omp->omp_pool->mp_num_blocks -
+             os_mempool_num_free(omp->omp_pool);
+
+    OS_ENTER_CRITICAL(sr);
+    if (in_use > omps->omps_high_water) {
+        STATS_INCN(omps->omps_stats, high_water,
+                   in_use - omps->omps_high_water);
+        omps->omps_high_water = in_use;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+void
+os_msys_stats_init(void)
+{
+    struct os_msys_pool_stats *omps;
+    int rc;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    for (omps = os_msys_pool_stats; omps->omps_pool != NULL; omps++) {
+        rc = stats_init_and_reg(
+            STATS_HDR(omps->omps_stats),
+            STATS_SIZE_INIT_PARMS(omps->omps_stats, STATS_SIZE_32),
+            STATS_NAME_INIT_PARMS(os_msys_stats),
+            omps->omps_pool->omp_pool->name);
+        SYSINIT_PANIC_ASSERT(rc == 0);
+
+        omps->omps_high_water = 0;
+    }
+}
+#else
+#define os_msys_stats_select(first, chosen)
+#define os_msys_stats_alloc(omp)
+#endif
+
 int
 os_msys_register(struct os_mbuf_pool *new_pool)
 {
@@ -93,10 +231,32 @@ os_msys_find_biggest_pool(void)
     return STAILQ_LAST(&g_msys_pool_list, os_mbuf_pool, omp_next);
 }
 
+#if MYNEWT_VAL_CHOICE(MSYS_POOL_SELECT, min_chain)
+/**
+ * Returns the number of mbufs from the specified pool needed to hold dsize
+ * bytes.
+ */
+static int
+os_msys_chain_len(const struct os_mbuf_pool *omp, uint16_t dsize)
+{
+    if (dsize == 0) {
+        return 1;
+    }
+
+    return (dsize + omp->omp_databuf_len - 1) / omp->omp_databuf_len;
+}
+#endif
+
 static struct os_mbuf_pool *
 os_msys_find_pool(uint16_t dsize)
 {
+    struct os_mbuf_pool *first;
     struct os_mbuf_pool *pool;
+#if MYNEWT_VAL_CHOICE(MSYS_POOL_SELECT, min_chain)
+    struct os_mbuf_pool *best;
+    int best_len;
+    int len;
+#endif
 
     pool = NULL;
     STAILQ_FOREACH(pool, &g_msys_pool_list, omp_next) {
@@ -107,7 +267,40 @@ os_msys_find_pool(uint16_t dsize)
 
     if (!pool) {
         pool = STAILQ_LAST(&g_msys_pool_list, os_mbuf_pool, omp_next);
+        if (!pool) {
+            return (NULL);
+        }
     }
+    first = pool;
+
+#if MYNEWT_VAL_CHOICE(MSYS_POOL_SELECT, fallback)
+    /* Pools are sorted by size; move on to larger ones while empty.  Blocks
+     * cached in other tasks' magazines do not count; we cannot get them.
+     */
+    while (pool != NULL && os_mempool_num_avail(pool->omp_pool) == 0) {
+        pool = STAILQ_NEXT(pool, omp_next);
+    }
+#elif MYNEWT_VAL_CHOICE(MSYS_POOL_SELECT, min_chain)
+    best = NULL;
+    best_len = 0;
+    STAILQ_FOREACH(pool, &g_msys_pool_list, omp_next) {
+        len = os_msys_chain_len(pool, dsize);
+        if (os_mempool_num_avail(pool->omp_pool) >= len &&
+            (best == NULL || len < best_len)) {
+
+            best = pool;
+            best_len = len;
+        }
+    }
+    pool = best;
+#endif
+
+    /* Nothing has room; let the allocation fail from the best fit. */
+    if (!pool) {
+        pool = first;
+    }
+
+    os_msys_stats_select(first, pool);
 
     return (pool);
 }
@@ -133,6 +326,9 @@ os_msys_get(uint16_t dsize, uint16_t leadingspace)
     }
 
     m = os_mbuf_get(pool, leadingspace);
+    if (m != NULL) {
+        os_msys_stats_alloc(pool);
+    }
     return (m);
 err:
     return (NULL);
@@ -161,6 +357,9 @@ os_msys_get_pkthdr(uint16_t dsize, uint16_t user_hdr_len)
     }
 
     m = os_mbuf_get_pkthdr(pool, user_hdr_len);
+    if (m != NULL) {
+        os_msys_stats_alloc(pool);
+    }
     return (m);
 err:
     return (NULL);
@@ -188,7 +387,7 @@ os_msys_num_free(void)
 
     total = 0;
     STAILQ_FOREACH(omp, &g_msys_pool_list, omp_next) {
-        total += omp->omp_pool->mp_num_free;
+        total += os_mempool_num_free(omp->omp_pool);
     }
 
     return total;
@@ -231,7 +430,7 @@ os_msys_sanity(struct os_sanity_check *sc, void *arg)
     idx = 0;
     STAILQ_FOREACH(omp, &g_msys_pool_list, omp_next) {
         min_count = os_msys_sanity_min_count(idx);
-        if (omp->omp_pool->mp_num_free < min_count) {
+        if (os_mempool_num_free(omp->omp_pool) < min_count) {
             return OS_ENOMEM;
         }
 
@@ -274,6 +473,15 @@ os_msys_init(void)
                       MYNEWT_VAL(MSYS_1_BLOCK_COUNT),
                       SYSINIT_MSYS_1_MEMBLOCK_SIZE,
                       "msys_1");
+#if OS_MSYS_MAG_ENABLED
+    rc = os_mempool_mag_init(&os_msys_1_mempool, os_msys_1_mags,
+                             MYNEWT_VAL(MSYS_MAG_COUNT));
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+#if MYNEWT_VAL(OS_MEMPOOL_FREE_MAP)
+    rc = os_mempool_free_map_init(&os_msys_1_mempool, os_msys_1_free_map);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
 #endif
 
 #if MYNEWT_VAL(MSYS_2_BLOCK_COUNT) > 0
@@ -283,6 +491,15 @@ os_msys_init(void)
                       MYNEWT_VAL(MSYS_2_BLOCK_COUNT),
                       SYSINIT_MSYS_2_MEMBLOCK_SIZE,
                       "msys_2");
+#if OS_MSYS_MAG_ENABLED
+    rc = os_mempool_mag_init(&os_msys_2_mempool, os_msys_2_mags,
+                             MYNEWT_VAL(MSYS_MAG_COUNT));
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+#if MYNEWT_VAL(OS_MEMPOOL_FREE_MAP)
+    rc = os_mempool_free_map_init(&os_msys_2_mempool, os_msys_2_free_map);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
 #endif
 
 #if OS_MSYS_SANITY_ENABLED
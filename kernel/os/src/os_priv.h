@@ -35,9 +35,12 @@ extern struct os_task g_idle_task;
 extern struct os_task_list g_os_run_list;
 extern struct os_task_list g_os_sleep_list;
 extern struct os_task_stailq g_os_task_list;
-extern struct os_callout_list g_callout_list;
 
+void os_sched_init(void);
+void os_callout_module_init(void);
 void os_mempool_module_init(void);
+void os_malloc_init(void);
+void os_msys_stats_init(void);
 void os_msys_init(void);
 
 /**
@@ -18,6 +18,7 @@
  */
 
 #include <assert.h>
+#include <string.h>
 #include "os/mynewt.h"
 #include "os_priv.h"
 
@@ -29,6 +30,223 @@ struct os_task *g_current_task;
 extern os_time_t g_os_time;
 os_time_t g_os_last_ctx_sw_time;
 
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+/*
+ * Priority bitmap for the run list.  The run list itself is still kept sorted
+ * by priority, but the insertion point is found in constant time: bit N of
+ * os_sched_prio_map is set when at least one ready task is queued at priority
+ * N, and os_sched_prio_tail[N] points to the last such task in the run list.
+ * Bit W of os_sched_prio_grp is set when word W of the map is non-zero.
+ */
+#define OS_SCHED_PRIO_CNT       (OS_TASK_PRI_LOWEST + 1)
+#define OS_SCHED_PRIO_WORDS     (OS_SCHED_PRIO_CNT / 32)
+
+static uint32_t os_sched_prio_grp;
+static uint32_t os_sched_prio_map[OS_SCHED_PRIO_WORDS];
+static struct os_task *os_sched_prio_tail[OS_SCHED_PRIO_CNT];
+
+/**
+ * Returns the numerically highest occupied priority that is lower than
+ * 'prio', i.e. the priority of the tasks that a task of priority 'prio' has
+ * to be queued behind.  Returns -1 if there are no such tasks.
+ */
+static int
+os_sched_prio_prev(uint8_t prio)
+{
+    uint32_t bits;
+    int word;
+
+    word = prio / 32;
+    bits = os_sched_prio_map[word] & ((1UL << (prio % 32)) - 1);
+    if (bits == 0) {
+        bits = os_sched_prio_grp & ((1UL << word) - 1);
+        if (bits == 0) {
+            return -1;
+        }
+        word = 31 - __builtin_clz(bits);
+        bits = os_sched_prio_map[word];
+    }
+
+    return word * 32 + 31 - __builtin_clz(bits);
+}
+
+static void
+os_sched_runq_insert(struct os_task *t)
+{
+    struct os_task *prev;
+    uint8_t prio;
+    int prev_prio;
+
+    prio = t->t_prio;
+    prev = os_sched_prio_tail[prio];
+    if (prev == NULL) {
+        prev_prio = os_sched_prio_prev(prio);
+        if (prev_prio >= 0) {
+            prev = os_sched_prio_tail[prev_prio];
+        }
+    }
+
+    if (prev) {
+        TAILQ_INSERT_AFTER(&g_os_run_list, prev, t, t_os_list);
+    } else {
+        TAILQ_INSERT_HEAD(&g_os_run_list, t, t_os_list);
+    }
+
+    t->t_runq_prio = prio;
+    os_sched_prio_tail[prio] = t;
+    os_sched_prio_map[prio / 32] |= 1UL << (prio % 32);
+    os_sched_prio_grp |= 1UL << (prio / 32);
+}
+
+static void
+os_sched_runq_remove(struct os_task *t)
+{
+    struct os_task *prev;
+    uint8_t prio;
+
+    /*
+     * Task priority may have been changed while the task was in the run list
+     * (see os_sched_resort()), so use the one it was queued with.
+     */
+    prio = t->t_runq_prio;
+    if (os_sched_prio_tail[prio] == t) {
+        prev = TAILQ_PREV(t, os_task_list, t_os_list);
+        if (prev && prev->t_runq_prio == prio) {
+            os_sched_prio_tail[prio] = prev;
+        } else {
+            os_sched_prio_tail[prio] = NULL;
+            os_sched_prio_map[prio / 32] &= ~(1UL << (prio % 32));
+            if (os_sched_prio_map[prio / 32] == 0) {
+                os_sched_prio_grp &= ~(1UL << (prio / 32));
+            }
+        }
+    }
+
+    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+}
+#else
+static void
+os_sched_runq_insert(struct os_task *t)
+{
+    struct os_task *entry;
+
+    TAILQ_FOREACH(entry, &g_os_run_list, t_os_list) {
+        if (t->t_prio < entry->t_prio) {
+            break;
+        }
+    }
+    if (entry) {
+        TAILQ_INSERT_BEFORE(entry, (struct os_task *) t, t_os_list);
+    } else {
+        TAILQ_INSERT_TAIL(&g_os_run_list, (struct os_task *) t, t_os_list);
+    }
+}
+
+static void
+os_sched_runq_remove(struct os_task *t)
+{
+    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+}
+#endif
+
+#if MYNEWT_VAL(OS_TIMEQ_HEAP)
+/*
+ * Tasks sleeping with a timeout are kept in a timeout queue, ordered by
+ * wakeup time.  g_os_sleep_list still holds all sleeping tasks, but in no
+ * particular order.
+ */
+static struct os_timeq g_os_sleep_timeq =
+    OS_TIMEQ_INITIALIZER(struct os_task, t_sleep_node, t_next_wakeup);
+
+static void
+os_sched_sleepq_insert(struct os_task *t)
+{
+    TAILQ_INSERT_TAIL(&g_os_sleep_list, t, t_os_list);
+    if (!(t->t_flags & OS_TASK_FLAG_NO_TIMEOUT)) {
+        os_timeq_insert(&g_os_sleep_timeq, &t->t_sleep_node);
+    }
+}
+
+static void
+os_sched_sleepq_remove(struct os_task *t)
+{
+    if (os_timeq_queued(&t->t_sleep_node)) {
+        os_timeq_remove(&g_os_sleep_timeq, &t->t_sleep_node);
+    }
+    TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
+}
+
+/* Returns the sleeping task with the earliest wakeup time, if any. */
+static struct os_task *
+os_sched_sleepq_first(void)
+{
+    struct os_timeq_node *node;
+
+    node = os_timeq_first(&g_os_sleep_timeq);
+    if (node == NULL) {
+        return NULL;
+    }
+    return CONTAINER_OF(node, struct os_task, t_sleep_node);
+}
+#else
+static void
+os_sched_sleepq_insert(struct os_task *t)
+{
+    struct os_task *entry;
+
+    if (t->t_flags & OS_TASK_FLAG_NO_TIMEOUT) {
+        TAILQ_INSERT_TAIL(&g_os_sleep_list, t, t_os_list);
+        return;
+    }
+
+    TAILQ_FOREACH(entry, &g_os_sleep_list, t_os_list) {
+        if ((entry->t_flags & OS_TASK_FLAG_NO_TIMEOUT) ||
+                OS_TIME_TICK_GT(entry->t_next_wakeup, t->t_next_wakeup)) {
+            break;
+        }
+    }
+    if (entry) {
+        TAILQ_INSERT_BEFORE(entry, t, t_os_list);
+    } else {
+        TAILQ_INSERT_TAIL(&g_os_sleep_list, t, t_os_list);
+    }
+}
+
+static void
+os_sched_sleepq_remove(struct os_task *t)
+{
+    TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
+}
+
+static struct os_task *
+os_sched_sleepq_first(void)
+{
+    struct os_task *t;
+
+    t = TAILQ_FIRST(&g_os_sleep_list);
+    if (t == NULL || (t->t_flags & OS_TASK_FLAG_NO_TIMEOUT)) {
+        return NULL;
+    }
+    return t;
+}
+#endif
+
+void
+os_sched_init(void)
+{
+    TAILQ_INIT(&g_os_run_list);
+    TAILQ_INIT(&g_os_sleep_list);
+
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+    os_sched_prio_grp = 0;
+    memset(os_sched_prio_map, 0, sizeof(os_sched_prio_map));
+    memset(os_sched_prio_tail, 0, sizeof(os_sched_prio_tail));
+#endif
+#if MYNEWT_VAL(OS_TIMEQ_HEAP)
+    g_os_sleep_timeq.tq_root = NULL;
+#endif
+}
+
 /**
  * os sched insert
  *
@@ -43,7 +261,6 @@ os_time_t g_os_last_ctx_sw_time;
 os_error_t
 os_sched_insert(struct os_task *t)
 {
-    struct os_task *entry;
     os_sr_t sr;
     os_error_t rc;
 
@@ -52,18 +269,8 @@ os_sched_insert(struct os_task *t)
         goto err;
     }
 
-    entry = NULL;
     OS_ENTER_CRITICAL(sr);
-    TAILQ_FOREACH(entry, &g_os_run_list, t_os_list) {
-        if (t->t_prio < entry->t_prio) {
-            break;
-        }
-    }
-    if (entry) {
-        TAILQ_INSERT_BEFORE(entry, (struct os_task *) t, t_os_list);
-    } else {
-        TAILQ_INSERT_TAIL(&g_os_run_list, (struct os_task *) t, t_os_list);
-    }
+    os_sched_runq_insert(t);
     OS_EXIT_CRITICAL(sr);
 
     return (0);
@@ -148,29 +355,13 @@ os_sched(struct os_task *next_t)
 int
 os_sched_sleep(struct os_task *t, os_time_t nticks)
 {
-    struct os_task *entry;
-
-    entry = NULL;
-
-    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+    os_sched_runq_remove(t);
     t->t_state = OS_TASK_SLEEP;
     t->t_next_wakeup = os_time_get() + nticks;
     if (nticks == OS_TIMEOUT_NEVER) {
         t->t_flags |= OS_TASK_FLAG_NO_TIMEOUT;
-        TAILQ_INSERT_TAIL(&g_os_sleep_list, t, t_os_list);
-    } else {
-        TAILQ_FOREACH(entry, &g_os_sleep_list, t_os_list) {
-            if ((entry->t_flags & OS_TASK_FLAG_NO_TIMEOUT) ||
-                    OS_TIME_TICK_GT(entry->t_next_wakeup, t->t_next_wakeup)) {
-                break;
-            }
-        }
-        if (entry) {
-            TAILQ_INSERT_BEFORE(entry, t, t_os_list);
-        } else {
-            TAILQ_INSERT_TAIL(&g_os_sleep_list, t, t_os_list);
-        }
     }
+    os_sched_sleepq_insert(t);
 
     os_trace_task_stop_ready(t, OS_TASK_SLEEP);
     return (0);
@@ -194,9 +385,9 @@ os_sched_remove(struct os_task *t)
 {
 
     if (t->t_state == OS_TASK_SLEEP) {
-        TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
+        os_sched_sleepq_remove(t);
     } else if (t->t_state == OS_TASK_READY) {
-        TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+        os_sched_runq_remove(t);
     }
     t->t_next_wakeup = 0;
     t->t_flags |= OS_TASK_FLAG_NO_TIMEOUT;
@@ -236,10 +427,10 @@ os_sched_wakeup(struct os_task *t)
     }
 
     /* Remove task from sleep list */
+    os_sched_sleepq_remove(t);
     t->t_state = OS_TASK_READY;
     t->t_next_wakeup = 0;
     t->t_flags &= ~OS_TASK_FLAG_NO_TIMEOUT;
-    TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
     os_sched_insert(t);
 
     os_trace_task_start_ready(t);
@@ -260,7 +451,6 @@ void
 os_sched_os_timer_exp(void)
 {
     struct os_task *t;
-    struct os_task *next;
     os_time_t now;
     os_sr_t sr;
 
@@ -269,21 +459,14 @@ os_sched_os_timer_exp(void)
     OS_ENTER_CRITICAL(sr);
 
     /*
-     * Wakeup any tasks that have their sleep timer expired
+     * Wakeup any tasks that have their sleep timer expired.  Tasks waiting
+     * forever are never returned by os_sched_sleepq_first().
      */
-    t = TAILQ_FIRST(&g_os_sleep_list);
-    while (t) {
-        /* If task waiting forever, do not check next wakeup time */
-        if (t->t_flags & OS_TASK_FLAG_NO_TIMEOUT) {
-            break;
-        }
-        next = TAILQ_NEXT(t, t_os_list);
-        if (OS_TIME_TICK_GEQ(now, t->t_next_wakeup)) {
-            os_sched_wakeup(t);
-        } else {
+    while ((t = os_sched_sleepq_first()) != NULL) {
+        if (!OS_TIME_TICK_GEQ(now, t->t_next_wakeup)) {
             break;
         }
-        t = next;
+        os_sched_wakeup(t);
     }
 
     OS_EXIT_CRITICAL(sr);
@@ -301,8 +484,8 @@ os_sched_wakeup_ticks(os_time_t now)
 
     OS_ASSERT_CRITICAL();
 
-    t = TAILQ_FIRST(&g_os_sleep_list);
-    if (t == NULL || (t->t_flags & OS_TASK_FLAG_NO_TIMEOUT)) {
+    t = os_sched_sleepq_first();
+    if (t == NULL) {
         rt = OS_TIMEOUT_NEVER;
     } else if (OS_TIME_TICK_GEQ(t->t_next_wakeup, now)) {
         rt = t->t_next_wakeup - now;
@@ -346,7 +529,7 @@ void
 os_sched_resort(struct os_task *t)
 {
     if (t->t_state == OS_TASK_READY) {
-        TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+        os_sched_runq_remove(t);
         os_sched_insert(t);
     }
 }
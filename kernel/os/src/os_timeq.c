@@ -0,0 +1,189 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(OS_TIMEQ_HEAP)
+
+#include "os/os_timeq.h"
+
+static inline os_time_t
+os_timeq_key(const struct os_timeq *tq, const struct os_timeq_node *node)
+{
+    return *(const os_time_t *)((const uint8_t *)node + tq->tq_key_off);
+}
+
+/*
+ * Returns true if 'a' expires before 'b'.  Of two nodes with the same expiry
+ * time the one inserted first comes first; sequence numbers are compared
+ * with wrap-around like tick counts are.
+ */
+static inline int
+os_timeq_lt(const struct os_timeq *tq, const struct os_timeq_node *a,
+            const struct os_timeq_node *b)
+{
+    os_time_t ka;
+    os_time_t kb;
+
+    ka = os_timeq_key(tq, a);
+    kb = os_timeq_key(tq, b);
+    if (ka != kb) {
+        return OS_TIME_TICK_LT(ka, kb);
+    }
+    return (int32_t)(a->tqn_seq - b->tqn_seq) < 0;
+}
+
+/*
+ * Links two heaps together; the one with the later expiry becomes the first
+ * child of the other.
+ */
+static struct os_timeq_node *
+os_timeq_link(const struct os_timeq *tq, struct os_timeq_node *a,
+              struct os_timeq_node *b)
+{
+    struct os_timeq_node *tmp;
+
+    if (os_timeq_lt(tq, b, a)) {
+        tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    b->tqn_next = a->tqn_child;
+    if (b->tqn_next) {
+        b->tqn_next->tqn_prev = b;
+    }
+    b->tqn_prev = a;
+    a->tqn_child = b;
+
+    return a;
+}
+
+/*
+ * Standard two-pass pairing: link siblings pairwise left to right, then fold
+ * the resulting heaps right to left.
+ */
+static struct os_timeq_node *
+os_timeq_merge_pairs(const struct os_timeq *tq, struct os_timeq_node *first)
+{
+    struct os_timeq_node *list;
+    struct os_timeq_node *next;
+    struct os_timeq_node *a;
+    struct os_timeq_node *b;
+
+    list = NULL;
+    while (first) {
+        a = first;
+        b = a->tqn_next;
+        if (b == NULL) {
+            a->tqn_next = list;
+            list = a;
+            break;
+        }
+        first = b->tqn_next;
+
+        a = os_timeq_link(tq, a, b);
+        a->tqn_next = list;
+        list = a;
+    }
+
+    a = list;
+    list = list->tqn_next;
+    while (list) {
+        next = list->tqn_next;
+        a = os_timeq_link(tq, a, list);
+        list = next;
+    }
+
+    return a;
+}
+
+static void
+os_timeq_set_root(struct os_timeq *tq, struct os_timeq_node *root)
+{
+    if (root) {
+        root->tqn_next = NULL;
+        root->tqn_prev = root;
+    }
+    tq->tq_root = root;
+}
+
+/**
+ * Inserts a node into the timeout queue.  The node's expiry time must be set
+ * before calling this, and must not change while the node is queued.
+ *
+ * NOTE: must be called with interrupts disabled.
+ */
+void
+os_timeq_insert(struct os_timeq *tq, struct os_timeq_node *node)
+{
+    node->tqn_child = NULL;
+    node->tqn_next = NULL;
+    node->tqn_seq = tq->tq_seq++;
+
+    if (tq->tq_root == NULL) {
+        os_timeq_set_root(tq, node);
+    } else {
+        os_timeq_set_root(tq, os_timeq_link(tq, tq->tq_root, node));
+    }
+}
+
+/**
+ * Removes a queued node from the timeout queue.
+ *
+ * NOTE: must be called with interrupts disabled.
+ */
+void
+os_timeq_remove(struct os_timeq *tq, struct os_timeq_node *node)
+{
+    struct os_timeq_node *sub;
+
+    assert(os_timeq_queued(node));
+
+    if (node == tq->tq_root) {
+        if (node->tqn_child) {
+            os_timeq_set_root(tq, os_timeq_merge_pairs(tq, node->tqn_child));
+        } else {
+            os_timeq_set_root(tq, NULL);
+        }
+    } else {
+        /* Unlink from parent / sibling list. */
+        if (node->tqn_prev->tqn_child == node) {
+            node->tqn_prev->tqn_child = node->tqn_next;
+        } else {
+            node->tqn_prev->tqn_next = node->tqn_next;
+        }
+        if (node->tqn_next) {
+            node->tqn_next->tqn_prev = node->tqn_prev;
+        }
+
+        /* Put subheap, if any, back into the queue. */
+        if (node->tqn_child) {
+            sub = os_timeq_merge_pairs(tq, node->tqn_child);
+            os_timeq_set_root(tq, os_timeq_link(tq, tq->tq_root, sub));
+        }
+    }
+
+    node->tqn_child = NULL;
+    node->tqn_next = NULL;
+    node->tqn_prev = NULL;
+}
+
+#endif
@@ -82,7 +82,8 @@ add_observer(oc_resource_t *resource, oc_endpoint_t *endpoint,
         o->resource = resource;
         resource->num_observers++;
         OC_LOG_DEBUG("Adding observer (%u/%u) for /%s [0x%02X%02X]\n",
-          coap_observer_pool.mp_num_blocks - coap_observer_pool.mp_num_free,
+          coap_observer_pool.mp_num_blocks -
+          os_mempool_num_free(&coap_observer_pool),
           coap_observer_pool.mp_num_blocks, o->url, o->token[0], o->token[1]);
         SLIST_INSERT_HEAD(&oc_observers, o, next);
         return dup;
@@ -272,7 +272,8 @@ int conf_save_tree(char *name);
 
 /**
  * Write a single configuration value to persisted storage (if it has
- * changed value).
+ * changed value). Between conf_save_batch_start() and
+ * conf_save_batch_commit() this is the same as conf_save_batch_set().
  *
  * @param name Name/key of the configuration item.
  * @param var Value of the configuration item.
@@ -281,6 +282,40 @@ int conf_save_tree(char *name);
  */
 int conf_save_one(const char *name, char *var);
 
+/**
+ * Start a batch of configuration writes. Values given to
+ * conf_save_batch_set() are collected in RAM (up to CONFIG_SAVE_BATCH_BUF
+ * bytes at a time), compared against persisted values in one pass over
+ * storage, and the ones which changed are written out back to back.
+ *
+ * Holds the config lock until the matching conf_save_batch_commit().
+ * Batches can be nested; values are written when the outermost batch is
+ * committed, or earlier if the buffer fills up.
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int conf_save_batch_start(void);
+
+/**
+ * Add a configuration value to the current batch. Setting the same name
+ * more than once within a batch persists only the last value. Outside a
+ * batch the value is written right away, like conf_save_one().
+ *
+ * @param name Name/key of the configuration item.
+ * @param value Value of the configuration item, NULL to delete it.
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int conf_save_batch_set(const char *name, const char *value);
+
+/**
+ * End a batch started with conf_save_batch_start(), writing out whatever
+ * is still pending if this is the outermost batch.
+ *
+ * @return 0 on success, first error seen during the batch otherwise.
+ */
+int conf_save_batch_commit(void);
+
 /**
  * Set configuration item identified by @p name to be value @p val_str.
  * This finds the configuration handler for this subtree and calls it's
@@ -0,0 +1,37 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _CONF_TEST_FCB_UTIL_H
+#define _CONF_TEST_FCB_UTIL_H
+
+#include <testutil/testutil.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+TEST_SUITE_DECL(config_test_c0);
+TEST_SUITE_DECL(config_test_c1);
+TEST_SUITE_DECL(config_test_c2);
+TEST_SUITE_DECL(config_test_c3);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CONF_TEST_FCB_UTIL_H */
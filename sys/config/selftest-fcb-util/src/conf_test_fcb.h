@@ -27,6 +27,7 @@
 #include <fcb/fcb.h>
 #include <config/config.h>
 #include <config/config_fcb.h>
+#include <config/config_generic_kv.h>
 #include "config_priv.h"
 
 #ifdef __cplusplus
@@ -96,6 +97,8 @@ TEST_CASE_DECL(config_test_save_3_fcb)
 TEST_CASE_DECL(config_test_compress_reset)
 TEST_CASE_DECL(config_test_save_one_fcb)
 TEST_CASE_DECL(config_test_custom_compress)
+TEST_CASE_DECL(config_test_compress_churn)
+TEST_CASE_DECL(config_test_save_batch)
 TEST_CASE_DECL(config_test_get_stored_fcb)
 
 #ifdef __cplusplus
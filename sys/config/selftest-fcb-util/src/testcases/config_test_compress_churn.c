@@ -0,0 +1,121 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_fcb.h"
+
+#define CT_STATIC_CNT   100
+#define CT_CHURN_CNT    64
+
+static int ct_copy_cnt;
+
+static int
+ct_count_copies(const char *name, const char *val, void *arg)
+{
+    ct_copy_cnt++;
+    return 0;
+}
+
+/*
+ * Settings which were written once and never touched again have to be
+ * copied forward by compression, while everything else in the oldest sector
+ * has been superseded. Check that the right set survives.
+ */
+TEST_CASE_SELF(config_test_compress_churn)
+{
+    int rc;
+    struct conf_fcb cf;
+    char name[CONF_MAX_NAME_LEN];
+    char val[16];
+    char buf[16];
+#if MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+    struct fcb_entry loc;
+    int oldest_cnt;
+#endif
+    int round;
+    int i;
+
+    config_wipe_srcs();
+    config_wipe_fcb(fcb_areas, sizeof(fcb_areas) / sizeof(fcb_areas[0]));
+
+    memset(&cf, 0, sizeof(cf));
+    cf.cf_fcb.f_magic = MYNEWT_VAL(CONFIG_FCB_MAGIC);
+    cf.cf_fcb.f_sectors = fcb_areas;
+    cf.cf_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
+
+    rc = conf_fcb_src(&cf);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < CT_STATIC_CNT; i++) {
+        snprintf(name, sizeof(name), "ct/s%d", i);
+        snprintf(val, sizeof(val), "%d", i);
+        rc = conf_fcb_kv_save(&cf.cf_fcb, name, val);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    for (round = 0; cf.cf_fcb.f_active.fe_area != &fcb_areas[2]; round++) {
+        for (i = 0; i < CT_CHURN_CNT; i++) {
+            snprintf(name, sizeof(name), "ct/c%d", i);
+            snprintf(val, sizeof(val), "%d", round);
+            rc = conf_fcb_kv_save(&cf.cf_fcb, name, val);
+            TEST_ASSERT_FATAL(rc == 0);
+        }
+    }
+    round--;
+
+#if MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+    oldest_cnt = 0;
+    memset(&loc, 0, sizeof(loc));
+    while (fcb_getnext(&cf.cf_fcb, &loc) == 0 &&
+           loc.fe_area == cf.cf_fcb.f_oldest) {
+        oldest_cnt++;
+    }
+    TEST_ASSERT_FATAL(oldest_cnt > CT_STATIC_CNT);
+    conf_fcb_cidx_scan_cnt = 0;
+#endif
+
+    ct_copy_cnt = 0;
+    conf_fcb_compress(&cf, ct_count_copies, NULL);
+    TEST_ASSERT(ct_copy_cnt == CT_STATIC_CNT);
+#if MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+    /*
+     * One scan per batch of indexed entries, instead of one per entry of
+     * the oldest sector.
+     */
+    TEST_ASSERT(conf_fcb_cidx_scan_cnt ==
+                (oldest_cnt + MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) - 1) /
+                MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX));
+#endif
+    TEST_ASSERT(cf.cf_fcb.f_oldest != &fcb_areas[0]);
+
+    for (i = 0; i < CT_STATIC_CNT; i++) {
+        snprintf(name, sizeof(name), "ct/s%d", i);
+        snprintf(val, sizeof(val), "%d", i);
+        rc = conf_fcb_kv_load(&cf.cf_fcb, name, buf, sizeof(buf));
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(!strcmp(buf, val));
+    }
+    snprintf(val, sizeof(val), "%d", round);
+    for (i = 0; i < CT_CHURN_CNT; i++) {
+        snprintf(name, sizeof(name), "ct/c%d", i);
+        rc = conf_fcb_kv_load(&cf.cf_fcb, name, buf, sizeof(buf));
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(!strcmp(buf, val));
+    }
+
+    config_wipe_srcs();
+}
@@ -97,6 +97,8 @@ TEST_CASE_DECL(config_test_compress_reset)
 TEST_CASE_DECL(config_test_save_one_fcb)
 TEST_CASE_DECL(config_test_custom_compress)
 TEST_CASE_DECL(config_test_get_stored_fcb)
+TEST_CASE_DECL(config_test_compress_churn)
+TEST_CASE_DECL(config_test_save_batch)
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,122 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_fcb2.h"
+
+#define CT_STATIC_CNT   100
+#define CT_CHURN_CNT    64
+
+static int ct_copy_cnt;
+
+static int
+ct_count_copies(const char *name, const char *val, void *arg)
+{
+    ct_copy_cnt++;
+    return 0;
+}
+
+/*
+ * Settings which were written once and never touched again have to be
+ * copied forward by compression, while everything else in the oldest sector
+ * has been superseded. Check that the right set survives.
+ */
+TEST_CASE_SELF(config_test_compress_churn)
+{
+    int rc;
+    struct conf_fcb2 cf;
+    char name[CONF_MAX_NAME_LEN];
+    char val[16];
+    char buf[16];
+#if MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+    struct fcb2_entry loc;
+    int oldest_cnt;
+#endif
+    int round;
+    int i;
+
+    config_wipe_srcs();
+    config_wipe_fcb2(fcb_range, CONF_TEST_FCB_RANGE_CNT);
+
+    memset(&cf, 0, sizeof(cf));
+    cf.cf2_fcb.f_magic = MYNEWT_VAL(CONFIG_FCB_MAGIC);
+    cf.cf2_fcb.f_range_cnt = CONF_TEST_FCB_RANGE_CNT;
+    cf.cf2_fcb.f_sector_cnt = fcb_range[0].fsr_sector_count;
+    cf.cf2_fcb.f_ranges = fcb_range;
+
+    rc = conf_fcb2_src(&cf);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < CT_STATIC_CNT; i++) {
+        snprintf(name, sizeof(name), "ct/s%d", i);
+        snprintf(val, sizeof(val), "%d", i);
+        rc = conf_fcb2_kv_save(&cf.cf2_fcb, name, val);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    for (round = 0; cf.cf2_fcb.f_active_id != 2; round++) {
+        for (i = 0; i < CT_CHURN_CNT; i++) {
+            snprintf(name, sizeof(name), "ct/c%d", i);
+            snprintf(val, sizeof(val), "%d", round);
+            rc = conf_fcb2_kv_save(&cf.cf2_fcb, name, val);
+            TEST_ASSERT_FATAL(rc == 0);
+        }
+    }
+    round--;
+
+#if MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+    oldest_cnt = 0;
+    memset(&loc, 0, sizeof(loc));
+    while (fcb2_getnext(&cf.cf2_fcb, &loc) == 0 &&
+           loc.fe_sector == cf.cf2_fcb.f_oldest_sec) {
+        oldest_cnt++;
+    }
+    TEST_ASSERT_FATAL(oldest_cnt > CT_STATIC_CNT);
+    conf_fcb_cidx_scan_cnt = 0;
+#endif
+
+    ct_copy_cnt = 0;
+    conf_fcb2_compress(&cf, ct_count_copies, NULL);
+    TEST_ASSERT(ct_copy_cnt == CT_STATIC_CNT);
+#if MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+    /*
+     * One scan per batch of indexed entries, instead of one per entry of
+     * the oldest sector.
+     */
+    TEST_ASSERT(conf_fcb_cidx_scan_cnt ==
+                (oldest_cnt + MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) - 1) /
+                MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX));
+#endif
+    TEST_ASSERT(cf.cf2_fcb.f_oldest_sec != 0);
+
+    for (i = 0; i < CT_STATIC_CNT; i++) {
+        snprintf(name, sizeof(name), "ct/s%d", i);
+        snprintf(val, sizeof(val), "%d", i);
+        rc = conf_fcb2_kv_load(&cf.cf2_fcb, name, buf, sizeof(buf));
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(!strcmp(buf, val));
+    }
+    snprintf(val, sizeof(val), "%d", round);
+    for (i = 0; i < CT_CHURN_CNT; i++) {
+        snprintf(name, sizeof(name), "ct/c%d", i);
+        rc = conf_fcb2_kv_load(&cf.cf2_fcb, name, buf, sizeof(buf));
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(!strcmp(buf, val));
+    }
+
+    config_wipe_srcs();
+}
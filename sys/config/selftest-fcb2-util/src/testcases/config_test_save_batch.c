@@ -0,0 +1,181 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_fcb2.h"
+
+#define CSB_CNT     40
+
+static int
+csb_count_cb(struct fcb2_entry *loc, void *arg)
+{
+    (*(int *)arg)++;
+    return 0;
+}
+
+static int
+csb_entry_cnt(struct conf_fcb2 *cf)
+{
+    int cnt;
+    int rc;
+
+    cnt = 0;
+    rc = fcb2_walk(&cf->cf2_fcb, FCB2_SECTOR_OLDEST, csb_count_cb, &cnt);
+    TEST_ASSERT(rc == 0);
+    return cnt;
+}
+
+static void
+csb_save_all(int changed, int offset)
+{
+    char name[CONF_MAX_NAME_LEN];
+    char val[16];
+    int rc;
+    int i;
+
+    rc = conf_save_batch_start();
+    TEST_ASSERT(rc == 0);
+    for (i = 0; i < CSB_CNT; i++) {
+        snprintf(name, sizeof(name), "csb/k%d", i);
+        snprintf(val, sizeof(val), "%d", i < changed ? i + offset : i);
+        rc = conf_save_batch_set(name, val);
+        TEST_ASSERT(rc == 0);
+    }
+    rc = conf_save_batch_commit();
+    TEST_ASSERT(rc == 0);
+}
+
+TEST_CASE_SELF(config_test_save_batch)
+{
+    int rc;
+    struct conf_fcb2 cf;
+    char buf[16];
+    int cnt;
+
+    config_wipe_srcs();
+    config_wipe_fcb2(fcb_range, CONF_TEST_FCB_RANGE_CNT);
+
+    memset(&cf, 0, sizeof(cf));
+    cf.cf2_fcb.f_magic = MYNEWT_VAL(CONFIG_FCB_MAGIC);
+    cf.cf2_fcb.f_range_cnt = CONF_TEST_FCB_RANGE_CNT;
+    cf.cf2_fcb.f_sector_cnt = fcb_range[0].fsr_sector_count;
+    cf.cf2_fcb.f_ranges = fcb_range;
+
+    rc = conf_fcb2_src(&cf);
+    TEST_ASSERT(rc == 0);
+
+    rc = conf_fcb2_dst(&cf);
+    TEST_ASSERT(rc == 0);
+
+    /*
+     * Everything is new, everything gets written.
+     */
+    csb_save_all(0, 0);
+    TEST_ASSERT(csb_entry_cnt(&cf) == CSB_CNT);
+
+    /*
+     * Nothing changed.
+     */
+    csb_save_all(0, 0);
+    TEST_ASSERT(csb_entry_cnt(&cf) == CSB_CNT);
+
+    /*
+     * Only changed values are written.
+     */
+    csb_save_all(5, 100);
+    TEST_ASSERT(csb_entry_cnt(&cf) == CSB_CNT + 5);
+
+    /*
+     * Same with the cache forgotten; storage is checked instead.
+     */
+    conf_save_cache_clear();
+    csb_save_all(5, 100);
+    TEST_ASSERT(csb_entry_cnt(&cf) == CSB_CNT + 5);
+
+    rc = conf_save_one("csb/k1", "101");
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(csb_entry_cnt(&cf) == CSB_CNT + 5);
+
+    /*
+     * Last value set within a batch wins, and values set back to what is
+     * persisted are not written at all.
+     */
+    rc = conf_save_batch_start();
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_batch_set("csb/k0", "x");
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_batch_set("csb/k2", "y");
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_batch_set("csb/k0", "z");
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_batch_set("csb/k2", "102");
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_batch_set("csb/k3", NULL);
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_batch_commit();
+    TEST_ASSERT(rc == 0);
+    cnt = csb_entry_cnt(&cf);
+#if MYNEWT_VAL(CONFIG_SAVE_BATCH_BUF) > 0
+    TEST_ASSERT(cnt == CSB_CNT + 7);
+#endif
+
+    rc = conf_get_stored_value("csb/k0", buf, sizeof(buf));
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!strcmp(buf, "z"));
+    rc = conf_get_stored_value("csb/k2", buf, sizeof(buf));
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!strcmp(buf, "102"));
+    rc = conf_get_stored_value("csb/k3", buf, sizeof(buf));
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(buf[0] == '\0');
+
+    rc = conf_save_one("csb/k3", NULL);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(csb_entry_cnt(&cf) == cnt);
+
+    /*
+     * Names with the same hash are still different settings.
+     */
+    rc = conf_save_one("csb/hpfo", "1");
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_one("csb/0rja", "1");
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(csb_entry_cnt(&cf) == cnt + 2);
+    rc = conf_get_stored_value("csb/0rja", buf, sizeof(buf));
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!strcmp(buf, "1"));
+
+    /*
+     * Values written through the generic KV API are not mistaken for
+     * duplicates afterwards.
+     */
+    rc = conf_save_one("csb/kv", "a");
+    TEST_ASSERT(rc == 0);
+    rc = conf_fcb2_kv_save(&cf.cf2_fcb, "csb/kv", "b");
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_one("csb/kv", "a");
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(csb_entry_cnt(&cf) == cnt + 5);
+    rc = conf_get_stored_value("csb/kv", buf, sizeof(buf));
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!strcmp(buf, "a"));
+
+    rc = conf_save_batch_commit();
+    TEST_ASSERT(rc != 0);
+
+    config_wipe_srcs();
+}
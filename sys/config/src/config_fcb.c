@@ -159,6 +159,92 @@ conf_fcb_var_read(struct fcb_entry *loc, char *buf, char **name, char **val)
     return rc;
 }
 
+#if MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+
+static int
+conf_fcb_cidx_getnext(void *fcb, union conf_fcb_cidx_loc *loc)
+{
+    return fcb_getnext(fcb, &loc->ccl_fcb);
+}
+
+static int
+conf_fcb_cidx_in_oldest(void *fcb, const union conf_fcb_cidx_loc *loc)
+{
+    return loc->ccl_fcb.fe_area == ((struct fcb *)fcb)->f_oldest;
+}
+
+static int
+conf_fcb_cidx_same(const union conf_fcb_cidx_loc *loc1,
+                   const union conf_fcb_cidx_loc *loc2)
+{
+    return loc1->ccl_fcb.fe_area == loc2->ccl_fcb.fe_area &&
+           loc1->ccl_fcb.fe_elem_off == loc2->ccl_fcb.fe_elem_off;
+}
+
+static int
+conf_fcb_cidx_read(union conf_fcb_cidx_loc *loc, char *buf, char **name,
+                   char **val)
+{
+    return conf_fcb_var_read(&loc->ccl_fcb, buf, name, val);
+}
+
+static int
+conf_fcb_cidx_copy(void *fcb, union conf_fcb_cidx_loc *loc, char *buf)
+{
+    struct fcb_entry *loc1;
+    struct fcb_entry loc2;
+    int rc;
+
+    loc1 = &loc->ccl_fcb;
+    rc = flash_area_read(loc1->fe_area, loc1->fe_data_off, buf,
+                         loc1->fe_data_len);
+    if (rc) {
+        return rc;
+    }
+    rc = fcb_append(fcb, loc1->fe_data_len, &loc2);
+    if (rc) {
+        return rc;
+    }
+    rc = flash_area_write(loc2.fe_area, loc2.fe_data_off, buf,
+                          loc1->fe_data_len);
+    if (rc) {
+        return rc;
+    }
+    return fcb_append_finish(fcb, &loc2);
+}
+
+static const struct conf_fcb_cidx_ops conf_fcb_cidx_ops = {
+    .cco_getnext = conf_fcb_cidx_getnext,
+    .cco_in_oldest = conf_fcb_cidx_in_oldest,
+    .cco_same = conf_fcb_cidx_same,
+    .cco_read = conf_fcb_cidx_read,
+    .cco_copy = conf_fcb_cidx_copy,
+};
+
+static void
+conf_fcb_compress_internal(struct fcb *fcb,
+                           int (*copy_or_not)(const char *name, const char *val,
+                                              void *cn_arg),
+                           void *cn_arg)
+{
+    int rc;
+
+    rc = fcb_append_to_scratch(fcb);
+    if (rc) {
+        return; /* XXX */
+    }
+
+    conf_fcb_cidx_compress(fcb, &conf_fcb_cidx_ops, copy_or_not, cn_arg);
+
+    rc = fcb_rotate(fcb);
+    if (rc) {
+        /* XXXX */
+        ;
+    }
+}
+
+#else
+
 static void
 conf_fcb_compress_internal(struct fcb *fcb,
                            int (*copy_or_not)(const char *name, const char *val,
@@ -240,6 +326,8 @@ conf_fcb_compress_internal(struct fcb *fcb,
     }
 }
 
+#endif
+
 static int
 conf_fcb_append(struct fcb *fcb, char *buf, int len)
 {
@@ -283,6 +371,9 @@ conf_fcb_compress(struct conf_fcb *cf,
                   void *cn_arg)
 {
     conf_fcb_compress_internal(&cf->cf_fcb, copy_or_not, cn_arg);
+    if (copy_or_not) {
+        conf_save_cache_clear();
+    }
 }
 
 static int
@@ -344,6 +435,7 @@ conf_fcb_kv_save(struct fcb *fcb, const char *name, const char *value)
 {
     char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
     int len;
+    int rc;
 
     if (!name) {
         return OS_INVALID_PARM;
@@ -353,7 +445,12 @@ conf_fcb_kv_save(struct fcb *fcb, const char *name, const char *value)
     if (len < 0 || len + 2 > sizeof(buf)) {
         return OS_INVALID_PARM;
     }
-    return conf_fcb_append(fcb, buf, len);
+    rc = conf_fcb_append(fcb, buf, len);
+    if (rc == 0) {
+        /* The FCB may well be the one conf_save_one() writes to. */
+        conf_save_cache_clear();
+    }
+    return rc;
 }
 
 #endif
@@ -158,6 +158,90 @@ conf_fcb2_var_read(struct fcb2_entry *loc, char *buf, char **name, char **val)
     return rc;
 }
 
+#if MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+
+static int
+conf_fcb2_cidx_getnext(void *fcb, union conf_fcb_cidx_loc *loc)
+{
+    return fcb2_getnext(fcb, &loc->ccl_fcb2);
+}
+
+static int
+conf_fcb2_cidx_in_oldest(void *fcb, const union conf_fcb_cidx_loc *loc)
+{
+    return loc->ccl_fcb2.fe_sector == ((struct fcb2 *)fcb)->f_oldest_sec;
+}
+
+static int
+conf_fcb2_cidx_same(const union conf_fcb_cidx_loc *loc1,
+                    const union conf_fcb_cidx_loc *loc2)
+{
+    return loc1->ccl_fcb2.fe_sector == loc2->ccl_fcb2.fe_sector &&
+           loc1->ccl_fcb2.fe_entry_num == loc2->ccl_fcb2.fe_entry_num;
+}
+
+static int
+conf_fcb2_cidx_read(union conf_fcb_cidx_loc *loc, char *buf, char **name,
+                    char **val)
+{
+    return conf_fcb2_var_read(&loc->ccl_fcb2, buf, name, val);
+}
+
+static int
+conf_fcb2_cidx_copy(void *fcb, union conf_fcb_cidx_loc *loc, char *buf)
+{
+    struct fcb2_entry *loc1;
+    struct fcb2_entry loc2;
+    int rc;
+
+    loc1 = &loc->ccl_fcb2;
+    rc = fcb2_read(loc1, 0, buf, loc1->fe_data_len);
+    if (rc) {
+        return rc;
+    }
+    rc = fcb2_append(fcb, loc1->fe_data_len, &loc2);
+    if (rc) {
+        return rc;
+    }
+    rc = fcb2_write(&loc2, 0, buf, loc1->fe_data_len);
+    if (rc) {
+        return rc;
+    }
+    return fcb2_append_finish(&loc2);
+}
+
+static const struct conf_fcb_cidx_ops conf_fcb2_cidx_ops = {
+    .cco_getnext = conf_fcb2_cidx_getnext,
+    .cco_in_oldest = conf_fcb2_cidx_in_oldest,
+    .cco_same = conf_fcb2_cidx_same,
+    .cco_read = conf_fcb2_cidx_read,
+    .cco_copy = conf_fcb2_cidx_copy,
+};
+
+static void
+conf_fcb2_compress_internal(struct fcb2 *fcb,
+                            int (*copy_or_not)(const char *name, const char *val,
+                                               void *cn_arg),
+                            void *cn_arg)
+{
+    int rc;
+
+    rc = fcb2_append_to_scratch(fcb);
+    if (rc) {
+        return; /* XXX */
+    }
+
+    conf_fcb_cidx_compress(fcb, &conf_fcb2_cidx_ops, copy_or_not, cn_arg);
+
+    rc = fcb2_rotate(fcb);
+    if (rc) {
+        /* XXXX */
+        ;
+    }
+}
+
+#else
+
 static void
 conf_fcb2_compress_internal(struct fcb2 *fcb,
                             int (*copy_or_not)(const char *name, const char *val,
@@ -237,6 +321,8 @@ conf_fcb2_compress_internal(struct fcb2 *fcb,
     }
 }
 
+#endif
+
 static int
 conf_fcb2_append(struct fcb2 *fcb, char *buf, int len)
 {
@@ -280,6 +366,9 @@ conf_fcb2_compress(struct conf_fcb2 *cf,
                    void *cn_arg)
 {
     conf_fcb2_compress_internal(&cf->cf2_fcb, copy_or_not, cn_arg);
+    if (copy_or_not) {
+        conf_save_cache_clear();
+    }
 }
 
 static int
@@ -328,7 +417,7 @@ conf_fcb2_kv_load(struct fcb2 *fcb, const char *name, char *value, size_t len)
     arg.value = value;
     arg.len = len;
 
-    rc = fcb2_walk(fcb, 0, conf_kv_load_cb, &arg);
+    rc = fcb2_walk(fcb, FCB2_SECTOR_OLDEST, conf_kv_load_cb, &arg);
     if (rc) {
         return OS_EINVAL;
     }
@@ -341,6 +430,7 @@ conf_fcb2_kv_save(struct fcb2 *fcb, const char *name, const char *value)
 {
     char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
     int len;
+    int rc;
 
     if (!name) {
         return OS_INVALID_PARM;
@@ -350,7 +440,12 @@ conf_fcb2_kv_save(struct fcb2 *fcb, const char *name, const char *value)
     if (len < 0 || len + 2 > sizeof(buf)) {
         return OS_INVALID_PARM;
     }
-    return conf_fcb2_append(fcb, buf, len);
+    rc = conf_fcb2_append(fcb, buf, len);
+    if (rc == 0) {
+        /* The FCB may well be the one conf_save_one() writes to. */
+        conf_save_cache_clear();
+    }
+    return rc;
 }
 
 #endif
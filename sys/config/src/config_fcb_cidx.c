@@ -0,0 +1,202 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/mynewt.h>
+
+#if (MYNEWT_VAL(CONFIG_FCB) || MYNEWT_VAL(CONFIG_FCB2)) && \
+    MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+
+#include <string.h>
+
+#include "config/config.h"
+#include "config_priv.h"
+
+#define CONF_FCB_CIDX_CNT       MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX)
+#define CONF_FCB_CIDX_NONE      0xffff
+
+#define CONF_FCB_CIDX_F_PASSED  0x01    /* Forward scan went past this one */
+#define CONF_FCB_CIDX_F_STALE   0x02    /* Newer entry with same name seen */
+
+/*
+ * Entry from the oldest sector which is a candidate for being copied
+ * forward during compression.
+ */
+struct conf_fcb_cidx {
+    union conf_fcb_cidx_loc cc_loc;
+    uint32_t cc_hash;
+    uint16_t cc_next;
+    uint8_t cc_flags;
+};
+
+/*
+ * Index over a batch of candidates, hashed by name. Shared by all conf_fcb
+ * and conf_fcb2 instances; access is serialized with conf_lock().
+ */
+static struct conf_fcb_cidx conf_fcb_cidx[CONF_FCB_CIDX_CNT];
+static uint16_t conf_fcb_cidx_bucket[CONF_FCB_CIDX_CNT];
+
+#if MYNEWT_VAL(SELFTEST)
+int conf_fcb_cidx_scan_cnt;
+#endif
+
+/*
+ * Index up to CONF_FCB_CIDX_CNT live entries from the oldest sector,
+ * starting after 'loc'. On return 'loc' points to the last entry looked at.
+ * Returns the number of candidates indexed.
+ */
+static int
+conf_fcb_cidx_fill(void *fcb, const struct conf_fcb_cidx_ops *ops,
+                   union conf_fcb_cidx_loc *loc, char *buf, int *done)
+{
+    struct conf_fcb_cidx *cc;
+    char *name, *val;
+    uint16_t *bucket;
+    int cnt;
+    int rc;
+
+    memset(conf_fcb_cidx_bucket, 0xff, sizeof(conf_fcb_cidx_bucket));
+    cnt = 0;
+    *done = 1;
+    while (cnt < CONF_FCB_CIDX_CNT) {
+        if (ops->cco_getnext(fcb, loc) || !ops->cco_in_oldest(fcb, loc)) {
+            return cnt;
+        }
+        rc = ops->cco_read(loc, buf, &name, &val);
+        if (rc || !val) {
+            continue;
+        }
+        cc = &conf_fcb_cidx[cnt];
+        cc->cc_loc = *loc;
+        cc->cc_hash = conf_str_hash(name);
+        cc->cc_flags = 0;
+        bucket = &conf_fcb_cidx_bucket[cc->cc_hash % CONF_FCB_CIDX_CNT];
+        cc->cc_next = *bucket;
+        *bucket = cnt;
+        cnt++;
+    }
+    *done = 0;
+    return cnt;
+}
+
+/*
+ * Single pass from the first candidate to the end of the FCB. Any candidate
+ * which has a later entry with the same name gets marked stale.
+ */
+static void
+conf_fcb_cidx_scan(void *fcb, const struct conf_fcb_cidx_ops *ops, int cnt,
+                   char *buf1, char *buf2)
+{
+    struct conf_fcb_cidx *cc;
+    union conf_fcb_cidx_loc loc;
+    char *name1, *val1;
+    char *name2, *val2;
+    uint32_t hash;
+    uint16_t idx;
+    int passed;
+    int self;
+    int rc;
+
+#if MYNEWT_VAL(SELFTEST)
+    conf_fcb_cidx_scan_cnt++;
+#endif
+    loc = conf_fcb_cidx[0].cc_loc;
+    passed = 0;
+    do {
+        self = -1;
+        if (passed < cnt &&
+            ops->cco_same(&loc, &conf_fcb_cidx[passed].cc_loc)) {
+            /*
+             * Only candidates before this entry can be superseded by it.
+             */
+            conf_fcb_cidx[passed].cc_flags |= CONF_FCB_CIDX_F_PASSED;
+            self = passed++;
+        }
+        rc = ops->cco_read(&loc, buf2, &name2, &val2);
+        if (rc) {
+            continue;
+        }
+        hash = conf_str_hash(name2);
+        for (idx = conf_fcb_cidx_bucket[hash % CONF_FCB_CIDX_CNT];
+             idx != CONF_FCB_CIDX_NONE; idx = cc->cc_next) {
+            cc = &conf_fcb_cidx[idx];
+            if (cc->cc_hash != hash ||
+                (cc->cc_flags & CONF_FCB_CIDX_F_STALE) ||
+                !(cc->cc_flags & CONF_FCB_CIDX_F_PASSED) || idx == self) {
+                continue;
+            }
+            rc = ops->cco_read(&cc->cc_loc, buf1, &name1, &val1);
+            if (rc == 0 && !strcmp(name1, name2)) {
+                cc->cc_flags |= CONF_FCB_CIDX_F_STALE;
+            }
+        }
+    } while (ops->cco_getnext(fcb, &loc) == 0);
+}
+
+void
+conf_fcb_cidx_compress(void *fcb, const struct conf_fcb_cidx_ops *ops,
+                       int (*copy_or_not)(const char *name, const char *val,
+                                          void *cn_arg),
+                       void *cn_arg)
+{
+    char buf1[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
+    char buf2[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
+    struct conf_fcb_cidx *cc;
+    union conf_fcb_cidx_loc loc;
+    char *name1, *val1;
+    int done;
+    int cnt;
+    int rc;
+    int i;
+
+    /*
+     * Live entries of the oldest sector are indexed in batches. A single
+     * scan over the rest of the FCB per batch finds out which of them have
+     * been superseded, instead of one scan per entry.
+     */
+    conf_lock();
+    memset(&loc, 0, sizeof(loc));
+    do {
+        cnt = conf_fcb_cidx_fill(fcb, ops, &loc, buf1, &done);
+        if (cnt == 0) {
+            break;
+        }
+        conf_fcb_cidx_scan(fcb, ops, cnt, buf1, buf2);
+
+        for (i = 0; i < cnt; i++) {
+            cc = &conf_fcb_cidx[i];
+            if (cc->cc_flags & CONF_FCB_CIDX_F_STALE) {
+                continue;
+            }
+            if (copy_or_not) {
+                rc = ops->cco_read(&cc->cc_loc, buf1, &name1, &val1);
+                if (rc) {
+                    continue;
+                }
+                if (copy_or_not(name1, val1, cn_arg)) {
+                    /* Copy rejected */
+                    continue;
+                }
+            }
+            ops->cco_copy(fcb, &cc->cc_loc, buf1);
+        }
+    } while (!done);
+    conf_unlock();
+}
+
+#endif
@@ -40,6 +40,70 @@ struct conf_handler *conf_parse_and_lookup(char *name, int *name_argc,
 int conf_export_cb(struct conf_handler *ch, conf_export_func_t export_func,
                    conf_export_tgt_t tgt);
 
+uint32_t conf_str_hash(const char *str);
+
+/**
+ * Forget fingerprints of persisted values. Needs to be called when
+ * persisted values are changed behind the back of conf_save*().
+ */
+void conf_save_cache_clear(void);
+
+#if (MYNEWT_VAL(CONFIG_FCB) || MYNEWT_VAL(CONFIG_FCB2)) && \
+    MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+#if MYNEWT_VAL(CONFIG_FCB)
+#include <fcb/fcb.h>
+#endif
+#if MYNEWT_VAL(CONFIG_FCB2)
+#include <fcb/fcb2.h>
+#endif
+
+/*
+ * Location of an entry in either FCB flavour. All zeroes is the position
+ * before the first entry.
+ */
+union conf_fcb_cidx_loc {
+#if MYNEWT_VAL(CONFIG_FCB)
+    struct fcb_entry ccl_fcb;
+#endif
+#if MYNEWT_VAL(CONFIG_FCB2)
+    struct fcb2_entry ccl_fcb2;
+#endif
+};
+
+/*
+ * Backend specific operations used by the indexed compression.
+ */
+struct conf_fcb_cidx_ops {
+    /* Advance 'loc' to the next entry; non-zero at the end of the FCB. */
+    int (*cco_getnext)(void *fcb, union conf_fcb_cidx_loc *loc);
+    /* Non-zero if 'loc' is within the oldest sector. */
+    int (*cco_in_oldest)(void *fcb, const union conf_fcb_cidx_loc *loc);
+    /* Non-zero if both refer to the same entry. */
+    int (*cco_same)(const union conf_fcb_cidx_loc *loc1,
+                    const union conf_fcb_cidx_loc *loc2);
+    /* Read and parse the entry into 'buf'. */
+    int (*cco_read)(union conf_fcb_cidx_loc *loc, char *buf, char **name,
+                    char **val);
+    /* Append a copy of the entry, using 'buf' as scratch. */
+    int (*cco_copy)(void *fcb, union conf_fcb_cidx_loc *loc, char *buf);
+};
+
+/**
+ * Copy live entries of the oldest sector forward, skipping the ones which
+ * have been superseded or are rejected by 'copy_or_not'. Caller appends to
+ * scratch before, and rotates after.
+ */
+void conf_fcb_cidx_compress(void *fcb, const struct conf_fcb_cidx_ops *ops,
+                            int (*copy_or_not)(const char *name,
+                                               const char *val, void *cn_arg),
+                            void *cn_arg);
+
+#if MYNEWT_VAL(SELFTEST)
+/* Number of scans over the FCB done by conf_fcb_cidx_compress(). */
+extern int conf_fcb_cidx_scan_cnt;
+#endif
+#endif
+
 SLIST_HEAD(conf_store_head, conf_store);
 extern struct conf_store_head conf_load_srcs;
 SLIST_HEAD(conf_handler_head, conf_handler);
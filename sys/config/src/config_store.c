@@ -42,6 +42,168 @@ struct conf_store *conf_save_dst;
 static bool conf_loading;
 static bool conf_loaded;
 
+#if MYNEWT_VAL(CONFIG_SAVE_CACHE_CNT) > 0
+#define CONF_SAVE_CACHE_DATA_LEN    MYNEWT_VAL(CONFIG_SAVE_CACHE_ENTRY_LEN)
+
+/*
+ * Copy of the last persisted value of a setting. csc_data holds the name
+ * and the value, both null-terminated. Hash of the name only speeds up the
+ * lookup; a hit is always confirmed by comparing the strings.
+ */
+struct conf_save_cache_entry {
+    uint32_t csc_name_hash;
+    uint8_t csc_used;
+    uint8_t csc_val_null;
+    char csc_data[CONF_SAVE_CACHE_DATA_LEN];
+};
+
+static struct conf_save_cache_entry
+    conf_save_cache[MYNEWT_VAL(CONFIG_SAVE_CACHE_CNT)];
+static int conf_save_cache_cnt;
+static int conf_save_cache_next;
+#endif
+
+#if MYNEWT_VAL(CONFIG_SAVE_BATCH_BUF) > 0
+/*
+ * Settings collected by conf_save_batch_set(). Each record is a flags byte
+ * followed by the name and the value, both null-terminated.
+ */
+#define CONF_BATCH_F_NULL       0x01    /* Value is NULL */
+#define CONF_BATCH_F_DEAD       0x02    /* Set again later in the batch */
+#define CONF_BATCH_F_KNOWN      0x04    /* Cache told whether it is a dup */
+#define CONF_BATCH_F_DUP        0x08    /* Same as the persisted value */
+
+static uint8_t conf_batch_buf[MYNEWT_VAL(CONFIG_SAVE_BATCH_BUF)];
+static int conf_batch_len;
+#endif
+static int conf_batch_depth;
+static int conf_batch_rc;
+
+uint32_t
+conf_str_hash(const char *str)
+{
+    uint32_t hash;
+
+    /* FNV-1a */
+    hash = 2166136261U;
+    while (*str) {
+        hash ^= (uint8_t)*str++;
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+/*
+ * Whether writing 'new_val' over persisted 'old_val' would change nothing.
+ */
+static int
+conf_val_is_dup(const char *old_val, const char *new_val)
+{
+    if (!old_val) {
+        return !new_val || new_val[0] == '\0';
+    }
+    return new_val && !strcmp(old_val, new_val);
+}
+
+#if MYNEWT_VAL(CONFIG_SAVE_CACHE_CNT) > 0
+static struct conf_save_cache_entry *
+conf_save_cache_find(const char *name, uint32_t name_hash)
+{
+    struct conf_save_cache_entry *csc;
+    int i;
+
+    for (i = 0; i < conf_save_cache_cnt; i++) {
+        csc = &conf_save_cache[i];
+        if (csc->csc_used && csc->csc_name_hash == name_hash &&
+            !strcmp(csc->csc_data, name)) {
+            return csc;
+        }
+    }
+    return NULL;
+}
+#endif
+
+/*
+ * Record 'val' as the persisted value of 'name'. Gets called for every
+ * entry seen while walking the stores, and after every successful save.
+ */
+static void
+conf_save_cache_update(const char *name, const char *val)
+{
+#if MYNEWT_VAL(CONFIG_SAVE_CACHE_CNT) > 0
+    struct conf_save_cache_entry *csc;
+    uint32_t name_hash;
+    int name_len;
+    int val_len;
+
+    name_hash = conf_str_hash(name);
+    csc = conf_save_cache_find(name, name_hash);
+
+    name_len = strlen(name) + 1;
+    val_len = val ? strlen(val) + 1 : 0;
+    if (name_len + val_len > CONF_SAVE_CACHE_DATA_LEN) {
+        /*
+         * Does not fit; forget the old value, storage has to be checked.
+         */
+        if (csc) {
+            csc->csc_used = 0;
+        }
+        return;
+    }
+    if (!csc) {
+        if (conf_save_cache_cnt < MYNEWT_VAL(CONFIG_SAVE_CACHE_CNT)) {
+            csc = &conf_save_cache[conf_save_cache_cnt++];
+        } else {
+            csc = &conf_save_cache[conf_save_cache_next];
+            conf_save_cache_next = (conf_save_cache_next + 1) %
+                                   MYNEWT_VAL(CONFIG_SAVE_CACHE_CNT);
+        }
+        csc->csc_name_hash = name_hash;
+        memcpy(csc->csc_data, name, name_len);
+        csc->csc_used = 1;
+    }
+    csc->csc_val_null = !val;
+    if (val) {
+        memcpy(csc->csc_data + name_len, val, val_len);
+    }
+#endif
+}
+
+/*
+ * Check the cache whether 'val' is what's persisted for 'name'.
+ *
+ * @return 1 if it is, 0 if not, -1 if the cache does not know.
+ */
+static int
+conf_save_cache_check(const char *name, const char *val)
+{
+#if MYNEWT_VAL(CONFIG_SAVE_CACHE_CNT) > 0
+    struct conf_save_cache_entry *csc;
+
+    csc = conf_save_cache_find(name, conf_str_hash(name));
+    if (!csc) {
+        return -1;
+    }
+    if (csc->csc_val_null) {
+        return conf_val_is_dup(NULL, val);
+    }
+    return conf_val_is_dup(csc->csc_data + strlen(csc->csc_data) + 1, val);
+#else
+    return -1;
+#endif
+}
+
+void
+conf_save_cache_clear(void)
+{
+#if MYNEWT_VAL(CONFIG_SAVE_CACHE_CNT) > 0
+    conf_lock();
+    conf_save_cache_cnt = 0;
+    conf_save_cache_next = 0;
+    conf_unlock();
+#endif
+}
+
 void
 conf_src_register(struct conf_store *cs)
 {
@@ -56,17 +218,20 @@ conf_src_register(struct conf_store *cs)
     } else {
         SLIST_INSERT_AFTER(prev, cs, cs_next);
     }
+    conf_save_cache_clear();
 }
 
 void
 conf_dst_register(struct conf_store *cs)
 {
     conf_save_dst = cs;
+    conf_save_cache_clear();
 }
 
 static void
 conf_load_cb(char *name, char *val, void *cb_arg)
 {
+    conf_save_cache_update(name, val);
     if (!cb_arg || !strcmp((char*)cb_arg, name)) {
         /* If cb_arg is set, set specific conf value
          * If cb_arg is not set, just set the value
@@ -143,6 +308,7 @@ conf_get_value_cb(char *name, char *val, void *cb_arg)
 {
     struct conf_get_val_arg *cgva = (struct conf_get_val_arg *)cb_arg;
 
+    conf_save_cache_update(name, val);
     if (strcmp(name, cgva->name)) {
         return;
     }
@@ -191,32 +357,196 @@ conf_dup_check_cb(char *name, char *val, void *cb_arg)
 {
     struct conf_dup_check_arg *cdca = (struct conf_dup_check_arg *)cb_arg;
 
+    conf_save_cache_update(name, val);
     if (strcmp(name, cdca->name)) {
         return;
     }
-    if (!val) {
-        if (!cdca->val || cdca->val[0] == '\0') {
-            cdca->is_dup = 1;
-        } else {
-            cdca->is_dup = 0;
+    cdca->is_dup = conf_val_is_dup(val, cdca->val);
+}
+
+/*
+ * Append a single value to persisted config. Don't store duplicate value.
+ */
+static int
+conf_save_direct(const char *name, const char *value)
+{
+    struct conf_store *cs;
+    struct conf_dup_check_arg cdca;
+    int rc;
+
+    /*
+     * Check if we're writing the same value again.
+     */
+    cdca.is_dup = conf_save_cache_check(name, value);
+    if (cdca.is_dup < 0) {
+        cdca.name = name;
+        cdca.val = value;
+        cdca.is_dup = 0;
+        SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
+            cs->cs_itf->csi_load(cs, conf_dup_check_cb, &cdca);
         }
-    } else {
-        if (cdca->val && !strcmp(val, cdca->val)) {
-            cdca->is_dup = 1;
+    }
+    if (cdca.is_dup == 1) {
+        return 0;
+    }
+    cs = conf_save_dst;
+    rc = cs->cs_itf->csi_save(cs, name, value);
+    if (rc == 0) {
+        conf_save_cache_update(name, value);
+    }
+    return rc;
+}
+
+#if MYNEWT_VAL(CONFIG_SAVE_BATCH_BUF) > 0
+static uint8_t *
+conf_batch_next(uint8_t *rec, char **name, char **val)
+{
+    *name = (char *)rec + 1;
+    *val = *name + strlen(*name) + 1;
+    return (uint8_t *)*val + strlen(*val) + 1;
+}
+
+static void
+conf_batch_dup_cb(char *name, char *val, void *cb_arg)
+{
+    uint8_t *rec;
+    uint8_t *next;
+    char *rname;
+    char *rval;
+
+    conf_save_cache_update(name, val);
+    for (rec = conf_batch_buf; rec < conf_batch_buf + conf_batch_len;
+         rec = next) {
+        next = conf_batch_next(rec, &rname, &rval);
+        if (*rec & (CONF_BATCH_F_DEAD | CONF_BATCH_F_KNOWN) ||
+            strcmp(name, rname)) {
+            continue;
+        }
+        if (conf_val_is_dup(val, *rec & CONF_BATCH_F_NULL ? NULL : rval)) {
+            *rec |= CONF_BATCH_F_DUP;
         } else {
-            cdca->is_dup = 0;
+            *rec &= ~CONF_BATCH_F_DUP;
         }
     }
 }
 
 /*
- * Append a single value to persisted config. Don't store duplicate value.
+ * Write out collected settings. Those the cache knows nothing about are
+ * checked against storage in a single pass, then everything which changed
+ * gets appended back to back.
  */
-int
-conf_save_one(const char *name, char *value)
+static int
+conf_batch_flush(void)
 {
     struct conf_store *cs;
-    struct conf_dup_check_arg cdca;
+    uint8_t *rec;
+    uint8_t *next;
+    char *name;
+    char *val;
+    int unknown;
+    int rc;
+    int rc2;
+
+    unknown = 0;
+    for (rec = conf_batch_buf; rec < conf_batch_buf + conf_batch_len;
+         rec = next) {
+        next = conf_batch_next(rec, &name, &val);
+        if (!(*rec & (CONF_BATCH_F_DEAD | CONF_BATCH_F_KNOWN))) {
+            unknown = 1;
+        }
+    }
+    if (unknown) {
+        SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
+            cs->cs_itf->csi_load(cs, conf_batch_dup_cb, NULL);
+        }
+    }
+
+    rc = 0;
+    cs = conf_save_dst;
+    for (rec = conf_batch_buf; rec < conf_batch_buf + conf_batch_len;
+         rec = next) {
+        next = conf_batch_next(rec, &name, &val);
+        if (*rec & (CONF_BATCH_F_DEAD | CONF_BATCH_F_DUP)) {
+            continue;
+        }
+        if (*rec & CONF_BATCH_F_NULL) {
+            val = NULL;
+        }
+        rc2 = cs->cs_itf->csi_save(cs, name, val);
+        if (rc2 == 0) {
+            conf_save_cache_update(name, val);
+        } else if (!rc) {
+            rc = rc2;
+        }
+    }
+    conf_batch_len = 0;
+    return rc;
+}
+
+static int
+conf_batch_add(const char *name, const char *value, int dup)
+{
+    uint8_t *rec;
+    uint8_t *next;
+    char *rname;
+    char *rval;
+    int name_len;
+    int val_len;
+    int rc;
+
+    /*
+     * Older value set for the same name within this batch is stale now.
+     */
+    for (rec = conf_batch_buf; rec < conf_batch_buf + conf_batch_len;
+         rec = next) {
+        next = conf_batch_next(rec, &rname, &rval);
+        if (!strcmp(name, rname)) {
+            *rec |= CONF_BATCH_F_DEAD;
+        }
+    }
+    if (dup == 1) {
+        return 0;
+    }
+
+    name_len = strlen(name) + 1;
+    val_len = value ? strlen(value) + 1 : 1;
+    if (1 + name_len + val_len > sizeof(conf_batch_buf)) {
+        return conf_save_direct(name, value);
+    }
+    rc = 0;
+    if (conf_batch_len + 1 + name_len + val_len > sizeof(conf_batch_buf)) {
+        rc = conf_batch_flush();
+    }
+
+    rec = conf_batch_buf + conf_batch_len;
+    rec[0] = 0;
+    if (!value) {
+        rec[0] |= CONF_BATCH_F_NULL;
+        value = "";
+    }
+    if (dup == 0) {
+        rec[0] |= CONF_BATCH_F_KNOWN;
+    }
+    memcpy(rec + 1, name, name_len);
+    memcpy(rec + 1 + name_len, value, val_len);
+    conf_batch_len += 1 + name_len + val_len;
+
+    return rc;
+}
+#endif
+
+int
+conf_save_batch_start(void)
+{
+    conf_lock();
+    conf_batch_depth++;
+    return 0;
+}
+
+int
+conf_save_batch_set(const char *name, const char *value)
+{
+    int dup;
     int rc;
 
     conf_lock();
@@ -224,31 +554,64 @@ conf_save_one(const char *name, char *value)
         rc = OS_ENOENT;
         goto out;
     }
-
-    /*
-     * Check if we're writing the same value again.
-     */
-    cdca.name = name;
-    cdca.val = value;
-    cdca.is_dup = 0;
-    SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
-        cs->cs_itf->csi_load(cs, conf_dup_check_cb, &cdca);
+    if (!conf_batch_depth) {
+        rc = conf_save_direct(name, value);
+        goto out;
     }
-    if (cdca.is_dup == 1) {
+
+    dup = conf_save_cache_check(name, value);
+#if MYNEWT_VAL(CONFIG_SAVE_BATCH_BUF) > 0
+    rc = conf_batch_add(name, value, dup);
+#else
+    if (dup == 1) {
         rc = 0;
-        goto out;
+    } else {
+        rc = conf_save_direct(name, value);
+    }
+#endif
+    if (rc && !conf_batch_rc) {
+        conf_batch_rc = rc;
     }
-    cs = conf_save_dst;
-    rc = cs->cs_itf->csi_save(cs, name, value);
 out:
     conf_unlock();
     return rc;
 }
 
+int
+conf_save_batch_commit(void)
+{
+    int rc;
+
+    if (!conf_batch_depth) {
+        return OS_EINVAL;
+    }
+    rc = 0;
+    if (--conf_batch_depth == 0) {
+#if MYNEWT_VAL(CONFIG_SAVE_BATCH_BUF) > 0
+        if (conf_save_dst) {
+            rc = conf_batch_flush();
+        }
+        conf_batch_len = 0;
+#endif
+        if (conf_batch_rc) {
+            rc = conf_batch_rc;
+            conf_batch_rc = 0;
+        }
+    }
+    conf_unlock();
+    return rc;
+}
+
+int
+conf_save_one(const char *name, char *value)
+{
+    return conf_save_batch_set(name, value);
+}
+
 static void
 conf_store_one(char *name, char *value)
 {
-    conf_save_one(name, value);
+    conf_save_batch_set(name, value);
 }
 
 int
@@ -258,6 +621,7 @@ conf_save_tree(char *name)
     char *name_argv[CONF_MAX_DIR_DEPTH];
     struct conf_handler *ch;
     int rc;
+    int rc2;
 
     conf_lock();
 
@@ -267,7 +631,12 @@ conf_save_tree(char *name)
         goto out;
     }
 
+    conf_save_batch_start();
     rc = conf_export_cb(ch, conf_store_one, CONF_EXPORT_PERSIST);
+    rc2 = conf_save_batch_commit();
+    if (!rc) {
+        rc = rc2;
+    }
 
 out:
     conf_unlock();
@@ -298,12 +667,17 @@ conf_save(void)
         cs->cs_itf->csi_save_start(cs);
     }
     rc = 0;
+    conf_save_batch_start();
     SLIST_FOREACH(ch, &conf_handlers, ch_list) {
         rc2 = conf_export_cb(ch, conf_store_one, CONF_EXPORT_PERSIST);
         if (!rc) {
             rc = rc2;
         }
     }
+    rc2 = conf_save_batch_commit();
+    if (!rc) {
+        rc = rc2;
+    }
     if (cs->cs_itf->csi_save_end) {
         cs->cs_itf->csi_save_end(cs);
     }
@@ -28,6 +28,9 @@
 #if MYNEWT_VAL(LOG_FCB) || MYNEWT_VAL(LOG_FCB2)
 #include "log/log_fcb.h"
 #endif
+#if MYNEWT_VAL(LOG_FMT)
+#include <stdarg.h>
+#endif
 
 #if MYNEWT_VAL(LOG_FLAGS_IMAGE_HASH)
 #define LOG_HDR_SIZE 19
@@ -131,6 +134,8 @@ struct log_handler {
 
 /* Flags used to indicate type of data in reserved payload*/
 #define LOG_FLAGS_IMG_HASH (1 << 0)
+/* Body is LZ compressed; see log_set_compress(). */
+#define LOG_FLAGS_LZ       (1 << 1)
 
 #if MYNEWT_VAL(LOG_VERSION) == 3
 struct log_entry_hdr {
@@ -192,6 +197,17 @@ STATS_SECT_START(logs)
     STATS_SECT_ENTRY(errs)
     STATS_SECT_ENTRY(lost)
     STATS_SECT_ENTRY(too_long)
+#if MYNEWT_VAL(LOG_COMPRESS)
+    /* Body bytes of entries considered for compression. */
+    STATS_SECT_ENTRY(lz_in)
+    /* Body bytes written for those entries, compressed or not. */
+    STATS_SECT_ENTRY(lz_out)
+    /* Entries written uncompressed as they did not shrink or were too long. */
+    STATS_SECT_ENTRY(lz_raw)
+    /* Microseconds spent compressing and decompressing entries. */
+    STATS_SECT_ENTRY(lz_enc_us)
+    STATS_SECT_ENTRY(lz_dec_us)
+#endif
 STATS_SECT_END
 
 #define LOG_STATS_INC(log, name)        STATS_INC(log->l_stats, name)
@@ -213,6 +229,12 @@ struct log {
 #if !MYNEWT_VAL(LOG_GLOBAL_IDX)
     uint32_t l_idx;
 #endif
+#if MYNEWT_VAL(LOG_ASYNC)
+    uint8_t l_async;            /* Appends are queued for the writer task. */
+#endif
+#if MYNEWT_VAL(LOG_COMPRESS)
+    uint8_t l_compress;         /* New entry bodies are LZ compressed. */
+#endif
 #if MYNEWT_VAL(LOG_STATS)
     STATS_SECT_DECL(logs) l_stats;
 #endif
@@ -508,6 +530,93 @@ log_append_mbuf(struct log *log, uint8_t module, uint8_t level,
 
 void log_printf(struct log *log, uint8_t module, uint8_t level,
         const char *msg, ...);
+
+#if MYNEWT_VAL(LOG_FMT)
+/**
+ * @brief Writes a printf-style entry without formatting it.
+ *
+ * The entry (type `LOG_ETYPE_FMT`) stores the address of the format string
+ * followed by the arguments; the text is only produced when the entry is
+ * read back, see log_fmt_render().  This avoids the cost of formatting at the
+ * call site, and entries are usually much smaller than the text.  Because
+ * only its address is stored, the format string must remain valid for the
+ * lifetime of the image, i.e., be a string literal.
+ *
+ * The body of an entry consists of the following fields, each in native byte
+ * order and packed without padding:
+ *     o Format string address (sizeof(void *) bytes).
+ *     o One field per conversion, in order: an int for each '*' width or
+ *       precision, then the value itself.  Integers are stored with the size
+ *       of their promoted type (int unless a length modifier is given),
+ *       floating point values as double and %p as a pointer.  %s strings are
+ *       copied with their terminating NUL.
+ * Arguments that do not fit in `LOG_FMT_MAX_ENTRY_LEN` bytes are dropped.
+ * Conversions not listed above (e.g., %n, %Lf) end the argument list.
+ *
+ * @param log                   The log to write to.
+ * @param module                The log module of the entry to write.
+ * @param level                 The severity of the log entry to write.
+ * @param fmt                   The format string.
+ */
+void log_fmt_printf(struct log *log, uint8_t module, uint8_t level,
+                    const char *fmt, ...);
+void log_fmt_vprintf(struct log *log, uint8_t module, uint8_t level,
+                     const char *fmt, va_list ap);
+
+/**
+ * @brief Encodes a format string and its arguments as a `LOG_ETYPE_FMT`
+ * entry body.
+ *
+ * @param buf                   The buffer to write the body to.
+ * @param buf_len               The size of the buffer.
+ * @param fmt                   The format string.
+ * @param ap                    The arguments.
+ *
+ * @return                      The length of the body.
+ */
+int log_fmt_encode(void *buf, int buf_len, const char *fmt, va_list ap);
+
+/**
+ * @brief Renders the body of a `LOG_ETYPE_FMT` entry as text.
+ *
+ * Output that does not fit is truncated; the result is always NUL
+ * terminated.  If the entry itself was truncated when it was written, the
+ * text ends with "..." where the first missing argument would go.
+ *
+ * The format string is only used if the entry carries the hash of the
+ * running image (`LOG_FLAGS_IMAGE_HASH`) and its address lies within the
+ * image's read-only data.  Otherwise the text is the format string address
+ * followed by the stored arguments in hex, for decoding host-side.
+ *
+ * @param hdr                   The header of the entry.
+ * @param body                  The entry body.
+ * @param body_len              The length of the entry body.
+ * @param buf                   The buffer to write the text to.
+ * @param buf_len               The size of the buffer.
+ *
+ * @return                      The length of the text on success;
+ *                              SYS_EINVAL if the body is malformed.
+ */
+int log_fmt_render(const struct log_entry_hdr *hdr, const void *body,
+                   uint16_t body_len, char *buf, int buf_len);
+
+/**
+ * @brief Reports where the running image keeps its read-only data.
+ *
+ * Format strings are only read from within this range.  The default
+ * implementation takes the range from the __text and __etext linker script
+ * symbols and reports SYS_ENOTSUP if the script does not define them; in
+ * that case entries are not rendered.  A BSP whose linker script uses other
+ * symbols can provide its own implementation.
+ *
+ * @param out_start             On success, the first address of the range.
+ * @param out_end               On success, the address following the range.
+ *
+ * @return                      0 on success; SYS_ENOTSUP if not known.
+ */
+int log_fmt_image_range(uintptr_t *out_start, uintptr_t *out_end);
+#endif
+
 int log_read(struct log *log, const void *dptr, void *buf, uint16_t off,
         uint16_t len);
 
@@ -590,6 +699,17 @@ int log_walk(struct log *log, log_walk_func_t walk_func,
  */
 int log_walk_body(struct log *log, log_walk_body_func_t walk_body_func,
         struct log_offset *log_offset);
+
+/**
+ * @brief Erases all entries from the specified log.
+ *
+ * For a log in async mode, entries queued before the call are written to the
+ * log first, so none of them show up after the flush.
+ *
+ * @param log                   The log to flush.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
 int log_flush(struct log *log);
 
 /**
@@ -725,6 +845,117 @@ log_set_rotate_notify_cb(struct log *log, log_notify_rotate_cb *cb);
 int log_set_watermark(struct log *log, uint32_t index);
 #endif
 
+#if MYNEWT_VAL(LOG_ASYNC)
+struct log_async_stats {
+    /* Entries queued in the staging ring. */
+    uint32_t las_queued;
+    /* Entries handed to their log handler by the writer task. */
+    uint32_t las_written;
+    /* Entries dropped because the staging ring was full. */
+    uint32_t las_drops;
+    /* Number of times the writer task drained the ring. */
+    uint32_t las_batches;
+    /* Bytes currently queued, and the most ever queued at once. */
+    uint16_t las_used;
+    uint16_t las_max_used;
+};
+
+/**
+ * @brief Switches a log between synchronous and asynchronous appends.
+ *
+ * In async mode, appends assign the entry its index and timestamp, copy it
+ * into a RAM staging ring shared by all async logs and return without
+ * touching the log handler.  The async writer task drains the ring in order,
+ * writing each entry to its log and then calling the log's append callback
+ * from the writer task's context.  If the ring has no room for an entry, the
+ * append fails with SYS_ENOMEM and the entry is counted as dropped.
+ *
+ * Queued entries are not visible to log walks until they have been written;
+ * use log_async_sync() to wait for them.
+ *
+ * @param log                   The log to configure.
+ * @param async                 1 to queue appends; 0 to write them directly.
+ */
+void log_set_async(struct log *log, int async);
+
+/**
+ * @brief Waits until every entry queued before the call has been written.
+ *
+ * Must not be called from an append callback, as those run in the writer
+ * task.  Before the OS is started, the ring is drained in the caller's
+ * context instead.
+ *
+ * @param timeout               Maximum number of OS ticks to wait, or
+ *                                  OS_TIMEOUT_NEVER.
+ *
+ * @return                      0 on success;
+ *                              SYS_ETIMEOUT if entries are still queued;
+ *                              SYS_EBUSY if called from the writer task.
+ */
+int log_async_sync(os_time_t timeout);
+
+/**
+ * @brief Retrieves counters of the async append pipeline.
+ *
+ * las_used against MYNEWT_VAL(LOG_ASYNC_BUF_SIZE) tells how close appenders
+ * are to having entries dropped.
+ *
+ * @param stats                 The destination to write the counters to.
+ */
+void log_async_stats_get(struct log_async_stats *stats);
+
+/* Functions called only by the log package. */
+void log_async_init(void);
+void log_call_append_cb(struct log *log, uint32_t idx);
+int log_async_append(struct log *log, const struct log_entry_hdr *hdr,
+                     const void *body, const struct os_mbuf *om,
+                     uint16_t om_off, uint16_t body_len);
+
+#if MYNEWT_VAL(SELFTEST)
+/**
+ * Called by log_async_sync() after it registers as a waiter and before it
+ * pends.  Only exposed to unit tests.
+ */
+extern void (*log_async_sync_test_hook)(void);
+#endif
+#endif
+
+#if MYNEWT_VAL(LOG_COMPRESS)
+/**
+ * @brief Enables or disables compression of entries appended to a log.
+ *
+ * Entry bodies of up to `LOG_COMPRESS_MAX_LEN` bytes are compressed with a
+ * small LZ77-family codec before being handed to the log handler, and are
+ * flagged with `LOG_FLAGS_LZ`.  Each entry is compressed on its own, so
+ * entries can still be read in any order.  Bodies that would not shrink are
+ * written as is.  Headers are never compressed.
+ *
+ * Compressed entries are decompressed transparently by log_read(),
+ * log_read_body(), the mbuf read functions and the walk functions, which
+ * report uncompressed lengths; this holds whether or not compression is
+ * currently enabled, and for entries written before the log was last
+ * registered.  With `LOG_STATS`, the lz_[...] stats give the compression
+ * ratio (lz_out / lz_in) and time spent in the codec.
+ *
+ * @param log                   The log to configure.
+ * @param enable                1 to compress new entries; 0 otherwise.
+ *
+ * @return                      0 on success;
+ *                              SYS_ENOTSUP for stream logs, which are never
+ *                                  read back.
+ */
+int log_set_compress(struct log *log, int enable);
+
+/* Functions called only by the log package. */
+int log_lz_append(struct log *log, const struct log_entry_hdr *hdr,
+                  const void *body, struct os_mbuf *om, uint16_t om_off,
+                  uint16_t body_len);
+int log_lz_read(struct log *log, const void *dptr, void *buf,
+                struct os_mbuf *om, uint16_t off, uint16_t len);
+int log_lz_body_len(struct log *log, const void *dptr,
+                    const struct log_entry_hdr *hdr);
+#endif
+
 /**
  * Fill log current image hash
  *
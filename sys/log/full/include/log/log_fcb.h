@@ -56,6 +56,26 @@ struct log_fcb_bset {
     int lfs_next;
 };
 
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+/** lfx_first_index is valid. */
+#define LOG_FCB_SECT_F_INDEX    0x01
+/** lfx_max_ts is valid. */
+#define LOG_FCB_SECT_F_TS       0x02
+
+/**
+ * Cached summary of one FCB sector.  Only sectors which are no longer being
+ * appended to are cached; an entry is dropped when its sector is erased.
+ */
+struct log_fcb_sect {
+    /** Newest timestamp of the entries in the sector. */
+    int64_t lfx_max_ts;
+    /** Index of the first entry in the sector. */
+    uint32_t lfx_first_index;
+    /** LOG_FCB_SECT_F_* flags. */
+    uint8_t lfx_flags;
+};
+#endif
+
 /**
  * fcb_log is needed as the number of entries in a log
  */
@@ -72,6 +92,10 @@ struct fcb_log {
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     struct log_fcb_bset fl_bset;
 #endif
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    /* Internal - per-sector index, see LOG_FCB_SECTOR_INDEX */
+    struct log_fcb_sect fl_sects[MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)];
+#endif
 };
 
 #elif MYNEWT_VAL(LOG_FCB2)
@@ -87,6 +111,10 @@ struct fcb_log {
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     struct log_fcb_bset fl_bset;
 #endif
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    /* Internal - per-sector index, see LOG_FCB_SECTOR_INDEX */
+    struct log_fcb_sect fl_sects[MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)];
+#endif
 };
 #endif
 
@@ -18,17 +18,7 @@
  */
 
 #include "os/mynewt.h"
-#include "log_test_util/log_test_util.h"
-#include "log_test_fcb_bookmarks.h"
-
-TEST_SUITE(log_test_suite_fcb_bookmarks)
-{
-    log_test_case_fcb_bookmarks_s0_l1_b0_p100();
-    log_test_case_fcb_bookmarks_s0_l1_b1_p100();
-    log_test_case_fcb_bookmarks_s10_l100_b1_p200();
-    log_test_case_fcb_bookmarks_s10_l100_b10_p2000();
-    log_test_case_fcb_bookmarks_s100_l500_b10_p2000();
-}
+#include "log_test_fcb_bookmarks/log_test_fcb_bookmarks.h"
 
 int
 main(int argc, char **argv)
@@ -17,7 +17,7 @@
  */
 
 #include "log_test_util/log_test_util.h"
-#include "log_test_fcb_bookmarks.h"
+#include "log_test_fcb_bookmarks/log_test_fcb_bookmarks.h"
 
 #define LTFBU_MAX_ENTRY_IDXS    20480
 #define LTFBU_MAX_BODY_LEN      1024
@@ -18,7 +18,7 @@
  */
 
 #include "log_test_util/log_test_util.h"
-#include "log_test_fcb_bookmarks.h"
+#include "log_test_fcb_bookmarks/log_test_fcb_bookmarks.h"
 
 TEST_CASE_SELF(log_test_case_fcb_bookmarks_s0_l1_b0_p100)
 {
@@ -40,5 +40,8 @@ TEST_CASE_DECL(log_test_case_fcb_bookmarks_s0_l1_b1_p100);
 TEST_CASE_DECL(log_test_case_fcb_bookmarks_s10_l100_b1_p200);
 TEST_CASE_DECL(log_test_case_fcb_bookmarks_s10_l100_b10_p2000);
 TEST_CASE_DECL(log_test_case_fcb_bookmarks_s100_l500_b10_p2000);
+TEST_CASE_DECL(log_test_case_fcb_bookmarks_sidx_ts);
+
+TEST_SUITE_DECL(log_test_suite_fcb_bookmarks);
 
 #endif
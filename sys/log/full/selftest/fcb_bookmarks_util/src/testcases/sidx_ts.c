@@ -0,0 +1,229 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_fcb_bookmarks/log_test_fcb_bookmarks.h"
+
+/*
+ * Walks starting at a timestamp, with the sector index covering more than
+ * two sectors.  The clock is set back while the second sector is written, so
+ * the newest timestamps are not monotonic across sectors.
+ */
+
+#define LTST_SECTOR_CNT     4
+#define LTST_SECTOR_SIZE    (16 * 1024)
+#define LTST_BODY_LEN       1000
+#define LTST_MAX_ENTRIES    128
+#define LTST_BASE_SEC       1500000000
+
+static struct flash_area ltst_fcb_areas[LTST_SECTOR_CNT] = {
+    [0] = {
+        .fa_off = 0 * LTST_SECTOR_SIZE,
+        .fa_size = LTST_SECTOR_SIZE,
+    },
+    [1] = {
+        .fa_off = 1 * LTST_SECTOR_SIZE,
+        .fa_size = LTST_SECTOR_SIZE,
+    },
+    [2] = {
+        .fa_off = 2 * LTST_SECTOR_SIZE,
+        .fa_size = LTST_SECTOR_SIZE,
+    },
+    [3] = {
+        .fa_off = 3 * LTST_SECTOR_SIZE,
+        .fa_size = LTST_SECTOR_SIZE,
+    },
+};
+
+/* Clock offset, in seconds, used while writing to each sector. */
+static const int ltst_sector_sec[LTST_SECTOR_CNT] = { 1000, 0, 2000, 3000 };
+
+static struct fcb_log ltst_fcb_log;
+static struct log ltst_log;
+
+static uint32_t ltst_idxs[LTST_MAX_ENTRIES];
+static uint8_t ltst_sects[LTST_MAX_ENTRIES];
+static int64_t ltst_max_ts[LTST_SECTOR_CNT];
+static int ltst_num_entries;
+
+struct ltst_walk_arg {
+    int first;
+    int cur;
+};
+
+static void
+ltst_init(void)
+{
+    int rc;
+    int i;
+
+    ltst_fcb_log = (struct fcb_log) {
+        .fl_fcb.f_scratch_cnt = 0,
+        .fl_fcb.f_sectors = ltst_fcb_areas,
+        .fl_fcb.f_sector_cnt = LTST_SECTOR_CNT,
+        .fl_fcb.f_magic = 0x7EADBADF,
+        .fl_fcb.f_version = 0,
+    };
+
+    for (i = 0; i < LTST_SECTOR_CNT; i++) {
+        rc = flash_area_erase(&ltst_fcb_areas[i], 0,
+                              ltst_fcb_areas[i].fa_size);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    rc = fcb_init(&ltst_fcb_log.fl_fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    log_register("log", &ltst_log, &log_fcb_handler, &ltst_fcb_log,
+                 LOG_SYSLEVEL);
+}
+
+/*
+ * Empties the log, fills sectors 0 to 2 and puts a few entries in sector 3.
+ * If 'sects' is given, it holds the sector of each entry from a previous
+ * identical run, and the clock is set according to it.
+ */
+static void
+ltst_populate(const uint8_t *sects)
+{
+    uint8_t body[LTST_BODY_LEN];
+    struct os_timeval tv;
+    int sect;
+    int tail;
+    int rc;
+    int i;
+
+    rc = log_flush(&ltst_log);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    memset(ltst_max_ts, 0, sizeof(ltst_max_ts));
+    tail = 0;
+    for (i = 0; tail < 3; i++) {
+        TEST_ASSERT_FATAL(i < LTST_MAX_ENTRIES);
+
+        tv.tv_sec = LTST_BASE_SEC + i;
+        if (sects != NULL) {
+            tv.tv_sec += ltst_sector_sec[sects[i]];
+        }
+        tv.tv_usec = 0;
+        rc = os_settimeofday(&tv, NULL);
+        TEST_ASSERT_FATAL(rc == 0);
+
+        ltst_idxs[i] = g_log_info.li_next_index;
+        memset(body, i, sizeof(body));
+        rc = log_append_body(&ltst_log, 0, 255, LOG_ETYPE_BINARY, body,
+                             sizeof(body));
+        TEST_ASSERT_FATAL(rc == 0);
+
+        sect = ltst_fcb_log.fl_fcb.f_active.fe_area - ltst_fcb_areas;
+        TEST_ASSERT_FATAL(sects == NULL || sects[i] == sect);
+        ltst_sects[i] = sect;
+        ltst_max_ts[sect] = (int64_t)tv.tv_sec * 1000000;
+        if (sect == LTST_SECTOR_CNT - 1) {
+            tail++;
+        }
+    }
+    ltst_num_entries = i;
+}
+
+static int
+ltst_walk_cb(struct log *log, struct log_offset *log_offset,
+             const struct log_entry_hdr *hdr, const void *dptr, uint16_t len)
+{
+    struct ltst_walk_arg *arg;
+
+    arg = log_offset->lo_arg;
+
+    TEST_ASSERT_FATAL(arg->first + arg->cur < ltst_num_entries);
+    TEST_ASSERT_FATAL(hdr->ue_index == ltst_idxs[arg->first + arg->cur]);
+
+    arg->cur++;
+
+    return 0;
+}
+
+/*
+ * A walk from 'ts' has to start with the first sector holding an entry at
+ * least as new, or with the active sector if there is none.
+ */
+static void
+ltst_verify_walk(int64_t ts)
+{
+    struct log_offset log_offset;
+    struct ltst_walk_arg arg;
+    int sect;
+    int rc;
+
+    for (sect = 0; sect < LTST_SECTOR_CNT - 1; sect++) {
+        if (ltst_max_ts[sect] >= ts) {
+            break;
+        }
+    }
+
+    arg.first = 0;
+    while (ltst_sects[arg.first] != sect) {
+        arg.first++;
+    }
+    arg.cur = 0;
+
+    log_offset = (struct log_offset) {
+        .lo_arg = &arg,
+        .lo_index = 0,
+        .lo_ts = ts,
+        .lo_data_len = 0,
+    };
+
+    rc = log_walk_body(&ltst_log, ltst_walk_cb, &log_offset);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(arg.first + arg.cur == ltst_num_entries);
+}
+
+TEST_CASE_SELF(log_test_case_fcb_bookmarks_sidx_ts)
+{
+    uint8_t sects[LTST_MAX_ENTRIES];
+    int64_t base;
+
+    ltst_init();
+
+    /* Find out which sector every entry ends up in, then write them again
+     * with the clock set per sector.
+     */
+    ltst_populate(NULL);
+    memcpy(sects, ltst_sects, ltst_num_entries);
+    ltst_populate(sects);
+
+    base = (int64_t)LTST_BASE_SEC * 1000000;
+
+    /* Newer than everything in sectors 0 and 1. */
+    TEST_ASSERT(ltst_max_ts[0] < base + 1500 * 1000000LL);
+    ltst_verify_walk(base + 1500 * 1000000LL);
+
+    /* Sector 1 is older than sector 0, but still within range. */
+    ltst_verify_walk(base + 1);
+    ltst_verify_walk(base + 1000 * 1000000LL);
+
+    /* Only the active sector qualifies. */
+    ltst_verify_walk(base + 2500 * 1000000LL);
+
+    /* Nothing qualifies; the active sector is still walked. */
+    ltst_verify_walk(base + 5000 * 1000000LL);
+
+    /* Repeat with the cached sector maximums. */
+    ltst_verify_walk(base + 1500 * 1000000LL);
+    ltst_verify_walk(base + 2500 * 1000000LL);
+}
@@ -74,6 +74,24 @@ TEST_CASE_DECL(log_test_case_append_cb);
 
 TEST_CASE_DECL(log_test_case_2logs);
 
+#if MYNEWT_VAL(LOG_FMT)
+TEST_SUITE_DECL(log_test_suite_fmt);
+TEST_CASE_DECL(log_test_case_fmt);
+#endif
+
+#if MYNEWT_VAL(LOG_COMPRESS)
+TEST_SUITE_DECL(log_test_suite_compress);
+TEST_CASE_DECL(log_test_case_compress);
+#endif
+
+#if MYNEWT_VAL(LOG_ASYNC)
+TEST_SUITE_DECL(log_test_suite_async);
+TEST_CASE_DECL(log_test_case_async);
+
+TEST_SUITE_DECL(log_test_suite_async_prio);
+TEST_CASE_DECL(log_test_case_async_sync_race);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
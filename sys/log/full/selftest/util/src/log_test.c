@@ -54,3 +54,29 @@ TEST_SUITE(log_test_suite_misc)
     log_test_case_2logs();
 #endif
 }
+
+#if MYNEWT_VAL(LOG_FMT)
+TEST_SUITE(log_test_suite_fmt)
+{
+    log_test_case_fmt();
+}
+#endif
+
+#if MYNEWT_VAL(LOG_COMPRESS)
+TEST_SUITE(log_test_suite_compress)
+{
+    log_test_case_compress();
+}
+#endif
+
+#if MYNEWT_VAL(LOG_ASYNC)
+TEST_SUITE(log_test_suite_async)
+{
+    log_test_case_async();
+}
+
+TEST_SUITE(log_test_suite_async_prio)
+{
+    log_test_case_async_sync_race();
+}
+#endif
@@ -136,6 +136,9 @@ ltu_setup_fcb(struct fcb_log *fcb_log, struct log *log)
 #endif
 
     log_register("log", log, &log_fcb_handler, fcb_log, LOG_SYSLEVEL);
+#if MYNEWT_VAL(LOG_COMPRESS)
+    log_set_compress(log, 1);
+#endif
 }
 
 void
@@ -178,6 +181,9 @@ ltu_setup_cbmem(struct cbmem *cbmem, struct log *log)
 {
     cbmem_init(cbmem, ltu_cbmem_buf, sizeof ltu_cbmem_buf);
     log_register("log", log, &log_cbmem_handler, cbmem, LOG_SYSLEVEL);
+#if MYNEWT_VAL(LOG_COMPRESS)
+    log_set_compress(log, 1);
+#endif
 }
 
 static int
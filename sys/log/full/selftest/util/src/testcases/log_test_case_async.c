@@ -0,0 +1,123 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+
+#if MYNEWT_VAL(LOG_ASYNC)
+
+static int
+ltca_count_walk(struct log *log, struct log_offset *log_offset,
+                const void *dptr, uint16_t len)
+{
+    (*(int *)log_offset->lo_arg)++;
+    return 0;
+}
+
+static int
+ltca_count(struct log *log)
+{
+    struct log_offset log_offset = { 0 };
+    int cnt;
+    int rc;
+
+    cnt = 0;
+    log_offset.lo_arg = &cnt;
+    rc = log_walk(log, ltca_count_walk, &log_offset);
+    TEST_ASSERT(rc == 0);
+
+    return cnt;
+}
+
+TEST_CASE_TASK(log_test_case_async)
+{
+    struct log_async_stats stats;
+    struct fcb_log fcb_log;
+    struct os_mbuf *om;
+    struct log log;
+    uint8_t buf[128];
+    uint32_t drops;
+    char *str;
+    int queued;
+    int rc;
+    int i;
+
+    ltu_setup_fcb(&fcb_log, &log);
+    log_set_async(&log, 1);
+
+    /* Alternate between the flat and mbuf append paths. */
+    for (i = 0; ; i++) {
+        str = ltu_str_logs[i];
+        if (!str) {
+            break;
+        }
+
+        if (i % 2 == 0) {
+            rc = log_append_body(&log, 0, 0, LOG_ETYPE_STRING, str,
+                                 strlen(str));
+        } else {
+            om = ltu_flat_to_fragged_mbuf(str, strlen(str), 2);
+            rc = log_append_mbuf_body(&log, 0, 0, LOG_ETYPE_STRING, om);
+        }
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /* The writer task has a lower priority; nothing is written yet. */
+    TEST_ASSERT(ltca_count(&log) == 0);
+
+    rc = log_async_sync(OS_TIMEOUT_NEVER);
+    TEST_ASSERT(rc == 0);
+    ltu_verify_contents(&log);
+
+    /*** Fill the staging ring until an append is dropped. */
+
+    log_async_stats_get(&stats);
+    drops = stats.las_drops;
+
+    memset(buf, 0xa5, sizeof(buf));
+    for (queued = 0; ; queued++) {
+        rc = log_append_body(&log, 0, 0, LOG_ETYPE_BINARY, buf, sizeof(buf));
+        if (rc != 0) {
+            break;
+        }
+    }
+    TEST_ASSERT(rc == SYS_ENOMEM);
+    TEST_ASSERT(queued > 0);
+
+    log_async_stats_get(&stats);
+    TEST_ASSERT(stats.las_drops == drops + 1);
+    TEST_ASSERT(stats.las_used > 0);
+
+    rc = log_async_sync(OS_TIMEOUT_NEVER);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(ltca_count(&log) == queued);
+
+    /*** log_flush() writes queued entries before erasing the log. */
+
+    rc = log_append_body(&log, 0, 0, LOG_ETYPE_BINARY, buf, sizeof(buf));
+    TEST_ASSERT(rc == 0);
+
+    rc = log_flush(&log);
+    TEST_ASSERT(rc == 0);
+
+    log_async_stats_get(&stats);
+    TEST_ASSERT(stats.las_used == 0);
+    TEST_ASSERT(ltca_count(&log) == 0);
+}
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include "log_test_util/log_test_util.h"
+
+#if MYNEWT_VAL(LOG_ASYNC)
+
+static struct log_handler ltcasr_handler;
+static struct os_sem ltcasr_gate;
+static int ltcasr_hook_calls;
+
+/* Holds the writer inside the log handler until the test opens the gate. */
+static int
+ltcasr_append(struct log *log, void *buf, int len)
+{
+    os_sem_pend(&ltcasr_gate, OS_TIMEOUT_NEVER);
+    return log_fcb_handler.log_append(log, buf, len);
+}
+
+static void
+ltcasr_hook(void)
+{
+    struct log_async_stats stats;
+
+    ltcasr_hook_calls++;
+
+    /* The writer has a higher priority; it runs to the end of the drain
+     * before this returns and before log_async_sync() pends.
+     */
+    os_sem_release(&ltcasr_gate);
+
+    log_async_stats_get(&stats);
+    TEST_ASSERT(stats.las_written == 1);
+    TEST_ASSERT(stats.las_used == 0);
+}
+
+TEST_CASE_TASK(log_test_case_async_sync_race)
+{
+    struct log_async_stats stats;
+    struct fcb_log fcb_log;
+    struct log log;
+    int rc;
+
+    ltu_setup_fcb(&fcb_log, &log);
+
+    ltcasr_handler = log_fcb_handler;
+    ltcasr_handler.log_append = ltcasr_append;
+    log.l_log = &ltcasr_handler;
+    log_set_async(&log, 1);
+
+    rc = os_sem_init(&ltcasr_gate, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* The writer picks the entry up right away and blocks on the gate. */
+    rc = log_append_body(&log, 0, 0, LOG_ETYPE_STRING, "race", 4);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    log_async_stats_get(&stats);
+    TEST_ASSERT(stats.las_written == 0);
+    TEST_ASSERT(stats.las_used > 0);
+
+    /* Let the writer finish the drain after log_async_sync() has seen the
+     * entry outstanding but before it pends.  This must not hang.
+     */
+    ltcasr_hook_calls = 0;
+    log_async_sync_test_hook = ltcasr_hook;
+    rc = log_async_sync(OS_TIMEOUT_NEVER);
+    log_async_sync_test_hook = NULL;
+
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(ltcasr_hook_calls == 1);
+
+    log.l_log = &log_fcb_handler;
+}
+
+#endif
@@ -0,0 +1,117 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+
+#if MYNEWT_VAL(LOG_COMPRESS)
+
+static uint8_t ltcc_body[100];
+static int ltcc_entries;
+
+static int
+ltcc_walk_body(struct log *log, struct log_offset *log_offset,
+               const struct log_entry_hdr *hdr, const void *dptr,
+               uint16_t len)
+{
+    struct os_mbuf *om;
+    uint8_t data[sizeof(ltcc_body)];
+    int rc;
+
+    if (ltcc_entries == 0) {
+        /* Repetitive body; stored compressed. */
+        TEST_ASSERT(hdr->ue_flags & LOG_FLAGS_LZ);
+        TEST_ASSERT(len == sizeof(ltcc_body));
+    } else {
+        /* Too short to shrink; stored as is. */
+        TEST_ASSERT(!(hdr->ue_flags & LOG_FLAGS_LZ));
+        TEST_ASSERT(len == 4);
+    }
+
+    rc = log_read_body(log, dptr, data, 0, len);
+    TEST_ASSERT(rc == len);
+    TEST_ASSERT(memcmp(data, ltcc_body, len) == 0);
+
+    /* Reads from the middle of the body and past its end. */
+    rc = log_read_body(log, dptr, data, len / 2, len);
+    TEST_ASSERT(rc == len - len / 2);
+    TEST_ASSERT(memcmp(data, ltcc_body + len / 2, rc) == 0);
+
+    om = os_msys_get_pkthdr(0, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    rc = log_read_mbuf_body(log, dptr, om, 1, len - 1);
+    TEST_ASSERT(rc == len - 1);
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, ltcc_body + 1, len - 1) == 0);
+
+    os_mbuf_free_chain(om);
+
+    ltcc_entries++;
+
+    return 0;
+}
+
+TEST_CASE_SELF(log_test_case_compress)
+{
+    struct log_offset log_offset = { 0 };
+    struct cbmem cbmem;
+    struct log log;
+    int rc;
+    int i;
+
+    ltu_setup_cbmem(&cbmem, &log);
+
+    rc = log_set_compress(&log, 1);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < sizeof(ltcc_body); i++) {
+        ltcc_body[i] = "compress"[i % 8] + i / 32;
+    }
+
+    rc = log_append_body(&log, 0, 0, LOG_ETYPE_BINARY, ltcc_body,
+                         sizeof(ltcc_body));
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = log_append_body(&log, 0, 0, LOG_ETYPE_BINARY, ltcc_body, 4);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ltcc_entries = 0;
+    rc = log_walk_body(&log, ltcc_walk_body, &log_offset);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(ltcc_entries == 2);
+
+    /* Entries already written stay readable with compression turned off. */
+    rc = log_set_compress(&log, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ltcc_entries = 0;
+    rc = log_walk_body(&log, ltcc_walk_body, &log_offset);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(ltcc_entries == 2);
+
+    /* So do entries written before the log was registered again, as after a
+     * reboot.
+     */
+    log_register("log", &log, &log_cbmem_handler, &cbmem, LOG_SYSLEVEL);
+
+    ltcc_entries = 0;
+    rc = log_walk_body(&log, ltcc_walk_body, &log_offset);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(ltcc_entries == 2);
+}
+
+#endif
@@ -0,0 +1,156 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+#include "log_test_util/log_test_util.h"
+
+#if MYNEWT_VAL(LOG_FMT)
+
+static char ltcf_text[LOG_PRINTF_MAX_ENTRY_LEN];
+static char ltcf_expected[LOG_PRINTF_MAX_ENTRY_LEN];
+
+/* Header and body of the last entry walked. */
+static struct log_entry_hdr ltcf_hdr;
+static uint8_t ltcf_body[MYNEWT_VAL(LOG_FMT_MAX_ENTRY_LEN)];
+static int ltcf_body_len;
+
+static int
+ltcf_walk_body(struct log *log, struct log_offset *log_offset,
+               const struct log_entry_hdr *hdr, const void *dptr,
+               uint16_t len)
+{
+    uint8_t body[MYNEWT_VAL(LOG_FMT_MAX_ENTRY_LEN)];
+    int rc;
+
+    TEST_ASSERT_FATAL(hdr->ue_etype == LOG_ETYPE_FMT);
+    TEST_ASSERT_FATAL(len <= sizeof(body));
+
+    rc = log_read_body(log, dptr, body, 0, len);
+    TEST_ASSERT_FATAL(rc == len);
+
+    ltcf_hdr = *hdr;
+    memcpy(ltcf_body, body, len);
+    ltcf_body_len = len;
+
+    rc = log_fmt_render(hdr, body, len, ltcf_text, sizeof(ltcf_text));
+    TEST_ASSERT(rc == strlen(ltcf_text));
+
+    return 0;
+}
+
+static void
+ltcf_verify_last(struct log *log)
+{
+    struct log_offset log_offset = { 0 };
+    int rc;
+
+    /* Only the latest entry. */
+    log_offset.lo_ts = -1;
+    rc = log_walk_body(log, ltcf_walk_body, &log_offset);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(strcmp(ltcf_text, ltcf_expected) == 0);
+}
+
+/*
+ * Renders the last entry walked with the given header and format string
+ * address; expects the address followed by the arguments in hex.
+ */
+static void
+ltcf_verify_raw(const struct log_entry_hdr *hdr, const char *fmt)
+{
+    uint8_t body[MYNEWT_VAL(LOG_FMT_MAX_ENTRY_LEN)];
+    int len;
+    int rc;
+    int i;
+
+    memcpy(body, ltcf_body, ltcf_body_len);
+    memcpy(body, &fmt, sizeof(fmt));
+
+    len = snprintf(ltcf_expected, sizeof(ltcf_expected), "fmt@%p:", fmt);
+    for (i = sizeof(fmt); i < ltcf_body_len; i++) {
+        len += snprintf(ltcf_expected + len, sizeof(ltcf_expected) - len,
+                        " %02x", body[i]);
+    }
+
+    rc = log_fmt_render(hdr, body, ltcf_body_len, ltcf_text,
+                        sizeof(ltcf_text));
+    TEST_ASSERT(rc == strlen(ltcf_text));
+    TEST_ASSERT(strcmp(ltcf_text, ltcf_expected) == 0);
+}
+
+TEST_CASE_SELF(log_test_case_fmt)
+{
+    struct log_entry_hdr hdr;
+    struct cbmem cbmem;
+    struct log log;
+    const char *fmt;
+    char str[16];
+    int len;
+
+    ltu_setup_cbmem(&cbmem, &log);
+
+    log_fmt_printf(&log, 0, 0, "no arguments");
+    strcpy(ltcf_expected, "no arguments");
+    ltcf_verify_last(&log);
+
+    /* Strings are copied; the buffer may change after the call. */
+    strcpy(str, "abc");
+    log_fmt_printf(&log, 0, 0, "%d %5u %-4x| %s %c %%", -12, 34u, 0x5a, str,
+                   'z');
+    strcpy(str, "xyz");
+    snprintf(ltcf_expected, sizeof(ltcf_expected), "%d %5u %-4x| %s %c %%",
+             -12, 34u, 0x5a, "abc", 'z');
+    ltcf_verify_last(&log);
+
+    log_fmt_printf(&log, 0, 0, "%*d %.*s %ld %lld", 6, 7, 2, "abc", -8L,
+                   9LL);
+    snprintf(ltcf_expected, sizeof(ltcf_expected), "%*d %.*s %ld %lld",
+             6, 7, 2, "abc", -8L, 9LL);
+    ltcf_verify_last(&log);
+
+    /* An argument that does not fit is rendered as "...". */
+    memset(ltcf_expected, 'a', MYNEWT_VAL(LOG_FMT_MAX_ENTRY_LEN));
+    ltcf_expected[MYNEWT_VAL(LOG_FMT_MAX_ENTRY_LEN)] = '\0';
+    log_fmt_printf(&log, 0, 0, "%s %d", ltcf_expected, 1);
+    len = MYNEWT_VAL(LOG_FMT_MAX_ENTRY_LEN) - sizeof(const char *) - 1;
+    strcpy(ltcf_expected + len, " ...");
+    ltcf_verify_last(&log);
+
+    /* The format string is only used with the hash of the running image,
+     * and only if it lies within the image.
+     */
+    log_fmt_printf(&log, 0, 0, "%d %s", 5, "raw");
+    strcpy(ltcf_expected, "5 raw");
+    ltcf_verify_last(&log);
+    memcpy(&fmt, ltcf_body, sizeof(fmt));
+
+    hdr = ltcf_hdr;
+    hdr.ue_flags &= ~LOG_FLAGS_IMG_HASH;
+    ltcf_verify_raw(&hdr, fmt);
+
+    hdr = ltcf_hdr;
+    hdr.ue_imghash[0] ^= 0xff;
+    ltcf_verify_raw(&hdr, fmt);
+
+    strcpy(str, "%d %s");
+    ltcf_verify_raw(&ltcf_hdr, str);
+    ltcf_verify_raw(&ltcf_hdr, (const char *)&hdr);
+}
+
+#endif
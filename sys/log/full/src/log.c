@@ -81,6 +81,13 @@ STATS_NAME_START(logs)
   STATS_NAME(logs, errs)
   STATS_NAME(logs, lost)
   STATS_NAME(logs, too_long)
+#if MYNEWT_VAL(LOG_COMPRESS)
+  STATS_NAME(logs, lz_in)
+  STATS_NAME(logs, lz_out)
+  STATS_NAME(logs, lz_raw)
+  STATS_NAME(logs, lz_enc_us)
+  STATS_NAME(logs, lz_dec_us)
+#endif
 STATS_NAME_END(logs)
 #endif
 
@@ -162,6 +169,10 @@ log_init(void)
     log_console_init();
 #endif
 
+#if MYNEWT_VAL(LOG_ASYNC)
+    log_async_init();
+#endif
+
 #if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
 #if MYNEWT_VAL(LOG_PERSIST_WATERMARK)
     rc = conf_register(&log_conf);
@@ -393,6 +404,12 @@ log_register(const char *name, struct log *log, const struct log_handler *lh,
 #if !MYNEWT_VAL(LOG_GLOBAL_IDX)
     log->l_idx = 0;
 #endif
+#if MYNEWT_VAL(LOG_ASYNC)
+    log->l_async = 0;
+#endif
+#if MYNEWT_VAL(LOG_COMPRESS)
+    log->l_compress = 0;
+#endif
 
     if (!log_registered(log)) {
         STAILQ_INSERT_TAIL(&g_log_list, log, l_next);
@@ -470,6 +487,7 @@ log_chk_type(uint8_t etype)
         case LOG_ETYPE_STRING:
         case LOG_ETYPE_BINARY:
         case LOG_ETYPE_CBOR:
+        case LOG_ETYPE_FMT:
             break;
         default:
             rc = OS_ERROR;
@@ -574,7 +592,7 @@ err:
 /**
  * Calls the given log's append callback, if it has one.
  */
-static void
+void
 log_call_append_cb(struct log *log, uint32_t idx)
 {
     /* Qualify this as `volatile` to prevent a race condition.  This prevents
@@ -613,7 +631,21 @@ log_append_typed(struct log *log, uint8_t module, uint8_t level, uint8_t etype,
         goto err;
     }
 
-    rc = log->l_log->log_append(log, data, len + log_hdr_len(hdr));
+#if MYNEWT_VAL(LOG_ASYNC)
+    if (log->l_async) {
+        return log_async_append(log, hdr, (uint8_t *)data + log_hdr_len(hdr),
+                                NULL, 0, len);
+    }
+#endif
+
+    rc = SYS_ENOTSUP;
+#if MYNEWT_VAL(LOG_COMPRESS)
+    rc = log_lz_append(log, hdr, (uint8_t *)data + log_hdr_len(hdr), NULL, 0,
+                       len);
+#endif
+    if (rc == SYS_ENOTSUP) {
+        rc = log->l_log->log_append(log, data, len + log_hdr_len(hdr));
+    }
     if (rc != 0) {
         LOG_STATS_INC(log, errs);
         goto err;
@@ -646,7 +678,19 @@ log_append_body(struct log *log, uint8_t module, uint8_t level, uint8_t etype,
         return rc;
     }
 
-    rc = log->l_log->log_append_body(log, &hdr, body, body_len);
+#if MYNEWT_VAL(LOG_ASYNC)
+    if (log->l_async) {
+        return log_async_append(log, &hdr, body, NULL, 0, body_len);
+    }
+#endif
+
+    rc = SYS_ENOTSUP;
+#if MYNEWT_VAL(LOG_COMPRESS)
+    rc = log_lz_append(log, &hdr, body, NULL, 0, body_len);
+#endif
+    if (rc == SYS_ENOTSUP) {
+        rc = log->l_log->log_append_body(log, &hdr, body, body_len);
+    }
     if (rc != 0) {
         LOG_STATS_INC(log, errs);
         return rc;
@@ -718,7 +762,29 @@ log_append_mbuf_typed_no_free(struct log *log, uint8_t module, uint8_t level,
         goto drop;
     }
 
-    rc = log->l_log->log_append_mbuf(log, om);
+#if MYNEWT_VAL(LOG_ASYNC)
+    if (log->l_async) {
+        hdr_len = log_hdr_len(hdr);
+        rc = log_async_append(log, hdr, NULL, om, hdr_len,
+                              len > hdr_len ? len - hdr_len : 0);
+        if (rc != 0) {
+            goto drop;
+        }
+        *om_ptr = om;
+        return 0;
+    }
+#endif
+
+    rc = SYS_ENOTSUP;
+#if MYNEWT_VAL(LOG_COMPRESS)
+    if (len > hdr_len) {
+        hdr_len = log_hdr_len(hdr);
+        rc = log_lz_append(log, hdr, NULL, om, hdr_len, len - hdr_len);
+    }
+#endif
+    if (rc == SYS_ENOTSUP) {
+        rc = log->l_log->log_append_mbuf(log, om);
+    }
     if (rc != 0) {
         goto err;
     }
@@ -781,7 +847,19 @@ log_append_mbuf_body_no_free(struct log *log, uint8_t module, uint8_t level,
         goto drop;
     }
 
-    rc = log->l_log->log_append_mbuf_body(log, &hdr, om);
+#if MYNEWT_VAL(LOG_ASYNC)
+    if (log->l_async) {
+        return log_async_append(log, &hdr, NULL, om, 0, len);
+    }
+#endif
+
+    rc = SYS_ENOTSUP;
+#if MYNEWT_VAL(LOG_COMPRESS)
+    rc = log_lz_append(log, &hdr, NULL, om, 0, len);
+#endif
+    if (rc == SYS_ENOTSUP) {
+        rc = log->l_log->log_append_mbuf_body(log, &hdr, om);
+    }
     if (rc != 0) {
         goto err;
     }
@@ -825,13 +903,66 @@ log_printf(struct log *log, uint8_t module, uint8_t level,
     log_append_body(log, module, level, LOG_ETYPE_STRING, buf, len);
 }
 
+#if MYNEWT_VAL(LOG_COMPRESS)
+/**
+ * Argument passed to the handler walk by `log_walk`.  Wraps the original walk
+ * argument and callback so that compressed entries can be reported with their
+ * uncompressed length.
+ */
+struct log_walk_lz_arg {
+    log_walk_func_t fn;
+    void *arg;
+};
+
+static int
+log_walk_lz_fn(struct log *log, struct log_offset *log_offset,
+               const void *dptr, uint16_t len)
+{
+    struct log_walk_lz_arg *lwla;
+    struct log_entry_hdr ueh;
+    int body_len;
+    int rc;
+
+    lwla = log_offset->lo_arg;
+
+    rc = log_read_hdr(log, dptr, &ueh);
+    if (rc == 0) {
+        body_len = log_lz_body_len(log, dptr, &ueh);
+        if (body_len >= 0) {
+            len = log_hdr_len(&ueh) + body_len;
+        }
+    }
+
+    log_offset->lo_arg = lwla->arg;
+    rc = lwla->fn(log, log_offset, dptr, len);
+    log_offset->lo_arg = lwla;
+
+    return rc;
+}
+#endif
+
 int
 log_walk(struct log *log, log_walk_func_t walk_func,
          struct log_offset *log_offset)
 {
     int rc;
 
+#if MYNEWT_VAL(LOG_COMPRESS)
+    struct log_walk_lz_arg lwla = {
+        .fn = walk_func,
+        .arg = log_offset->lo_arg,
+    };
+
+    /* Entries may have been compressed before the log was registered, so
+     * every walk reads the header of each entry to report its uncompressed
+     * length.
+     */
+    log_offset->lo_arg = &lwla;
+    rc = log->l_log->log_walk(log, log_walk_lz_fn, log_offset);
+    log_offset->lo_arg = lwla.arg;
+#else
     rc = log->l_log->log_walk(log, walk_func, log_offset);
+#endif
     if (rc != 0) {
         goto err;
     }
@@ -877,6 +1008,12 @@ log_walk_body_fn(struct log *log, struct log_offset *log_offset, const void *dpt
     }
     if (log_offset->lo_index <= ueh.ue_index) {
         len -= log_hdr_len(&ueh);
+#if MYNEWT_VAL(LOG_COMPRESS)
+        rc = log_lz_body_len(log, dptr, &ueh);
+        if (rc >= 0) {
+            len = rc;
+        }
+#endif
 
         /* Pass the wrapped callback argument to the body walk function. */
         log_offset->lo_arg = lwba->arg;
@@ -945,6 +1082,13 @@ log_read(struct log *log, const void *dptr, void *buf, uint16_t off,
 {
     int rc;
 
+#if MYNEWT_VAL(LOG_COMPRESS)
+    rc = log_lz_read(log, dptr, buf, NULL, off, len);
+    if (rc != SYS_ENOTSUP) {
+        return rc;
+    }
+#endif
+
     rc = log->l_log->log_read(log, dptr, buf, off, len);
 
     return (rc);
@@ -996,6 +1140,13 @@ log_read_mbuf(struct log *log, const void *dptr, struct os_mbuf *om, uint16_t of
         return 0;
     }
 
+#if MYNEWT_VAL(LOG_COMPRESS)
+    rc = log_lz_read(log, dptr, NULL, om, off, len);
+    if (rc != SYS_ENOTSUP) {
+        return rc;
+    }
+#endif
+
     rc = log->l_log->log_read_mbuf(log, dptr, om, off, len);
 
     return (rc);
@@ -1021,6 +1172,16 @@ log_flush(struct log *log)
 {
     int rc;
 
+#if MYNEWT_VAL(LOG_ASYNC)
+    /* Write out queued entries so they are erased along with the rest. */
+    if (log->l_async) {
+        rc = log_async_sync(OS_TIMEOUT_NEVER);
+        if (rc != 0) {
+            goto err;
+        }
+    }
+#endif
+
     rc = log->l_log->log_flush(log);
     if (rc != 0) {
         goto err;
@@ -0,0 +1,381 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_ASYNC)
+
+#include <assert.h>
+#include <string.h>
+
+#include "log/log.h"
+
+/*
+ * Staging ring for async appends.  Each queued entry is stored contiguously
+ * as a record header followed by the entry header and body, so the writer
+ * can pass it to the handler's log_append() as is.  A record that does not
+ * fit between the head and the end of the buffer is placed at the start and
+ * the unused tail is skipped (la_end marks where valid data stops).
+ *
+ * Producers reserve space with interrupts disabled, copy the entry with them
+ * enabled and then mark the record ready.  The writer only consumes records
+ * in order, so a record still being copied holds back the ones behind it.
+ */
+struct log_async_rec {
+    struct log *lar_log;
+    uint16_t lar_len;       /* Length of entry header + body. */
+    uint16_t lar_size;      /* Space taken in the ring, including this. */
+    volatile uint8_t lar_ready;
+};
+
+#define LOG_ASYNC_REC_HDR_SIZE  OS_ALIGN(sizeof(struct log_async_rec), 4)
+
+static uint8_t log_async_buf[MYNEWT_VAL(LOG_ASYNC_BUF_SIZE)]
+    __attribute__((aligned(OS_ALIGNMENT)));
+static uint16_t la_head;
+static uint16_t la_tail;
+static uint16_t la_end;
+static uint8_t la_wrapped;
+
+/* Number of records reserved and written; used by log_async_sync(). */
+static uint32_t la_seq_queued;
+static uint32_t la_seq_done;
+static uint16_t la_sync_waiters;
+
+static struct log_async_stats la_stats;
+
+#if MYNEWT_VAL(SELFTEST)
+void (*log_async_sync_test_hook)(void);
+#endif
+
+static struct os_sem la_sem;
+static struct os_sem la_sync_sem;
+static struct os_task la_task;
+OS_TASK_STACK_DEFINE(la_stack, MYNEWT_VAL(LOG_ASYNC_STACK_SIZE));
+
+/**
+ * Reserves a record of the given size.  Must be called with interrupts
+ * disabled.
+ */
+static struct log_async_rec *
+log_async_reserve(uint16_t size)
+{
+    struct log_async_rec *rec;
+    uint16_t off;
+
+    if (!la_wrapped) {
+        if (sizeof(log_async_buf) - la_head >= size) {
+            off = la_head;
+        } else if (la_tail >= size) {
+            la_end = la_head;
+            la_wrapped = 1;
+            off = 0;
+        } else {
+            return NULL;
+        }
+    } else if (la_tail - la_head >= size) {
+        off = la_head;
+    } else {
+        return NULL;
+    }
+
+    la_head = off + size;
+    la_stats.las_used += size;
+    if (la_stats.las_used > la_stats.las_max_used) {
+        la_stats.las_max_used = la_stats.las_used;
+    }
+    la_stats.las_queued++;
+    la_seq_queued++;
+
+    rec = (struct log_async_rec *)&log_async_buf[off];
+    rec->lar_ready = 0;
+
+    return rec;
+}
+
+/**
+ * Returns the oldest record, or NULL if the ring is empty.  Must be called
+ * with interrupts disabled.
+ */
+static struct log_async_rec *
+log_async_peek(void)
+{
+    if (la_stats.las_used == 0) {
+        return NULL;
+    }
+    if (la_wrapped && la_tail == la_end) {
+        la_tail = 0;
+        la_wrapped = 0;
+    }
+
+    return (struct log_async_rec *)&log_async_buf[la_tail];
+}
+
+/**
+ * Releases the oldest record.  Must be called with interrupts disabled.
+ */
+static void
+log_async_release(struct log_async_rec *rec)
+{
+    la_tail += rec->lar_size;
+    la_stats.las_used -= rec->lar_size;
+    if (la_stats.las_used == 0) {
+        la_head = 0;
+        la_tail = 0;
+        la_wrapped = 0;
+    }
+    la_seq_done++;
+}
+
+/**
+ * Writes all ready records to their logs.  Stops at the first record that is
+ * still being filled in; its producer signals the writer again once done.
+ */
+static void
+log_async_drain(void)
+{
+    struct log_async_rec *rec;
+    struct log_entry_hdr *hdr;
+    struct log *log;
+    uint16_t waiters;
+    int sr;
+    int rc;
+
+    la_stats.las_batches++;
+
+    while (1) {
+        OS_ENTER_CRITICAL(sr);
+        rec = log_async_peek();
+        OS_EXIT_CRITICAL(sr);
+        if (rec == NULL || !rec->lar_ready) {
+            break;
+        }
+
+        log = rec->lar_log;
+        hdr = (struct log_entry_hdr *)((uint8_t *)rec + LOG_ASYNC_REC_HDR_SIZE);
+
+        rc = SYS_ENOTSUP;
+#if MYNEWT_VAL(LOG_COMPRESS)
+        rc = log_lz_append(log, hdr, (uint8_t *)hdr + log_hdr_len(hdr), NULL,
+                           0, rec->lar_len - log_hdr_len(hdr));
+#endif
+        if (rc == SYS_ENOTSUP) {
+            rc = log->l_log->log_append(log, hdr, rec->lar_len);
+        }
+        if (rc != 0) {
+            LOG_STATS_INC(log, errs);
+        } else {
+            la_stats.las_written++;
+            log_call_append_cb(log, hdr->ue_index);
+        }
+
+        OS_ENTER_CRITICAL(sr);
+        log_async_release(rec);
+        OS_EXIT_CRITICAL(sr);
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    waiters = la_sync_waiters;
+    OS_EXIT_CRITICAL(sr);
+    while (waiters-- > 0) {
+        os_sem_release(&la_sync_sem);
+    }
+}
+
+static void
+log_async_task(void *arg)
+{
+    while (1) {
+        os_sem_pend(&la_sem, OS_TIMEOUT_NEVER);
+        log_async_drain();
+    }
+}
+
+int
+log_async_append(struct log *log, const struct log_entry_hdr *hdr,
+                 const void *body, const struct os_mbuf *om, uint16_t om_off,
+                 uint16_t body_len)
+{
+    struct log_async_rec *rec;
+    uint8_t *dst;
+    uint16_t hdr_len;
+    uint32_t size;
+    int sr;
+    int rc;
+
+    hdr_len = log_hdr_len(hdr);
+    size = LOG_ASYNC_REC_HDR_SIZE + OS_ALIGN(hdr_len + body_len, 4);
+
+    rec = NULL;
+    OS_ENTER_CRITICAL(sr);
+    if (size <= sizeof(log_async_buf)) {
+        rec = log_async_reserve(size);
+    }
+    if (rec == NULL) {
+        la_stats.las_drops++;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (rec == NULL) {
+        LOG_STATS_INC(log, drops);
+        return SYS_ENOMEM;
+    }
+
+    rec->lar_log = log;
+    rec->lar_len = hdr_len + body_len;
+    rec->lar_size = size;
+
+    dst = (uint8_t *)rec + LOG_ASYNC_REC_HDR_SIZE;
+    memcpy(dst, hdr, hdr_len);
+    if (om != NULL) {
+        rc = os_mbuf_copydata(om, om_off, body_len, dst + hdr_len);
+        assert(rc == 0);
+    } else {
+        memcpy(dst + hdr_len, body, body_len);
+    }
+
+    rec->lar_ready = 1;
+
+    /* Only one wakeup is needed to drain everything queued so far. */
+    OS_ENTER_CRITICAL(sr);
+    if (os_sem_get_count(&la_sem) == 0) {
+        os_sem_release(&la_sem);
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return 0;
+}
+
+int
+log_async_sync(os_time_t timeout)
+{
+    os_time_t start;
+    os_time_t elapsed;
+    uint32_t target;
+    int sr;
+    int rc;
+
+    if (!os_started()) {
+        log_async_drain();
+        return 0;
+    }
+
+    if (os_sched_get_current_task() == &la_task) {
+        return SYS_EBUSY;
+    }
+
+    start = os_time_get();
+
+    OS_ENTER_CRITICAL(sr);
+    target = la_seq_queued;
+    OS_EXIT_CRITICAL(sr);
+
+    rc = 0;
+    while (1) {
+        if (timeout != OS_TIMEOUT_NEVER) {
+            elapsed = os_time_get() - start;
+        } else {
+            elapsed = 0;
+        }
+
+        /* Check and register as a waiter atomically; otherwise the writer
+         * could finish draining in between, see no waiters and never wake
+         * this task.
+         */
+        OS_ENTER_CRITICAL(sr);
+        if ((int32_t)(la_seq_done - target) >= 0) {
+            OS_EXIT_CRITICAL(sr);
+            break;
+        }
+        if (timeout != OS_TIMEOUT_NEVER && elapsed >= timeout) {
+            OS_EXIT_CRITICAL(sr);
+            rc = SYS_ETIMEOUT;
+            break;
+        }
+        la_sync_waiters++;
+        OS_EXIT_CRITICAL(sr);
+
+#if MYNEWT_VAL(SELFTEST)
+        if (log_async_sync_test_hook != NULL) {
+            log_async_sync_test_hook();
+        }
+#endif
+
+        /* Spurious wakeups left behind by timed out waiters are harmless;
+         * the loop condition is checked again.
+         */
+        os_sem_pend(&la_sync_sem, timeout == OS_TIMEOUT_NEVER ?
+                                  OS_TIMEOUT_NEVER : timeout - elapsed);
+
+        OS_ENTER_CRITICAL(sr);
+        la_sync_waiters--;
+        OS_EXIT_CRITICAL(sr);
+    }
+
+    return rc;
+}
+
+void
+log_async_stats_get(struct log_async_stats *stats)
+{
+    int sr;
+
+    OS_ENTER_CRITICAL(sr);
+    *stats = la_stats;
+    OS_EXIT_CRITICAL(sr);
+}
+
+void
+log_set_async(struct log *log, int async)
+{
+    /* Entries queued while the log was async are still written in order;
+     * make sure they land before anything written synchronously.
+     */
+    if (!async && log->l_async) {
+        log_async_sync(OS_TIMEOUT_NEVER);
+    }
+    log->l_async = !!async;
+}
+
+void
+log_async_init(void)
+{
+    int rc;
+
+    la_head = 0;
+    la_tail = 0;
+    la_end = 0;
+    la_wrapped = 0;
+    la_seq_queued = 0;
+    la_seq_done = 0;
+    la_sync_waiters = 0;
+    memset(&la_stats, 0, sizeof(la_stats));
+
+    rc = os_sem_init(&la_sem, 0);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+    rc = os_sem_init(&la_sync_sem, 0);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    rc = os_task_init(&la_task, "log_async", log_async_task, NULL,
+                      MYNEWT_VAL(LOG_ASYNC_TASK_PRIO), OS_WAIT_FOREVER,
+                      la_stack, MYNEWT_VAL(LOG_ASYNC_STACK_SIZE));
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+
+#endif
@@ -42,6 +42,21 @@ log_console_dump_cbor_entry(const void *dptr, uint16_t len)
     return 0;
 }
 
+#if MYNEWT_VAL(LOG_FMT)
+static void
+log_console_dump_fmt_entry(const struct log_entry_hdr *hdr, const void *body,
+                           uint16_t body_len)
+{
+    char text[LOG_PRINTF_MAX_ENTRY_LEN];
+    int rc;
+
+    rc = log_fmt_render(hdr, body, body_len, text, sizeof(text));
+    if (rc > 0) {
+        console_write(text, rc);
+    }
+}
+#endif
+
 static struct log log_console;
 
 struct log *
@@ -75,10 +90,18 @@ log_console_append_body(struct log *log, const struct log_entry_hdr *hdr,
         log_console_print_hdr(hdr);
     }
 
-    if (hdr->ue_etype != LOG_ETYPE_CBOR) {
-        console_write(body, body_len);
-    } else {
+    switch (hdr->ue_etype) {
+    case LOG_ETYPE_CBOR:
         log_console_dump_cbor_entry(body, body_len);
+        break;
+#if MYNEWT_VAL(LOG_FMT)
+    case LOG_ETYPE_FMT:
+        log_console_dump_fmt_entry(hdr, body, body_len);
+        break;
+#endif
+    default:
+        console_write(body, body_len);
+        break;
     }
     return (0);
 }
@@ -97,21 +97,283 @@ found_ent:
     return 0;
 }
 
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+struct log_fcb_sidx_ts_arg {
+    struct log *log;
+    int64_t max_ts;
+    int rc;
+};
+
+static bool
+log_fcb_sidx_usable(const struct fcb_log *fcb_log)
+{
+    return fcb_log->fl_fcb.f_sector_cnt <= MYNEWT_VAL(LOG_FCB_SECTOR_INDEX);
+}
+
+static void
+log_fcb_sidx_clear(struct fcb_log *fcb_log)
+{
+    memset(fcb_log->fl_sects, 0, sizeof(fcb_log->fl_sects));
+}
+
+/**
+ * Drops the cached summary of a sector.  Called once the sector has been
+ * erased.
+ */
+static void
+log_fcb_sidx_invalidate(struct fcb_log *fcb_log, const struct flash_area *fap)
+{
+    if (log_fcb_sidx_usable(fcb_log)) {
+        fcb_log->fl_sects[fap - fcb_log->fl_fcb.f_sectors].lfx_flags = 0;
+    }
+}
+
+static int
+log_fcb_sidx_first_cb(struct fcb_entry *loc, void *arg)
+{
+    *(struct fcb_entry *)arg = *loc;
+    return 1;
+}
+
+static int
+log_fcb_sidx_ts_cb(struct fcb_entry *loc, void *arg)
+{
+    struct log_fcb_sidx_ts_arg *ts_arg;
+    struct log_entry_hdr hdr;
+
+    ts_arg = arg;
+    ts_arg->rc = log_read_hdr(ts_arg->log, loc, &hdr);
+    if (ts_arg->rc != 0) {
+        return 1;
+    }
+    if (hdr.ue_ts > ts_arg->max_ts) {
+        ts_arg->max_ts = hdr.ue_ts;
+    }
+    return 0;
+}
+
+/**
+ * Retrieves the index of the first entry in a sector.  If 'loc' is not NULL,
+ * it is positioned at that entry; otherwise a cached index is used if there
+ * is one.  Must be called with the FCB mutex held.
+ *
+ * @return                      0 on success;
+ *                              SYS_ENOENT if the sector is empty;
+ *                              other error on failure.
+ */
+static int
+log_fcb_sidx_first(struct log *log, struct flash_area *fap,
+                   struct fcb_entry *loc, uint32_t *out_index)
+{
+    struct log_entry_hdr hdr;
+    struct log_fcb_sect *sect;
+    struct fcb_log *fcb_log;
+    struct fcb_entry entry;
+    struct fcb *fcb;
+    int rc;
+
+    fcb_log = log->l_arg;
+    fcb = &fcb_log->fl_fcb;
+    sect = &fcb_log->fl_sects[fap - fcb->f_sectors];
+
+    if (loc == NULL) {
+        if (sect->lfx_flags & LOG_FCB_SECT_F_INDEX) {
+            *out_index = sect->lfx_first_index;
+            return 0;
+        }
+        loc = &entry;
+    }
+
+    rc = fcb_walk(fcb, fap, log_fcb_sidx_first_cb, loc);
+    if (rc == 0) {
+        return SYS_ENOENT;
+    } else if (rc < 0) {
+        return SYS_EUNKNOWN;
+    }
+
+    rc = log_read_hdr(log, loc, &hdr);
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* The active sector may still receive entries ahead of an unfinished
+     * one; only sectors that are complete get cached.
+     */
+    if (fap != fcb->f_active.fe_area) {
+        sect->lfx_first_index = hdr.ue_index;
+        sect->lfx_flags |= LOG_FCB_SECT_F_INDEX;
+    }
+    *out_index = hdr.ue_index;
+
+    return 0;
+}
+
+/**
+ * Retrieves the newest timestamp in a sector, reading every entry of the
+ * sector unless the value is cached.  Must be called with the FCB mutex
+ * held.
+ */
+static int
+log_fcb_sidx_max_ts(struct log *log, struct flash_area *fap, int64_t *out_ts)
+{
+    struct log_fcb_sidx_ts_arg ts_arg;
+    struct log_fcb_sect *sect;
+    struct fcb_log *fcb_log;
+    struct fcb *fcb;
+    int rc;
+
+    fcb_log = log->l_arg;
+    fcb = &fcb_log->fl_fcb;
+    sect = &fcb_log->fl_sects[fap - fcb->f_sectors];
+
+    if (sect->lfx_flags & LOG_FCB_SECT_F_TS) {
+        *out_ts = sect->lfx_max_ts;
+        return 0;
+    }
+
+    ts_arg.log = log;
+    ts_arg.max_ts = INT64_MIN;
+    ts_arg.rc = 0;
+    rc = fcb_walk(fcb, fap, log_fcb_sidx_ts_cb, &ts_arg);
+    if (ts_arg.rc != 0) {
+        return ts_arg.rc;
+    }
+    if (rc < 0) {
+        return SYS_EUNKNOWN;
+    }
+
+    if (fap != fcb->f_active.fe_area) {
+        sect->lfx_max_ts = ts_arg.max_ts;
+        sect->lfx_flags |= LOG_FCB_SECT_F_TS;
+    }
+    *out_ts = ts_arg.max_ts;
+
+    return 0;
+}
+
+/**
+ * Uses the sector index to find a starting point for a walk: the first entry
+ * of the newest sector whose first index is <= the requested index.  The
+ * sectors are binary-searched, so only a logarithmic number of entry headers
+ * is read.  If a timestamp is requested, sectors holding only older entries
+ * are skipped as well.
+ *
+ * @param log                   The log to search.
+ * @param log_offset            The requested index and timestamp.
+ * @param out_entry             On success, the first entry of the sector.
+ * @param out_index             On success, the index of that entry.
+ *
+ * @return                      0 on success;
+ *                              SYS_ENOTSUP if the log has too many sectors
+ *                                  for the index;
+ *                              SYS_ENOENT if no sector can hold a match;
+ *                              other error on failure.
+ */
+static int
+log_fcb_sidx_seek(struct log *log, const struct log_offset *log_offset,
+                  struct fcb_entry *out_entry, uint32_t *out_index)
+{
+    struct flash_area *fap;
+    struct fcb_log *fcb_log;
+    struct fcb *fcb;
+    uint32_t index;
+    int64_t max_ts;
+    int oldest;
+    int cnt;
+    int lo;
+    int hi;
+    int mid;
+    int rc;
+
+    fcb_log = log->l_arg;
+    fcb = &fcb_log->fl_fcb;
+
+    if (!log_fcb_sidx_usable(fcb_log)) {
+        return SYS_ENOTSUP;
+    }
+
+    /* Hold the FCB lock so that no sector is erased while it is examined. */
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return SYS_EUNKNOWN;
+    }
+
+    /* Number of sectors in use, from the oldest up to the active one. */
+    oldest = fcb->f_oldest - fcb->f_sectors;
+    cnt = fcb->f_active.fe_area - fcb->f_oldest;
+    if (cnt < 0) {
+        cnt += fcb->f_sector_cnt;
+    }
+    cnt++;
+
+    lo = 0;
+    hi = cnt - 1;
+    while (lo < hi) {
+        mid = (lo + hi + 1) / 2;
+        fap = &fcb->f_sectors[(oldest + mid) % fcb->f_sector_cnt];
+        rc = log_fcb_sidx_first(log, fap, NULL, &index);
+        if (rc == SYS_ENOENT) {
+            /* Empty sector; start the walk before it. */
+            hi = mid - 1;
+            continue;
+        } else if (rc != 0) {
+            goto done;
+        }
+
+        if (index <= log_offset->lo_index) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    /* Timestamps are not guaranteed to be monotonic (the clock can be set
+     * back), so sectors are checked one at a time here.  This costs a single
+     * scan per sector; the results are cached.
+     */
+    if (log_offset->lo_ts > 0) {
+        for (; lo < cnt - 1; lo++) {
+            fap = &fcb->f_sectors[(oldest + lo) % fcb->f_sector_cnt];
+            rc = log_fcb_sidx_max_ts(log, fap, &max_ts);
+            if (rc != 0) {
+                goto done;
+            }
+            if (max_ts >= log_offset->lo_ts) {
+                break;
+            }
+        }
+    }
+
+    fap = &fcb->f_sectors[(oldest + lo) % fcb->f_sector_cnt];
+    rc = log_fcb_sidx_first(log, fap, out_entry, out_index);
+
+done:
+    os_mutex_release(&fcb->f_mtx);
+    return rc;
+}
+#endif
+
 /**
  * Finds the first log entry whose "offset" is >= the one specified.  A log
  * offset consists of two parts:
  *     o timestamp
  *     o index
  *
- * The "timestamp" field is misnamed.  If it has a value of -1, then the offset
- * always points to the latest entry.  If this value is not -1, then it is
- * ignored; the "index" field is used instead.
+ * If the timestamp has a value of -1, then the offset always points to the
+ * latest entry.  A timestamp of 0 is ignored; the "index" field is used
+ * instead.
  *
- * XXX: We should rename "timestamp" or make it an actual timestamp.
+ * A positive timestamp is only used as a filter on whole sectors, and only
+ * if the sector index is enabled: the search skips sectors whose entries are
+ * all older than it.  Entries are not filtered by timestamp; the walk
+ * continues past the starting point regardless of entry timestamps.  Without
+ * the sector index, a positive timestamp is ignored as well.
  *
  * The "index" field corresponds to a log entry index.
  *
- * If bookmarks are enabled, this function uses them in the search.
+ * If bookmarks are enabled, this function uses them in the search.  If the
+ * sector index is enabled, the walk starts no earlier than the sector found
+ * by binary search on the index.
  *
  * @return                      0 if an entry was found
  *                              SYS_ENOENT if there are no suitable entries.
@@ -123,12 +385,16 @@ log_fcb_find_gte(struct log *log, struct log_offset *log_offset,
 {
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     const struct log_fcb_bmark *bmark;
+#endif
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    uint32_t seek_index;
 #endif
     struct log_entry_hdr hdr;
     struct fcb_log *fcb_log;
     struct fcb *fcb;
     int rc;
     bool bmark_found = false;
+    bool seek_found = false;
 
     fcb_log = log->l_arg;
     fcb = &fcb_log->fl_fcb;
@@ -161,8 +427,25 @@ log_fcb_find_gte(struct log *log, struct log_offset *log_offset,
         return SYS_ENOENT;
     }
 
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    if (log_offset->lo_index != 0 || log_offset->lo_ts > 0) {
+        rc = log_fcb_sidx_seek(log, log_offset, out_entry, &seek_index);
+        if (rc == 0) {
+            seek_found = true;
+        } else if (rc != SYS_ENOTSUP && rc != SYS_ENOENT) {
+            return rc;
+        }
+    }
+#endif
+
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     bmark = log_fcb_closest_bmark(fcb_log, log_offset->lo_index);
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    /* Only use a bookmark that lies beyond the sector the index found. */
+    if (bmark != NULL && seek_found && bmark->lfb_index < seek_index) {
+        bmark = NULL;
+    }
+#endif
     if (bmark != NULL) {
         *out_entry = bmark->lfb_entry;
         bmark_found = true;
@@ -177,7 +460,8 @@ log_fcb_find_gte(struct log *log, struct log_offset *log_offset,
      * GTE to any random non-zero value. If bookmark is set, it is expected
      * that the log is walked from there.
      */
-    if ((bmark_found == false) && (log_offset->lo_index != 0)) {
+    if ((bmark_found == false) && (seek_found == false) &&
+        (log_offset->lo_index != 0)) {
         rc = fcb_walk_back_find_start(fcb, log, log_offset, out_entry);
         if (rc != 0) {
             return rc;
@@ -256,6 +540,10 @@ log_fcb_start_append(struct log *log, int len, struct fcb_entry *loc)
             goto err;
         }
 
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+        log_fcb_sidx_invalidate(fcb_log, old_fa);
+#endif
+
 #if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
         /*
          * FCB was rotated successfully so let's check if watermark was within
@@ -599,8 +887,11 @@ log_fcb_walk_impl(struct log *log, log_walk_func_t walk_func,
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     /* If a minimum index was specified (i.e., we are not just retrieving the
      * last entry), add a bookmark pointing to this walk's start location.
+     * A start that the sector index advanced by timestamp says nothing about
+     * the index, so it is not bookmarked.
      */
-    if (log_offset->lo_ts >= 0) {
+    if (log_offset->lo_ts == 0 ||
+        (log_offset->lo_ts > 0 && !MYNEWT_VAL(LOG_FCB_SECTOR_INDEX))) {
         log_fcb_add_bmark(fcb_log, &loc, log_offset->lo_index);
     }
 #endif
@@ -644,6 +935,7 @@ log_fcb_flush(struct log *log)
 {
     struct fcb_log *fcb_log;
     struct fcb *fcb;
+    int rc;
 
     fcb_log = (struct fcb_log *)log->l_arg;
     fcb = &fcb_log->fl_fcb;
@@ -652,12 +944,21 @@ log_fcb_flush(struct log *log)
     log_fcb_clear_bmarks(fcb_log);
 #endif
 
-    return fcb_clear(fcb);
+    rc = fcb_clear(fcb);
+
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    log_fcb_sidx_clear(fcb_log);
+#endif
+
+    return rc;
 }
 
 static int
 log_fcb_registered(struct log *log)
 {
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    log_fcb_sidx_clear(log->l_arg);
+#endif
 #if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
     struct fcb_log *fl;
 #if MYNEWT_VAL(LOG_PERSIST_WATERMARK)
@@ -32,21 +32,281 @@
 
 static int log_fcb2_rtr_erase(struct log *log);
 
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+struct log_fcb2_sidx_ts_arg {
+    struct log *log;
+    int64_t max_ts;
+    int rc;
+};
+
+static bool
+log_fcb2_sidx_usable(const struct fcb_log *fcb_log)
+{
+    return fcb_log->fl_fcb.f_sector_cnt <= MYNEWT_VAL(LOG_FCB_SECTOR_INDEX);
+}
+
+static void
+log_fcb2_sidx_clear(struct fcb_log *fcb_log)
+{
+    memset(fcb_log->fl_sects, 0, sizeof(fcb_log->fl_sects));
+}
+
+/**
+ * Drops the cached summary of a sector.  Called once the sector has been
+ * erased.
+ */
+static void
+log_fcb2_sidx_invalidate(struct fcb_log *fcb_log, int sector)
+{
+    if (log_fcb2_sidx_usable(fcb_log)) {
+        fcb_log->fl_sects[sector].lfx_flags = 0;
+    }
+}
+
+static int
+log_fcb2_sidx_first_cb(struct fcb2_entry *loc, void *arg)
+{
+    *(struct fcb2_entry *)arg = *loc;
+    return 1;
+}
+
+static int
+log_fcb2_sidx_ts_cb(struct fcb2_entry *loc, void *arg)
+{
+    struct log_fcb2_sidx_ts_arg *ts_arg;
+    struct log_entry_hdr hdr;
+
+    ts_arg = arg;
+    ts_arg->rc = log_read_hdr(ts_arg->log, loc, &hdr);
+    if (ts_arg->rc != 0) {
+        return 1;
+    }
+    if (hdr.ue_ts > ts_arg->max_ts) {
+        ts_arg->max_ts = hdr.ue_ts;
+    }
+    return 0;
+}
+
+/**
+ * Retrieves the index of the first entry in a sector.  If 'loc' is not NULL,
+ * it is positioned at that entry; otherwise a cached index is used if there
+ * is one.  Must be called with the FCB mutex held.
+ *
+ * @return                      0 on success;
+ *                              SYS_ENOENT if the sector is empty;
+ *                              other error on failure.
+ */
+static int
+log_fcb2_sidx_first(struct log *log, int sector, struct fcb2_entry *loc,
+                    uint32_t *out_index)
+{
+    struct log_entry_hdr hdr;
+    struct log_fcb_sect *sect;
+    struct fcb_log *fcb_log;
+    struct fcb2_entry entry;
+    struct fcb2 *fcb;
+    int rc;
+
+    fcb_log = log->l_arg;
+    fcb = &fcb_log->fl_fcb;
+    sect = &fcb_log->fl_sects[sector];
+
+    if (loc == NULL) {
+        if (sect->lfx_flags & LOG_FCB_SECT_F_INDEX) {
+            *out_index = sect->lfx_first_index;
+            return 0;
+        }
+        loc = &entry;
+    }
+
+    rc = fcb2_walk(fcb, sector, log_fcb2_sidx_first_cb, loc);
+    if (rc == 0) {
+        return SYS_ENOENT;
+    } else if (rc < 0) {
+        return SYS_EUNKNOWN;
+    }
+
+    rc = log_read_hdr(log, loc, &hdr);
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* The active sector may still receive entries ahead of an unfinished
+     * one; only sectors that are complete get cached.
+     */
+    if (sector != fcb->f_active.fe_sector) {
+        sect->lfx_first_index = hdr.ue_index;
+        sect->lfx_flags |= LOG_FCB_SECT_F_INDEX;
+    }
+    *out_index = hdr.ue_index;
+
+    return 0;
+}
+
+/**
+ * Retrieves the newest timestamp in a sector, reading every entry of the
+ * sector unless the value is cached.  Must be called with the FCB mutex
+ * held.
+ */
+static int
+log_fcb2_sidx_max_ts(struct log *log, int sector, int64_t *out_ts)
+{
+    struct log_fcb2_sidx_ts_arg ts_arg;
+    struct log_fcb_sect *sect;
+    struct fcb_log *fcb_log;
+    struct fcb2 *fcb;
+    int rc;
+
+    fcb_log = log->l_arg;
+    fcb = &fcb_log->fl_fcb;
+    sect = &fcb_log->fl_sects[sector];
+
+    if (sect->lfx_flags & LOG_FCB_SECT_F_TS) {
+        *out_ts = sect->lfx_max_ts;
+        return 0;
+    }
+
+    ts_arg.log = log;
+    ts_arg.max_ts = INT64_MIN;
+    ts_arg.rc = 0;
+    rc = fcb2_walk(fcb, sector, log_fcb2_sidx_ts_cb, &ts_arg);
+    if (ts_arg.rc != 0) {
+        return ts_arg.rc;
+    }
+    if (rc < 0) {
+        return SYS_EUNKNOWN;
+    }
+
+    if (sector != fcb->f_active.fe_sector) {
+        sect->lfx_max_ts = ts_arg.max_ts;
+        sect->lfx_flags |= LOG_FCB_SECT_F_TS;
+    }
+    *out_ts = ts_arg.max_ts;
+
+    return 0;
+}
+
+/**
+ * Uses the sector index to find a starting point for a walk: the first entry
+ * of the newest sector whose first index is <= the requested index.  The
+ * sectors are binary-searched, so only a logarithmic number of entry headers
+ * is read.  If a timestamp is requested, sectors holding only older entries
+ * are skipped as well.
+ *
+ * @param log                   The log to search.
+ * @param log_offset            The requested index and timestamp.
+ * @param out_entry             On success, the first entry of the sector.
+ * @param out_index             On success, the index of that entry.
+ *
+ * @return                      0 on success;
+ *                              SYS_ENOTSUP if the log has too many sectors
+ *                                  for the index;
+ *                              SYS_ENOENT if no sector can hold a match;
+ *                              other error on failure.
+ */
+static int
+log_fcb2_sidx_seek(struct log *log, const struct log_offset *log_offset,
+                  struct fcb2_entry *out_entry, uint32_t *out_index)
+{
+    struct fcb_log *fcb_log;
+    struct fcb2 *fcb;
+    uint32_t index;
+    int64_t max_ts;
+    int sector;
+    int cnt;
+    int lo;
+    int hi;
+    int mid;
+    int rc;
+
+    fcb_log = log->l_arg;
+    fcb = &fcb_log->fl_fcb;
+
+    if (!log_fcb2_sidx_usable(fcb_log)) {
+        return SYS_ENOTSUP;
+    }
+
+    /* Hold the FCB lock so that no sector is erased while it is examined. */
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return SYS_EUNKNOWN;
+    }
+
+    /* Number of sectors in use, from the oldest up to the active one. */
+    cnt = fcb->f_active.fe_sector - fcb->f_oldest_sec;
+    if (cnt < 0) {
+        cnt += fcb->f_sector_cnt;
+    }
+    cnt++;
+
+    lo = 0;
+    hi = cnt - 1;
+    while (lo < hi) {
+        mid = (lo + hi + 1) / 2;
+        sector = (fcb->f_oldest_sec + mid) % fcb->f_sector_cnt;
+        rc = log_fcb2_sidx_first(log, sector, NULL, &index);
+        if (rc == SYS_ENOENT) {
+            /* Empty sector; start the walk before it. */
+            hi = mid - 1;
+            continue;
+        } else if (rc != 0) {
+            goto done;
+        }
+
+        if (index <= log_offset->lo_index) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    /* Timestamps are not guaranteed to be monotonic (the clock can be set
+     * back), so sectors are checked one at a time here.  This costs a single
+     * scan per sector; the results are cached.
+     */
+    if (log_offset->lo_ts > 0) {
+        for (; lo < cnt - 1; lo++) {
+            sector = (fcb->f_oldest_sec + lo) % fcb->f_sector_cnt;
+            rc = log_fcb2_sidx_max_ts(log, sector, &max_ts);
+            if (rc != 0) {
+                goto done;
+            }
+            if (max_ts >= log_offset->lo_ts) {
+                break;
+            }
+        }
+    }
+
+    sector = (fcb->f_oldest_sec + lo) % fcb->f_sector_cnt;
+    rc = log_fcb2_sidx_first(log, sector, out_entry, out_index);
+
+done:
+    os_mutex_release(&fcb->f_mtx);
+    return rc;
+}
+#endif
+
 /**
  * Finds the first log entry whose "offset" is >= the one specified.  A log
  * offset consists of two parts:
  *     o timestamp
  *     o index
  *
- * The "timestamp" field is misnamed.  If it has a value of -1, then the offset
- * always points to the latest entry.  If this value is not -1, then it is
- * ignored; the "index" field is used instead.
+ * If the timestamp has a value of -1, then the offset always points to the
+ * latest entry.  A timestamp of 0 is ignored; the "index" field is used
+ * instead.
  *
- * XXX: We should rename "timestamp" or make it an actual timestamp.
+ * A positive timestamp is only used as a filter on whole sectors, and only
+ * if the sector index is enabled: the search skips sectors whose entries are
+ * all older than it.  Entries are not filtered by timestamp; the walk
+ * continues past the starting point regardless of entry timestamps.  Without
+ * the sector index, a positive timestamp is ignored as well.
  *
  * The "index" field corresponds to a log entry index.
  *
- * If bookmarks are enabled, this function uses them in the search.
+ * If bookmarks are enabled, this function uses them in the search.  If the
+ * sector index is enabled, the walk starts no earlier than the sector found
+ * by binary search on the index.
  *
  * @return                      0 if an entry was found
  *                              SYS_ENOENT if there are no suitable entries.
@@ -58,6 +318,9 @@ log_fcb2_find_gte(struct log *log, struct log_offset *log_offset,
 {
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     const struct log_fcb_bmark *bmark;
+#endif
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    uint32_t seek_index = 0;
 #endif
     struct log_entry_hdr hdr;
     struct fcb_log *fcb_log;
@@ -102,8 +365,30 @@ log_fcb2_find_gte(struct log *log, struct log_offset *log_offset,
     if (rc != 0) {
         return SYS_EUNKNOWN;
     }
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    if (log_offset->lo_index != 0 || log_offset->lo_ts > 0) {
+        rc = log_fcb2_sidx_seek(log, log_offset, out_entry, &seek_index);
+        if (rc == SYS_ENOTSUP || rc == SYS_ENOENT) {
+            /* Fall back to a scan from the beginning. */
+            seek_index = 0;
+            memset(out_entry, 0, sizeof(*out_entry));
+            rc = fcb2_getnext(fcb, out_entry);
+            if (rc != 0) {
+                return SYS_EUNKNOWN;
+            }
+        } else if (rc != 0) {
+            return rc;
+        }
+    }
+#endif
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     bmark = log_fcb_closest_bmark(fcb_log, log_offset->lo_index);
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    /* Only use a bookmark that lies beyond the sector the index found. */
+    if (bmark != NULL && bmark->lfb_index < seek_index) {
+        bmark = NULL;
+    }
+#endif
     if (bmark != NULL) {
         *out_entry = bmark->lfb_entry;
     }
@@ -129,7 +414,7 @@ log_fcb2_start_append(struct log *log, int len, struct fcb2_entry *loc)
 {
     struct fcb2 *fcb;
     struct fcb_log *fcb_log;
-#if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
+#if MYNEWT_VAL(LOG_STORAGE_WATERMARK) || MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
     int old_sec;
 #endif
     int rc = 0;
@@ -158,7 +443,7 @@ log_fcb2_start_append(struct log *log, int len, struct fcb2_entry *loc)
             continue;
         }
 
-#if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
+#if MYNEWT_VAL(LOG_STORAGE_WATERMARK) || MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
         old_sec = fcb->f_oldest_sec;
 #endif
 
@@ -179,6 +464,10 @@ log_fcb2_start_append(struct log *log, int len, struct fcb2_entry *loc)
             goto err;
         }
 
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+        log_fcb2_sidx_invalidate(fcb_log, old_sec);
+#endif
+
 #if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
         /*
          * FCB was rotated successfully so let's check if watermark was within
@@ -496,8 +785,11 @@ log_fcb2_walk(struct log *log, log_walk_func_t walk_func,
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     /* If a minimum index was specified (i.e., we are not just retrieving the
      * last entry), add a bookmark pointing to this walk's start location.
+     * A start that the sector index advanced by timestamp says nothing about
+     * the index, so it is not bookmarked.
      */
-    if (log_off->lo_ts >= 0) {
+    if (log_off->lo_ts == 0 ||
+        (log_off->lo_ts > 0 && !MYNEWT_VAL(LOG_FCB_SECTOR_INDEX))) {
         log_fcb_add_bmark(fcb_log, &loc, log_off->lo_index);
     }
 #endif
@@ -521,6 +813,7 @@ log_fcb2_flush(struct log *log)
 {
     struct fcb_log *fcb_log;
     struct fcb2 *fcb;
+    int rc;
 
     fcb_log = (struct fcb_log *)log->l_arg;
     fcb = &fcb_log->fl_fcb;
@@ -529,7 +822,13 @@ log_fcb2_flush(struct log *log)
     log_fcb_clear_bmarks(fcb_log);
 #endif
 
-    return fcb2_clear(fcb);
+    rc = fcb2_clear(fcb);
+
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    log_fcb2_sidx_clear(fcb_log);
+#endif
+
+    return rc;
 }
 
 static int
@@ -553,6 +852,10 @@ log_fcb2_registered(struct log *log)
         }
     }
 
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    log_fcb2_sidx_clear(fl);
+#endif
+
 #if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
 #if MYNEWT_VAL(LOG_PERSIST_WATERMARK)
     /* Set watermark to first element */
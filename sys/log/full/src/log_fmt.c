@@ -0,0 +1,599 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_FMT)
+
+#include <stdio.h>
+#include <string.h>
+
+#include "log/log.h"
+
+/* How the argument of a conversion is packed. */
+#define LOG_FMT_ARG_NONE        0   /* "%%"; no argument. */
+#define LOG_FMT_ARG_INT         1
+#define LOG_FMT_ARG_LONG        2
+#define LOG_FMT_ARG_LLONG       3
+#define LOG_FMT_ARG_INTMAX      4
+#define LOG_FMT_ARG_SIZE        5
+#define LOG_FMT_ARG_PTRDIFF     6
+#define LOG_FMT_ARG_PTR         7
+#define LOG_FMT_ARG_DOUBLE      8
+#define LOG_FMT_ARG_STR         9
+#define LOG_FMT_ARG_BAD         10  /* Unsupported; stops processing. */
+
+struct log_fmt_spec {
+    /* Points to the '%' introducing the conversion. */
+    const char *lfs_start;
+    uint8_t lfs_len;
+    uint8_t lfs_arg;
+    /* Number of '*' width / precision arguments preceding the value. */
+    uint8_t lfs_stars;
+};
+
+/**
+ * Finds the next conversion in a format string.
+ *
+ * @return                      The first character after the conversion;
+ *                              NULL if there are no more conversions.
+ */
+static const char *
+log_fmt_next(const char *fmt, struct log_fmt_spec *spec)
+{
+    const char *p;
+    int lmod;
+
+    p = strchr(fmt, '%');
+    if (p == NULL) {
+        return NULL;
+    }
+
+    spec->lfs_start = p++;
+    spec->lfs_stars = 0;
+
+    while (*p != '\0' && strchr("-+ #0", *p) != NULL) {
+        p++;
+    }
+    if (*p == '*') {
+        spec->lfs_stars++;
+        p++;
+    } else {
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->lfs_stars++;
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') {
+                p++;
+            }
+        }
+    }
+
+    lmod = 0;
+    switch (*p) {
+    case 'h':
+        p++;
+        if (*p == 'h') {
+            p++;
+        }
+        break;
+    case 'l':
+        p++;
+        lmod = LOG_FMT_ARG_LONG;
+        if (*p == 'l') {
+            p++;
+            lmod = LOG_FMT_ARG_LLONG;
+        }
+        break;
+    case 'j':
+        p++;
+        lmod = LOG_FMT_ARG_INTMAX;
+        break;
+    case 'z':
+        p++;
+        lmod = LOG_FMT_ARG_SIZE;
+        break;
+    case 't':
+        p++;
+        lmod = LOG_FMT_ARG_PTRDIFF;
+        break;
+    case 'L':
+        p++;
+        lmod = LOG_FMT_ARG_BAD;
+        break;
+    }
+
+    switch (*p) {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+    case 'c':
+        spec->lfs_arg = lmod ? lmod : LOG_FMT_ARG_INT;
+        break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        spec->lfs_arg = lmod ? LOG_FMT_ARG_BAD : LOG_FMT_ARG_DOUBLE;
+        break;
+    case 'p':
+        spec->lfs_arg = LOG_FMT_ARG_PTR;
+        break;
+    case 's':
+        spec->lfs_arg = lmod ? LOG_FMT_ARG_BAD : LOG_FMT_ARG_STR;
+        break;
+    case '%':
+        spec->lfs_arg = LOG_FMT_ARG_NONE;
+        break;
+    default:
+        spec->lfs_arg = LOG_FMT_ARG_BAD;
+        break;
+    }
+
+    if (*p != '\0') {
+        p++;
+    }
+    spec->lfs_len = p - spec->lfs_start;
+
+    return p;
+}
+
+static int
+log_fmt_put(uint8_t *buf, int *off, int buf_len, const void *val, int len)
+{
+    if (*off + len > buf_len) {
+        return -1;
+    }
+
+    memcpy(buf + *off, val, len);
+    *off += len;
+
+    return 0;
+}
+
+static int
+log_fmt_get(const uint8_t *body, int *off, int body_len, void *val, int len)
+{
+    if (*off + len > body_len) {
+        return -1;
+    }
+
+    memcpy(val, body + *off, len);
+    *off += len;
+
+    return 0;
+}
+
+int
+log_fmt_encode(void *buf, int buf_len, const char *fmt, va_list ap)
+{
+    struct log_fmt_spec spec;
+    const char *s;
+    long long ll;
+    intmax_t im;
+    ptrdiff_t pd;
+    double d;
+    size_t sz;
+    void *ptr;
+    long l;
+    int off;
+    int rc;
+    int v;
+    int i;
+
+    off = 0;
+    rc = log_fmt_put(buf, &off, buf_len, &fmt, sizeof(fmt));
+    if (rc != 0) {
+        return 0;
+    }
+
+    while ((fmt = log_fmt_next(fmt, &spec)) != NULL) {
+        for (i = 0; i < spec.lfs_stars; i++) {
+            v = va_arg(ap, int);
+            rc = log_fmt_put(buf, &off, buf_len, &v, sizeof(v));
+            if (rc != 0) {
+                return off;
+            }
+        }
+
+        switch (spec.lfs_arg) {
+        case LOG_FMT_ARG_NONE:
+            break;
+        case LOG_FMT_ARG_INT:
+            v = va_arg(ap, int);
+            rc = log_fmt_put(buf, &off, buf_len, &v, sizeof(v));
+            break;
+        case LOG_FMT_ARG_LONG:
+            l = va_arg(ap, long);
+            rc = log_fmt_put(buf, &off, buf_len, &l, sizeof(l));
+            break;
+        case LOG_FMT_ARG_LLONG:
+            ll = va_arg(ap, long long);
+            rc = log_fmt_put(buf, &off, buf_len, &ll, sizeof(ll));
+            break;
+        case LOG_FMT_ARG_INTMAX:
+            im = va_arg(ap, intmax_t);
+            rc = log_fmt_put(buf, &off, buf_len, &im, sizeof(im));
+            break;
+        case LOG_FMT_ARG_SIZE:
+            sz = va_arg(ap, size_t);
+            rc = log_fmt_put(buf, &off, buf_len, &sz, sizeof(sz));
+            break;
+        case LOG_FMT_ARG_PTRDIFF:
+            pd = va_arg(ap, ptrdiff_t);
+            rc = log_fmt_put(buf, &off, buf_len, &pd, sizeof(pd));
+            break;
+        case LOG_FMT_ARG_PTR:
+            ptr = va_arg(ap, void *);
+            rc = log_fmt_put(buf, &off, buf_len, &ptr, sizeof(ptr));
+            break;
+        case LOG_FMT_ARG_DOUBLE:
+            d = va_arg(ap, double);
+            rc = log_fmt_put(buf, &off, buf_len, &d, sizeof(d));
+            break;
+        case LOG_FMT_ARG_STR:
+            /* Strings are copied; the pointer may be stale by the time the
+             * entry is rendered.  Truncate to whatever space is left.
+             */
+            s = va_arg(ap, const char *);
+            if (s == NULL) {
+                s = "(null)";
+            }
+            if (off >= buf_len) {
+                return off;
+            }
+            sz = strnlen(s, buf_len - off - 1);
+            memcpy((uint8_t *)buf + off, s, sz);
+            off += sz;
+            ((uint8_t *)buf)[off++] = '\0';
+            break;
+        default:
+            return off;
+        }
+
+        if (rc != 0) {
+            return off;
+        }
+    }
+
+    return off;
+}
+
+/**
+ * Appends at most `len` characters of `src` to the output buffer, keeping it
+ * NUL terminated.
+ */
+static void
+log_fmt_out(char *buf, int buf_len, int *out, const char *src, int len)
+{
+    int room;
+
+    room = buf_len - 1 - *out;
+    if (len > room) {
+        len = room;
+    }
+    if (len > 0) {
+        memcpy(buf + *out, src, len);
+        *out += len;
+    }
+    buf[*out] = '\0';
+}
+
+/**
+ * Renders one conversion whose argument is stored at `body + *off`.
+ *
+ * @return                      0 on success; -1 if the argument is missing
+ *                                  from the entry.
+ */
+static int
+log_fmt_render_one(const struct log_fmt_spec *spec, const uint8_t *body,
+                   int *off, int body_len, char *buf, int buf_len, int *out)
+{
+    char conv[24];
+    const char *s;
+    const char *c;
+    long long ll;
+    intmax_t im;
+    ptrdiff_t pd;
+    double d;
+    size_t sz;
+    void *ptr;
+    long l;
+    int clen;
+    int room;
+    int v;
+    int n;
+
+    /* Copy the conversion, replacing '*' with the stored values. */
+    clen = 0;
+    for (c = spec->lfs_start; c < spec->lfs_start + spec->lfs_len; c++) {
+        if (*c == '*') {
+            if (log_fmt_get(body, off, body_len, &v, sizeof(v))) {
+                return -1;
+            }
+            n = snprintf(conv + clen, sizeof(conv) - clen, "%d", v);
+        } else {
+            n = snprintf(conv + clen, sizeof(conv) - clen, "%c", *c);
+        }
+        if (n < 0 || clen + n >= sizeof(conv)) {
+            return -1;
+        }
+        clen += n;
+    }
+
+    room = buf_len - *out;
+    switch (spec->lfs_arg) {
+    case LOG_FMT_ARG_NONE:
+        n = snprintf(buf + *out, room, "%%");
+        break;
+    case LOG_FMT_ARG_INT:
+        if (log_fmt_get(body, off, body_len, &v, sizeof(v))) {
+            return -1;
+        }
+        n = snprintf(buf + *out, room, conv, v);
+        break;
+    case LOG_FMT_ARG_LONG:
+        if (log_fmt_get(body, off, body_len, &l, sizeof(l))) {
+            return -1;
+        }
+        n = snprintf(buf + *out, room, conv, l);
+        break;
+    case LOG_FMT_ARG_LLONG:
+        if (log_fmt_get(body, off, body_len, &ll, sizeof(ll))) {
+            return -1;
+        }
+        n = snprintf(buf + *out, room, conv, ll);
+        break;
+    case LOG_FMT_ARG_INTMAX:
+        if (log_fmt_get(body, off, body_len, &im, sizeof(im))) {
+            return -1;
+        }
+        n = snprintf(buf + *out, room, conv, im);
+        break;
+    case LOG_FMT_ARG_SIZE:
+        if (log_fmt_get(body, off, body_len, &sz, sizeof(sz))) {
+            return -1;
+        }
+        n = snprintf(buf + *out, room, conv, sz);
+        break;
+    case LOG_FMT_ARG_PTRDIFF:
+        if (log_fmt_get(body, off, body_len, &pd, sizeof(pd))) {
+            return -1;
+        }
+        n = snprintf(buf + *out, room, conv, pd);
+        break;
+    case LOG_FMT_ARG_PTR:
+        if (log_fmt_get(body, off, body_len, &ptr, sizeof(ptr))) {
+            return -1;
+        }
+        n = snprintf(buf + *out, room, conv, ptr);
+        break;
+    case LOG_FMT_ARG_DOUBLE:
+        if (log_fmt_get(body, off, body_len, &d, sizeof(d))) {
+            return -1;
+        }
+        n = snprintf(buf + *out, room, conv, d);
+        break;
+    case LOG_FMT_ARG_STR:
+        s = (const char *)body + *off;
+        sz = strnlen(s, body_len - *off);
+        if (sz == body_len - *off) {
+            return -1;
+        }
+        *off += sz + 1;
+        n = snprintf(buf + *out, room, conv, s);
+        break;
+    default:
+        return -1;
+    }
+
+    if (n > 0) {
+        *out += min(n, room - 1);
+    }
+
+    return 0;
+}
+
+int __attribute__((weak))
+log_fmt_image_range(uintptr_t *out_start, uintptr_t *out_end)
+{
+#ifdef ARCH_sim
+    /* Default host linker script; .rodata follows .text. */
+    extern char __executable_start;
+    extern char edata;
+
+    *out_start = (uintptr_t)&__executable_start;
+    *out_end = (uintptr_t)&edata;
+#else
+    /* Most BSP linker scripts place .rodata between __text and __etext.
+     * Some do not define __text; the weak references are then NULL.
+     */
+    extern char __text __attribute__((weak));
+    extern char __etext __attribute__((weak));
+
+    if (&__text == NULL || &__etext == NULL) {
+        return SYS_ENOTSUP;
+    }
+    *out_start = (uintptr_t)&__text;
+    *out_end = (uintptr_t)&__etext;
+#endif
+
+    return 0;
+}
+
+/**
+ * Checks that a NUL terminated string at `addr` lies within the read-only
+ * data of the running image.
+ */
+static bool
+log_fmt_addr_in_image(const char *addr)
+{
+    uintptr_t start;
+    uintptr_t end;
+
+    if (log_fmt_image_range(&start, &end) != 0) {
+        return false;
+    }
+
+    if ((uintptr_t)addr < start || (uintptr_t)addr >= end) {
+        return false;
+    }
+
+    return strnlen(addr, end - (uintptr_t)addr) < end - (uintptr_t)addr;
+}
+
+/**
+ * Tells whether the format string address stored in an entry can be
+ * dereferenced.  It is only meaningful in the image that wrote the entry, so
+ * the entry has to carry the hash of the running image.
+ */
+static bool
+log_fmt_addr_usable(const struct log_entry_hdr *hdr, const char *fmt)
+{
+#if MYNEWT_VAL(LOG_FLAGS_IMAGE_HASH)
+    struct log_entry_hdr cur;
+
+    if (!(hdr->ue_flags & LOG_FLAGS_IMG_HASH)) {
+        return false;
+    }
+    if (log_fill_current_img_hash(&cur) != 0) {
+        return false;
+    }
+    if (memcmp(cur.ue_imghash, hdr->ue_imghash, LOG_IMG_HASHLEN) != 0) {
+        return false;
+    }
+
+    return log_fmt_addr_in_image(fmt);
+#else
+    return false;
+#endif
+}
+
+/**
+ * Renders an entry without its format string: the format string address
+ * followed by the stored arguments in hex.
+ */
+static int
+log_fmt_render_raw(const char *fmt, const uint8_t *body, int off,
+                   int body_len, char *buf, int buf_len)
+{
+    char tmp[24];
+    int out;
+    int n;
+
+    out = 0;
+    buf[0] = '\0';
+
+    n = snprintf(tmp, sizeof(tmp), "fmt@%p:", fmt);
+    if (n > 0) {
+        log_fmt_out(buf, buf_len, &out, tmp, n);
+    }
+    for (; off < body_len; off++) {
+        n = snprintf(tmp, sizeof(tmp), " %02x", body[off]);
+        log_fmt_out(buf, buf_len, &out, tmp, n);
+    }
+
+    return out;
+}
+
+int
+log_fmt_render(const struct log_entry_hdr *hdr, const void *body,
+               uint16_t body_len, char *buf, int buf_len)
+{
+    struct log_fmt_spec spec;
+    const char *fmt;
+    const char *next;
+    int off;
+    int out;
+    int rc;
+
+    if (buf_len <= 0) {
+        return SYS_EINVAL;
+    }
+
+    off = 0;
+    rc = log_fmt_get(body, &off, body_len, &fmt, sizeof(fmt));
+    if (rc != 0 || fmt == NULL) {
+        return SYS_EINVAL;
+    }
+
+    if (!log_fmt_addr_usable(hdr, fmt)) {
+        return log_fmt_render_raw(fmt, body, off, body_len, buf, buf_len);
+    }
+
+    out = 0;
+    buf[0] = '\0';
+    while (1) {
+        next = log_fmt_next(fmt, &spec);
+        if (next == NULL) {
+            log_fmt_out(buf, buf_len, &out, fmt, strlen(fmt));
+            break;
+        }
+
+        log_fmt_out(buf, buf_len, &out, fmt, spec.lfs_start - fmt);
+        rc = log_fmt_render_one(&spec, body, &off, body_len, buf, buf_len,
+                                &out);
+        if (rc != 0) {
+            /* The entry was truncated when it was written. */
+            log_fmt_out(buf, buf_len, &out, "...", 3);
+            break;
+        }
+        fmt = next;
+    }
+
+    return out;
+}
+
+void
+log_fmt_vprintf(struct log *log, uint8_t module, uint8_t level,
+                const char *fmt, va_list ap)
+{
+    uint8_t buf[MYNEWT_VAL(LOG_FMT_MAX_ENTRY_LEN)];
+    int len;
+
+    len = log_fmt_encode(buf, sizeof(buf), fmt, ap);
+
+    log_append_body(log, module, level, LOG_ETYPE_FMT, buf, len);
+}
+
+void
+log_fmt_printf(struct log *log, uint8_t module, uint8_t level,
+               const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    log_fmt_vprintf(log, module, level, fmt, ap);
+    va_end(ap);
+}
+
+#endif
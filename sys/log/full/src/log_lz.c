@@ -0,0 +1,406 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_COMPRESS)
+
+#include <string.h>
+
+#include "log/log.h"
+
+/*
+ * A compressed body is the uncompressed length (2 bytes, little endian)
+ * followed by an LZSS stream.  The stream is made of groups: a flag byte,
+ * then up to eight items, one per flag bit starting with the least
+ * significant.  A set bit is a literal byte; a clear bit is a match encoded
+ * as two bytes, (distance - 1) and (length - LOG_LZ_MIN_MATCH).  Matches only
+ * refer back within the same entry, so every entry can be decoded on its
+ * own with a LOG_LZ_WINDOW byte history.
+ */
+#define LOG_LZ_HDR_SIZE     2
+#define LOG_LZ_MIN_MATCH    3
+#define LOG_LZ_MAX_MATCH    (LOG_LZ_MIN_MATCH + 255)
+#define LOG_LZ_WINDOW       256
+
+struct log_lz_dec {
+    struct log *log;
+    const void *dptr;
+    uint16_t in_off;            /* Entry offset of in_buf[in_len]. */
+    uint8_t in_pos;
+    uint8_t in_len;
+    uint8_t in_buf[32];
+    uint8_t win[LOG_LZ_WINDOW];
+};
+
+#if MYNEWT_VAL(LOG_STATS)
+static uint32_t
+log_lz_usecs(void)
+{
+#if MYNEWT_VAL(OS_CPUTIME_TIMER_NUM) >= 0
+    return os_cputime_ticks_to_usecs(os_cputime_get32());
+#else
+    return os_get_uptime_usec();
+#endif
+}
+#endif
+
+static int
+log_lz_encode(const uint8_t *src, int src_len, uint8_t *dst, int dst_len)
+{
+    int best_dist;
+    int best_len;
+    int flag_off;
+    int cand;
+    int max;
+    int out;
+    int pos;
+    int bit;
+    int n;
+
+    flag_off = 0;
+    out = 0;
+    pos = 0;
+    bit = 8;
+
+    while (pos < src_len) {
+        if (bit == 8) {
+            if (out >= dst_len) {
+                return -1;
+            }
+            flag_off = out;
+            dst[out++] = 0;
+            bit = 0;
+        }
+
+        /* Longest match in the window; the closest one wins ties. */
+        best_len = 0;
+        best_dist = 0;
+        max = min(src_len - pos, LOG_LZ_MAX_MATCH);
+        cand = pos > LOG_LZ_WINDOW ? pos - LOG_LZ_WINDOW : 0;
+        for (; cand < pos; cand++) {
+            if (src[cand] != src[pos]) {
+                continue;
+            }
+            for (n = 1; n < max && src[cand + n] == src[pos + n]; n++) {
+            }
+            if (n >= best_len) {
+                best_len = n;
+                best_dist = pos - cand;
+            }
+        }
+
+        if (best_len >= LOG_LZ_MIN_MATCH) {
+            if (out + 2 > dst_len) {
+                return -1;
+            }
+            dst[out++] = best_dist - 1;
+            dst[out++] = best_len - LOG_LZ_MIN_MATCH;
+            pos += best_len;
+        } else {
+            if (out >= dst_len) {
+                return -1;
+            }
+            dst[flag_off] |= 1 << bit;
+            dst[out++] = src[pos++];
+        }
+        bit++;
+    }
+
+    return out;
+}
+
+static int
+log_lz_getc(struct log_lz_dec *dec)
+{
+    int rc;
+
+    if (dec->in_pos == dec->in_len) {
+        rc = dec->log->l_log->log_read(dec->log, dec->dptr, dec->in_buf,
+                                       dec->in_off, sizeof(dec->in_buf));
+        if (rc <= 0) {
+            return -1;
+        }
+        dec->in_off += rc;
+        dec->in_len = rc;
+        dec->in_pos = 0;
+    }
+
+    return dec->in_buf[dec->in_pos++];
+}
+
+/**
+ * Decodes the body that starts at the given entry offset and passes the
+ * uncompressed bytes [start, end) to the buffer or mbuf.
+ *
+ * @return                      Number of bytes passed on.
+ */
+static int
+log_lz_decode(struct log_lz_dec *dec, uint16_t start, uint16_t end,
+              uint8_t *buf, struct os_mbuf *om)
+{
+    uint8_t chunk[32];
+    uint16_t chunk_len;
+    uint16_t pos;
+    uint16_t dist;
+    int flags;
+    int copied;
+    int len;
+    int bit;
+    int c;
+
+    chunk_len = 0;
+    copied = 0;
+    flags = 0;
+    bit = 8;
+    pos = 0;
+
+    while (pos < end) {
+        if (bit == 8) {
+            flags = log_lz_getc(dec);
+            if (flags < 0) {
+                break;
+            }
+            bit = 0;
+        }
+
+        if (flags & (1 << bit)) {
+            c = log_lz_getc(dec);
+            if (c < 0) {
+                break;
+            }
+            dist = 0;
+            len = 1;
+        } else {
+            c = log_lz_getc(dec);
+            len = log_lz_getc(dec);
+            if (c < 0 || len < 0) {
+                break;
+            }
+            dist = c + 1;
+            len += LOG_LZ_MIN_MATCH;
+            if (dist > pos) {
+                /* Corrupt entry. */
+                break;
+            }
+        }
+        bit++;
+
+        while (len-- > 0 && pos < end) {
+            if (dist != 0) {
+                c = dec->win[(pos - dist) % LOG_LZ_WINDOW];
+            }
+            dec->win[pos % LOG_LZ_WINDOW] = c;
+
+            if (pos >= start) {
+                if (buf != NULL) {
+                    buf[copied] = c;
+                } else {
+                    chunk[chunk_len++] = c;
+                    if (chunk_len == sizeof(chunk)) {
+                        if (os_mbuf_append(om, chunk, chunk_len)) {
+                            return copied;
+                        }
+                        chunk_len = 0;
+                    }
+                }
+                copied++;
+            }
+            pos++;
+        }
+    }
+
+    if (chunk_len > 0) {
+        if (os_mbuf_append(om, chunk, chunk_len)) {
+            copied -= chunk_len;
+        }
+    }
+
+    return copied;
+}
+
+int
+log_lz_body_len(struct log *log, const void *dptr,
+                const struct log_entry_hdr *hdr)
+{
+    uint8_t buf[LOG_LZ_HDR_SIZE];
+    int rc;
+
+    if (!(hdr->ue_flags & LOG_FLAGS_LZ)) {
+        return SYS_ENOTSUP;
+    }
+
+    rc = log->l_log->log_read(log, dptr, buf, log_hdr_len(hdr), sizeof(buf));
+    if (rc != sizeof(buf)) {
+        return SYS_EIO;
+    }
+
+    return get_le16(buf);
+}
+
+int
+log_lz_read(struct log *log, const void *dptr, void *buf, struct os_mbuf *om,
+            uint16_t off, uint16_t len)
+{
+    struct log_entry_hdr hdr;
+    struct log_lz_dec dec;
+    uint16_t hdr_len;
+    uint16_t end;
+    int copied;
+    int body_len;
+    int rc;
+#if MYNEWT_VAL(LOG_STATS)
+    uint32_t start;
+#endif
+
+    /* Header reads never involve the codec. */
+    if (off + len <= LOG_BASE_ENTRY_HDR_SIZE) {
+        return SYS_ENOTSUP;
+    }
+
+    rc = log->l_log->log_read(log, dptr, &hdr, 0, LOG_BASE_ENTRY_HDR_SIZE);
+    if (rc != LOG_BASE_ENTRY_HDR_SIZE || !(hdr.ue_flags & LOG_FLAGS_LZ)) {
+        return SYS_ENOTSUP;
+    }
+    hdr_len = log_hdr_len(&hdr);
+
+    copied = 0;
+    if (off < hdr_len) {
+        copied = min(len, hdr_len - off);
+        if (om != NULL) {
+            rc = log->l_log->log_read_mbuf(log, dptr, om, off, copied);
+        } else {
+            rc = log->l_log->log_read(log, dptr, buf, off, copied);
+        }
+        if (rc != copied) {
+            return rc < 0 ? 0 : rc;
+        }
+        off += copied;
+        len -= copied;
+        if (len == 0) {
+            return copied;
+        }
+    }
+
+    body_len = log_lz_body_len(log, dptr, &hdr);
+    if (body_len < 0) {
+        return copied;
+    }
+
+    off -= hdr_len;
+    end = min(off + len, body_len);
+    if (off >= end) {
+        return copied;
+    }
+
+#if MYNEWT_VAL(LOG_STATS)
+    start = log_lz_usecs();
+#endif
+
+    dec.log = log;
+    dec.dptr = dptr;
+    dec.in_off = hdr_len + LOG_LZ_HDR_SIZE;
+    dec.in_pos = 0;
+    dec.in_len = 0;
+    rc = log_lz_decode(&dec, off, end,
+                       om != NULL ? NULL : (uint8_t *)buf + copied, om);
+
+#if MYNEWT_VAL(LOG_STATS)
+    LOG_STATS_INCN(log, lz_dec_us, log_lz_usecs() - start);
+#endif
+
+    return copied + rc;
+}
+
+int
+log_lz_append(struct log *log, const struct log_entry_hdr *hdr,
+              const void *body, struct os_mbuf *om, uint16_t om_off,
+              uint16_t body_len)
+{
+    uint8_t out[LOG_LZ_HDR_SIZE + MYNEWT_VAL(LOG_COMPRESS_MAX_LEN)];
+    uint8_t in[MYNEWT_VAL(LOG_COMPRESS_MAX_LEN)];
+    struct log_entry_hdr lz_hdr;
+    int len;
+    int rc;
+#if MYNEWT_VAL(LOG_STATS)
+    uint32_t start;
+#endif
+
+    if (!log->l_compress) {
+        return SYS_ENOTSUP;
+    }
+
+    LOG_STATS_INCN(log, lz_in, body_len);
+
+    /* A compressed body must save at least one byte. */
+    len = -1;
+    if (body_len <= sizeof(in) && body_len > LOG_LZ_HDR_SIZE + 1) {
+        if (om != NULL) {
+            rc = os_mbuf_copydata(om, om_off, body_len, in);
+            if (rc != 0) {
+                return SYS_EINVAL;
+            }
+            body = in;
+        }
+
+#if MYNEWT_VAL(LOG_STATS)
+        start = log_lz_usecs();
+#endif
+        len = log_lz_encode(body, body_len, out + LOG_LZ_HDR_SIZE,
+                            body_len - LOG_LZ_HDR_SIZE - 1);
+#if MYNEWT_VAL(LOG_STATS)
+        LOG_STATS_INCN(log, lz_enc_us, log_lz_usecs() - start);
+#endif
+    }
+
+    if (len < 0) {
+        LOG_STATS_INC(log, lz_raw);
+        LOG_STATS_INCN(log, lz_out, body_len);
+        return SYS_ENOTSUP;
+    }
+
+    put_le16(out, body_len);
+    len += LOG_LZ_HDR_SIZE;
+
+    memset(&lz_hdr, 0, sizeof(lz_hdr));
+    memcpy(&lz_hdr, hdr, log_hdr_len(hdr));
+    lz_hdr.ue_flags |= LOG_FLAGS_LZ;
+
+    rc = log->l_log->log_append_body(log, &lz_hdr, out, len);
+    if (rc == 0) {
+        LOG_STATS_INCN(log, lz_out, len);
+    }
+
+    return rc;
+}
+
+int
+log_set_compress(struct log *log, int enable)
+{
+    if (log->l_log->log_type == LOG_TYPE_STREAM ||
+        log->l_log->log_append_body == NULL) {
+        return SYS_ENOTSUP;
+    }
+
+    log->l_compress = !!enable;
+
+    return 0;
+}
+
+#endif
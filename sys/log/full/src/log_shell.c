@@ -50,6 +50,9 @@ shell_log_dump_entry(struct log *log, struct log_offset *log_offset,
     struct CborValue cbor_value;
     struct log_cbor_reader cbor_reader;
     char tmp[32 + 1];
+#if MYNEWT_VAL(LOG_FMT)
+    char text[LOG_PRINTF_MAX_ENTRY_LEN];
+#endif
     int off;
     int blksz;
     bool read_data = ueh->ue_etype != LOG_ETYPE_CBOR;
@@ -80,6 +83,14 @@ shell_log_dump_entry(struct log *log, struct log_offset *log_offset,
         cbor_parser_init(&cbor_reader.r, 0, &cbor_parser, &cbor_value);
         cbor_value_to_pretty(stdout, &cbor_value);
         break;
+#if MYNEWT_VAL(LOG_FMT)
+    case LOG_ETYPE_FMT:
+        if (log_fmt_render(ueh, data, rc, text, sizeof(text)) >= 0) {
+            console_write(text, strlen(text));
+            break;
+        }
+        /* Malformed body; fall through to the hex dump. */
+#endif
     default:
         for (off = 0; off < rc; off += blksz) {
             blksz = dlen - off;
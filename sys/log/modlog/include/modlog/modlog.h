@@ -188,6 +188,22 @@ int modlog_foreach(modlog_foreach_fn *fn, void *arg);
  */
 void modlog_printf(uint8_t module, uint8_t level, const char *msg, ...);
 
+#if MYNEWT_VAL(LOG_FMT) || defined(__DOXYGEN__)
+/**
+ * @brief Writes an unformatted printf-style entry to the specified log
+ * module.
+ *
+ * Stores the format string address and the arguments (`LOG_ETYPE_FMT`); the
+ * text is rendered when the entry is read.  See log_fmt_printf().
+ *
+ * @param module                The log module to write to.
+ * @param level                 The severity of the log entry to write.
+ * @param fmt                   The "printf" format string; must be a string
+ *                                  literal.
+ */
+void modlog_fmt_printf(uint8_t module, uint8_t level, const char *fmt, ...);
+#endif
+
 #else /* LOG_FULL */
 
 static inline int
@@ -238,6 +254,17 @@ static inline void
 modlog_printf(uint8_t module, uint8_t level, const char *msg, ...)
 { }
 
+static inline void
+modlog_fmt_printf(uint8_t module, uint8_t level, const char *fmt, ...)
+{ }
+
+#endif
+
+/* The function behind the MODLOG_[...] macros. */
+#if MYNEWT_VAL(MODLOG_FMT)
+#define MODLOG_PRINTF_FN    modlog_fmt_printf
+#else
+#define MODLOG_PRINTF_FN    modlog_printf
 #endif
 
 #if MYNEWT_VAL(LOG_LEVEL) <= LOG_LEVEL_DEBUG || defined __DOXYGEN__
@@ -251,7 +278,7 @@ modlog_printf(uint8_t module, uint8_t level, const char *msg, ...)
  * @param ml_msg_               The "printf" formatted string to write.
  */
 #define MODLOG_DEBUG(ml_mod_, ml_msg_, ...) \
-    modlog_printf((ml_mod_), LOG_LEVEL_DEBUG, (ml_msg_), ##__VA_ARGS__)
+    MODLOG_PRINTF_FN((ml_mod_), LOG_LEVEL_DEBUG, (ml_msg_), ##__VA_ARGS__)
 #else
 #define MODLOG_DEBUG(ml_mod_, ...) IGNORE(__VA_ARGS__)
 #endif
@@ -267,7 +294,7 @@ modlog_printf(uint8_t module, uint8_t level, const char *msg, ...)
  * @param ml_msg_               The "printf" formatted string to write.
  */
 #define MODLOG_INFO(ml_mod_, ml_msg_, ...) \
-    modlog_printf((ml_mod_), LOG_LEVEL_INFO, (ml_msg_), ##__VA_ARGS__)
+    MODLOG_PRINTF_FN((ml_mod_), LOG_LEVEL_INFO, (ml_msg_), ##__VA_ARGS__)
 #else
 #define MODLOG_INFO(ml_mod_, ...) IGNORE(__VA_ARGS__)
 #endif
@@ -283,7 +310,7 @@ modlog_printf(uint8_t module, uint8_t level, const char *msg, ...)
  * @param ml_msg_               The "printf" formatted string to write.
  */
 #define MODLOG_WARN(ml_mod_, ml_msg_, ...) \
-    modlog_printf((ml_mod_), LOG_LEVEL_WARN, (ml_msg_), ##__VA_ARGS__)
+    MODLOG_PRINTF_FN((ml_mod_), LOG_LEVEL_WARN, (ml_msg_), ##__VA_ARGS__)
 #else
 #define MODLOG_WARN(ml_mod_, ...) IGNORE(__VA_ARGS__)
 #endif
@@ -299,7 +326,7 @@ modlog_printf(uint8_t module, uint8_t level, const char *msg, ...)
  * @param ml_msg_               The "printf" formatted string to write.
  */
 #define MODLOG_ERROR(ml_mod_, ml_msg_, ...) \
-    modlog_printf((ml_mod_), LOG_LEVEL_ERROR, (ml_msg_), ##__VA_ARGS__)
+    MODLOG_PRINTF_FN((ml_mod_), LOG_LEVEL_ERROR, (ml_msg_), ##__VA_ARGS__)
 #else
 #define MODLOG_ERROR(ml_mod_, ...) IGNORE(__VA_ARGS__)
 #endif
@@ -315,7 +342,7 @@ modlog_printf(uint8_t module, uint8_t level, const char *msg, ...)
  * @param ml_msg_               The "printf" formatted string to write.
  */
 #define MODLOG_CRITICAL(ml_mod_, ml_msg_, ...) \
-    modlog_printf((ml_mod_), LOG_LEVEL_CRITICAL, (ml_msg_), ##__VA_ARGS__)
+    MODLOG_PRINTF_FN((ml_mod_), LOG_LEVEL_CRITICAL, (ml_msg_), ##__VA_ARGS__)
 #else
 #define MODLOG_CRITICAL(ml_mod_, ...) IGNORE(__VA_ARGS__)
 #endif
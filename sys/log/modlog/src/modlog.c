@@ -476,6 +476,22 @@ modlog_printf(uint8_t module, uint8_t level, const char *msg, ...)
     modlog_append(module, level, LOG_ETYPE_STRING, buf, len);
 }
 
+#if MYNEWT_VAL(LOG_FMT)
+void
+modlog_fmt_printf(uint8_t module, uint8_t level, const char *fmt, ...)
+{
+    va_list args;
+    uint8_t buf[MYNEWT_VAL(LOG_FMT_MAX_ENTRY_LEN)];
+    int len;
+
+    va_start(args, fmt);
+    len = log_fmt_encode(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    modlog_append(module, level, LOG_ETYPE_FMT, buf, len);
+}
+#endif
+
 void
 modlog_init(void)
 {
@@ -164,6 +164,7 @@ log_set_max_entry_len(struct log *log, uint16_t max_entry_len)
 }
 
 #define log_printf(...)
+#define log_fmt_printf(...)
 
 /*
  * Dummy handler exports.
@@ -86,4 +86,6 @@ TEST_SUITE(cbmem_test_suite)
     cbmem_test_case_1();
     cbmem_test_case_2();
     cbmem_test_case_3();
+    cbmem_test_case_reserve();
+    cbmem_test_case_stress();
 }
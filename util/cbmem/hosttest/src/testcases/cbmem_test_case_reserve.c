@@ -0,0 +1,121 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "cbmem_test/cbmem_test.h"
+
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+static struct cbmem cbmem_res;
+static uint8_t cbmem_res_buf[256];
+
+static struct cbmem_entry_hdr *
+cbmem_test_res_fill(uint8_t val, uint16_t len)
+{
+    struct cbmem_entry_hdr *hdr;
+
+    hdr = cbmem_reserve(&cbmem_res, len);
+    if (hdr != NULL) {
+        memset(CBMEM_ENTRY_DATA(hdr), val, len);
+    }
+    return hdr;
+}
+#endif
+
+TEST_CASE(cbmem_test_case_reserve)
+{
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    struct cbmem_entry_hdr *hdr;
+    struct cbmem_entry_hdr *a;
+    struct cbmem_entry_hdr *b;
+    struct cbmem_iter iter;
+    uint8_t data[20];
+    uint8_t val;
+    int rc;
+    int i;
+
+    rc = cbmem_init(&cbmem_res, cbmem_res_buf, sizeof cbmem_res_buf);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /*** Readers stop at an uncommitted entry. */
+    a = cbmem_test_res_fill(1, sizeof data);
+    TEST_ASSERT_FATAL(a != NULL);
+    b = cbmem_test_res_fill(2, sizeof data);
+    TEST_ASSERT_FATAL(b != NULL);
+    cbmem_commit(&cbmem_res, b);
+
+    cbmem_iter_start(&cbmem_res, &iter);
+    TEST_ASSERT(cbmem_iter_next(&cbmem_res, &iter) == NULL);
+    TEST_ASSERT(cbmem_read(&cbmem_res, a, &val, 0, 1) == -1);
+
+    TEST_ASSERT(cbmem_flush(&cbmem_res) == OS_EBUSY);
+
+    cbmem_commit(&cbmem_res, a);
+    TEST_ASSERT(cbmem_iter_next(&cbmem_res, &iter) == a);
+    TEST_ASSERT(cbmem_iter_next(&cbmem_res, &iter) == b);
+    TEST_ASSERT(cbmem_iter_next(&cbmem_res, &iter) == NULL);
+
+    rc = cbmem_read(&cbmem_res, b, &val, 0, 1);
+    TEST_ASSERT(rc == 1 && val == 2);
+
+    /*** Writers never overwrite an uncommitted entry. */
+    a = cbmem_test_res_fill(3, sizeof data);
+    TEST_ASSERT_FATAL(a != NULL);
+    memset(data, 4, sizeof data);
+    for (i = 0; i < 100; i++) {
+        rc = cbmem_append(&cbmem_res, data, sizeof data);
+        if (rc != 0) {
+            break;
+        }
+    }
+    TEST_ASSERT(rc != 0);
+    TEST_ASSERT(i < 100);
+    for (i = 0; i < sizeof data; i++) {
+        TEST_ASSERT(CBMEM_ENTRY_DATA(a)[i] == 3);
+    }
+    cbmem_commit(&cbmem_res, a);
+
+    /*** An overtaken reader resumes at the oldest entry. */
+    cbmem_iter_start(&cbmem_res, &iter);
+    hdr = cbmem_iter_next(&cbmem_res, &iter);
+    TEST_ASSERT_FATAL(hdr == a);
+    memset(data, 5, sizeof data);
+    for (i = 0; i < 3; i++) {
+        rc = cbmem_append(&cbmem_res, data, sizeof data);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    /* The old entry is gone; its address now holds a newer entry. */
+    rc = cbmem_read(&cbmem_res, a, &val, 0, 1);
+    TEST_ASSERT(rc == -1 || val == 5);
+
+    /* The iterator only covers entries present when it was started. */
+    i = 0;
+    while ((hdr = cbmem_iter_next(&cbmem_res, &iter)) != NULL) {
+        if (i == 0) {
+            TEST_ASSERT(hdr == cbmem_res.c_entry_start);
+        }
+        rc = cbmem_read(&cbmem_res, hdr, &val, 0, 1);
+        TEST_ASSERT(rc == 1 && val == 4);
+        i++;
+    }
+    TEST_ASSERT(i > 0);
+
+    TEST_ASSERT(cbmem_flush(&cbmem_res) == 0);
+    cbmem_iter_start(&cbmem_res, &iter);
+    TEST_ASSERT(cbmem_iter_next(&cbmem_res, &iter) == NULL);
+#endif
+}
@@ -0,0 +1,188 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "cbmem_test/cbmem_test.h"
+
+/*
+ * Interleaves reservations, out-of-order commits and reads the way
+ * preempting writers (e.g., interrupt handlers) would, and checks that
+ * readers only ever see complete entries, in order.
+ */
+
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+#define CBMEM_STRESS_BUF_SIZE   1000
+#define CBMEM_STRESS_ROUNDS     50000
+#define CBMEM_STRESS_MAX_LEN    64
+#define CBMEM_STRESS_WRITERS    4
+
+struct cbmem_stress_writer {
+    struct cbmem_entry_hdr *hdr;
+    uint32_t seq;
+    uint16_t len;
+};
+
+static struct cbmem cbmem_stress;
+static uint8_t cbmem_stress_buf[CBMEM_STRESS_BUF_SIZE];
+static struct cbmem_stress_writer cbmem_stress_writers[CBMEM_STRESS_WRITERS];
+static uint32_t cbmem_stress_seed;
+
+static uint32_t
+cbmem_stress_rand(void)
+{
+    cbmem_stress_seed = cbmem_stress_seed * 1103515245 + 12345;
+    return cbmem_stress_seed >> 8;
+}
+
+/* Entry contents: the writer's sequence number, then a pattern derived
+ * from it.
+ */
+static void
+cbmem_stress_fill(uint8_t *dst, uint32_t seq, int from, int to)
+{
+    int i;
+
+    for (i = from; i < to; i++) {
+        if (i < sizeof seq) {
+            dst[i] = seq >> (8 * i);
+        } else {
+            dst[i] = seq + i;
+        }
+    }
+}
+
+static uint32_t
+cbmem_stress_check(const uint8_t *data, int len)
+{
+    uint32_t seq;
+    int i;
+
+    TEST_ASSERT_FATAL(len >= sizeof seq);
+    memcpy(&seq, data, sizeof seq);
+    for (i = sizeof seq; i < len; i++) {
+        TEST_ASSERT_FATAL(data[i] == (uint8_t)(seq + i),
+                          "corrupt entry seq=%u", (unsigned)seq);
+    }
+    return seq;
+}
+#endif
+
+TEST_CASE(cbmem_test_case_stress)
+{
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    struct cbmem_stress_writer *w;
+    struct cbmem_entry_hdr *hdr;
+    struct cbmem_iter iter;
+    uint8_t data[CBMEM_STRESS_MAX_LEN];
+    uint32_t next_seq;
+    uint32_t last_seq;
+    uint32_t seq;
+    int num_writers;
+    int num_read;
+    int round;
+    int rc;
+    int i;
+
+    rc = cbmem_init(&cbmem_stress, cbmem_stress_buf, sizeof cbmem_stress_buf);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    cbmem_stress_seed = 1;
+    num_writers = 0;
+    num_read = 0;
+    next_seq = 1;
+    last_seq = 0;
+    cbmem_iter_start(&cbmem_stress, &iter);
+
+    for (round = 0; round < CBMEM_STRESS_ROUNDS; round++) {
+        switch (cbmem_stress_rand() % 8) {
+        case 0:
+        case 1:
+        case 2:
+            /* A writer reserves an entry and writes half of it. */
+            if (num_writers == CBMEM_STRESS_WRITERS) {
+                break;
+            }
+            w = cbmem_stress_writers + num_writers;
+            w->len = 4 + cbmem_stress_rand() % (CBMEM_STRESS_MAX_LEN - 4);
+            w->hdr = cbmem_reserve(&cbmem_stress, w->len);
+            if (w->hdr == NULL) {
+                /* Only allowed if it would overwrite an unfinished entry. */
+                TEST_ASSERT_FATAL(num_writers > 0);
+                break;
+            }
+            w->seq = next_seq++;
+            cbmem_stress_fill(CBMEM_ENTRY_DATA(w->hdr), w->seq, 0,
+                              w->len / 2);
+            num_writers++;
+            break;
+
+        case 3:
+        case 4:
+            /* Some writer finishes its entry and commits it. */
+            if (num_writers == 0) {
+                break;
+            }
+            i = cbmem_stress_rand() % num_writers;
+            w = cbmem_stress_writers + i;
+            cbmem_stress_fill(CBMEM_ENTRY_DATA(w->hdr), w->seq, w->len / 2,
+                              w->len);
+            cbmem_commit(&cbmem_stress, w->hdr);
+            cbmem_stress_writers[i] =
+                cbmem_stress_writers[--num_writers];
+            break;
+
+        default:
+            /* The reader takes a step. */
+            hdr = cbmem_iter_next(&cbmem_stress, &iter);
+            if (hdr == NULL) {
+                cbmem_iter_start(&cbmem_stress, &iter);
+                last_seq = 0;
+                break;
+            }
+            rc = cbmem_read(&cbmem_stress, hdr, data, 0, sizeof data);
+            TEST_ASSERT_FATAL(rc == hdr->ceh_len);
+            seq = cbmem_stress_check(data, rc);
+            TEST_ASSERT_FATAL(seq > last_seq, "seq=%u last=%u",
+                              (unsigned)seq, (unsigned)last_seq);
+            last_seq = seq;
+            num_read++;
+            break;
+        }
+    }
+
+    TEST_ASSERT(num_read > CBMEM_STRESS_ROUNDS / 10);
+
+    /* Once every writer is done, all remaining entries are readable. */
+    while (num_writers > 0) {
+        w = cbmem_stress_writers + --num_writers;
+        cbmem_stress_fill(CBMEM_ENTRY_DATA(w->hdr), w->seq, w->len / 2,
+                          w->len);
+        cbmem_commit(&cbmem_stress, w->hdr);
+    }
+
+    i = 0;
+    cbmem_iter_start(&cbmem_stress, &iter);
+    while ((hdr = cbmem_iter_next(&cbmem_stress, &iter)) != NULL) {
+        rc = cbmem_read(&cbmem_stress, hdr, data, 0, sizeof data);
+        TEST_ASSERT_FATAL(rc == hdr->ceh_len);
+        cbmem_stress_check(data, rc);
+        i++;
+    }
+    TEST_ASSERT(i == cbmem_stress.c_seq_next - cbmem_stress.c_seq_start);
+#endif
+}
@@ -30,6 +30,16 @@ struct cbmem_entry_hdr {
     uint16_t ceh_flags;
 } __attribute__((packed));
 
+/*
+ * With CBMEM_LOCKFREE, ceh_flags holds the low bits of the entry's sequence
+ * number and a busy flag, set while the entry is reserved but not yet
+ * committed.  Reads fail if the entry is overwritten while being read.  A
+ * header that was overwritten before the read started may already hold a
+ * newer entry, whose data is then returned.
+ */
+#define CBMEM_ENTRY_F_BUSY      0x8000
+#define CBMEM_ENTRY_SEQ_MASK    0x7fff
+
 struct cbmem {
     struct os_mutex c_lock;
 
@@ -38,12 +48,28 @@ struct cbmem {
     uint8_t *c_buf;
     uint8_t *c_buf_end;
     uint8_t *c_buf_cur_end;
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    /* Sequence numbers of the oldest entry and of the next one to be
+     * reserved.  Entries in [c_seq_start, c_seq_next) are live.
+     */
+    uint32_t c_seq_start;
+    uint32_t c_seq_next;
+    /* Number of entries reserved but not yet committed. */
+    uint16_t c_pending;
+#endif
 };
 
 struct cbmem_iter {
     struct cbmem_entry_hdr *ci_start;
     struct cbmem_entry_hdr *ci_cur;
     struct cbmem_entry_hdr *ci_end;
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    /* Sequence number of the entry after ci_cur, and of the first entry
+     * appended after the iterator was started.
+     */
+    uint32_t ci_seq;
+    uint32_t ci_end_seq;
+#endif
 };
 
 /**
@@ -71,6 +97,8 @@ struct cbmem_scat_gath {
         + ((struct cbmem_entry_hdr *) (__p))->ceh_len)
 #define CBMEM_ENTRY_NEXT(__p) ((struct cbmem_entry_hdr *) \
         ((uint8_t *) (__p) + CBMEM_ENTRY_SIZE(__p)))
+#define CBMEM_ENTRY_DATA(__p) ((uint8_t *) (__p) + \
+        sizeof(struct cbmem_entry_hdr))
 
 typedef int (*cbmem_walk_func_t)(struct cbmem *, struct cbmem_entry_hdr *, 
         void *arg);
@@ -92,6 +120,33 @@ int cbmem_append_mbuf(struct cbmem *cbmem, const struct os_mbuf *om);
 int cbmem_append_scat_gath(struct cbmem *cbmem,
                            const struct cbmem_scat_gath *sg);
 
+/**
+ * @brief Reserves space for an entry, to be filled in by the caller.
+ *
+ * The caller writes len bytes at CBMEM_ENTRY_DATA(hdr) and then calls
+ * cbmem_commit().  With CBMEM_LOCKFREE, no lock is held in between: other
+ * writers, including interrupt handlers, can reserve and commit their own
+ * entries meanwhile, and readers stop at the reserved entry until it is
+ * committed.  Without it, the cbmem lock is held until cbmem_commit().
+ *
+ * @param cbmem                 The cbmem to write to.
+ * @param len                   Length of the entry's data.
+ *
+ * @return                      The reserved entry; NULL if the space could
+ *                              not be reserved (too big, or it would
+ *                              overwrite an entry that is still being
+ *                              written).
+ */
+struct cbmem_entry_hdr *cbmem_reserve(struct cbmem *cbmem, uint16_t len);
+
+/**
+ * @brief Publishes an entry obtained from cbmem_reserve().
+ *
+ * @param cbmem                 The cbmem the entry was reserved in.
+ * @param hdr                   The reserved entry.
+ */
+void cbmem_commit(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr);
+
 void cbmem_iter_start(struct cbmem *cbmem, struct cbmem_iter *iter);
 struct cbmem_entry_hdr *cbmem_iter_next(struct cbmem *cbmem, 
         struct cbmem_iter *iter);
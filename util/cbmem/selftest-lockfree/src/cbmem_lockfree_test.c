@@ -0,0 +1,40 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "cbmem_test/cbmem_test.h"
+
+TEST_CASE_DECL(cbmem_test_case_concurrent);
+TEST_CASE_DECL(cbmem_test_case_stale);
+
+TEST_SUITE(cbmem_lockfree_test_suite)
+{
+    cbmem_test_case_concurrent();
+    cbmem_test_case_stale();
+}
+
+int
+main(int argc, char **argv)
+{
+    cbmem_test_suite();
+    cbmem_lockfree_test_suite();
+
+    return tu_any_failed;
+}
@@ -0,0 +1,164 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "cbmem/cbmem.h"
+
+/*
+ * A writer task appends entries while a lower priority reader task walks the
+ * buffer.  The writer wakes up on every tick and preempts the reader, often
+ * in the middle of a read, so the buffer wraps underneath it.  Reads may
+ * fail, but must never return a partially overwritten entry.
+ */
+
+#define CTC_BUF_SIZE        512
+#define CTC_MAX_LEN         48
+#define CTC_ENTRY_CNT       8192
+#define CTC_BURST_CNT       32
+
+#define CTC_WRITER_PRIO     10
+#define CTC_STACK_SIZE      OS_STACK_ALIGN(1024)
+
+static struct cbmem ctc_cbmem;
+static uint8_t ctc_buf[CTC_BUF_SIZE];
+
+static struct os_task ctc_writer_task;
+static os_stack_t ctc_writer_stack[CTC_STACK_SIZE];
+
+static volatile int ctc_writer_done;
+static int ctc_append_fails;
+
+static int
+ctc_entry_len(uint32_t seq)
+{
+    return sizeof seq + seq % (CTC_MAX_LEN - sizeof seq + 1);
+}
+
+/* Entry contents: the sequence number, then a pattern derived from it. */
+static void
+ctc_fill(uint8_t *dst, uint32_t seq, int len)
+{
+    int i;
+
+    memcpy(dst, &seq, sizeof seq);
+    for (i = sizeof seq; i < len; i++) {
+        dst[i] = seq + i;
+    }
+}
+
+static uint32_t
+ctc_check(const uint8_t *data, int len)
+{
+    uint32_t seq;
+    int i;
+
+    TEST_ASSERT_FATAL(len >= sizeof seq);
+    memcpy(&seq, data, sizeof seq);
+    TEST_ASSERT_FATAL(len == ctc_entry_len(seq), "seq=%u len=%d",
+                      (unsigned)seq, len);
+    for (i = sizeof seq; i < len; i++) {
+        TEST_ASSERT_FATAL(data[i] == (uint8_t)(seq + i),
+                          "corrupt entry seq=%u", (unsigned)seq);
+    }
+
+    return seq;
+}
+
+static void
+ctc_writer(void *arg)
+{
+    uint8_t data[CTC_MAX_LEN];
+    uint32_t seq;
+    int len;
+
+    for (seq = 1; seq <= CTC_ENTRY_CNT; seq++) {
+        len = ctc_entry_len(seq);
+        ctc_fill(data, seq, len);
+        if (cbmem_append(&ctc_cbmem, data, len) != 0) {
+            ctc_append_fails++;
+        }
+
+        if (seq % CTC_BURST_CNT == 0) {
+            os_time_delay(1);
+        }
+    }
+
+    ctc_writer_done = 1;
+    while (1) {
+        os_time_delay(OS_TICKS_PER_SEC);
+    }
+}
+
+TEST_CASE_TASK(cbmem_test_case_concurrent)
+{
+    struct cbmem_entry_hdr *hdr;
+    struct cbmem_iter iter;
+    uint8_t data[CTC_MAX_LEN];
+    uint32_t last_seq;
+    uint32_t seq;
+    int num_read;
+    int rc;
+
+    rc = cbmem_init(&ctc_cbmem, ctc_buf, sizeof ctc_buf);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = os_task_init(&ctc_writer_task, "ctc_writer", ctc_writer, NULL,
+                      CTC_WRITER_PRIO, OS_WAIT_FOREVER, ctc_writer_stack,
+                      CTC_STACK_SIZE);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    num_read = 0;
+    while (!ctc_writer_done) {
+        last_seq = 0;
+        cbmem_iter_start(&ctc_cbmem, &iter);
+        while ((hdr = cbmem_iter_next(&ctc_cbmem, &iter)) != NULL) {
+            rc = cbmem_read(&ctc_cbmem, hdr, data, 0, sizeof data);
+            if (rc < 0) {
+                /* Overwritten while we were copying it. */
+                continue;
+            }
+
+            seq = ctc_check(data, rc);
+            TEST_ASSERT_FATAL(seq > last_seq, "seq=%u last=%u",
+                              (unsigned)seq, (unsigned)last_seq);
+            last_seq = seq;
+            num_read++;
+        }
+
+        /* Let the tick advance so the writer runs without preemption too. */
+        os_time_delay(1);
+    }
+
+    /* A single writer never finds an unfinished entry in its way. */
+    TEST_ASSERT(ctc_append_fails == 0);
+    TEST_ASSERT(num_read > 0);
+
+    /* With the writer done, every remaining entry reads back, newest last. */
+    last_seq = 0;
+    cbmem_iter_start(&ctc_cbmem, &iter);
+    while ((hdr = cbmem_iter_next(&ctc_cbmem, &iter)) != NULL) {
+        rc = cbmem_read(&ctc_cbmem, hdr, data, 0, sizeof data);
+        TEST_ASSERT_FATAL(rc == hdr->ceh_len);
+        seq = ctc_check(data, rc);
+        TEST_ASSERT_FATAL(last_seq == 0 || seq == last_seq + 1);
+        last_seq = seq;
+    }
+    TEST_ASSERT(last_seq == CTC_ENTRY_CNT);
+}
@@ -0,0 +1,99 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "cbmem/cbmem.h"
+
+/*
+ * A reader keeps a pointer to an entry while the buffer wraps underneath it,
+ * so that the pointer ends up in the middle of a newer entry's data.  That
+ * data is crafted to look like a live header with a huge length.  Reads
+ * through the stale pointer must fail instead of copying past the end of the
+ * buffer.
+ */
+
+#define CTS_BUF_SIZE        64
+
+static struct cbmem cts_cbmem;
+static uint8_t cts_buf[CTS_BUF_SIZE];
+
+TEST_CASE_SELF(cbmem_test_case_stale)
+{
+    struct cbmem_entry_hdr *stale;
+    struct cbmem_entry_hdr *hdr;
+    struct cbmem_entry_hdr fake;
+    struct cbmem_iter iter;
+    struct os_mbuf *om;
+    uint8_t data[40];
+    int rc;
+
+    rc = cbmem_init(&cts_cbmem, cts_buf, sizeof cts_buf);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    memset(data, 0, sizeof data);
+
+    /* Entries at offsets 0, 8 and 16; the last one ends at 60. */
+    rc = cbmem_append(&cts_cbmem, data, 4);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = cbmem_append(&cts_cbmem, data, 4);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = cbmem_append(&cts_cbmem, data, 40);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    cbmem_iter_start(&cts_cbmem, &iter);
+    cbmem_iter_next(&cts_cbmem, &iter);
+    stale = cbmem_iter_next(&cts_cbmem, &iter);
+    TEST_ASSERT_FATAL(stale == (void *)&cts_buf[8]);
+
+    /* Wrap; the new entry overwrites all three, and the stale pointer lands
+     * 4 bytes into its data.  Make those bytes look like the new entry's
+     * header, with a length reaching far past the buffer.
+     */
+    hdr = cbmem_reserve(&cts_cbmem, 40);
+    TEST_ASSERT_FATAL(hdr == (void *)&cts_buf[0]);
+
+    fake.ceh_len = 0xfff0;
+    fake.ceh_flags = hdr->ceh_flags & CBMEM_ENTRY_SEQ_MASK;
+    memcpy(data + 4, &fake, sizeof fake);
+    memcpy(CBMEM_ENTRY_DATA(hdr), data, sizeof data);
+    cbmem_commit(&cts_cbmem, hdr);
+
+    /* The sequence number alone would pass the stale header. */
+    rc = cbmem_read(&cts_cbmem, stale, data, 48, 16);
+    TEST_ASSERT(rc == -1);
+    rc = cbmem_read(&cts_cbmem, stale, data, 0, sizeof data);
+    TEST_ASSERT(rc == -1);
+
+    om = os_msys_get_pkthdr(0, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = cbmem_read_mbuf(&cts_cbmem, stale, om, 48, 16);
+    TEST_ASSERT(rc == -1);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 0);
+    os_mbuf_free_chain(om);
+
+    /* A pointer outside the buffer is never dereferenced. */
+    rc = cbmem_read(&cts_cbmem, (void *)&cts_buf[CTS_BUF_SIZE - 2], data, 0,
+                    sizeof data);
+    TEST_ASSERT(rc == -1);
+
+    /* The entry itself is still readable. */
+    rc = cbmem_read(&cts_cbmem, hdr, data, 0, sizeof data);
+    TEST_ASSERT(rc == 40);
+}
@@ -74,18 +74,27 @@ err:
 }
 
 
-static int
-cbmem_append_internal(struct cbmem *cbmem, const void *data, uint16_t len,
-                      copy_data_func_t *copy_func)
+/**
+ * Picks the location for a new entry of the given length, dropping the
+ * oldest entries as needed to make room.  Must be called with the cbmem
+ * locked (or, with CBMEM_LOCKFREE, in a critical section).
+ */
+static struct cbmem_entry_hdr *
+cbmem_place(struct cbmem *cbmem, uint16_t len)
 {
     struct cbmem_entry_hdr *dst;
+    uint8_t *cur_end;
     uint8_t *start;
     uint8_t *end;
-    int rc;
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    uint32_t evicted;
+    uint8_t *p;
 
-    rc = cbmem_lock_acquire(cbmem);
-    if (rc != 0) {
-        goto err;
+    evicted = 0;
+#endif
+
+    if (sizeof(*dst) + len > cbmem->c_buf_end - cbmem->c_buf) {
+        return NULL;
     }
 
     if (cbmem->c_entry_end) {
@@ -94,16 +103,29 @@ cbmem_append_internal(struct cbmem *cbmem, const void *data, uint16_t len,
         dst = (struct cbmem_entry_hdr *) cbmem->c_buf;
     }
     end = (uint8_t *) dst + len + sizeof(*dst);
+    cur_end = cbmem->c_buf_cur_end;
+    start = (uint8_t *) cbmem->c_entry_start;
 
     /* If this item would take us past the end of this buffer, then adjust
      * the item to the beginning of the buffer.
      */
     if (end > cbmem->c_buf_end) {
-        cbmem->c_buf_cur_end = (uint8_t *) dst;
+        cur_end = (uint8_t *) dst;
         dst = (struct cbmem_entry_hdr *) cbmem->c_buf;
         end = (uint8_t *) dst + len + sizeof(*dst);
-        if ((uint8_t *) cbmem->c_entry_start >= cbmem->c_buf_cur_end) {
-            cbmem->c_entry_start = (struct cbmem_entry_hdr *) cbmem->c_buf;
+        if (start >= cur_end) {
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+            /* Entries up to the old wrap point are dropped. */
+            for (p = start; p < cbmem->c_buf_cur_end; p = (uint8_t *)
+                 CBMEM_ENTRY_NEXT(p)) {
+                if (((struct cbmem_entry_hdr *) p)->ceh_flags &
+                    CBMEM_ENTRY_F_BUSY) {
+                    return NULL;
+                }
+                evicted++;
+            }
+#endif
+            start = cbmem->c_buf;
         }
     }
 
@@ -111,37 +133,101 @@ cbmem_append_internal(struct cbmem *cbmem, const void *data, uint16_t len,
      * start of the buffer, move start forward until you don't overwrite it
      * anymore.
      */
-    start = (uint8_t *) cbmem->c_entry_start;
     if (start && (uint8_t *) dst < start + CBMEM_ENTRY_SIZE(start) &&
             end > start) {
         while (start < end) {
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+            /* Never overwrite an entry that is still being written. */
+            if (((struct cbmem_entry_hdr *) start)->ceh_flags &
+                CBMEM_ENTRY_F_BUSY) {
+                return NULL;
+            }
+            evicted++;
+#endif
             start = (uint8_t *) CBMEM_ENTRY_NEXT(start);
-            if (start == cbmem->c_buf_cur_end) {
+            if (start == cur_end) {
                 start = cbmem->c_buf;
                 break;
             }
         }
-        cbmem->c_entry_start = (struct cbmem_entry_hdr *) start;
     }
 
-    /* Copy the entry into the log
-     */
-    dst->ceh_len = len;
-    copy_func((uint8_t *) dst + sizeof(*dst), data, len);
-
-    cbmem->c_entry_end = dst;
+    cbmem->c_buf_cur_end = cur_end;
+    cbmem->c_entry_start = (struct cbmem_entry_hdr *) start;
     if (!cbmem->c_entry_start) {
         cbmem->c_entry_start = dst;
     }
+    cbmem->c_entry_end = dst;
+    dst->ceh_len = len;
 
-    rc = cbmem_lock_release(cbmem);
-    if (rc != 0) {
-        goto err;
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    cbmem->c_seq_start += evicted;
+    dst->ceh_flags = CBMEM_ENTRY_F_BUSY |
+                     (cbmem->c_seq_next & CBMEM_ENTRY_SEQ_MASK);
+    cbmem->c_seq_next++;
+    cbmem->c_pending++;
+#endif
+
+    return dst;
+}
+
+struct cbmem_entry_hdr *
+cbmem_reserve(struct cbmem *cbmem, uint16_t len)
+{
+    struct cbmem_entry_hdr *dst;
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    dst = cbmem_place(cbmem, len);
+    OS_EXIT_CRITICAL(sr);
+#else
+    if (cbmem_lock_acquire(cbmem) != 0) {
+        return NULL;
+    }
+
+    dst = cbmem_place(cbmem, len);
+    if (dst == NULL) {
+        cbmem_lock_release(cbmem);
     }
+#endif
+
+    return dst;
+}
+
+void
+cbmem_commit(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr)
+{
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    hdr->ceh_flags &= ~CBMEM_ENTRY_F_BUSY;
+    cbmem->c_pending--;
+    OS_EXIT_CRITICAL(sr);
+#else
+    cbmem_lock_release(cbmem);
+#endif
+}
+
+static int
+cbmem_append_internal(struct cbmem *cbmem, const void *data, uint16_t len,
+                      copy_data_func_t *copy_func)
+{
+    struct cbmem_entry_hdr *dst;
+
+    dst = cbmem_reserve(cbmem, len);
+    if (dst == NULL) {
+        return (-1);
+    }
+
+    /* Copy the entry into the log
+     */
+    copy_func(CBMEM_ENTRY_DATA(dst), data, len);
+
+    cbmem_commit(cbmem, dst);
 
     return (0);
-err:
-    return (-1);
 }
 
 static void
@@ -223,14 +309,104 @@ cbmem_append_scat_gath(struct cbmem *cbmem, const struct cbmem_scat_gath *sg)
     return cbmem_append_internal(cbmem, sg, len, copy_data_from_scat_gath);
 }
 
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+/**
+ * Indicates whether the entry with the given flags is committed and has not
+ * been overwritten yet.  Must be called in a critical section.
+ */
+static bool
+cbmem_entry_live(const struct cbmem *cbmem, uint16_t flags)
+{
+    uint16_t idx;
+
+    if (flags & CBMEM_ENTRY_F_BUSY) {
+        return false;
+    }
+
+    idx = (flags - cbmem->c_seq_start) & CBMEM_ENTRY_SEQ_MASK;
+    return idx < cbmem->c_seq_next - cbmem->c_seq_start;
+}
+
+/**
+ * Returns the entry following a live entry.  Must be called in a critical
+ * section.
+ */
+static struct cbmem_entry_hdr *
+cbmem_entry_next(const struct cbmem *cbmem, struct cbmem_entry_hdr *hdr)
+{
+    struct cbmem_entry_hdr *next;
+
+    next = CBMEM_ENTRY_NEXT(hdr);
+
+    /* Entries above the newest one belong to the previous lap; the one
+     * ending at the wrap point is followed by the start of the buffer.
+     */
+    if (hdr > cbmem->c_entry_end &&
+        (uint8_t *) next >= cbmem->c_buf_cur_end) {
+        next = (struct cbmem_entry_hdr *) cbmem->c_buf;
+    }
+
+    return next;
+}
+#endif
+
 void
 cbmem_iter_start(struct cbmem *cbmem, struct cbmem_iter *iter)
 {
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    iter->ci_start = cbmem->c_entry_start;
+    iter->ci_cur = NULL;
+    iter->ci_end = cbmem->c_entry_end;
+    iter->ci_seq = cbmem->c_seq_start;
+    iter->ci_end_seq = cbmem->c_seq_next;
+    OS_EXIT_CRITICAL(sr);
+#else
     iter->ci_start = cbmem->c_entry_start;
     iter->ci_cur = cbmem->c_entry_start;
     iter->ci_end = cbmem->c_entry_end;
+#endif
 }
 
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+struct cbmem_entry_hdr *
+cbmem_iter_next(struct cbmem *cbmem, struct cbmem_iter *iter)
+{
+    struct cbmem_entry_hdr *hdr;
+    uint32_t seq;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+
+    if (iter->ci_cur == NULL ||
+        (int32_t)(iter->ci_seq - cbmem->c_seq_start) <= 0) {
+        /* First call, or writers have overwritten the last entry returned;
+         * continue from the oldest entry still present.
+         */
+        hdr = cbmem->c_entry_start;
+        seq = cbmem->c_seq_start;
+    } else {
+        hdr = cbmem_entry_next(cbmem, iter->ci_cur);
+        seq = iter->ci_seq;
+    }
+
+    if (seq == cbmem->c_seq_next ||
+        (int32_t)(seq - iter->ci_end_seq) >= 0 ||
+        (hdr->ceh_flags & CBMEM_ENTRY_F_BUSY)) {
+        /* End of the entries, or the next one is still being written. */
+        hdr = NULL;
+    } else {
+        iter->ci_cur = hdr;
+        iter->ci_seq = seq + 1;
+    }
+
+    OS_EXIT_CRITICAL(sr);
+
+    return (hdr);
+}
+#else
 struct cbmem_entry_hdr *
 cbmem_iter_next(struct cbmem *cbmem, struct cbmem_iter *iter)
 {
@@ -260,10 +436,32 @@ cbmem_iter_next(struct cbmem *cbmem, struct cbmem_iter *iter)
 err:
     return (hdr);
 }
+#endif
 
 int
 cbmem_flush(struct cbmem *cbmem)
 {
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    os_sr_t sr;
+    int rc;
+
+    OS_ENTER_CRITICAL(sr);
+    if (cbmem->c_pending != 0) {
+        /* An entry is being written; its space cannot be handed out again
+         * yet.
+         */
+        rc = OS_EBUSY;
+    } else {
+        cbmem->c_entry_start = NULL;
+        cbmem->c_entry_end = NULL;
+        cbmem->c_buf_cur_end = NULL;
+        cbmem->c_seq_start = cbmem->c_seq_next;
+        rc = 0;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return (rc);
+#else
     int rc;
 
     rc = cbmem_lock_acquire(cbmem);
@@ -283,12 +481,93 @@ cbmem_flush(struct cbmem *cbmem)
     return (0);
 err:
     return (rc);
+#endif
+}
+
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+/**
+ * Reads an entry's flags and length, if it is live.
+ *
+ * A reader holding on to an entry after the buffer wrapped may pass a
+ * pointer into another entry's data.  Those bytes can pass for a live
+ * header by chance, so the entry must also lie within the buffer.
+ *
+ * @return                      The entry's length; -1 if the entry is
+ *                              uncommitted or has been overwritten.
+ */
+static int
+cbmem_entry_get(const struct cbmem *cbmem, const struct cbmem_entry_hdr *hdr,
+                uint16_t *out_flags)
+{
+    uint16_t flags;
+    int len;
+    os_sr_t sr;
+
+    flags = 0;
+    len = -1;
+
+    OS_ENTER_CRITICAL(sr);
+    if ((uint8_t *)hdr >= cbmem->c_buf &&
+        CBMEM_ENTRY_DATA(hdr) <= cbmem->c_buf_end) {
+        flags = hdr->ceh_flags;
+        len = hdr->ceh_len;
+        if (!cbmem_entry_live(cbmem, flags) ||
+            len > cbmem->c_buf_end - CBMEM_ENTRY_DATA(hdr)) {
+            len = -1;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    *out_flags = flags;
+    return len;
+}
+
+/**
+ * Indicates whether an entry read with cbmem_entry_get() is still live,
+ * i.e., no writer overwrote it in the meantime.
+ */
+static bool
+cbmem_entry_unchanged(const struct cbmem *cbmem,
+                      const struct cbmem_entry_hdr *hdr, uint16_t flags)
+{
+    bool unchanged;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    unchanged = hdr->ceh_flags == flags && cbmem_entry_live(cbmem, flags);
+    OS_EXIT_CRITICAL(sr);
+
+    return unchanged;
 }
+#endif
 
 int
 cbmem_read(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr, void *buf,
         uint16_t off, uint16_t len)
 {
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    uint16_t flags;
+    int hdr_len;
+
+    hdr_len = cbmem_entry_get(cbmem, hdr, &flags);
+    if (hdr_len < 0 || off > hdr_len) {
+        return (-1);
+    }
+    if (off + len > hdr_len) {
+        len = hdr_len - off;
+    }
+
+    memcpy(buf, CBMEM_ENTRY_DATA(hdr) + off, len);
+
+    /* Writers do not wait for readers; make sure the entry was not
+     * overwritten during the copy.
+     */
+    if (!cbmem_entry_unchanged(cbmem, hdr, flags)) {
+        return (-1);
+    }
+
+    return (len);
+#else
     int rc;
 
     rc = cbmem_lock_acquire(cbmem);
@@ -319,11 +598,37 @@ cbmem_read(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr, void *buf,
     return (len);
 err:
     return (-1);
+#endif
 }
 
 int cbmem_read_mbuf(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr,
                     struct os_mbuf *om, uint16_t off, uint16_t len)
 {
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    uint16_t flags;
+    int hdr_len;
+    int rc;
+
+    hdr_len = cbmem_entry_get(cbmem, hdr, &flags);
+    if (hdr_len < 0 || off > hdr_len) {
+        return (-1);
+    }
+    if (off + len > hdr_len) {
+        len = hdr_len - off;
+    }
+
+    rc = os_mbuf_append(om, CBMEM_ENTRY_DATA(hdr) + off, len);
+    if (rc != 0) {
+        return (-1);
+    }
+
+    if (!cbmem_entry_unchanged(cbmem, hdr, flags)) {
+        os_mbuf_adj(om, -(int)len);
+        return (-1);
+    }
+
+    return (len);
+#else
     int rc;
 
     rc = cbmem_lock_acquire(cbmem);
@@ -355,7 +660,7 @@ int cbmem_read_mbuf(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr,
     return (len);
 err:
     return (-1);
-
+#endif
 }
 
 int
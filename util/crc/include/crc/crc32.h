@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * CRC-32 (IEEE 802.3, as used by zlib and Ethernet) and CRC-32C
+ * (Castagnoli, as used by iSCSI and ext4).
+ */
+
+#ifndef _UTIL_CRC32_H_
+#define _UTIL_CRC32_H_
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CRC32_INITIAL_CRC       0       /* what to seed crc32 with */
+
+/**
+ * Computes the CRC-32 of a buffer, continuing from a previous result.
+ * Pre- and post-inversion are handled internally, so checksumming a
+ * buffer in pieces gives the same result as checksumming it at once:
+ *
+ *     crc = crc32_ieee(CRC32_INITIAL_CRC, a, a_len);
+ *     crc = crc32_ieee(crc, b, b_len);
+ *
+ * @param crc           CRC32_INITIAL_CRC, or the result of a previous call.
+ * @param buf           Data to checksum.
+ * @param len           Number of bytes in buf.
+ *
+ * @return The updated CRC.
+ */
+uint32_t crc32_ieee(uint32_t crc, const void *buf, int len);
+
+/**
+ * Computes the CRC-32C of a buffer, continuing from a previous result.
+ * Same conventions as crc32_ieee().
+ */
+uint32_t crc32c(uint32_t crc, const void *buf, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _UTIL_CRC_MBUF_H_
+#define _UTIL_CRC_MBUF_H_
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct os_mbuf;
+
+/*
+ * Checksum part of an mbuf chain in place, without copying it into a flat
+ * buffer.  Each function continues from the CRC in *crc and writes the
+ * result back there; seed it with the matching *_INITIAL_CRC value.
+ *
+ * Return 0 on success; OS_EINVAL if the chain holds fewer than off + len
+ * bytes, in which case *crc is left unchanged.
+ */
+int crc16_ccitt_mbuf(const struct os_mbuf *om, int off, int len,
+                     uint16_t *crc);
+int crc32_ieee_mbuf(const struct os_mbuf *om, int off, int len,
+                    uint32_t *crc);
+int crc32c_mbuf(const struct os_mbuf *om, int off, int len, uint32_t *crc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
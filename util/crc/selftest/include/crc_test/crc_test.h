@@ -0,0 +1,52 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __CRC_TEST_H
+#define __CRC_TEST_H
+
+#include <string.h>
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "crc/crc16.h"
+#include "crc/crc32.h"
+#include "crc/crc_mbuf.h"
+
+#define CRC_TEST_BUF_SIZE   1024
+
+extern uint8_t crc_test_buf[CRC_TEST_BUF_SIZE];
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+TEST_CASE_DECL(crc_test_check_values);
+TEST_CASE_DECL(crc_test_slice);
+TEST_CASE_DECL(crc_test_mbuf);
+TEST_SUITE_DECL(crc_test_suite);
+
+/* Bit-at-a-time reference implementations. */
+uint16_t crc_test_ref16(uint16_t crc, const uint8_t *buf, int len);
+uint32_t crc_test_ref32(uint32_t poly, uint32_t crc, const uint8_t *buf,
+                        int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRC_TEST_H */
@@ -0,0 +1,80 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "crc_test/crc_test.h"
+
+#define CRC_TEST_MBUF_DATA_LEN  40
+#define CRC_TEST_MBUF_BLOCK_LEN \
+    (CRC_TEST_MBUF_DATA_LEN + sizeof(struct os_mbuf))
+#define CRC_TEST_MBUF_COUNT     40
+
+static os_membuf_t crc_test_mbuf_mem[
+    OS_MEMPOOL_SIZE(CRC_TEST_MBUF_COUNT, CRC_TEST_MBUF_BLOCK_LEN)];
+
+TEST_CASE_SELF(crc_test_mbuf)
+{
+    struct os_mbuf_pool omp;
+    struct os_mempool mp;
+    struct os_mbuf *om;
+    uint32_t crc32;
+    uint16_t crc16;
+    int off;
+    int len;
+    int rc;
+
+    rc = os_mempool_init(&mp, CRC_TEST_MBUF_COUNT, CRC_TEST_MBUF_BLOCK_LEN,
+                         crc_test_mbuf_mem, "crc_test_mbuf");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&omp, &mp, CRC_TEST_MBUF_BLOCK_LEN,
+                           CRC_TEST_MBUF_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    om = os_mbuf_get_pkthdr(&omp, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, crc_test_buf, 1000);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(SLIST_NEXT(om, om_next) != NULL);
+
+    for (off = 0; off < 100; off += 13) {
+        for (len = 0; len < 900; len += 97) {
+            crc16 = 0;
+            rc = crc16_ccitt_mbuf(om, off, len, &crc16);
+            TEST_ASSERT(rc == 0);
+            TEST_ASSERT(crc16 == crc16_ccitt(0, crc_test_buf + off, len));
+
+            crc32 = CRC32_INITIAL_CRC;
+            rc = crc32_ieee_mbuf(om, off, len, &crc32);
+            TEST_ASSERT(rc == 0);
+            TEST_ASSERT(crc32 == crc32_ieee(0, crc_test_buf + off, len));
+
+            crc32 = CRC32_INITIAL_CRC;
+            rc = crc32c_mbuf(om, off, len, &crc32);
+            TEST_ASSERT(rc == 0);
+            TEST_ASSERT(crc32 == crc32c(0, crc_test_buf + off, len));
+        }
+    }
+
+    /* Region past the end of the chain; CRC is untouched. */
+    crc32 = 0x1234;
+    rc = crc32_ieee_mbuf(om, 900, 101, &crc32);
+    TEST_ASSERT(rc == OS_EINVAL);
+    TEST_ASSERT(crc32 == 0x1234);
+
+    os_mbuf_free_chain(om);
+}
@@ -0,0 +1,55 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "crc_test/crc_test.h"
+
+/*
+ * Compare the table driven (possibly sliced) implementations against the
+ * bitwise references for every length up to a few slices, at every
+ * alignment.
+ */
+TEST_CASE_SELF(crc_test_slice)
+{
+    const uint8_t *buf;
+    int off;
+    int len;
+
+    for (off = 0; off < 8; off++) {
+        buf = crc_test_buf + off;
+        for (len = 0; len <= 40; len++) {
+            TEST_ASSERT_FATAL(crc16_ccitt(0x1d0f, buf, len) ==
+                              crc_test_ref16(0x1d0f, buf, len),
+                              "crc16 mismatch off=%d len=%d", off, len);
+            TEST_ASSERT_FATAL(crc32_ieee(0, buf, len) ==
+                              crc_test_ref32(0xedb88320, 0, buf, len),
+                              "crc32 mismatch off=%d len=%d", off, len);
+            TEST_ASSERT_FATAL(crc32c(0, buf, len) ==
+                              crc_test_ref32(0x82f63b78, 0, buf, len),
+                              "crc32c mismatch off=%d len=%d", off, len);
+        }
+    }
+
+    len = CRC_TEST_BUF_SIZE - 8;
+    buf = crc_test_buf + 3;
+    TEST_ASSERT(crc16_ccitt(0, buf, len) == crc_test_ref16(0, buf, len));
+    TEST_ASSERT(crc32_ieee(0, buf, len) ==
+                crc_test_ref32(0xedb88320, 0, buf, len));
+    TEST_ASSERT(crc32c(0, buf, len) ==
+                crc_test_ref32(0x82f63b78, 0, buf, len));
+}
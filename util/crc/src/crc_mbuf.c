@@ -0,0 +1,101 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(CRC_MBUF)
+
+#include "os/mynewt.h"
+#include "crc/crc16.h"
+#include "crc/crc32.h"
+#include "crc/crc_mbuf.h"
+
+static int
+crc16_ccitt_seg(const void *data, uint16_t len, void *arg)
+{
+    uint16_t *crc;
+
+    crc = arg;
+    *crc = crc16_ccitt(*crc, data, len);
+    return 0;
+}
+
+static int
+crc32_ieee_seg(const void *data, uint16_t len, void *arg)
+{
+    uint32_t *crc;
+
+    crc = arg;
+    *crc = crc32_ieee(*crc, data, len);
+    return 0;
+}
+
+static int
+crc32c_seg(const void *data, uint16_t len, void *arg)
+{
+    uint32_t *crc;
+
+    crc = arg;
+    *crc = crc32c(*crc, data, len);
+    return 0;
+}
+
+int
+crc16_ccitt_mbuf(const struct os_mbuf *om, int off, int len, uint16_t *crc)
+{
+    uint16_t tmp;
+    int rc;
+
+    tmp = *crc;
+    rc = os_mbuf_foreach_segment(om, off, len, crc16_ccitt_seg, &tmp);
+    if (rc == 0) {
+        *crc = tmp;
+    }
+    return rc;
+}
+
+int
+crc32_ieee_mbuf(const struct os_mbuf *om, int off, int len, uint32_t *crc)
+{
+    uint32_t tmp;
+    int rc;
+
+    tmp = *crc;
+    rc = os_mbuf_foreach_segment(om, off, len, crc32_ieee_seg, &tmp);
+    if (rc == 0) {
+        *crc = tmp;
+    }
+    return rc;
+}
+
+int
+crc32c_mbuf(const struct os_mbuf *om, int off, int len, uint32_t *crc)
+{
+    uint32_t tmp;
+    int rc;
+
+    tmp = *crc;
+    rc = os_mbuf_foreach_segment(om, off, len, crc32c_seg, &tmp);
+    if (rc == 0) {
+        *crc = tmp;
+    }
+    return rc;
+}
+
+#endif